@@ -42,8 +42,11 @@
 #endif
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -330,33 +333,29 @@ class ActionInterface {
 
 // An Action<F> is a copyable and IMMUTABLE (except by assignment)
 // object that represents an action to be taken when a mock function
-// of type F is called.  The implementation of Action<T> is just a
-// std::shared_ptr to const ActionInterface<T>. Don't inherit from Action!
+// of type F is called.  Don't inherit from Action!
 // You can view an object implementing ActionInterface<F> as a
 // concrete action (including its current state), and an Action<F>
 // object as a handle to it.
+//
+// The implementation is held by value, as a std::function<F> would
+// hold it.  One that is small enough (Return(x) for a scalar or a
+// string, ReturnRef(x), SetArgPointee<N>(x), a lambda capturing a few
+// pointers) lives in a buffer inside the action, so making, copying
+// and destroying the action never allocates, and performing it calls
+// the implementation on the argument tuple without a virtual call.
+// A bigger one lives on the heap: it's shared by the copies of the
+// action when performing it can't change it, and copied with the
+// action otherwise.  An ActionInterface<F> is always shared.
 template <typename F>
 class Action {
-  // Adapter class to allow constructing Action from a legacy ActionInterface.
-  // New code should create Actions from functors instead.
-  struct ActionAdapter {
-    // Adapter must be copyable to satisfy std::function requirements.
-    ::std::shared_ptr<ActionInterface<F>> impl_;
-
-    template <typename... Args>
-    typename internal::Function<F>::Result operator()(Args&&... args) {
-      return impl_->Perform(
-          ::std::forward_as_tuple(::std::forward<Args>(args)...));
-    }
-  };
-
  public:
   typedef typename internal::Function<F>::Result Result;
   typedef typename internal::Function<F>::ArgumentTuple ArgumentTuple;
 
   // Constructs a null Action.  Needed for storing Action objects in
   // STL containers.
-  Action() {}
+  Action() : vtable_(nullptr) {}
 
   // Construct an Action from a specified callable.
   // This cannot take std::function directly, because then Action would not be
@@ -364,20 +363,68 @@ class Action {
   template <typename G,
             typename = typename ::std::enable_if<
                 ::std::is_constructible<::std::function<F>, G>::value>::type>
-  Action(G&& fun) : fun_(::std::forward<G>(fun)) {}  // NOLINT
+  Action(G&& fun) : vtable_(nullptr) {  // NOLINT
+    typedef typename ::std::decay<G>::type Functor;
+    if (!IsNullCallable(fun)) {
+      Init<typename PolicyFor<FunctorImpl<Functor>,
+                              IsConstCallable<Functor>::value,
+                              false>::type>(::std::forward<G>(fun));
+    }
+  }
 
   // Constructs an Action from its implementation.
-  explicit Action(ActionInterface<F>* impl)
-      : fun_(ActionAdapter{::std::shared_ptr<ActionInterface<F>>(impl)}) {}
+  explicit Action(ActionInterface<F>* impl) : vtable_(nullptr) {
+    Init<SharedPolicy<OwnedImpl> >(impl);
+  }
 
   // This constructor allows us to turn an Action<Func> object into an
   // Action<F>, as long as F's arguments can be implicitly converted
   // to Func's and Func's return type can be implicitly converted to F's.
+  // The converted action is copied with this one, as the state of action
+  // (e.g. a mutable callable) belongs to each copy.
   template <typename Func>
-  explicit Action(const Action<Func>& action) : fun_(action.fun_) {}
+  explicit Action(const Action<Func>& action) : vtable_(nullptr) {
+    if (!action.IsDoDefault()) {
+      Init<typename PolicyFor<ConvertedImpl<Func>, false, false>::type>(
+          action);
+    }
+  }
+
+  Action(const Action& other) : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) vtable_->copy(other.buffer_, &buffer_);
+  }
+
+  Action& operator=(const Action& other) {
+    if (this != &other) {
+      Action copy(other);
+      *this = ::std::move(copy);
+    }
+    return *this;
+  }
+
+  Action(Action&& other) noexcept : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) {
+      vtable_->move(&other.buffer_, &buffer_);
+      other.vtable_ = nullptr;
+    }
+  }
+
+  Action& operator=(Action&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      vtable_ = other.vtable_;
+      if (vtable_ != nullptr) {
+        vtable_->move(&other.buffer_, &buffer_);
+        other.vtable_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  ~Action() { Reset(); }
 
   // Returns true if and only if this is the DoDefault() action.
-  bool IsDoDefault() const { return fun_ == nullptr; }
+  bool IsDoDefault() const { return vtable_ == nullptr; }
 
   // Performs the action.  Note that this method is const even though
   // the corresponding method in ActionInterface is not.  The reason
@@ -385,19 +432,259 @@ class Action {
   // another concrete action, not that the concrete action it binds to
   // cannot change state.  (Think of the difference between a const
   // pointer and a pointer to const.)
-  Result Perform(ArgumentTuple args) const {
+  //
+  // The arguments are moved on from 'args', never copied.
+  Result Perform(ArgumentTuple&& args) const {
     if (IsDoDefault()) {
       internal::IllegalDoDefault(__FILE__, __LINE__);
     }
-    return internal::Apply(fun_, ::std::move(args));
+    return vtable_->perform(&buffer_, &args);
+  }
+
+  Result Perform(const ArgumentTuple& args) const {
+    return Perform(ArgumentTuple(args));
   }
 
  private:
   template <typename G>
   friend class Action;
 
-  // fun_ is an empty function if and only if this is the DoDefault() action.
-  ::std::function<F> fun_;
+  template <typename Impl>
+  friend class PolymorphicAction;
+
+  // Room for an implementation made of a std::string and a pointer.
+  static const size_t kInlineSize = sizeof(void*) + sizeof(::std::string);
+
+  union Buffer {
+    // Aligns the inline storage for anything whose alignment is no
+    // stricter than one of these.
+    void* pointer;
+    double floating_point;
+    long long integer;  // NOLINT
+
+    unsigned char inline_storage[kInlineSize];
+  };
+
+  // How an action performs, copies and destroys the implementation in
+  // its buffer.  The implementations are all kept as classes with a
+  // Result Perform(ArgumentTuple& args) method that may move the
+  // arguments out of args.
+  struct VTable {
+    Result (*perform)(Buffer* buffer, ArgumentTuple* args);
+    void (*copy)(const Buffer& from, Buffer* to);
+    // Leaves nothing to destroy in 'from'.
+    void (*move)(Buffer* from, Buffer* to);
+    void (*destroy)(Buffer* buffer);
+  };
+
+  // A callable implementation.
+  template <typename Functor>
+  class FunctorImpl {
+   public:
+    template <typename Arg>
+    explicit FunctorImpl(Arg&& fun) : fun_(::std::forward<Arg>(fun)) {}
+
+    Result Perform(ArgumentTuple& args) {
+      return Call(args, ::std::is_void<Result>());
+    }
+
+   private:
+    // Drops what fun_ returns when Result is void, as std::function<F>
+    // does.
+    Result Call(ArgumentTuple& args, ::std::true_type /* is_void */) {
+      internal::Apply(fun_, ::std::move(args));
+    }
+    Result Call(ArgumentTuple& args, ::std::false_type /* is_void */) {
+      return internal::Apply(fun_, ::std::move(args));
+    }
+
+    Functor fun_;
+  };
+
+  // An implementation given as a pointer, which the action owns.
+  class OwnedImpl {
+   public:
+    explicit OwnedImpl(ActionInterface<F>* impl) : impl_(impl) {}
+
+    Result Perform(ArgumentTuple& args) { return impl_->Perform(args); }
+
+   private:
+    ::std::unique_ptr<ActionInterface<F> > impl_;
+  };
+
+  // An action of another function type, performed on this one's arguments.
+  template <typename Func>
+  class ConvertedImpl {
+   public:
+    explicit ConvertedImpl(const Action<Func>& action) : action_(action) {}
+
+    Result Perform(ArgumentTuple& args) {
+      return Call(args, ::std::is_void<Result>());
+    }
+
+   private:
+    typedef typename Action<Func>::ArgumentTuple FuncArgumentTuple;
+
+    Result Call(ArgumentTuple& args, ::std::true_type /* is_void */) {
+      action_.Perform(FuncArgumentTuple(::std::move(args)));
+    }
+    Result Call(ArgumentTuple& args, ::std::false_type /* is_void */) {
+      return action_.Perform(FuncArgumentTuple(::std::move(args)));
+    }
+
+    const Action<Func> action_;
+  };
+
+  // Whether a Functor can be called through a const reference, in which
+  // case calling it can't change it (short of mutable members).
+  template <typename Functor, typename = void>
+  struct IsConstCallable : ::std::false_type {};
+  template <typename Functor>
+  struct IsConstCallable<
+      Functor, decltype(void(internal::Apply(
+                   ::std::declval<const Functor&>(),
+                   ::std::declval<ArgumentTuple&&>())))> : ::std::true_type {
+  };
+
+  // Whether std::function<F> would be empty if made from fun.
+  template <typename Functor>
+  static bool IsNullCallable(const Functor& /* fun */) {
+    return false;
+  }
+  template <typename R, typename... Args>
+  static bool IsNullCallable(R (*fun)(Args...)) {
+    return fun == nullptr;
+  }
+  template <typename Signature>
+  static bool IsNullCallable(const ::std::function<Signature>& fun) {
+    return !fun;
+  }
+
+  template <typename M>
+  struct FitsInline
+      : ::std::integral_constant<
+            bool, sizeof(M) <= sizeof(Buffer) &&
+                      alignof(Buffer) % alignof(M) == 0 &&
+                      ::std::is_copy_constructible<M>::value &&
+                      ::std::is_nothrow_move_constructible<M>::value> {};
+
+  // Keeps an M in the buffer itself.
+  template <typename M>
+  struct InlinePolicy {
+    template <typename Arg>
+    static void Create(Buffer* buffer, Arg&& arg) {
+      new (buffer->inline_storage) M(::std::forward<Arg>(arg));
+    }
+    static M& Get(Buffer* buffer) {
+      return *reinterpret_cast<M*>(buffer->inline_storage);
+    }
+    static void Copy(const Buffer& from, Buffer* to) {
+      Create(to, *reinterpret_cast<const M*>(from.inline_storage));
+    }
+    static void Move(Buffer* from, Buffer* to) {
+      Create(to, ::std::move(Get(from)));
+      Destroy(from);
+    }
+    static void Destroy(Buffer* buffer) { Get(buffer).~M(); }
+  };
+
+  // Keeps an M on the heap, shared by the copies of the action.
+  template <typename M>
+  struct SharedPolicy {
+    struct Shared {
+      template <typename Arg>
+      explicit Shared(Arg&& arg)
+          : ref_count(1), impl(::std::forward<Arg>(arg)) {}
+
+      ::std::atomic<int> ref_count;
+      M impl;
+    };
+
+    template <typename Arg>
+    static void Create(Buffer* buffer, Arg&& arg) {
+      buffer->pointer = new Shared(::std::forward<Arg>(arg));
+    }
+    static M& Get(Buffer* buffer) {
+      return static_cast<Shared*>(buffer->pointer)->impl;
+    }
+    static void Copy(const Buffer& from, Buffer* to) {
+      static_cast<Shared*>(from.pointer)
+          ->ref_count.fetch_add(1, ::std::memory_order_relaxed);
+      to->pointer = from.pointer;
+    }
+    static void Move(Buffer* from, Buffer* to) {
+      to->pointer = from->pointer;
+    }
+    static void Destroy(Buffer* buffer) {
+      Shared* const shared = static_cast<Shared*>(buffer->pointer);
+      if (shared->ref_count.fetch_sub(1, ::std::memory_order_acq_rel) == 1) {
+        delete shared;
+      }
+    }
+  };
+
+  // Keeps an M on the heap, copied with the action.
+  template <typename M>
+  struct CopiedPolicy {
+    template <typename Arg>
+    static void Create(Buffer* buffer, Arg&& arg) {
+      buffer->pointer = new M(::std::forward<Arg>(arg));
+    }
+    static M& Get(Buffer* buffer) { return *static_cast<M*>(buffer->pointer); }
+    static void Copy(const Buffer& from, Buffer* to) {
+      Create(to, *static_cast<const M*>(from.pointer));
+    }
+    static void Move(Buffer* from, Buffer* to) {
+      to->pointer = from->pointer;
+    }
+    static void Destroy(Buffer* buffer) { delete &Get(buffer); }
+  };
+
+  // Where to keep an implementation M: in the buffer when it fits, unless
+  // it has state that the copies of the action must share; otherwise on
+  // the heap, shared when it has no state to change or its state must be
+  // shared, and copied with the action when it has state of its own.
+  template <typename M, bool kIsConst, bool kSharesState>
+  struct PolicyFor
+      : ::std::conditional<
+            FitsInline<M>::value && (kIsConst || !kSharesState),
+            InlinePolicy<M>,
+            typename ::std::conditional<kIsConst || kSharesState,
+                                        SharedPolicy<M>,
+                                        CopiedPolicy<M> >::type> {};
+
+  // Makes an action from an implementation with a
+  // Result Perform(ArgumentTuple& args) method.
+  template <bool kIsConst, typename M>
+  static Action FromImpl(M&& impl) {
+    Action action;
+    action.template Init<typename PolicyFor<
+        typename ::std::decay<M>::type, kIsConst, true>::type>(
+        ::std::forward<M>(impl));
+    return action;
+  }
+
+  template <typename Policy>
+  static Result PerformImpl(Buffer* buffer, ArgumentTuple* args) {
+    return Policy::Get(buffer).Perform(*args);
+  }
+
+  template <typename Policy, typename Arg>
+  void Init(Arg&& arg) {
+    static const VTable kVTable = {&PerformImpl<Policy>, &Policy::Copy,
+                                   &Policy::Move, &Policy::Destroy};
+    Policy::Create(&buffer_, ::std::forward<Arg>(arg));
+    vtable_ = &kVTable;
+  }
+
+  void Reset() {
+    if (vtable_ != nullptr) vtable_->destroy(&buffer_);
+    vtable_ = nullptr;
+  }
+
+  // NULL if and only if this is the DoDefault() action.
+  const VTable* vtable_;
+  mutable Buffer buffer_;
 };
 
 // The PolymorphicAction class template makes it easy to implement a
@@ -421,6 +708,10 @@ class Action {
 // MakePolymorphicAction(object) where object has type FooAction.  See
 // the definition of Return(void) and SetArgumentPointee<N>(value) for
 // complete examples.
+//
+// The copies of an Action made from it share one copy of the
+// implementation, unless Perform() is const: then a small implementation
+// is kept inside each of them.
 template <typename Impl>
 class PolymorphicAction {
  public:
@@ -428,28 +719,38 @@ class PolymorphicAction {
 
   template <typename F>
   operator Action<F>() const {
-    return Action<F>(new MonomorphicImpl<F>(impl_));
+    return Action<F>::template FromImpl<IsConstPerformable<F>::value>(
+        MonomorphicImpl<F>(impl_));
   }
 
  private:
   template <typename F>
-  class MonomorphicImpl : public ActionInterface<F> {
+  class MonomorphicImpl {
    public:
     typedef typename internal::Function<F>::Result Result;
     typedef typename internal::Function<F>::ArgumentTuple ArgumentTuple;
 
     explicit MonomorphicImpl(const Impl& impl) : impl_(impl) {}
 
-    Result Perform(const ArgumentTuple& args) override {
+    Result Perform(const ArgumentTuple& args) {
       return impl_.template Perform<Result>(args);
     }
 
    private:
     Impl impl_;
-
-    GTEST_DISALLOW_ASSIGN_(MonomorphicImpl);
   };
 
+  // Whether Impl::Perform() for F can be called on a const Impl.
+  template <typename F, typename = void>
+  struct IsConstPerformable : std::false_type {};
+  template <typename F>
+  struct IsConstPerformable<
+      F, decltype(void(std::declval<const Impl&>().template Perform<
+                       typename internal::Function<F>::Result>(
+          std::declval<
+              const typename internal::Function<F>::ArgumentTuple&>())))>
+      : std::true_type {};
+
   Impl impl_;
 
   GTEST_DISALLOW_ASSIGN_(PolymorphicAction);
@@ -517,7 +818,7 @@ class ReturnAction {
   // Constructs a ReturnAction object from the value to be returned.
   // 'value' is passed by value instead of by const reference in order
   // to allow Return("string literal") to compile.
-  explicit ReturnAction(R value) : value_(new R(std::move(value))) {}
+  explicit ReturnAction(R value) : value_(std::move(value)) {}
 
   // This template type conversion operator allows Return(x) to be
   // used in ANY function that returns x's type.
@@ -537,12 +838,47 @@ class ReturnAction {
         use_ReturnRef_instead_of_Return_to_return_a_reference);
     static_assert(!std::is_void<Result>::value,
                   "Can't use Return() on an action expected to return `void`.");
-    return Action<F>(new Impl<R, F>(value_));
+    return MakeAction<F>(std::integral_constant<
+                         bool, std::is_same<R, Result>::value ||
+                                   std::is_scalar<R>::value>());
   }
 
  private:
+  // When x is the very value to return, or a scalar from which that is
+  // converted, the converted value is all the action keeps, and it's
+  // copied with the action, which keeps it inline when it's small.
+  template <typename F>
+  Action<F> MakeAction(std::true_type /* keeps_only_result */) const {
+    return Action<F>(ValueImpl<F>(value_));
+  }
+
+  // Otherwise the result may refer to x, so the action must keep both,
+  // and its copies share them.
+  template <typename F>
+  Action<F> MakeAction(std::false_type /* keeps_only_result */) const {
+    return Action<F>(new Impl<F>(value_));
+  }
+
+  // Implements the Return(x) action for a particular function type F,
+  // keeping only the value to return.
+  template <typename F>
+  class ValueImpl {
+   public:
+    typedef typename Function<F>::Result Result;
+
+    explicit ValueImpl(const R& value) : value_(ImplicitCast_<Result>(value)) {}
+
+    template <typename... Args>
+    Result operator()(const Args&...) const {
+      return value_;
+    }
+
+   private:
+    Result value_;
+  };
+
   // Implements the Return(x) action for a particular function type F.
-  template <typename R_, typename F>
+  template <typename F>
   class Impl : public ActionInterface<F> {
    public:
     typedef typename Function<F>::Result Result;
@@ -555,8 +891,8 @@ class ReturnAction {
     // Result to call.  ImplicitCast_ forces the compiler to convert R to
     // Result without considering explicit constructors, thus resolving the
     // ambiguity. value_ is then initialized using its copy constructor.
-    explicit Impl(const std::shared_ptr<R>& value)
-        : value_before_cast_(*value),
+    explicit Impl(const R& value)
+        : value_before_cast_(value),
           value_(ImplicitCast_<Result>(value_before_cast_)) {}
 
     Result Perform(const ArgumentTuple&) override { return value_; }
@@ -572,15 +908,38 @@ class ReturnAction {
     GTEST_DISALLOW_COPY_AND_ASSIGN_(Impl);
   };
 
-  // Partially specialize for ByMoveWrapper. This version of ReturnAction will
-  // move its contents instead.
-  template <typename R_, typename F>
-  class Impl<ByMoveWrapper<R_>, F> : public ActionInterface<F> {
+  const R value_;
+
+  GTEST_DISALLOW_ASSIGN_(ReturnAction);
+};
+
+// Specializes ReturnAction for ByMoveWrapper. This version of ReturnAction
+// moves its contents instead of copying them.
+template <typename T>
+class ReturnAction<ByMoveWrapper<T> > {
+ public:
+  explicit ReturnAction(ByMoveWrapper<T> wrapper)
+      : wrapper_(new ByMoveWrapper<T>(std::move(wrapper))) {}
+
+  template <typename F>
+  operator Action<F>() const {  // NOLINT
+    typedef typename Function<F>::Result Result;
+    GTEST_COMPILE_ASSERT_(
+        !std::is_reference<Result>::value,
+        use_ReturnRef_instead_of_Return_to_return_a_reference);
+    static_assert(!std::is_void<Result>::value,
+                  "Can't use Return() on an action expected to return `void`.");
+    return Action<F>(new Impl<F>(wrapper_));
+  }
+
+ private:
+  template <typename F>
+  class Impl : public ActionInterface<F> {
    public:
     typedef typename Function<F>::Result Result;
     typedef typename Function<F>::ArgumentTuple ArgumentTuple;
 
-    explicit Impl(const std::shared_ptr<R>& wrapper)
+    explicit Impl(const std::shared_ptr<ByMoveWrapper<T> >& wrapper)
         : performed_(false), wrapper_(wrapper) {}
 
     Result Perform(const ArgumentTuple&) override {
@@ -592,12 +951,12 @@ class ReturnAction {
 
    private:
     bool performed_;
-    const std::shared_ptr<R> wrapper_;
+    const std::shared_ptr<ByMoveWrapper<T> > wrapper_;
 
     GTEST_DISALLOW_ASSIGN_(Impl);
   };
 
-  const std::shared_ptr<R> value_;
+  const std::shared_ptr<ByMoveWrapper<T> > wrapper_;
 
   GTEST_DISALLOW_ASSIGN_(ReturnAction);
 };
@@ -643,25 +1002,26 @@ class ReturnRefAction {
     // should be used, and generates some helpful error message.
     GTEST_COMPILE_ASSERT_(std::is_reference<Result>::value,
                           use_Return_instead_of_ReturnRef_to_return_a_value);
-    return Action<F>(new Impl<F>(ref_));
+    return Action<F>(Impl<F>(ref_));
   }
 
  private:
   // Implements the ReturnRef(x) action for a particular function type F.
+  // It's only a pointer, so the action keeps it inline.
   template <typename F>
-  class Impl : public ActionInterface<F> {
+  class Impl {
    public:
     typedef typename Function<F>::Result Result;
-    typedef typename Function<F>::ArgumentTuple ArgumentTuple;
 
-    explicit Impl(T& ref) : ref_(ref) {}  // NOLINT
+    explicit Impl(T& ref) : ref_(&ref) {}  // NOLINT
 
-    Result Perform(const ArgumentTuple&) override { return ref_; }
+    template <typename... Args>
+    Result operator()(const Args&...) const {
+      return *ref_;
+    }
 
    private:
-    T& ref_;
-
-    GTEST_DISALLOW_ASSIGN_(Impl);
+    T* ref_;
   };
 
   T& ref_;
@@ -930,25 +1290,39 @@ struct WithArgsAction {
 template <typename... Actions>
 struct DoAllAction {
  private:
+  // A by-value argument is passed to the actions but the last as a const
+  // reference, unless it's a scalar.
+  template <typename T>
+  using InitialActionArgType =
+      typename std::conditional<std::is_scalar<T>::value ||
+                                    std::is_reference<T>::value,
+                                T, const T&>::type;
+
   template <typename... Args, size_t... I>
-  std::vector<Action<void(Args...)>> Convert(IndexSequence<I...>) const {
-    return {std::get<I>(actions)...};
+  std::array<Action<void(InitialActionArgType<Args>...)>, sizeof...(I)>
+  Convert(IndexSequence<I...>) const {
+    typedef Action<void(InitialActionArgType<Args>...)> InitialAction;
+    return {{InitialAction(std::get<I>(actions))...}};
   }
 
  public:
   std::tuple<Actions...> actions;
 
+  // All the actions but the last get the arguments as references, so
+  // that none of them is copied for them, and the last one gets them
+  // moved on.  No action is copied when performing them.
   template <typename R, typename... Args>
   operator Action<R(Args...)>() const {  // NOLINT
     struct Op {
-      std::vector<Action<void(Args...)>> converted;
+      std::array<Action<void(InitialActionArgType<Args>...)>,
+                 sizeof...(Actions) - 1>
+          converted;
       Action<R(Args...)> last;
-      R operator()(Args... args) const {
-        auto tuple_args = std::forward_as_tuple(std::forward<Args>(args)...);
+      R operator()(Args&&... args) const {
         for (auto& a : converted) {
-          a.Perform(tuple_args);
+          a.Perform(std::forward_as_tuple(std::forward<Args>(args)...));
         }
-        return last.Perform(tuple_args);
+        return last.Perform(std::forward_as_tuple(std::forward<Args>(args)...));
       }
     };
     return Op{Convert<Args...>(MakeIndexSequence<sizeof...(Actions) - 1>()),
@@ -28,66 +28,45 @@ JMSD_DEPRECATED_GMOCK_API_ std::string FormatMatcherDescription(bool negation,
 
 // FindMaxBipartiteMatching and its helper class.
 //
-// Uses the well-known Ford-Fulkerson max flow method to find a maximum
-// bipartite matching. Flow is considered to be from left to right.
-// There is an implicit source node that is connected to all of the left
-// nodes, and an implicit sink node that is connected to all of the
-// right nodes. All edges have unit capacity.
+// Uses the Hopcroft-Karp algorithm to find a maximum bipartite matching
+// in O(E * sqrt(V)) time, where E is the number of edges of 'graph' and V
+// the number of elements plus matchers.
 //
-// Neither the flow graph nor the residual flow graph are represented
-// explicitly. Instead, they are implied by the information in 'graph' and
-// a vector<int> called 'left_' whose elements are initialized to the
-// value kUnused. This represents the initial state of the algorithm,
-// where the flow graph is empty, and the residual flow graph has the
-// following edges:
-//   - An edge from source to each left_ node
-//   - An edge from each right_ node to sink
-//   - An edge from each left_ node to each right_ node, if the
-//     corresponding edge exists in 'graph'.
-//
-// When the TryAugment() method adds a flow, it sets left_[l] = r for some
-// nodes l and r. This induces the following changes:
-//   - The edges (source, l), (l, r), and (r, sink) are added to the
-//     flow graph.
-//   - The same three edges are removed from the residual flow graph.
-//   - The reverse edges (l, source), (r, l), and (sink, r) are added
-//     to the residual flow graph, which is a directional graph
-//     representing unused flow capacity.
-//
-// When the method augments a flow (moving left_[l] from some r1 to some
-// other r2), this can be thought of as "undoing" the above steps with
-// respect to r1 and "redoing" them with respect to r2.
-//
-// It bears repeating that the flow graph and residual flow graph are
-// never represented explicitly, but can be derived by looking at the
-// information in 'graph' and in left_.
-//
-// As an optimization, there is a second vector<int> called right_ which
-// does not provide any new information. Instead, it enables more
-// efficient queries about edges entering or leaving the right-side nodes
-// of the flow or residual flow graphs. The following invariants are
+// The matching is kept in two vectors: left_[l] is the matcher element l
+// is paired with, and right_[r] the element matcher r is paired with,
+// either being kUnused for an unpaired node. The following invariants are
 // maintained:
 //
 // left[l] == kUnused or right[left[l]] == l
 // right[r] == kUnused or left[right[r]] == r
 //
-// . [ source ]                                        .
-// .   |||                                             .
-// .   |||                                             .
-// .   ||\--> left[0]=1  ---\    right[0]=-1 ----\     .
-// .   ||                   |                    |     .
-// .   |\---> left[1]=-1    \--> right[1]=0  ---\|     .
-// .   |                                        ||     .
-// .   \----> left[2]=2  ------> right[2]=2  --\||     .
-// .                                           |||     .
-// .         elements           matchers       vvv     .
-// .                                         [ sink ]  .
+// An augmenting path starts at an unpaired element, alternates between an
+// edge that isn't in the matching and one that is, and ends at an
+// unpaired matcher. Flipping the edges of such a path grows the matching
+// by one; a matching is maximum if and only if no such path is left.
+//
+// Instead of searching for one path per element, every phase of the
+// algorithm runs a breadth-first search from all the unpaired elements at
+// once, which assigns each element reachable along alternating edges its
+// distance (its layer) from them, and stops at the first layer that
+// reaches an unpaired matcher. A depth-first search from each unpaired
+// element then follows only the edges that go one layer deeper, so it
+// finds a maximal set of disjoint shortest augmenting paths. Each phase
+// takes O(E) time, and there are O(sqrt(V)) phases.
+//
+// Before the first phase, every element is greedily paired with its first
+// unpaired matcher. When that already pairs every element or every
+// matcher (for instance, when each element matches exactly one matcher
+// and no two elements share one) the matching is returned right away, so
+// the common case of a container that matches costs a single pass over
+// the rows of 'graph'.
 //
 // See Also:
-//   [1] Cormen, et al (2001). "Section 26.2: The Ford-Fulkerson method".
-//       "Introduction to Algorithms (Second ed.)", pp. 651-664.
-//   [2] "Ford-Fulkerson algorithm", Wikipedia,
-//       'http://en.wikipedia.org/wiki/Ford%E2%80%93Fulkerson_algorithm'
+//   [1] Hopcroft, J. E.; Karp, R. M. (1973). "An n^5/2 algorithm for
+//       maximum matchings in bipartite graphs". SIAM Journal on Computing.
+//       2 (4): 225-231.
+//   [2] "Hopcroft-Karp algorithm", Wikipedia,
+//       'https://en.wikipedia.org/wiki/Hopcroft%E2%80%93Karp_algorithm'
 class MaxBipartiteMatchState {
  public:
   explicit MaxBipartiteMatchState(const MatchMatrix& graph)
@@ -95,30 +74,16 @@ class MaxBipartiteMatchState {
         left_(graph_->LhsSize(), kUnused),
         right_(graph_->RhsSize(), kUnused) {}
 
-  // Returns the edges of a maximal match, each in the form {left, right}.
+  // Returns the edges of a maximal match, each in the form {left, right},
+  // in increasing order of the left node.
   ElementMatcherPairs Compute() {
-    // 'seen' is used for path finding { 0: unseen, 1: seen }.
-    ::std::vector<char> seen;
-    // Searches the residual flow graph for a path from each left node to
-    // the sink in the residual flow graph, and if one is found, add flow
-    // to the graph. It's okay to search through the left nodes once. The
-    // edge from the implicit source node to each previously-visited left
-    // node will have flow if that left node has any path to the sink
-    // whatsoever. Subsequent augmentations can only add flow to the
-    // network, and cannot take away that previous flow unit from the source.
-    // Since the source-to-left edge can only carry one flow unit (or,
-    // each element can be matched to only one matcher), there is no need
-    // to visit the left nodes more than once looking for augmented paths.
-    // The flow is known to be possible or impossible by looking at the
-    // node once.
-    for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
-      // Reset the path-marking vector and try to find a path from
-      // source to sink starting at the left_[ilhs] node.
-      GTEST_CHECK_(left_[ilhs] == kUnused)
-          << "ilhs: " << ilhs << ", left_[ilhs]: " << left_[ilhs];
-      // 'seen' initialized to 'graph_->RhsSize()' copies of 0.
-      seen.assign(graph_->RhsSize(), 0);
-      TryAugment(ilhs, &seen);
+    if (!MatchGreedily()) {
+      while (BuildLayers()) {
+        next_edge_.assign(graph_->LhsSize(), 0);
+        for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
+          if (left_[ilhs] == kUnused) TryAugment(ilhs);
+        }
+      }
     }
     ElementMatcherPairs result;
     for (size_t ilhs = 0; ilhs < left_.size(); ++ilhs) {
@@ -132,44 +97,89 @@ class MaxBipartiteMatchState {
  private:
   static const size_t kUnused = static_cast<size_t>(-1);
 
-  // Perform a depth-first search from left node ilhs to the sink.  If a
-  // path is found, flow is added to the network by linking the left and
-  // right vector elements corresponding each segment of the path.
-  // Returns true if a path to sink was found, which means that a unit of
-  // flow was added to the network. The 'seen' vector elements correspond
-  // to right nodes and are marked to eliminate cycles from the search.
-  //
-  // Left nodes will only be explored at most once because they
-  // are accessible from at most one right node in the residual flow
-  // graph.
-  //
-  // Note that left_[ilhs] is the only element of left_ that TryAugment will
-  // potentially transition from kUnused to another value. Any other
-  // left_ element holding kUnused before TryAugment will be holding it
-  // when TryAugment returns.
-  //
-  bool TryAugment(size_t ilhs, ::std::vector<char>* seen) {
-    for (size_t irhs = 0; irhs < graph_->RhsSize(); ++irhs) {
-      if ((*seen)[irhs]) continue;
-      if (!graph_->HasEdge(ilhs, irhs)) continue;
-      // There's an available edge from ilhs to irhs.
-      (*seen)[irhs] = 1;
-      // Next a search is performed to determine whether
-      // this edge is a dead end or leads to the sink.
-      //
-      // right_[irhs] == kUnused means that there is residual flow from
-      // right node irhs to the sink, so we can use that to finish this
-      // flow path and return success.
-      //
-      // Otherwise there is residual flow to some ilhs. We push flow
-      // along that path and call ourselves recursively to see if this
-      // ultimately leads to sink.
-      if (right_[irhs] == kUnused || TryAugment(right_[irhs], seen)) {
-        // Add flow from left_[ilhs] to right_[irhs].
+  // Pairs every element with the first of its matchers that is still
+  // unpaired.  Returns true if the result is known to be maximum because
+  // all the elements or all the matchers are paired.
+  bool MatchGreedily() {
+    size_t matched = 0;
+    for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
+      for (size_t irhs = graph_->NextEdge(ilhs, 0); irhs < graph_->RhsSize();
+           irhs = graph_->NextEdge(ilhs, irhs + 1)) {
+        if (right_[irhs] != kUnused) continue;
         left_[ilhs] = irhs;
         right_[irhs] = ilhs;
+        ++matched;
+        break;
+      }
+    }
+    return matched == graph_->LhsSize() || matched == graph_->RhsSize();
+  }
+
+  // Assigns each element its layer: 0 for the unpaired elements, and one
+  // more than the layer of element l for the element paired with a
+  // matcher that l has an edge to.  Elements that aren't reached before
+  // the first layer with an edge to an unpaired matcher are left at
+  // kUnused.  Returns true if an unpaired matcher was reached, which means
+  // that there is an augmenting path.
+  bool BuildLayers() {
+    layer_.assign(graph_->LhsSize(), kUnused);
+    queue_.clear();
+    for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
+      if (left_[ilhs] != kUnused) continue;
+      layer_[ilhs] = 0;
+      queue_.push_back(ilhs);
+    }
+    size_t shortest = kUnused;
+    for (size_t head = 0; head < queue_.size(); ++head) {
+      const size_t ilhs = queue_[head];
+      if (layer_[ilhs] >= shortest) break;
+      for (size_t irhs = graph_->NextEdge(ilhs, 0); irhs < graph_->RhsSize();
+           irhs = graph_->NextEdge(ilhs, irhs + 1)) {
+        const size_t next = right_[irhs];
+        if (next == kUnused) {
+          shortest = layer_[ilhs];
+        } else if (layer_[next] == kUnused) {
+          layer_[next] = layer_[ilhs] + 1;
+          queue_.push_back(next);
+        }
+      }
+    }
+    return shortest != kUnused;
+  }
+
+  // Performs a depth-first search from the unpaired element ilhs along
+  // edges that go one layer deeper, until it reaches an unpaired matcher.
+  // If a path is found, its edges are flipped, which pairs ilhs and grows
+  // the matching by one, and true is returned.
+  //
+  // The search keeps its own stack of elements, as the paths can be as
+  // long as the container. next_edge_[l] is the first matcher of element
+  // l that hasn't been tried yet in this phase, so the matcher that
+  // leads from a stacked element to the one above it is next_edge_[l] - 1.
+  // An element whose matchers are all tried is a dead end for the rest of
+  // the phase, which is recorded by taking it out of the layers.
+  bool TryAugment(size_t ilhs) {
+    path_.assign(1, ilhs);
+    while (!path_.empty()) {
+      const size_t current = path_.back();
+      const size_t irhs = graph_->NextEdge(current, next_edge_[current]);
+      if (irhs == graph_->RhsSize()) {
+        layer_[current] = kUnused;
+        path_.pop_back();
+        continue;
+      }
+      next_edge_[current] = irhs + 1;
+      const size_t next = right_[irhs];
+      if (next == kUnused) {
+        for (size_t i = 0; i < path_.size(); ++i) {
+          left_[path_[i]] = next_edge_[path_[i]] - 1;
+          right_[left_[path_[i]]] = path_[i];
+        }
         return true;
       }
+      if (layer_[next] == layer_[current] + 1) {
+        path_.push_back(next);
+      }
     }
     return false;
   }
@@ -177,18 +187,21 @@ class MaxBipartiteMatchState {
   const MatchMatrix* graph_;  // not owned
   // Each element of the left_ vector represents a left hand side node
   // (i.e. an element) and each element of right_ is a right hand side
-  // node (i.e. a matcher). The values in the left_ vector indicate
-  // outflow from that node to a node on the right_ side. The values
-  // in the right_ indicate inflow, and specify which left_ node is
-  // feeding that right_ node, if any. For example, left_[3] == 1 means
-  // there's a flow from element #3 to matcher #1. Such a flow would also
-  // be redundantly represented in the right_ vector as right_[1] == 3.
-  // Elements of left_ and right_ are either kUnused or mutually
-  // referent. Mutually referent means that left_[right_[i]] = i and
-  // right_[left_[i]] = i.
+  // node (i.e. a matcher). For example, left_[3] == 1 means that element
+  // #3 is paired with matcher #1, which is redundantly represented in the
+  // right_ vector as right_[1] == 3. Elements of left_ and right_ are
+  // either kUnused or mutually referent. Mutually referent means that
+  // left_[right_[i]] = i and right_[left_[i]] = i.
   ::std::vector<size_t> left_;
   ::std::vector<size_t> right_;
 
+  // Scratch space of a phase, indexed by left node (but for path_ and
+  // queue_, which hold left nodes); kept here to be reused by the phases.
+  ::std::vector<size_t> layer_;
+  ::std::vector<size_t> next_edge_;
+  ::std::vector<size_t> queue_;
+  ::std::vector<size_t> path_;
+
   GTEST_DISALLOW_ASSIGN_(MaxBipartiteMatchState);
 };
 
@@ -213,15 +226,36 @@ static void LogElementMatcherPairVec(const ElementMatcherPairs& pairs,
   os << "\n}";
 }
 
+size_t MatchMatrix::NextEdge(size_t ilhs, size_t irhs) const {
+  if (irhs >= RhsSize()) return RhsSize();
+  const Word* const row = &matched_[ilhs * words_per_row_];
+  size_t iword = irhs / kBitsPerWord;
+  // Drops the bits of the matchers before 'irhs'.
+  Word word = row[iword] & ~(BitMask(irhs) - 1);
+  while (word == 0) {
+    if (++iword == words_per_row_) return RhsSize();
+    word = row[iword];
+  }
+  size_t bit = 0;
+#if defined(__GNUC__)
+  bit = static_cast<size_t>(__builtin_ctzll(word));
+#else
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++bit;
+  }
+#endif
+  return iword * kBitsPerWord + bit;
+}
+
 bool MatchMatrix::NextGraph() {
   for (size_t ilhs = 0; ilhs < LhsSize(); ++ilhs) {
     for (size_t irhs = 0; irhs < RhsSize(); ++irhs) {
-      char& b = matched_[SpaceIndex(ilhs, irhs)];
-      if (!b) {
-        b = 1;
+      if (!HasEdge(ilhs, irhs)) {
+        SetEdge(ilhs, irhs, true);
         return true;
       }
-      b = 0;
+      SetEdge(ilhs, irhs, false);
     }
   }
   return false;
@@ -230,8 +264,7 @@ bool MatchMatrix::NextGraph() {
 void MatchMatrix::Randomize() {
   for (size_t ilhs = 0; ilhs < LhsSize(); ++ilhs) {
     for (size_t irhs = 0; irhs < RhsSize(); ++irhs) {
-      char& b = matched_[SpaceIndex(ilhs, irhs)];
-      b = static_cast<char>(rand() & 1);  // NOLINT
+      SetEdge(ilhs, irhs, (rand() & 1) != 0);  // NOLINT
     }
   }
 }
@@ -344,10 +377,10 @@ bool UnorderedElementsAreMatcherImplBase::VerifyMatchMatrix(
   ::std::vector<char> matcher_matched(matrix.RhsSize(), 0);
 
   for (size_t ilhs = 0; ilhs < matrix.LhsSize(); ilhs++) {
-    for (size_t irhs = 0; irhs < matrix.RhsSize(); irhs++) {
-      char matched = matrix.HasEdge(ilhs, irhs);
-      element_matched[ilhs] |= matched;
-      matcher_matched[irhs] |= matched;
+    for (size_t irhs = matrix.NextEdge(ilhs, 0); irhs < matrix.RhsSize();
+         irhs = matrix.NextEdge(ilhs, irhs + 1)) {
+      element_matched[ilhs] = 1;
+      matcher_matched[irhs] = 1;
     }
   }
 
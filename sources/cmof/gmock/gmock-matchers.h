@@ -14,6 +14,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <initializer_list>
 #include <iterator>
 #include <limits>
@@ -2803,18 +2804,34 @@ class JMSD_DEPRECATED_GMOCK_API_ MatchMatrix {
   MatchMatrix(size_t num_elements, size_t num_matchers)
       : num_elements_(num_elements),
         num_matchers_(num_matchers),
-        matched_(num_elements_* num_matchers_, 0) {
+        words_per_row_((num_matchers_ + kBitsPerWord - 1) / kBitsPerWord),
+        matched_(num_elements_ * words_per_row_, 0) {
   }
 
   size_t LhsSize() const { return num_elements_; }
   size_t RhsSize() const { return num_matchers_; }
+  // Adds an element without edges, so that a matrix can be filled in while
+  // walking a sequence whose length isn't known up front.
+  void AddLhs() {
+    ++num_elements_;
+    matched_.resize(num_elements_ * words_per_row_, 0);
+  }
   bool HasEdge(size_t ilhs, size_t irhs) const {
-    return matched_[SpaceIndex(ilhs, irhs)] == 1;
+    return (matched_[WordIndex(ilhs, irhs)] & BitMask(irhs)) != 0;
   }
   void SetEdge(size_t ilhs, size_t irhs, bool b) {
-    matched_[SpaceIndex(ilhs, irhs)] = b ? 1 : 0;
+    if (b) {
+      matched_[WordIndex(ilhs, irhs)] |= BitMask(irhs);
+    } else {
+      matched_[WordIndex(ilhs, irhs)] &= ~BitMask(irhs);
+    }
   }
 
+  // Returns the first matcher at or after 'irhs' that has an edge to
+  // element 'ilhs', or RhsSize() if there is none.  Skips a whole word of
+  // missing edges at a time, so walking a sparse row is cheap.
+  size_t NextEdge(size_t ilhs, size_t irhs) const;
+
   // Treating the connectivity matrix as a (LhsSize()*RhsSize())-bit number,
   // adds 1 to that number; returns false if incrementing the graph left it
   // empty.
@@ -2825,17 +2842,26 @@ class JMSD_DEPRECATED_GMOCK_API_ MatchMatrix {
   std::string DebugString() const;
 
  private:
-  size_t SpaceIndex(size_t ilhs, size_t irhs) const {
-    return ilhs * num_matchers_ + irhs;
+  typedef uint64_t Word;
+
+  static const size_t kBitsPerWord = 64;
+
+  size_t WordIndex(size_t ilhs, size_t irhs) const {
+    return ilhs * words_per_row_ + irhs / kBitsPerWord;
+  }
+  static Word BitMask(size_t irhs) {
+    return Word{1} << (irhs % kBitsPerWord);
   }
 
   size_t num_elements_;
   size_t num_matchers_;
+  size_t words_per_row_;
 
-  // Each element is a char interpreted as bool. They are stored as a
-  // flattened array in lhs-major order, use 'SpaceIndex()' to translate
-  // a (ilhs, irhs) matrix coordinate into an offset.
-  ::std::vector<char> matched_;
+  // Each bit is an edge. Every element owns 'words_per_row_' words, which
+  // are stored as a flattened array in lhs-major order; matcher 'irhs' is
+  // bit 'irhs % kBitsPerWord' of word 'irhs / kBitsPerWord' of its row.
+  // Use 'WordIndex()' and 'BitMask()' to locate a (ilhs, irhs) coordinate.
+  ::std::vector<Word> matched_;
 };
 
 typedef ::std::pair<size_t, size_t> ElementMatcherPair;
@@ -2918,7 +2944,11 @@ class UnorderedElementsAreMatcherImpl
       : UnorderedElementsAreMatcherImplBase(matcher_flags) {
     for (; first != last; ++first) {
       matchers_.push_back(MatcherCast<const Element&>(*first));
-      matcher_describers().push_back(matchers_.back().GetDescriber());
+    }
+    // A small describer lives inside its matcher, so the describers are
+    // only taken once growing matchers_ can no longer move them.
+    for (size_t i = 0; i != matchers_.size(); ++i) {
+      matcher_describers().push_back(matchers_[i].GetDescriber());
     }
   }
 
@@ -2967,24 +2997,17 @@ class UnorderedElementsAreMatcherImpl
                               ::std::vector<std::string>* element_printouts,
                               MatchResultListener* listener) const {
     element_printouts->clear();
-    ::std::vector<char> did_match;
-    size_t num_elements = 0;
+    MatchMatrix matrix(0, matchers_.size());
     DummyMatchResultListener dummy;
-    for (; elem_first != elem_last; ++num_elements, ++elem_first) {
+    for (size_t ilhs = 0; elem_first != elem_last; ++ilhs, ++elem_first) {
       if (listener->IsInterested()) {
         element_printouts->push_back(PrintToString(*elem_first));
       }
+      matrix.AddLhs();
       for (size_t irhs = 0; irhs != matchers_.size(); ++irhs) {
-        did_match.push_back(
-            matchers_[irhs].MatchAndExplain(*elem_first, &dummy));
-      }
-    }
-
-    MatchMatrix matrix(num_elements, matchers_.size());
-    ::std::vector<char>::const_iterator did_match_iter = did_match.begin();
-    for (size_t ilhs = 0; ilhs != num_elements; ++ilhs) {
-      for (size_t irhs = 0; irhs != matchers_.size(); ++irhs) {
-        matrix.SetEdge(ilhs, irhs, *did_match_iter++ != 0);
+        if (matchers_[irhs].MatchAndExplain(*elem_first, &dummy)) {
+          matrix.SetEdge(ilhs, irhs, true);
+        }
       }
     }
     return matrix;
@@ -3553,7 +3576,7 @@ const internal::AnythingMatcher _ = {};
 // Creates a matcher that matches any value of the given type T.
 template <typename T>
 inline Matcher<T> A() {
-  return Matcher<T>(new internal::AnyMatcherImpl<T>());
+  return Matcher<T>(internal::AnyMatcherImpl<T>());
 }
 
 // Creates a matcher that matches any value of the given type T.
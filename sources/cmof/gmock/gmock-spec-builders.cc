@@ -9,11 +9,14 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <iostream>
-#include <map>
 #include <memory>
-#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #if GTEST_OS_CYGWIN || GTEST_OS_LINUX || GTEST_OS_MAC
@@ -38,9 +41,11 @@ JMSD_DEPRECATED_GMOCK_API_ void LogWithLocation(testing::internal::LogSeverity s
 }
 
 // Constructs an ExpectationBase object.
-ExpectationBase::ExpectationBase(const char* a_file, int a_line,
+ExpectationBase::ExpectationBase(UntypedFunctionMockerBase* owner,
+                                 const char* a_file, int a_line,
                                  const std::string& a_source_text)
-    : file_(a_file),
+    : untyped_owner_(owner),
+      file_(a_file),
       line_(a_line),
       source_text_(a_source_text),
       cardinality_specified_(false),
@@ -63,6 +68,30 @@ void ExpectationBase::SpecifyCardinality(const Cardinality& a_cardinality) {
   cardinality_ = a_cardinality;
 }
 
+// Makes prerequisite an immediate pre-requisite of this expectation.
+void ExpectationBase::AddPrerequisite(const Expectation& prerequisite)
+    GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  immediate_prerequisites_ += prerequisite;
+
+  // Matching this expectation reads (and retires) the pre-requisite,
+  // so both mock functions have to be serialized by the same lock.
+  UntypedFunctionMockerBase* const prerequisite_owner =
+      prerequisite.expectation_base()->untyped_owner_;
+  if (prerequisite_owner != untyped_owner_) {
+    if (untyped_owner_ != nullptr) untyped_owner_->ShareGlobalLock();
+    if (prerequisite_owner != nullptr) prerequisite_owner->ShareGlobalLock();
+  }
+}
+
+// Asserts that the state lock of the owning mock function is held.
+void ExpectationBase::AssertStateLockHeld() const {
+  if (untyped_owner_ == nullptr) {
+    g_gmock_mutex.AssertHeld();
+  } else {
+    untyped_owner_->AssertStateLockHeld();
+  }
+}
+
 // Retires all pre-requisites of this expectation.
 void ExpectationBase::RetireAllPreRequisites()
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
@@ -93,7 +122,7 @@ void ExpectationBase::RetireAllPreRequisites()
 // have been satisfied.
 bool ExpectationBase::AllPrerequisitesAreSatisfied() const
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-  g_gmock_mutex.AssertHeld();
+  AssertStateLockHeld();
   ::std::vector<const ExpectationBase*> expectations(1, this);
   while (!expectations.empty()) {
     const ExpectationBase* exp = expectations.back();
@@ -113,7 +142,7 @@ bool ExpectationBase::AllPrerequisitesAreSatisfied() const
 // Adds unsatisfied pre-requisites of this expectation to 'result'.
 void ExpectationBase::FindUnsatisfiedPrerequisites(ExpectationSet* result) const
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-  g_gmock_mutex.AssertHeld();
+  AssertStateLockHeld();
   ::std::vector<const ExpectationBase*> expectations(1, this);
   while (!expectations.empty()) {
     const ExpectationBase* exp = expectations.back();
@@ -144,7 +173,7 @@ void ExpectationBase::FindUnsatisfiedPrerequisites(ExpectationSet* result) const
 // expectation has occurred.
 void ExpectationBase::DescribeCallCountTo(::std::ostream* os) const
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-  g_gmock_mutex.AssertHeld();
+  AssertStateLockHeld();
 
   // Describes how many times the function is expected to be called.
   *os << "         Expected: to be ";
@@ -265,7 +294,7 @@ void ReportUninterestingCall(CallReaction reaction, const std::string& msg) {
 }
 
 UntypedFunctionMockerBase::UntypedFunctionMockerBase()
-    : mock_obj_(nullptr), name_("") {}
+    : mock_obj_(nullptr), name_(""), shares_global_lock_(false) {}
 
 UntypedFunctionMockerBase::~UntypedFunctionMockerBase() {}
 
@@ -275,10 +304,7 @@ UntypedFunctionMockerBase::~UntypedFunctionMockerBase() {}
 // method.
 void UntypedFunctionMockerBase::RegisterOwner(const void* mock_obj)
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  {
-    MutexLock l(&g_gmock_mutex);
-    mock_obj_ = mock_obj;
-  }
+  mock_obj_ = mock_obj;
   Mock::Register(mock_obj, this);
 }
 
@@ -288,27 +314,24 @@ void UntypedFunctionMockerBase::RegisterOwner(const void* mock_obj)
 void UntypedFunctionMockerBase::SetOwnerAndName(const void* mock_obj,
                                                 const char* name)
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  // We protect name_ under g_gmock_mutex in case this mock function
-  // is called from two threads concurrently.
-  MutexLock l(&g_gmock_mutex);
-  mock_obj_ = mock_obj;
-  name_ = name;
+  // The values hardly ever change, so concurrent calls of this mock
+  // function only read the shared cache line.
+  if (mock_obj_.load(std::memory_order_relaxed) != mock_obj) {
+    mock_obj_ = mock_obj;
+  }
+  if (name_.load(std::memory_order_relaxed) != name) {
+    name_ = name;
+  }
 }
 
 // Returns the name of the function being mocked.  Must be called
 // after RegisterOwner() or SetOwnerAndName() has been called.
 const void* UntypedFunctionMockerBase::MockObject() const
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  const void* mock_obj;
-  {
-    // We protect mock_obj_ under g_gmock_mutex in case this mock
-    // function is called from two threads concurrently.
-    MutexLock l(&g_gmock_mutex);
-    Assert(mock_obj_ != nullptr, __FILE__, __LINE__,
-           "MockObject() must not be called before RegisterOwner() or "
-           "SetOwnerAndName() has been called.");
-    mock_obj = mock_obj_;
-  }
+  const void* const mock_obj = mock_obj_;
+  Assert(mock_obj != nullptr, __FILE__, __LINE__,
+         "MockObject() must not be called before RegisterOwner() or "
+         "SetOwnerAndName() has been called.");
   return mock_obj;
 }
 
@@ -316,19 +339,51 @@ const void* UntypedFunctionMockerBase::MockObject() const
 // SetOwnerAndName() has been called.
 const char* UntypedFunctionMockerBase::Name() const
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  const char* name;
-  {
-    // We protect name_ under g_gmock_mutex in case this mock
-    // function is called from two threads concurrently.
-    MutexLock l(&g_gmock_mutex);
-    Assert(name_ != nullptr, __FILE__, __LINE__,
-           "Name() must not be called before SetOwnerAndName() has "
-           "been called.");
-    name = name_;
-  }
+  const char* const name = name_;
+  Assert(name != nullptr, __FILE__, __LINE__,
+         "Name() must not be called before SetOwnerAndName() has "
+         "been called.");
   return name;
 }
 
+// Makes g_gmock_mutex the state lock of this mock function.
+void UntypedFunctionMockerBase::ShareGlobalLock()
+    GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  if (shares_global_lock_) return;
+
+  // Waits for any call holding state_mutex_ to finish; later ones see
+  // the flag set and take g_gmock_mutex instead.
+  MutexLock global_lock(&g_gmock_mutex);
+  MutexLock state_lock(&state_mutex_);
+  shares_global_lock_ = true;
+}
+
+// Asserts that the current thread holds the state lock.
+void UntypedFunctionMockerBase::AssertStateLockHeld() const {
+  if (shares_global_lock_) {
+    g_gmock_mutex.AssertHeld();
+  } else {
+    state_mutex_.AssertHeld();
+  }
+}
+
+// Acquires the state lock and returns it.
+MutexBase* UntypedFunctionMockerBase::LockState() const
+    GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  if (!shares_global_lock_) {
+    state_mutex_.Lock();
+    // The flag only changes while state_mutex_ is held, so it can be
+    // trusted now.
+    if (!shares_global_lock_) return &state_mutex_;
+    state_mutex_.Unlock();
+  }
+
+  // Once set, the flag never goes back, so g_gmock_mutex stays the
+  // state lock after this.
+  g_gmock_mutex.Lock();
+  return &g_gmock_mutex;
+}
+
 // Calculates the result of invoking this mock function with the given
 // arguments, prints it, and returns it.  The caller is responsible
 // for deleting the result.
@@ -384,10 +439,15 @@ UntypedActionResultHolderBase* UntypedFunctionMockerBase::UntypedInvokeWith(
     return result;
   }
 
+  // Decided before looking for the expectation, so that a matching
+  // call is only described when the description will be logged.
+  const bool is_info_visible = LogIsVisible(kInfo);
+
   bool is_excessive = false;
-  ::std::stringstream ss;
-  ::std::stringstream why;
-  ::std::stringstream loc;
+  // Nothing is written to these (and they construct no stream) unless
+  // the call has to be reported; see need_to_report_call below.
+  LazyStringStream what;
+  LazyStringStream why;
   const void* untyped_action = nullptr;
 
   // The UntypedFindMatchingExpectation() function acquires and
@@ -395,7 +455,7 @@ UntypedActionResultHolderBase* UntypedFunctionMockerBase::UntypedInvokeWith(
   const ExpectationBase* const untyped_expectation =
       this->UntypedFindMatchingExpectation(
           untyped_args, &untyped_action, &is_excessive,
-          &ss, &why);
+          is_info_visible, &what, &why);
   const bool found = untyped_expectation != nullptr;
 
   // True if and only if we need to print the call's arguments
@@ -403,7 +463,7 @@ UntypedActionResultHolderBase* UntypedFunctionMockerBase::UntypedInvokeWith(
   // This definition must be kept in sync with the uses of Expect()
   // and Log() in this function.
   const bool need_to_report_call =
-      !found || is_excessive || LogIsVisible(kInfo);
+      !found || is_excessive || is_info_visible;
   if (!need_to_report_call) {
     // Perform the action without printing the call information.
     return untyped_action == nullptr
@@ -411,7 +471,9 @@ UntypedActionResultHolderBase* UntypedFunctionMockerBase::UntypedInvokeWith(
                : this->UntypedPerformAction(untyped_action, untyped_args);
   }
 
-  ss << "    Function call: " << Name();
+  ::std::stringstream ss;
+  ::std::stringstream loc;
+  ss << what.str() << "    Function call: " << Name();
   this->UntypedPrintArgs(untyped_args, &ss);
 
   // In case the action deletes a piece of the expectation, we
@@ -468,6 +530,9 @@ Expectation UntypedFunctionMockerBase::GetHandleOf(ExpectationBase* exp) {
 bool UntypedFunctionMockerBase::VerifyAndClearExpectationsLocked()
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
   g_gmock_mutex.AssertHeld();
+  // Holding both locks excludes calls of this mock function whichever
+  // its state lock is (g_gmock_mutex comes first in the lock order).
+  state_mutex_.Lock();
   bool expectations_met = true;
   for (UntypedExpectations::const_iterator it =
            untyped_expectations_.begin();
@@ -502,7 +567,18 @@ bool UntypedFunctionMockerBase::VerifyAndClearExpectationsLocked()
   // copied set outside of it.
   UntypedExpectations expectations_to_delete;
   untyped_expectations_.swap(expectations_to_delete);
+  ClearExpectationIndexLocked();
 
+  // Expectations kept alive as pre-requisites of other mock functions'
+  // expectations are from now on protected by g_gmock_mutex (those
+  // functions share it already).
+  for (UntypedExpectations::const_iterator it =
+           expectations_to_delete.begin();
+       it != expectations_to_delete.end(); ++it) {
+    (*it)->untyped_owner_ = nullptr;
+  }
+
+  state_mutex_.Unlock();
   g_gmock_mutex.Unlock();
   expectations_to_delete.clear();
   g_gmock_mutex.Lock();
@@ -523,95 +599,406 @@ CallReaction intToCallReaction(int mock_behavior) {
 
 namespace {
 
-typedef std::set<internal::UntypedFunctionMockerBase*> FunctionMockers;
+// The mock methods of a mock object, in the order of their addresses.
+typedef std::vector<internal::UntypedFunctionMockerBase*> FunctionMockers;
+
+// The names of a test, kept for reporting the mock objects first used
+// in it that are leaked.
+struct TestNames {
+  ::std::string test_suite;
+  ::std::string test;
+};
 
 // The current state of a mock object.  Such information is needed for
 // detecting leaked mock objects and explicitly verifying a mock's
 // expectations.
 struct MockObjectState {
   MockObjectState()
-      : first_used_file(nullptr), first_used_line(-1), leakable(false) {}
+      : first_used_file(nullptr),
+        first_used_line(-1),
+        first_used_test(nullptr),
+        leakable(false) {}
 
   // Where in the source file an ON_CALL or EXPECT_CALL is first
   // invoked on this mock object.
   const char* first_used_file;
   int first_used_line;
-  ::std::string first_used_test_suite;
-  ::std::string first_used_test;
+  // The test it was invoked in, or NULL outside of tests.
+  const TestNames* first_used_test;
   bool leakable;  // true if and only if it's OK to leak the object.
   FunctionMockers function_mockers;  // All registered methods of the object.
 };
 
 // A global registry holding the state of all mock objects that are
-// alive.  A mock object is added to this registry the first time
-// Mock::AllowLeak(), ON_CALL(), or EXPECT_CALL() is called on it.  It
-// is removed from the registry in the mock object's destructor.
+// alive, and the reaction to uninteresting calls of the nice, naggy and
+// strict ones.  A mock object is registered the first time
+// Mock::AllowLeak(), ON_CALL(), or EXPECT_CALL() is called on it, and
+// gets a reaction when NiceMock, NaggyMock or StrictMock wraps it.  Both
+// are removed in the mock object's destructor.
+//
+// The mock objects are kept in an open-addressing hash table keyed by
+// their addresses.  Only the registered ones allocate a MockObjectState,
+// so creating and destroying a nice or strict mock without expectations
+// doesn't allocate at all.  The writers hold g_gmock_mutex.  The reaction
+// to uninteresting calls is read on every such call, without a lock: a
+// writer makes the version odd while it changes the table, and a reader
+// tries again until the version was even and the same before and after
+// its lookup.
 class MockObjectRegistry {
  public:
-  // Maps a mock object (identified by its address) to its state.
-  typedef std::map<const void*, MockObjectState> StateMap;
+  MockObjectRegistry();
 
   // This destructor will be called when a program exits, after all
   // tests in it have been run.  By then, there should be no mock
   // object alive.  Therefore we report any living object as test
   // failure, unless the user explicitly asked us to ignore it.
-  ~MockObjectRegistry() {
-    if (!GMOCK_FLAG(catch_leaked_mocks))
-      return;
+  ~MockObjectRegistry();
+
+  // Finds the reaction to uninteresting calls set for the given mock
+  // object.  Returns false if there is none.  Doesn't need a lock.
+  bool FindReaction(const void* mock_obj,
+                    internal::CallReaction* reaction) const;
+
+  // Sets the reaction to uninteresting calls of the given mock object.
+  void SetReaction(const void* mock_obj, internal::CallReaction reaction)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
+
+  // Removes the reaction to uninteresting calls of the given mock object.
+  void EraseReaction(const void* mock_obj)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
+
+  // Returns the state of the given mock object, or NULL if it isn't
+  // registered.
+  MockObjectState* FindState(const void* mock_obj)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
 
-    int leaked_count = 0;
-    for (StateMap::const_iterator it = states_.begin(); it != states_.end();
-         ++it) {
-      if (it->second.leakable)  // The user said it's fine to leak this object.
-        continue;
+  // Returns the state of the given mock object, registering it first if
+  // needed.
+  MockObjectState& GetState(const void* mock_obj)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
+
+  // Unregisters the given mock object.
+  void EraseState(const void* mock_obj)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
+
+  // Returns the names of the given test, copied once per test.
+  const TestNames* InternTestNames(const ::jmsd::cutf::TestInfo* test_info)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
+
+ private:
+  // The reaction of a mock object that doesn't have one.
+  static constexpr int kNoReaction = -1;
+
+  static constexpr size_t kInitialCapacity = 64;
+
+  // A mock object in the table.  Empty when mock_obj is NULL.
+  struct Slot {
+    std::atomic<const void*> mock_obj;
+    std::atomic<int> reaction;
+    MockObjectState* state;  // Owned; NULL if not registered.
+  };
+
+  struct Table {
+    explicit Table(size_t capacity);
+
+    size_t mask;  // The capacity, a power of two, minus one.
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  static size_t Hash(const void* mock_obj);
+
+  // Copies the slot from into the slot to.
+  static void Move(const Slot& from, Slot* to);
+
+  // Makes the version odd, then even again: the readers wait for
+  // EndWrite() and read the table again if it changed.
+  void BeginWrite();
+  void EndWrite();
+
+  // Returns the slot of the given mock object, or NULL.
+  Slot* Find(const void* mock_obj) const;
+
+  // Adds the given mock object, which isn't in the table, and returns
+  // its slot.  Called between BeginWrite() and EndWrite().
+  Slot* Insert(const void* mock_obj);
+
+  // Empties the slot, moving back the slots after it that are out of
+  // their place, so that the lookups stop at the first empty slot.
+  // Called between BeginWrite() and EndWrite().
+  void Erase(Slot* slot);
+
+  // Rehashes the table into one twice as large.
+  void Grow();
+
+  std::atomic<size_t> version_;
+  std::atomic<Table*> table_;
+  // Every table used so far: readers may still be probing an old one.
+  // Their total size is less than twice the size of the last one.
+  std::vector<std::unique_ptr<Table> > tables_;
+  size_t size_;
+
+  std::unordered_map<const ::jmsd::cutf::TestInfo*, TestNames> test_names_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(MockObjectRegistry);
+};
+
+MockObjectRegistry::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new Slot[capacity]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].mock_obj.store(nullptr, std::memory_order_relaxed);
+    slots[i].reaction.store(kNoReaction, std::memory_order_relaxed);
+    slots[i].state = nullptr;
+  }
+}
 
+MockObjectRegistry::MockObjectRegistry() : version_(0), size_(0) {
+  tables_.emplace_back(new Table(kInitialCapacity));
+  table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+MockObjectRegistry::~MockObjectRegistry() {
+  const Table& table = *table_.load(std::memory_order_relaxed);
+
+  // Reports the leaked objects in the order of their addresses.
+  std::vector<const Slot*> leaked;
+  for (size_t i = 0; i <= table.mask; ++i) {
+    const MockObjectState* const state = table.slots[i].state;
+    // The user said it's fine to leak this object.
+    if (state != nullptr && !state->leakable) {
+      leaked.push_back(&table.slots[i]);
+    }
+  }
+
+  if (GMOCK_FLAG(catch_leaked_mocks) && !leaked.empty()) {
+    std::sort(leaked.begin(), leaked.end(), [](const Slot* a, const Slot* b) {
+      return std::less<const void*>()(a->mock_obj.load(std::memory_order_relaxed),
+                                      b->mock_obj.load(std::memory_order_relaxed));
+    });
+
+    for (const Slot* const slot : leaked) {
       // FIXME: Print the type of the leaked object.
       // This can help the user identify the leaked object.
       std::cout << "\n";
-      const MockObjectState& state = it->second;
+      const MockObjectState& state = *slot->state;
       std::cout << internal::FormatFileLocation(state.first_used_file,
                                                 state.first_used_line);
       std::cout << " ERROR: this mock object";
-      if (state.first_used_test != "") {
-        std::cout << " (used in test " << state.first_used_test_suite << "."
-                  << state.first_used_test << ")";
+      if (state.first_used_test != nullptr) {
+        std::cout << " (used in test " << state.first_used_test->test_suite
+                  << "." << state.first_used_test->test << ")";
       }
       std::cout << " should be deleted but never is. Its address is @"
-           << it->first << ".";
-      leaked_count++;
+           << slot->mock_obj.load(std::memory_order_relaxed) << ".";
     }
-    if (leaked_count > 0) {
-      std::cout << "\nERROR: " << leaked_count << " leaked mock "
-                << (leaked_count == 1 ? "object" : "objects")
-                << " found at program exit. Expectations on a mock object is "
-                   "verified when the object is destructed. Leaking a mock "
-                   "means that its expectations aren't verified, which is "
-                   "usually a test bug. If you really intend to leak a mock, "
-                   "you can suppress this error using "
-                   "testing::Mock::AllowLeak(mock_object), or you may use a "
-                   "fake or stub instead of a mock.\n";
-      std::cout.flush();
-      ::std::cerr.flush();
-      // RUN_ALL_TESTS() has already returned when this destructor is
-      // called.  Therefore we cannot use the normal Google Test
-      // failure reporting mechanism.
-      _exit(1);  // We cannot call exit() as it is not reentrant and
-                 // may already have been called.
+    std::cout << "\nERROR: " << leaked.size() << " leaked mock "
+              << (leaked.size() == 1 ? "object" : "objects")
+              << " found at program exit. Expectations on a mock object is "
+                 "verified when the object is destructed. Leaking a mock "
+                 "means that its expectations aren't verified, which is "
+                 "usually a test bug. If you really intend to leak a mock, "
+                 "you can suppress this error using "
+                 "testing::Mock::AllowLeak(mock_object), or you may use a "
+                 "fake or stub instead of a mock.\n";
+    std::cout.flush();
+    ::std::cerr.flush();
+    // RUN_ALL_TESTS() has already returned when this destructor is
+    // called.  Therefore we cannot use the normal Google Test
+    // failure reporting mechanism.
+    _exit(1);  // We cannot call exit() as it is not reentrant and
+               // may already have been called.
+  }
+
+  for (size_t i = 0; i <= table.mask; ++i) {
+    delete table.slots[i].state;
+  }
+}
+
+bool MockObjectRegistry::FindReaction(const void* mock_obj,
+                                      internal::CallReaction* reaction) const {
+  for (;;) {
+    const size_t version = version_.load(std::memory_order_acquire);
+    if (version % 2 != 0) continue;  // A writer is changing the table.
+
+    const Table& table = *table_.load(std::memory_order_acquire);
+    int found = kNoReaction;
+    // Bounded, as a table changed under the reader may have no empty slot.
+    for (size_t i = Hash(mock_obj) & table.mask, probes = 0;
+         probes <= table.mask; i = (i + 1) & table.mask, ++probes) {
+      const void* const key = table.slots[i].mock_obj.load(std::memory_order_relaxed);
+      if (key == mock_obj) {
+        found = table.slots[i].reaction.load(std::memory_order_relaxed);
+        break;
+      }
+      if (key == nullptr) break;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (version_.load(std::memory_order_relaxed) == version) {
+      if (found == kNoReaction) return false;
+      *reaction = static_cast<internal::CallReaction>(found);
+      return true;
     }
   }
+}
 
-  StateMap& states() { return states_; }
+void MockObjectRegistry::SetReaction(const void* mock_obj,
+                                     internal::CallReaction reaction) {
+  BeginWrite();
+  Slot* slot = Find(mock_obj);
+  if (slot == nullptr) slot = Insert(mock_obj);
+  slot->reaction.store(reaction, std::memory_order_relaxed);
+  EndWrite();
+}
 
- private:
-  StateMap states_;
-};
+void MockObjectRegistry::EraseReaction(const void* mock_obj) {
+  Slot* const slot = Find(mock_obj);
+  if (slot == nullptr) return;
 
-// Protected by g_gmock_mutex.
-MockObjectRegistry g_mock_object_registry;
+  BeginWrite();
+  slot->reaction.store(kNoReaction, std::memory_order_relaxed);
+  if (slot->state == nullptr) Erase(slot);
+  EndWrite();
+}
+
+MockObjectState* MockObjectRegistry::FindState(const void* mock_obj) {
+  Slot* const slot = Find(mock_obj);
+  return slot == nullptr ? nullptr : slot->state;
+}
+
+MockObjectState& MockObjectRegistry::GetState(const void* mock_obj) {
+  Slot* slot = Find(mock_obj);
+  if (slot == nullptr) {
+    BeginWrite();
+    slot = Insert(mock_obj);
+    EndWrite();
+  }
+  if (slot->state == nullptr) slot->state = new MockObjectState;
+  return *slot->state;
+}
+
+void MockObjectRegistry::EraseState(const void* mock_obj) {
+  Slot* const slot = Find(mock_obj);
+  if (slot == nullptr || slot->state == nullptr) return;
+
+  delete slot->state;
+  slot->state = nullptr;
+  if (slot->reaction.load(std::memory_order_relaxed) == kNoReaction) {
+    BeginWrite();
+    Erase(slot);
+    EndWrite();
+  }
+}
 
-// Maps a mock object to the reaction Google Mock should have when an
-// uninteresting method is called.  Protected by g_gmock_mutex.
-std::map<const void*, internal::CallReaction> g_uninteresting_call_reaction;
+const TestNames* MockObjectRegistry::InternTestNames(
+    const ::jmsd::cutf::TestInfo* test_info) {
+  TestNames& names = test_names_[test_info];
+  if (names.test.empty()) {
+    names.test_suite = test_info->test_suite_name();
+    names.test = test_info->name();
+  }
+  return &names;
+}
+
+// static
+size_t MockObjectRegistry::Hash(const void* mock_obj) {
+  // Mock objects are aligned, so the low bits of their addresses are
+  // mostly zero; the multiplication mixes the high ones into the bits the
+  // mask keeps.
+  const uint64_t address = reinterpret_cast<uintptr_t>(mock_obj);
+  return static_cast<size_t>((address * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// static
+void MockObjectRegistry::Move(const Slot& from, Slot* to) {
+  to->mock_obj.store(from.mock_obj.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+  to->reaction.store(from.reaction.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+  to->state = from.state;
+}
+
+void MockObjectRegistry::BeginWrite() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void MockObjectRegistry::EndWrite() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+}
+
+MockObjectRegistry::Slot* MockObjectRegistry::Find(const void* mock_obj) const {
+  const Table& table = *table_.load(std::memory_order_relaxed);
+  for (size_t i = Hash(mock_obj) & table.mask;; i = (i + 1) & table.mask) {
+    const void* const key = table.slots[i].mock_obj.load(std::memory_order_relaxed);
+    if (key == mock_obj) return &table.slots[i];
+    if (key == nullptr) return nullptr;
+  }
+}
+
+MockObjectRegistry::Slot* MockObjectRegistry::Insert(const void* mock_obj) {
+  // Keeps at least half of the slots empty, so that probes stay short.
+  if ((size_ + 1) * 2 > table_.load(std::memory_order_relaxed)->mask + 1) {
+    Grow();
+  }
+
+  const Table& table = *table_.load(std::memory_order_relaxed);
+  size_t i = Hash(mock_obj) & table.mask;
+  while (table.slots[i].mock_obj.load(std::memory_order_relaxed) != nullptr) {
+    i = (i + 1) & table.mask;
+  }
+
+  table.slots[i].mock_obj.store(mock_obj, std::memory_order_relaxed);
+  ++size_;
+  return &table.slots[i];
+}
+
+void MockObjectRegistry::Erase(Slot* const slot) {
+  const Table& table = *table_.load(std::memory_order_relaxed);
+  size_t hole = static_cast<size_t>(slot - table.slots.get());
+
+  for (size_t i = (hole + 1) & table.mask;; i = (i + 1) & table.mask) {
+    const void* const key = table.slots[i].mock_obj.load(std::memory_order_relaxed);
+    if (key == nullptr) break;
+
+    // The slot can fill the hole if the hole lies between the slot's
+    // home and the slot.
+    const size_t home = Hash(key) & table.mask;
+    if (((i - home) & table.mask) >= ((i - hole) & table.mask)) {
+      Move(table.slots[i], &table.slots[hole]);
+      hole = i;
+    }
+  }
+
+  table.slots[hole].mock_obj.store(nullptr, std::memory_order_relaxed);
+  table.slots[hole].reaction.store(kNoReaction, std::memory_order_relaxed);
+  table.slots[hole].state = nullptr;
+  --size_;
+}
+
+void MockObjectRegistry::Grow() {
+  const Table& table = *table_.load(std::memory_order_relaxed);
+  Table* const grown = new Table((table.mask + 1) * 2);
+
+  for (size_t i = 0; i <= table.mask; ++i) {
+    const void* const key = table.slots[i].mock_obj.load(std::memory_order_relaxed);
+    if (key == nullptr) continue;
+
+    size_t j = Hash(key) & grown->mask;
+    while (grown->slots[j].mock_obj.load(std::memory_order_relaxed) != nullptr) {
+      j = (j + 1) & grown->mask;
+    }
+    Move(table.slots[i], &grown->slots[j]);
+  }
+
+  tables_.emplace_back(grown);
+  table_.store(grown, std::memory_order_release);
+}
+
+// Protected by g_gmock_mutex, except for
+// MockObjectRegistry::FindReaction().
+MockObjectRegistry g_mock_object_registry;
 
 // Sets the reaction Google Mock should have when an uninteresting
 // method of the given mock object is called.
@@ -619,7 +1006,7 @@ void SetReactionOnUninterestingCalls(const void* mock_obj,
                                      internal::CallReaction reaction)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
   internal::MutexLock l(&internal::g_gmock_mutex);
-  g_uninteresting_call_reaction[mock_obj] = reaction;
+  g_mock_object_registry.SetReaction(mock_obj, reaction);
 }
 
 }  // namespace
@@ -650,18 +1037,18 @@ void Mock::FailUninterestingCalls(const void* mock_obj)
 void Mock::UnregisterCallReaction(const void* mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
   internal::MutexLock l(&internal::g_gmock_mutex);
-  g_uninteresting_call_reaction.erase(mock_obj);
+  g_mock_object_registry.EraseReaction(mock_obj);
 }
 
 // Returns the reaction Google Mock will have on uninteresting calls
-// made on the given mock object.
+// made on the given mock object.  Doesn't take g_gmock_mutex.
 internal::CallReaction Mock::GetReactionOnUninterestingCalls(
     const void* mock_obj)
         GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  return (g_uninteresting_call_reaction.count(mock_obj) == 0) ?
-      internal::intToCallReaction(GMOCK_FLAG(default_mock_behavior)) :
-      g_uninteresting_call_reaction[mock_obj];
+  internal::CallReaction reaction;
+  return g_mock_object_registry.FindReaction(mock_obj, &reaction) ?
+      reaction :
+      internal::intToCallReaction(GMOCK_FLAG(default_mock_behavior));
 }
 
 // Tells Google Mock to ignore mock_obj when checking for leaked mock
@@ -669,7 +1056,7 @@ internal::CallReaction Mock::GetReactionOnUninterestingCalls(
 void Mock::AllowLeak(const void* mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
   internal::MutexLock l(&internal::g_gmock_mutex);
-  g_mock_object_registry.states()[mock_obj].leakable = true;
+  g_mock_object_registry.GetState(mock_obj).leakable = true;
 }
 
 // Verifies and clears all expectations on the given mock object.  If
@@ -697,7 +1084,8 @@ bool Mock::VerifyAndClear(void* mock_obj)
 bool Mock::VerifyAndClearExpectationsLocked(void* mock_obj)
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex) {
   internal::g_gmock_mutex.AssertHeld();
-  if (g_mock_object_registry.states().count(mock_obj) == 0) {
+  MockObjectState* const state = g_mock_object_registry.FindState(mock_obj);
+  if (state == nullptr) {
     // No EXPECT_CALL() was set on the given mock object.
     return true;
   }
@@ -705,8 +1093,7 @@ bool Mock::VerifyAndClearExpectationsLocked(void* mock_obj)
   // Verifies and clears the expectations on each mock method in the
   // given mock object.
   bool expectations_met = true;
-  FunctionMockers& mockers =
-      g_mock_object_registry.states()[mock_obj].function_mockers;
+  FunctionMockers& mockers = state->function_mockers;
   for (FunctionMockers::const_iterator it = mockers.begin();
        it != mockers.end(); ++it) {
     if (!(*it)->VerifyAndClearExpectationsLocked()) {
@@ -737,7 +1124,13 @@ void Mock::Register(const void* mock_obj,
                     internal::UntypedFunctionMockerBase* mocker)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
   internal::MutexLock l(&internal::g_gmock_mutex);
-  g_mock_object_registry.states()[mock_obj].function_mockers.insert(mocker);
+  FunctionMockers& mockers =
+      g_mock_object_registry.GetState(mock_obj).function_mockers;
+  const FunctionMockers::iterator it =
+      std::lower_bound(mockers.begin(), mockers.end(), mocker);
+  if (it == mockers.end() || *it != mocker) {
+    mockers.insert(it, mocker);
+  }
 }
 
 // Tells Google Mock where in the source code mock_obj is used in an
@@ -747,14 +1140,13 @@ void Mock::RegisterUseByOnCallOrExpectCall(const void* mock_obj,
                                            const char* file, int line)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
   internal::MutexLock l(&internal::g_gmock_mutex);
-  MockObjectState& state = g_mock_object_registry.states()[mock_obj];
+  MockObjectState& state = g_mock_object_registry.GetState(mock_obj);
   if (state.first_used_file == nullptr) {
     state.first_used_file = file;
     state.first_used_line = line;
     const ::jmsd::cutf::TestInfo* const test_info = ::jmsd::cutf::UnitTest::GetInstance()->current_test_info();
     if (test_info != nullptr) {
-      state.first_used_test_suite = test_info->test_suite_name();
-      state.first_used_test = test_info->name();
+      state.first_used_test = g_mock_object_registry.InternTestNames(test_info);
     }
   }
 }
@@ -762,21 +1154,27 @@ void Mock::RegisterUseByOnCallOrExpectCall(const void* mock_obj,
 // Unregisters a mock method; removes the owning mock object from the
 // registry when the last mock method associated with it has been
 // unregistered.  This is called only in the destructor of
-// FunctionMockerBase.
+// FunctionMocker.
 void Mock::UnregisterLocked(internal::UntypedFunctionMockerBase* mocker)
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex) {
   internal::g_gmock_mutex.AssertHeld();
-  for (MockObjectRegistry::StateMap::iterator it =
-           g_mock_object_registry.states().begin();
-       it != g_mock_object_registry.states().end(); ++it) {
-    FunctionMockers& mockers = it->second.function_mockers;
-    if (mockers.erase(mocker) > 0) {
-      // mocker was in mockers and has been just removed.
-      if (mockers.empty()) {
-        g_mock_object_registry.states().erase(it);
-      }
-      return;
-    }
+  // A mock method is registered with the object it's a member of, which
+  // is the one it knows.  It knows none if it was never used.
+  const void* const mock_obj = mocker->mock_obj_.load(std::memory_order_relaxed);
+  if (mock_obj == nullptr) return;
+
+  MockObjectState* const state = g_mock_object_registry.FindState(mock_obj);
+  if (state == nullptr) return;
+
+  FunctionMockers& mockers = state->function_mockers;
+  const FunctionMockers::iterator it =
+      std::lower_bound(mockers.begin(), mockers.end(), mocker);
+  if (it == mockers.end() || *it != mocker) return;
+
+  // mocker was in mockers and is now removed.
+  mockers.erase(it);
+  if (mockers.empty()) {
+    g_mock_object_registry.EraseState(mock_obj);
   }
 }
 
@@ -785,15 +1183,15 @@ void Mock::ClearDefaultActionsLocked(void* mock_obj)
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex) {
   internal::g_gmock_mutex.AssertHeld();
 
-  if (g_mock_object_registry.states().count(mock_obj) == 0) {
+  MockObjectState* const state = g_mock_object_registry.FindState(mock_obj);
+  if (state == nullptr) {
     // No ON_CALL() was set on the given mock object.
     return;
   }
 
   // Clears the default actions for each mock method in the given mock
   // object.
-  FunctionMockers& mockers =
-      g_mock_object_registry.states()[mock_obj].function_mockers;
+  FunctionMockers& mockers = state->function_mockers;
   for (FunctionMockers::const_iterator it = mockers.begin();
        it != mockers.end(); ++it) {
     (*it)->ClearDefaultActionsLocked();
@@ -815,8 +1213,7 @@ Expectation::~Expectation() {}
 void Sequence::AddExpectation(const Expectation& expectation) const {
   if (*last_expectation_ != expectation) {
     if (last_expectation_->expectation_base() != nullptr) {
-      expectation.expectation_base()->immediate_prerequisites_
-          += *last_expectation_;
+      expectation.expectation_base()->AddPrerequisite(*last_expectation_);
     }
     *last_expectation_ = expectation;
   }
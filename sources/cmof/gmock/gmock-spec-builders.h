@@ -36,6 +36,7 @@
 
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -43,6 +44,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -59,6 +61,9 @@ class Expectation;
 // A set of expectation handles.
 class ExpectationSet;
 
+// The registry of mock objects.
+class Mock;
+
 // Anything inside the 'internal' namespace IS INTERNAL IMPLEMENTATION
 // and MUST NOT BE USED IN USER CODE!!!
 namespace internal {
@@ -75,22 +80,55 @@ template <typename F> class TypedExpectation;
 // Helper class for testing the Expectation class template.
 class ExpectationTester;
 
-// Protects the mock object registry (in class Mock), all function
-// mockers, and all expectations.
+// Protects the mock object registry (in class Mock) and the default
+// actions of all function mockers.
+//
+// The state of the expectations of a function mocker (call counts,
+// retirement) is protected by the mocker's state lock instead; see
+// UntypedFunctionMockerBase::LockState().  While none of its
+// expectations has or is a pre-requisite of an expectation of another
+// mock function, that is a mutex of its own, so calls to independent
+// mock functions don't contend.  Once one has, calling Foo() reads and
+// retires expectations of other mock functions when InSequence() or
+// After() is used, so all mockers linked that way share g_gmock_mutex
+// as their state lock, sequencing their calls as before.
+//
+// Lock order: g_gmock_mutex is always acquired before any mocker's own
+// state mutex, and no thread holds two mockers' own state mutexes.
 //
-// The reason we don't use more fine-grained protection is: when a
-// mock function Foo() is called, it needs to consult its expectations
-// to see which one should be picked.  If another thread is allowed to
-// call a mock function (either Foo() or a different one) at the same
-// time, it could affect the "retired" attributes of Foo()'s
-// expectations when InSequence() is used, and thus affect which
-// expectation gets picked.  Therefore, we sequence all mock function
-// calls to ensure the integrity of the mock objects' states.
+// GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) on the methods of
+// expectations means that the state lock of their mock function must
+// be held.
 JMSD_DEPRECATED_GMOCK_API_ GTEST_DECLARE_STATIC_MUTEX_(g_gmock_mutex);
 
 // Untyped base class for ActionResultHolder<R>.
 class UntypedActionResultHolderBase;
 
+// A std::stringstream that is only constructed when something is
+// written to it.  Mock function calls describe themselves into these,
+// so that a call that matches an expectation and logs nothing doesn't
+// pay for constructing any iostream.
+class LazyStringStream {
+ public:
+  LazyStringStream() {}
+
+  // Returns the stream, constructing it on first use.
+  ::std::ostream* get() {
+    if (stream_ == nullptr) stream_.reset(new ::std::stringstream);
+    return stream_.get();
+  }
+
+  // Returns what has been written so far.
+  std::string str() const {
+    return stream_ == nullptr ? std::string() : stream_->str();
+  }
+
+ private:
+  std::unique_ptr< ::std::stringstream> stream_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(LazyStringStream);
+};
+
 // Abstract base class of FunctionMocker.  This is the
 // type-agnostic part of the function mocker interface.  Its pure
 // virtual methods are implemented by FunctionMocker.
@@ -109,6 +147,11 @@ class JMSD_DEPRECATED_GMOCK_API_ UntypedFunctionMockerBase {
   virtual void ClearDefaultActionsLocked()
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) = 0;
 
+  // Forgets the expectations indexed for lookup; called when they are
+  // dropped.
+  virtual void ClearExpectationIndexLocked()
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) = 0;
+
   // In all of the following Untyped* functions, it's the caller's
   // responsibility to guarantee the correctness of the arguments'
   // types.
@@ -140,11 +183,13 @@ class JMSD_DEPRECATED_GMOCK_API_ UntypedFunctionMockerBase {
   // untyped_action is set to point to the action that should be
   // performed (or NULL if the action is "do default"), and
   // is_excessive is modified to indicate whether the call exceeds the
-  // expected number.
+  // expected number.  Unexpected and excessive calls are always
+  // described to what and why; a call that matches is described only
+  // if describe_match is true.
   virtual const ExpectationBase* UntypedFindMatchingExpectation(
       const void* untyped_args,
       const void** untyped_action, bool* is_excessive,
-      ::std::ostream* what, ::std::ostream* why)
+      bool describe_match, LazyStringStream* what, LazyStringStream* why)
           GTEST_LOCK_EXCLUDED_(g_gmock_mutex) = 0;
 
   // Prints the given function arguments to the ostream.
@@ -182,23 +227,65 @@ class JMSD_DEPRECATED_GMOCK_API_ UntypedFunctionMockerBase {
   UntypedActionResultHolderBase* UntypedInvokeWith(void* untyped_args)
       GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
 
+  // Makes g_gmock_mutex the state lock of this mock function, for the
+  // rest of its life.  Called when one of its expectations gets or
+  // becomes a pre-requisite of an expectation of another mock function.
+  void ShareGlobalLock()
+      GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
+
+  // Asserts that the current thread holds the state lock of this mock
+  // function.
+  void AssertStateLockHeld() const;
+
  protected:
+  // Mock::UnregisterLocked() finds the owner of a mock method in the
+  // registry by mock_obj_.
+  friend class ::testing::Mock;
+
   typedef std::vector<const void*> UntypedOnCallSpecs;
 
   using UntypedExpectations = std::vector<std::shared_ptr<ExpectationBase>>;
 
+  // Holds the state lock of a mock function while in scope.
+  class StateLock {
+   public:
+    explicit StateLock(const UntypedFunctionMockerBase* mocker)
+        : mutex_(mocker->LockState()) {}
+    ~StateLock() { mutex_->Unlock(); }
+
+   private:
+    MutexBase* const mutex_;
+
+    GTEST_DISALLOW_COPY_AND_ASSIGN_(StateLock);
+  };
+
+  // Acquires the lock protecting the state of this mock function's
+  // expectations and returns it: state_mutex_, or g_gmock_mutex once
+  // ShareGlobalLock() has been called.
+  MutexBase* LockState() const
+      GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
+
   // Returns an Expectation object that references and co-owns exp,
   // which must be an expectation on this mock function.
   Expectation GetHandleOf(ExpectationBase* exp);
 
   // Address of the mock object this mock method belongs to.  Only
   // valid after this mock method has been called or
-  // ON_CALL/EXPECT_CALL has been invoked on it.
-  const void* mock_obj_;  // Protected by g_gmock_mutex.
+  // ON_CALL/EXPECT_CALL has been invoked on it.  Atomic, as it is
+  // set on every call.
+  std::atomic<const void*> mock_obj_;
 
   // Name of the function being mocked.  Only valid after this mock
-  // method has been called.
-  const char* name_;  // Protected by g_gmock_mutex.
+  // method has been called.  Atomic, as it is set on every call.
+  std::atomic<const char*> name_;
+
+  // The state lock of this mock function until it shares the global
+  // one.
+  mutable Mutex state_mutex_;
+
+  // True if and only if g_gmock_mutex is the state lock.  Only ever
+  // set, and only while holding both g_gmock_mutex and state_mutex_.
+  std::atomic<bool> shares_global_lock_;
 
   // All default action specs for this function mocker.
   UntypedOnCallSpecs untyped_on_call_specs_;
@@ -665,7 +752,8 @@ JMSD_DEPRECATED_GMOCK_API_ extern ThreadLocal<Sequence*> g_gmock_implicit_sequen
 class JMSD_DEPRECATED_GMOCK_API_ ExpectationBase {
  public:
   // source_text is the EXPECT_CALL(...) source that created this Expectation.
-  ExpectationBase(const char* file, int line, const std::string& source_text);
+  ExpectationBase(UntypedFunctionMockerBase* owner, const char* file, int line,
+                  const std::string& source_text);
 
   virtual ~ExpectationBase();
 
@@ -737,9 +825,20 @@ class JMSD_DEPRECATED_GMOCK_API_ ExpectationBase {
     cardinality_ = a_cardinality;
   }
 
+  // Makes prerequisite an immediate pre-requisite of this expectation.
+  // If they belong to different mock functions, both of those start
+  // sharing g_gmock_mutex as their state lock.
+  void AddPrerequisite(const Expectation& prerequisite)
+      GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
+
+  // Asserts that the current thread holds the state lock of the mock
+  // function owning this expectation (g_gmock_mutex once the mock
+  // function has been destroyed or cleared).
+  void AssertStateLockHeld() const;
+
   // The following group of methods should only be called after the
-  // EXPECT_CALL() statement, and only when g_gmock_mutex is held by
-  // the current thread.
+  // EXPECT_CALL() statement, and only when the state lock of the
+  // owning mock function is held by the current thread.
 
   // Retires all pre-requisites of this expectation.
   void RetireAllPreRequisites()
@@ -748,35 +847,35 @@ class JMSD_DEPRECATED_GMOCK_API_ ExpectationBase {
   // Returns true if and only if this expectation is retired.
   bool is_retired() const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     return retired_;
   }
 
   // Retires this expectation.
   void Retire()
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     retired_ = true;
   }
 
   // Returns true if and only if this expectation is satisfied.
   bool IsSatisfied() const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     return cardinality().IsSatisfiedByCallCount(call_count_);
   }
 
   // Returns true if and only if this expectation is saturated.
   bool IsSaturated() const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     return cardinality().IsSaturatedByCallCount(call_count_);
   }
 
   // Returns true if and only if this expectation is over-saturated.
   bool IsOverSaturated() const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     return cardinality().IsOverSaturatedByCallCount(call_count_);
   }
 
@@ -792,14 +891,14 @@ class JMSD_DEPRECATED_GMOCK_API_ ExpectationBase {
   // Returns the number this expectation has been invoked.
   int call_count() const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     return call_count_;
   }
 
   // Increments the number this expectation has been invoked.
   void IncrementCallCount()
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     call_count_++;
   }
 
@@ -819,6 +918,11 @@ class JMSD_DEPRECATED_GMOCK_API_ ExpectationBase {
   // Implements the .Times() clause.
   void UntypedTimes(const Cardinality& a_cardinality);
 
+  // The mock function this expectation belongs to, or NULL once that
+  // has dropped it (see VerifyAndClearExpectationsLocked()).  Only
+  // changed while holding both g_gmock_mutex and its state lock.
+  UntypedFunctionMockerBase* untyped_owner_;
+
   // This group of fields are part of the spec and won't change after
   // an EXPECT_CALL() statement finishes.
   const char* file_;          // The file that contains the expectation.
@@ -861,7 +965,7 @@ class TypedExpectation : public ExpectationBase {
   TypedExpectation(FunctionMocker<F>* owner, const char* a_file, int a_line,
                    const std::string& a_source_text,
                    const ArgumentMatcherTuple& m)
-      : ExpectationBase(a_file, a_line, a_source_text),
+      : ExpectationBase(owner, a_file, a_line, a_source_text),
         owner_(owner),
         matchers_(m),
         // By default, extra_matcher_ should match anything.  However,
@@ -946,7 +1050,7 @@ class TypedExpectation : public ExpectationBase {
     last_clause_ = kAfter;
 
     for (ExpectationSet::const_iterator it = s.begin(); it != s.end(); ++it) {
-      immediate_prerequisites_ += *it;
+      AddPrerequisite(*it);
     }
     return *this;
   }
@@ -1053,13 +1157,13 @@ class TypedExpectation : public ExpectationBase {
   Expectation GetHandle() override { return owner_->GetHandleOf(this); }
 
   // The following methods will be called only after the EXPECT_CALL()
-  // statement finishes and when the current thread holds
-  // g_gmock_mutex.
+  // statement finishes and when the current thread holds the state
+  // lock of owner_.
 
   // Returns true if and only if this expectation matches the given arguments.
   bool Matches(const ArgumentTuple& args) const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     return TupleMatches(matchers_, args) && extra_matcher_.Matches(args);
   }
 
@@ -1067,7 +1171,7 @@ class TypedExpectation : public ExpectationBase {
   // arguments.
   bool ShouldHandleArguments(const ArgumentTuple& args) const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
 
     // In case the action count wasn't checked when the expectation
     // was defined (e.g. if this expectation has no WillRepeatedly()
@@ -1083,7 +1187,7 @@ class TypedExpectation : public ExpectationBase {
       const ArgumentTuple& args,
       ::std::ostream* os) const
           GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
 
     if (is_retired()) {
       *os << "         Expected: the expectation is active\n"
@@ -1127,7 +1231,7 @@ class TypedExpectation : public ExpectationBase {
   const Action<F>& GetCurrentAction(const FunctionMocker<F>* mocker,
                                     const ArgumentTuple& args) const
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     const int count = call_count();
     Assert(count >= 1, __FILE__, __LINE__,
            "call_count() is <= 0 when GetCurrentAction() is "
@@ -1158,21 +1262,23 @@ class TypedExpectation : public ExpectationBase {
   // over-saturate this expectation, returns the default action;
   // otherwise, returns the next action in this expectation.  Also
   // describes *what* happened to 'what', and explains *why* Google
-  // Mock does it to 'why'.  This method is not const as it calls
-  // IncrementCallCount().  A return value of NULL means the default
-  // action.
+  // Mock does it to 'why'; a call that doesn't over-saturate is only
+  // described if describe_match is true.  This method is not const as
+  // it calls IncrementCallCount().  A return value of NULL means the
+  // default action.
   const Action<F>* GetActionForArguments(const FunctionMocker<F>* mocker,
                                          const ArgumentTuple& args,
-                                         ::std::ostream* what,
-                                         ::std::ostream* why)
+                                         bool describe_match,
+                                         LazyStringStream* what,
+                                         LazyStringStream* why)
       GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    AssertStateLockHeld();
     if (IsSaturated()) {
       // We have an excessive call.
       IncrementCallCount();
-      *what << "Mock function called more times than expected - ";
-      mocker->DescribeDefaultActionTo(args, what);
-      DescribeCallCountTo(why);
+      *what->get() << "Mock function called more times than expected - ";
+      mocker->DescribeDefaultActionTo(args, what->get());
+      DescribeCallCountTo(why->get());
 
       return nullptr;
     }
@@ -1185,7 +1291,9 @@ class TypedExpectation : public ExpectationBase {
     }
 
     // Must be done after IncrementCount()!
-    *what << "Mock function call matches " << source_text() <<"...\n";
+    if (describe_match) {
+      *what->get() << "Mock function call matches " << source_text() << "...\n";
+    }
     return &(GetCurrentAction(mocker, args));
   }
 
@@ -1415,6 +1523,80 @@ class ActionResultHolder<void> : public UntypedActionResultHolderBase {
   GTEST_DISALLOW_COPY_AND_ASSIGN_(ActionResultHolder);
 };
 
+// Whether expectations can be looked up by the value of an argument of
+// type T: values equal under == must hash alike, as they do for these.
+template <typename T>
+struct IsIndexableArgument
+    : std::integral_constant<bool, std::is_integral<T>::value ||
+                                       std::is_enum<T>::value ||
+                                       std::is_pointer<T>::value ||
+                                       std::is_same<T, std::string>::value> {};
+
+// Indexes the expectations of a mock function by the value their first
+// argument matcher requires them to be called with (see
+// MatcherBase::GetExactValue()), so that a call is only tried against
+// the expectations that can match its first argument.  Expectations
+// are identified by their position in the function's list of
+// expectations.  This general version, for functions whose first
+// argument isn't indexable, indexes nothing.
+template <typename ArgumentTuple, typename = void>
+class ExpectationIndex {
+ public:
+  template <typename MatcherTuple>
+  void Add(size_t /* position */, const MatcherTuple& /* matchers */) {}
+
+  bool Lookup(const ArgumentTuple& /* args */,
+              const std::vector<size_t>** /* bucket */,
+              const std::vector<size_t>** /* others */) const {
+    return false;
+  }
+};
+
+template <typename Arg, typename... Rest>
+class ExpectationIndex<
+    std::tuple<Arg, Rest...>,
+    typename std::enable_if<IsIndexableArgument<
+        GTEST_REMOVE_REFERENCE_AND_CONST_(Arg)>::value>::type> {
+  typedef GTEST_REMOVE_REFERENCE_AND_CONST_(Arg) Key;
+
+ public:
+  // Indexes the expectation at the given position, which is past all
+  // the positions indexed so far.
+  void Add(size_t position,
+           const std::tuple<Matcher<Arg>, Matcher<Rest>...>& matchers) {
+    const Key* const value = std::get<0>(matchers).GetExactValue();
+    if (value == nullptr) {
+      others_.push_back(position);
+    } else {
+      buckets_[*value].push_back(position);
+    }
+  }
+
+  // Returns false if the index is of no help, in which case all the
+  // expectations have to be tried.  Otherwise sets *bucket to the
+  // positions of the expectations requiring the first argument of the
+  // call (or to NULL if there are none) and *others to the positions
+  // of those that may match any first argument, both in increasing
+  // order.
+  bool Lookup(const std::tuple<Arg, Rest...>& args,
+              const std::vector<size_t>** bucket,
+              const std::vector<size_t>** others) const {
+    if (buckets_.empty()) return false;
+
+    const typename Buckets::const_iterator it =
+        buckets_.find(std::get<0>(args));
+    *bucket = it == buckets_.end() ? nullptr : &it->second;
+    *others = &others_;
+    return true;
+  }
+
+ private:
+  typedef std::unordered_map<Key, std::vector<size_t> > Buckets;
+
+  Buckets buckets_;
+  std::vector<size_t> others_;
+};
+
 template <typename F>
 class FunctionMocker;
 
@@ -1552,6 +1734,13 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
     g_gmock_mutex.Lock();
   }
 
+  // Implements UntypedFunctionMockerBase::ClearExpectationIndexLocked().
+  void ClearExpectationIndexLocked() override
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
+    this->AssertStateLockHeld();
+    expectation_index_.reset();
+  }
+
   // Returns the result of invoking this mock function with the given
   // arguments.  This function can be safely called from multiple
   // threads concurrently.
@@ -1593,7 +1782,11 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
         new TypedExpectation<F>(this, file, line, source_text, m);
     const std::shared_ptr<ExpectationBase> untyped_expectation(expectation);
     // See the definition of untyped_expectations_ for why access to
-    // it is unprotected here.
+    // it (and to expectation_index_) is unprotected here.
+    if (expectation_index_ == nullptr) {
+      expectation_index_.reset(new ExpectationIndex<ArgumentTuple>);
+    }
+    expectation_index_->Add(untyped_expectations_.size(), m);
     untyped_expectations_.push_back(untyped_expectation);
 
     // Adds this expectation into the implicit sequence if there is one.
@@ -1658,14 +1851,14 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
   // mock function) and excessive locking could cause a dead lock.
   const ExpectationBase* UntypedFindMatchingExpectation(
       const void* untyped_args, const void** untyped_action, bool* is_excessive,
-      ::std::ostream* what, ::std::ostream* why) override
+      bool describe_match, LazyStringStream* what, LazyStringStream* why) override
       GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
     const ArgumentTuple& args =
         *static_cast<const ArgumentTuple*>(untyped_args);
-    MutexLock l(&g_gmock_mutex);
+    StateLock l(this);
     TypedExpectation<F>* exp = this->FindMatchingExpectationLocked(args);
     if (exp == nullptr) {  // A match wasn't found.
-      this->FormatUnexpectedCallMessageLocked(args, what, why);
+      this->FormatUnexpectedCallMessageLocked(args, what->get(), why->get());
       return nullptr;
     }
 
@@ -1673,7 +1866,8 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
     // which will increment the call count for *exp and thus affect
     // its saturation status.
     *is_excessive = exp->IsSaturated();
-    const Action<F>* action = exp->GetActionForArguments(this, args, what, why);
+    const Action<F>* action =
+        exp->GetActionForArguments(this, args, describe_match, what, why);
     if (action != nullptr && action->IsDoDefault())
       action = nullptr;  // Normalize "do default" to NULL.
     *untyped_action = action;
@@ -1693,9 +1887,31 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
   TypedExpectation<F>* FindMatchingExpectationLocked(
       const ArgumentTuple& args) const
           GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    this->AssertStateLockHeld();
     // See the definition of untyped_expectations_ for why access to
     // it is unprotected here.
+    const std::vector<size_t>* bucket = nullptr;
+    const std::vector<size_t>* others = nullptr;
+    if (expectation_index_ != nullptr &&
+        expectation_index_->Lookup(args, &bucket, &others)) {
+      // Tries the candidates newest first, as the scan below does, by
+      // merging the two lists from their ends.
+      size_t b = bucket == nullptr ? 0 : bucket->size();
+      size_t o = others->size();
+      while (b > 0 || o > 0) {
+        const size_t position =
+            o == 0 || (b > 0 && (*bucket)[b - 1] > (*others)[o - 1])
+                ? (*bucket)[--b]
+                : (*others)[--o];
+        TypedExpectation<F>* const exp = static_cast<TypedExpectation<F>*>(
+            untyped_expectations_[position].get());
+        if (exp->ShouldHandleArguments(args)) {
+          return exp;
+        }
+      }
+      return nullptr;
+    }
+
     for (typename UntypedExpectations::const_reverse_iterator it =
              untyped_expectations_.rbegin();
          it != untyped_expectations_.rend(); ++it) {
@@ -1714,7 +1930,7 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
       ::std::ostream* os,
       ::std::ostream* why) const
           GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    this->AssertStateLockHeld();
     *os << "\nUnexpected mock function call - ";
     DescribeDefaultActionTo(args, os);
     PrintTriedExpectationsLocked(args, why);
@@ -1726,7 +1942,7 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
       const ArgumentTuple& args,
       ::std::ostream* why) const
           GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+    this->AssertStateLockHeld();
     const size_t count = untyped_expectations_.size();
     *why << "Google Mock tried the following " << count << " "
          << (count == 1 ? "expectation, but it didn't match" :
@@ -1745,6 +1961,12 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
       expectation->DescribeCallCountTo(why);
     }
   }
+
+  // Finds the candidate expectations for a call among
+  // untyped_expectations_; accessed like it.  Created along with the
+  // first expectation, so that it doesn't change the size of a mock
+  // function whatever its signature.
+  std::unique_ptr<ExpectationIndex<ArgumentTuple> > expectation_index_;
 };  // class FunctionMocker
 
 // Reports an uninteresting call (whose description is in msg) in the
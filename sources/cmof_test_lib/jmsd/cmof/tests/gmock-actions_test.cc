@@ -12,6 +12,7 @@
 #include "gtest/internal/Floating_point_comparator.hin"
 
 #include <algorithm>
+#include <array>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -404,6 +405,19 @@ TEST(ActionTest, CanBeConvertedToOtherActionType) {
   EXPECT_EQ(0, a2.Perform(std::make_tuple('\0')));
 }
 
+// Tests that the copies of a converted action have their own copy of the
+// action it was converted from.
+TEST(ActionTest, CopiesOfConvertedActionHaveTheirOwnState) {
+  int count = 0;
+  const Action<int()> counter = [count]() mutable { return ++count; };
+  const Action<long()> converted = Action<long()>(counter);  // NOLINT
+  Action<long()> copy1 = converted;  // NOLINT
+  Action<long()> copy2 = converted;  // NOLINT
+  EXPECT_EQ(1, copy1.Perform(std::make_tuple()));
+  EXPECT_EQ(1, copy2.Perform(std::make_tuple()));
+  EXPECT_EQ(2, copy1.Perform(std::make_tuple()));
+}
+
 // The following two classes are for testing MakePolymorphicAction().
 
 // Implements a polymorphic action that returns the second of the
@@ -1448,6 +1462,73 @@ TEST(FunctorActionTest, UnusedArguments) {
   EXPECT_EQ(6, a.Perform(dummy));
 }
 
+// Tests that the copies of an action made from a callable have their own
+// copy of it, whether it's kept inside the action or not.
+TEST(FunctorActionTest, CopiesHaveTheirOwnState) {
+  int small_count = 0;
+  Action<int()> small1 = [small_count]() mutable { return ++small_count; };
+  EXPECT_EQ(1, small1.Perform(std::make_tuple()));
+  Action<int()> small2 = small1;
+  EXPECT_EQ(2, small1.Perform(std::make_tuple()));
+  EXPECT_EQ(2, small2.Perform(std::make_tuple()));
+
+  std::array<int, 32> big_counts = {};
+  Action<int()> big1 = [big_counts]() mutable { return ++big_counts[31]; };
+  EXPECT_EQ(1, big1.Perform(std::make_tuple()));
+  Action<int()> big2 = big1;
+  EXPECT_EQ(2, big1.Perform(std::make_tuple()));
+  EXPECT_EQ(2, big2.Perform(std::make_tuple()));
+}
+
+// Counts the times it's copied.
+class CopyCounter {
+ public:
+  explicit CopyCounter(int* copies) : copies_(copies) {}
+  CopyCounter(const CopyCounter& other) : copies_(other.copies_) {
+    ++*copies_;
+  }
+  CopyCounter(CopyCounter&& other) : copies_(other.copies_) {}
+
+ private:
+  int* copies_;
+};
+
+// Tests that DoAll() hands its arguments on to its actions without
+// copying them.
+TEST(DoAllTest, DoesNotCopyArguments) {
+  int copies = 0;
+  int performed = 0;
+  Action<int(CopyCounter)> a =
+      DoAll([&performed](const CopyCounter&) { ++performed; },
+            [&performed](const CopyCounter&) { ++performed; },
+            [&performed](CopyCounter) { return ++performed; });
+  EXPECT_EQ(3, a.Perform(std::make_tuple(CopyCounter(&copies))));
+  EXPECT_EQ(0, copies);
+}
+
+// A polymorphic action which counts the times it's performed.
+class CountingAction {
+ public:
+  explicit CountingAction(int initial) : count_(initial) {}
+
+  template <typename Result, typename ArgumentTuple>
+  Result Perform(const ArgumentTuple& /* args */) {
+    return ++count_;
+  }
+
+ private:
+  int count_;
+};
+
+// Tests that the copies of an action made from a polymorphic action
+// whose Perform() isn't const share its state.
+TEST(MakePolymorphicActionTest, CopiesShareNonConstState) {
+  Action<int()> a1 = MakePolymorphicAction(CountingAction(0));
+  Action<int()> a2 = a1;
+  EXPECT_EQ(1, a1.Perform(std::make_tuple()));
+  EXPECT_EQ(2, a2.Perform(std::make_tuple()));
+}
+
 // Test that basic built-in actions work with move-only arguments.
 TEST(MoveOnlyArgumentsTest, ReturningActions) {
   Action<int(std::unique_ptr<int>)> a = Return(1);
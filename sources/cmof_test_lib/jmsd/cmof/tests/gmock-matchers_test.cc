@@ -273,6 +273,62 @@ TEST(MatcherTest, IsCopyable) {
   EXPECT_FALSE(m1.Matches(false));
 }
 
+// A matcher implementation too big to be kept inside a Matcher.
+class IsInBigTableImpl : public MatcherInterface<const int&> {
+ public:
+  explicit IsInBigTableImpl(int n) {
+    for (int i = 0; i != kSize; ++i) table_[i] = n * i;
+  }
+
+  bool MatchAndExplain(const int& x,
+                       MatchResultListener* /* listener */) const override {
+    for (int i = 0; i != kSize; ++i) {
+      if (table_[i] == x) return true;
+    }
+    return false;
+  }
+
+  void DescribeTo(ostream* os) const override { *os << "is in the table"; }
+
+ private:
+  static const int kSize = 64;
+  int table_[kSize];
+};
+
+// Tests that Matcher<T> can hold its implementation by value, whether
+// that is kept inside the matcher or not.
+TEST(MatcherTest, CanBeConstructedFromImplementationByValue) {
+  const Matcher<int> small(internal::AnyMatcherImpl<int>{});
+  EXPECT_TRUE(small.Matches(7));
+  EXPECT_EQ("is anything", Describe(small));
+
+  const Matcher<int> big((IsInBigTableImpl(3)));
+  EXPECT_TRUE(big.Matches(9));
+  EXPECT_FALSE(big.Matches(10));
+  EXPECT_EQ("is in the table", Describe(big));
+}
+
+// Tests that copies and moves of a matcher match and describe like it.
+TEST(MatcherTest, CopiesAndMovesKeepTheImplementation) {
+  Matcher<std::string> m1 = Eq(std::string("a string too long to be short"));
+  Matcher<std::string> m2 = m1;
+  Matcher<std::string> m3 = std::move(m1);
+  EXPECT_TRUE(m2.Matches("a string too long to be short"));
+  EXPECT_TRUE(m3.Matches("a string too long to be short"));
+  ASSERT_TRUE(m3.GetExactValue() != nullptr);
+  EXPECT_EQ("a string too long to be short", *m3.GetExactValue());
+
+  Matcher<int> big1((IsInBigTableImpl(2)));
+  Matcher<int> big2 = big1;
+  big1 = Matcher<int>(IsInBigTableImpl(5));
+  EXPECT_TRUE(big1.Matches(10));
+  EXPECT_FALSE(big1.Matches(4));
+  EXPECT_TRUE(big2.Matches(4));
+
+  m2 = std::move(m3);
+  EXPECT_EQ("is equal to \"a string too long to be short\"", Describe(m2));
+}
+
 // Tests that Matcher<T>::DescribeTo() calls
 // MatcherInterface<T>::DescribeTo().
 TEST(MatcherTest, CanDescribeItself) {
@@ -907,6 +963,26 @@ TEST(EqTest, IsPolymorphic) {
   EXPECT_FALSE(m2.Matches('a'));
 }
 
+#if GTEST_HAS_RTTI
+// Tests that a matcher made from Eq(v), or from v, tells v when v has
+// the matched type.
+TEST(EqTest, ReportsExactValueOfMatchedType) {
+  Matcher<int> m1 = Eq(5);
+  ASSERT_TRUE(m1.GetExactValue() != nullptr);
+  EXPECT_EQ(5, *m1.GetExactValue());
+
+  Matcher<const std::string&> m2 = "hi";
+  ASSERT_TRUE(m2.GetExactValue() != nullptr);
+  EXPECT_EQ("hi", *m2.GetExactValue());
+
+  Matcher<long> m3 = Eq(5);  // NOLINT
+  EXPECT_TRUE(m3.GetExactValue() == nullptr);
+
+  Matcher<int> m4 = Ge(5);
+  EXPECT_TRUE(m4.GetExactValue() == nullptr);
+}
+#endif  // GTEST_HAS_RTTI
+
 // Tests that TypedEq<T>(v) matches values of type T that's equal to v.
 TEST(TypedEqTest, ChecksEqualityForGivenType) {
   Matcher<char> m1 = TypedEq<char>('a');
@@ -5656,6 +5732,20 @@ TEST_F(UnorderedElementsAreTest, Performance) {
                                  s, &listener)) << listener.str();
 }
 
+// Each element matches exactly one matcher, which the matcher pairs up
+// without searching for augmenting paths.
+TEST_F(UnorderedElementsAreTest, PerformanceUniqueMatches) {
+  std::vector<int> s;
+  std::vector<Matcher<int> > mv;
+  for (int i = 0; i < 1000; ++i) {
+    s.push_back(i);
+    mv.push_back(Eq(999 - i));
+  }
+  StringMatchResultListener listener;
+  EXPECT_TRUE(ExplainMatchResult(UnorderedElementsAreArray(mv),
+                                 s, &listener)) << listener.str();
+}
+
 // Another variant of 'Performance' with similar expectations.
 // [ RUN      ] UnorderedElementsAreTest.PerformanceHalfStrict
 // [       OK ] UnorderedElementsAreTest.PerformanceHalfStrict (4 ms)
@@ -6014,6 +6104,45 @@ INSTANTIATE_TEST_SUITE_P(Samples, BipartiteRandomTest,
         std::make_pair(8, 500),
         std::make_pair(9, 100)));
 
+TEST(MatchMatrixTest, NextEdgeSkipsMissingEdgesAcrossWords) {
+  MatchMatrix graph(2, 200);
+  graph.SetEdge(0, 3, true);
+  graph.SetEdge(0, 64, true);
+  graph.SetEdge(0, 199, true);
+  EXPECT_EQ(3u, graph.NextEdge(0, 0));
+  EXPECT_EQ(3u, graph.NextEdge(0, 3));
+  EXPECT_EQ(64u, graph.NextEdge(0, 4));
+  EXPECT_EQ(199u, graph.NextEdge(0, 65));
+  EXPECT_EQ(200u, graph.NextEdge(0, 200));
+  EXPECT_EQ(200u, graph.NextEdge(1, 0));
+
+  graph.SetEdge(0, 64, false);
+  EXPECT_FALSE(graph.HasEdge(0, 64));
+  EXPECT_EQ(199u, graph.NextEdge(0, 4));
+}
+
+// Element i has edges to matchers i and i + 1, but the last element only
+// has one to matcher 0. Pairing each element with its first matcher
+// leaves the last one out, and the only augmenting path then runs through
+// every element, which must neither take quadratic time nor exhaust the
+// stack.
+TEST(BipartiteLargeTest, AugmentsAlongPathThroughEveryElement) {
+  const size_t kNodes = 10000;
+  MatchMatrix graph(kNodes, kNodes);
+  for (size_t i = 0; i + 1 < kNodes; ++i) {
+    graph.SetEdge(i, i, true);
+    graph.SetEdge(i, i + 1, true);
+  }
+  graph.SetEdge(kNodes - 1, 0, true);
+
+  ElementMatcherPairs matches = internal::FindMaxBipartiteMatching(graph);
+  ASSERT_EQ(kNodes, matches.size());
+  for (size_t i = 0; i < matches.size(); ++i) {
+    EXPECT_EQ(i, matches[i].first);
+    EXPECT_EQ(i + 1 < kNodes ? i + 1 : 0, matches[i].second);
+  }
+}
+
 // Tests IsReadableTypeName().
 
 TEST(IsReadableTypeNameTest, ReturnsTrueForShortNames) {
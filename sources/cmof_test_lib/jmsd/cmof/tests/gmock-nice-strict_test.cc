@@ -6,8 +6,10 @@
 #include "gtest/Assertion_result.hin"
 #include "gtest/Message.hin"
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 // This must not be defined inside the ::testing namespace, or it will clash with ::testing::Mock.
 class Mock {
@@ -27,6 +29,7 @@ using testing::GMOCK_FLAG(verbose);
 using testing::HasSubstr;
 using testing::NaggyMock;
 using testing::NiceMock;
+using testing::Return;
 using testing::StrictMock;
 
 #if GTEST_HAS_STREAM_REDIRECTION
@@ -469,5 +472,51 @@ TEST(StrictMockTest, IsNaggy_IsNice_IsStrict) {
   EXPECT_TRUE(Mock::IsStrict(&strict_foo));
 }
 
+// Tests that the reactions of many mock objects, more than fit in the
+// registry at first, survive their neighbours being destroyed.
+TEST(MockRegistryTest, KeepsReactionsOfManyMocks) {
+  std::vector<std::unique_ptr<MockFoo> > mocks;
+  for (int i = 0; i < 300; ++i) {
+    switch (i % 3) {
+      case 0: mocks.emplace_back(new NiceMock<MockFoo>); break;
+      case 1: mocks.emplace_back(new NaggyMock<MockFoo>); break;
+      default: mocks.emplace_back(new StrictMock<MockFoo>); break;
+    }
+    if (i % 4 != 3) {
+      EXPECT_CALL(*mocks.back(), DoThat(true)).WillOnce(Return(i));
+    }
+  }
+
+  for (size_t i = 0; i < mocks.size(); i += 2) {
+    if (i % 4 != 3) mocks[i]->DoThat(true);
+    mocks[i].reset();
+  }
+
+  for (size_t i = 1; i < mocks.size(); i += 2) {
+    MockFoo* const mock = mocks[i].get();
+    EXPECT_EQ(i % 3 == 0, Mock::IsNice(mock));
+    EXPECT_EQ(i % 3 == 1, Mock::IsNaggy(mock));
+    EXPECT_EQ(i % 3 == 2, Mock::IsStrict(mock));
+    if (i % 4 != 3) {
+      EXPECT_EQ(static_cast<int>(i), mock->DoThat(true));
+    }
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(mock));
+  }
+}
+
+// Tests that a mock object made at the address of a destroyed one
+// doesn't inherit its reaction.
+TEST(MockRegistryTest, ForgetsReactionsOfDestroyedMocks) {
+  for (int i = 0; i < 100; ++i) {
+    std::unique_ptr<StrictMock<MockFoo> > strict_foo(new StrictMock<MockFoo>);
+    EXPECT_TRUE(Mock::IsStrict(strict_foo.get()));
+    strict_foo.reset();
+
+    std::unique_ptr<MockFoo> raw_foo(new MockFoo);
+    EXPECT_FALSE(Mock::IsStrict(raw_foo.get()));
+    EXPECT_FALSE(Mock::IsNice(raw_foo.get()));
+  }
+}
+
 }  // namespace gmock_nice_strict_test
 }  // namespace testing
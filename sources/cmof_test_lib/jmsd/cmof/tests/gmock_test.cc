@@ -147,3 +147,117 @@ TEST(FlagTest, IsAccessibleInCode) {
       testing::GMOCK_FLAG(verbose) == "";
   (void)dummy;  // Avoids the "unused local variable" warning.
 }
+
+namespace {
+
+class MockB {
+ public:
+  MOCK_METHOD1(DoB, int(int n));  // NOLINT
+};
+
+}  // namespace
+
+// Tests that the last matching EXPECT_CALL() fires when many of them
+// expect distinct argument values, which the mock function indexes.
+TEST(ExpectationIndexTest, PicksLastMatchingExpectCallAmongExactValues) {
+  MockB b;
+  EXPECT_CALL(b, DoB(testing::_))
+      .WillRepeatedly(testing::Return(-1));
+  for (int i = 0; i < 100; i++) {
+    EXPECT_CALL(b, DoB(i))
+        .WillRepeatedly(testing::Return(i));
+  }
+  EXPECT_CALL(b, DoB(testing::Gt(90)))
+      .WillRepeatedly(testing::Return(90));
+  EXPECT_CALL(b, DoB(95))
+      .WillRepeatedly(testing::Return(-95));
+
+  EXPECT_EQ(-1, b.DoB(-5));
+  EXPECT_EQ(42, b.DoB(42));
+  EXPECT_EQ(90, b.DoB(91));
+  EXPECT_EQ(-95, b.DoB(95));
+}
+
+// Tests that a retired EXPECT_CALL() for a value gives way to an
+// earlier one.
+TEST(ExpectationIndexTest, SkipsRetiredExactValueExpectCall) {
+  MockB b;
+  EXPECT_CALL(b, DoB(testing::_))
+      .WillRepeatedly(testing::Return(0));
+  EXPECT_CALL(b, DoB(1))
+      .WillRepeatedly(testing::Return(1));
+  EXPECT_CALL(b, DoB(1))
+      .WillOnce(testing::Return(2))
+      .RetiresOnSaturation();
+
+  EXPECT_EQ(2, b.DoB(1));
+  EXPECT_EQ(1, b.DoB(1));
+  EXPECT_EQ(0, b.DoB(2));
+}
+
+// Tests that EXPECT_CALL()s for argument values set after
+// VerifyAndClearExpectations() don't see the cleared ones.
+TEST(ExpectationIndexTest, ForgetsExpectedArgumentValuesWhenCleared) {
+  MockB b;
+  EXPECT_CALL(b, DoB(1))
+      .WillOnce(testing::Return(1));
+  b.DoB(1);
+  testing::Mock::VerifyAndClearExpectations(&b);
+
+  EXPECT_CALL(b, DoB(2))
+      .WillOnce(testing::Return(2));
+  EXPECT_CALL(b, DoB(1))
+      .WillOnce(testing::Return(3));
+  EXPECT_EQ(3, b.DoB(1));
+  EXPECT_EQ(2, b.DoB(2));
+}
+
+#if GTEST_IS_THREADSAFE
+
+namespace {
+
+class MockFoo {
+ public:
+  MOCK_METHOD1(Bar, int(int n));  // NOLINT
+  MOCK_METHOD2(Baz, char(const char* s1, const std::string& s2));  // NOLINT
+};
+
+// How many times CallBarAndBaz() calls each method.
+const int kRepeat = 50;
+
+void CallBarAndBaz(MockFoo* foo) {
+  for (int i = 0; i < kRepeat; i++) {
+    foo->Bar(5);
+    foo->Baz("a", "b");
+  }
+}
+
+}  // namespace
+
+// Tests calling different methods of the same mock object in two threads
+// when expectations on one method are pre-requisites of expectations on the
+// other, so that both methods share one state lock.
+TEST(MockFunctionStateLockTest, SharedByMethodsWithOrderedExpectations) {
+  MockFoo foo;
+
+  const testing::Expectation first = EXPECT_CALL(foo, Bar(0));
+  const testing::Expectation bars = EXPECT_CALL(foo, Bar(5))
+      .Times(2*kRepeat)
+      .After(first);
+  const testing::Expectation bazs = EXPECT_CALL(foo, Baz(testing::_, testing::_))
+      .Times(2*kRepeat)
+      .After(first);
+  EXPECT_CALL(foo, Bar(9))
+      .After(bars, bazs);
+
+  foo.Bar(0);
+
+  testing::internal::ThreadWithParam<MockFoo*> thread(&CallBarAndBaz, &foo,
+                                                      nullptr);
+  CallBarAndBaz(&foo);
+  thread.Join();
+
+  foo.Bar(9);
+}
+
+#endif  // GTEST_IS_THREADSAFE
@@ -14,9 +14,9 @@ namespace ctf {
 
 
 int ctf_main( int const argc, char const *const argv[], bool const do_warn_about_mocks ) {
-	{ // base and flags initialization
-		::jmsd::ctf::modification::Writable_command_line_arguments writable_command_line_arguments( argc, argv );
+	::jmsd::ctf::modification::Writable_command_line_arguments writable_command_line_arguments( argc, argv );
 
+	{ // base and flags initialization
 		::testing::InitGoogleMock(
 			writable_command_line_arguments.take_argument_counter(),
 			writable_command_line_arguments.take_argument_string_array() );
@@ -31,10 +31,13 @@ int ctf_main( int const argc, char const *const argv[], bool const do_warn_about
 				testing::internal::kErrorVerbosity;
 	}
 
-	{ // will only print errors, not successes
+	{ // will only print errors, not successes, unless the --ctf_show_* flags ask for more
 		cutf::TestEventListeners &listeners = cutf::UnitTest::GetInstance()->listeners();
 		auto default_printer = listeners.Release( listeners.default_result_printer() );
 		auto the_listener = new ::jmsd::ctf::modification::Configurable_event_listener( default_printer );
+		the_listener->Parse_flags(
+			writable_command_line_arguments.take_argument_counter(),
+			writable_command_line_arguments.take_argument_string_array() );
 		listeners.Append( the_listener );
 	}
 
@@ -2,6 +2,7 @@
 
 
 #include "gtest/Test_info.h"
+#include "gtest/gtest-internal-inl.h"
 
 
 namespace jmsd {
@@ -9,6 +10,15 @@ namespace ctf {
 namespace modification {
 
 
+namespace {
+
+// The flags of the listener are "--ctf_<flag_name>" or
+// "--ctf_<flag_name>=<value>".
+char const kFlagPrefix[] = "ctf_";
+
+} // namespace
+
+
 Configurable_event_listener::Configurable_event_listener( TestEventListener *an_event_listener )
 	:
 		_event_listener( an_event_listener)
@@ -38,12 +48,55 @@ Configurable_event_listener::Configurable_event_listener( TestEventListener *an_
 //*/
 }
 
+void Configurable_event_listener::Parse_flags( int *const argument_counter, char **const argument_string_array ) {
+	for ( int i = 1; i < *argument_counter; ) {
+		char const *const argument = argument_string_array[ i ];
+
+		using ::testing::internal::ParseBoolFlag;
+
+		bool const is_ctf_flag =
+			ParseBoolFlag( argument, kFlagPrefix, "show_test_cases", &_showTestCases ) ||
+			ParseBoolFlag( argument, kFlagPrefix, "show_test_names", &_showTestNames ) ||
+			ParseBoolFlag( argument, kFlagPrefix, "show_successes", &_showSuccesses ) ||
+			ParseBoolFlag( argument, kFlagPrefix, "show_inline_failures", &_showInlineFailures ) ||
+			ParseBoolFlag( argument, kFlagPrefix, "show_test_part_failures", &_showTestPartFailures ) ||
+			ParseBoolFlag( argument, kFlagPrefix, "show_environment", &_showEnvironment );
+
+		if ( !is_ctf_flag ) {
+			++i;
+			continue;
+		}
+
+		// argv is NULL terminated, so the terminator moves down too.
+		for ( int j = i; j < *argument_counter; ++j ) {
+			argument_string_array[ j ] = argument_string_array[ j + 1 ];
+		}
+
+		--*argument_counter;
+	}
+}
+
 // virtual TestEventListener
 Configurable_event_listener::~Configurable_event_listener() {
 	delete _event_listener;
 }
 
 // virtuals TestEventListener
+unsigned Configurable_event_listener::event_interests() const {
+	unsigned interests = kOnTestProgramStart | kOnTestIterationStart | kOnTestIterationEnd | kOnTestProgramEnd;
+
+	if ( _showTestCases ) interests |= kOnTestSuiteStart | kOnTestSuiteEnd;
+	if ( _showTestNames ) interests |= kOnTestStart;
+	if ( _showTestPartFailures ) interests |= kOnTestPartResult;
+	if ( _showSuccesses || _showInlineFailures ) interests |= kOnTestEnd;
+
+	if ( _showEnvironment ) {
+		interests |= kOnEnvironmentsSetUpStart | kOnEnvironmentsSetUpEnd | kOnEnvironmentsTearDownStart | kOnEnvironmentsTearDownEnd;
+	}
+
+	return interests & _event_listener->event_interests();
+}
+
 void Configurable_event_listener::OnTestProgramStart( ::jmsd::cutf::UnitTest const &unit_test ) {
 	_event_listener->OnTestProgramStart( unit_test );
 }
@@ -78,6 +131,12 @@ void Configurable_event_listener::OnTestCaseEnd( ::jmsd::cutf::TestCase const &t
 }
 #endif // #ifdef GTEST_KEEP_LEGACY_TEST_CASEAPI
 
+void Configurable_event_listener::OnTestSuiteStart( ::jmsd::cutf::TestSuite const &test_suite ) {
+	if ( !_showTestCases ) return;
+
+	_event_listener->OnTestSuiteStart( test_suite );
+}
+
 void Configurable_event_listener::OnTestStart( ::jmsd::cutf::TestInfo const &test_info ) {
 	if ( !_showTestNames ) return;
 
@@ -100,6 +159,12 @@ void Configurable_event_listener::OnTestEnd( ::jmsd::cutf::TestInfo const &test_
 	 _event_listener->OnTestEnd( test_info );
 }
 
+void Configurable_event_listener::OnTestSuiteEnd( ::jmsd::cutf::TestSuite const &test_suite ) {
+	if ( !_showTestCases ) return;
+
+	_event_listener->OnTestSuiteEnd( test_suite );
+}
+
 void Configurable_event_listener::OnEnvironmentsTearDownStart( ::jmsd::cutf::UnitTest const &unit_test ) {
 	if ( !_showEnvironment ) return;
 
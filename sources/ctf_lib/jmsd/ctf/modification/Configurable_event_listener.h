@@ -30,10 +30,20 @@ private:
 public:
 	explicit Configurable_event_listener( TestEventListener *an_event_listener );
 
+	// Takes the --ctf_show_test_cases, --ctf_show_test_names,
+	// --ctf_show_successes, --ctf_show_inline_failures,
+	// --ctf_show_test_part_failures and --ctf_show_environment flags out of
+	// the command line, the way InitGoogleTest() takes out its own ones.
+	// Must be called before the listener is appended, as the events it
+	// forwards are decided then.
+	void Parse_flags( int *argument_counter, char **argument_string_array );
+
 	// virtual TestEventListener
 	~Configurable_event_listener() override final;
 
 	// virtuals TestEventListener
+	unsigned event_interests() const override final;
+
 	void OnTestProgramStart( ::jmsd::cutf::UnitTest const &unit_test ) override final;
 	void OnTestIterationStart( ::jmsd::cutf::UnitTest const &unit_test, int iteration ) override final;
 	void OnEnvironmentsSetUpStart( ::jmsd::cutf::UnitTest const &unit_test ) override final;
@@ -44,10 +54,12 @@ public:
 	void OnTestCaseEnd( ::testing::TestCase const &test_case ) override final;
 #endif // #ifdef GTEST_KEEP_LEGACY_TEST_CASEAPI
 
+	void OnTestSuiteStart( ::jmsd::cutf::TestSuite const &test_suite ) override final;
 	void OnTestStart( ::jmsd::cutf::TestInfo const &test_info ) override final;
 	void OnTestPartResult( ::testing::TestPartResult const &result ) override final;
 	void OnTestEnd( ::jmsd::cutf::TestInfo const &test_info ) override final;
-		void OnEnvironmentsTearDownStart( ::jmsd::cutf::UnitTest const &unit_test ) override final;
+	void OnTestSuiteEnd( ::jmsd::cutf::TestSuite const &test_suite ) override final;
+	void OnEnvironmentsTearDownStart( ::jmsd::cutf::UnitTest const &unit_test ) override final;
 	void OnEnvironmentsTearDownEnd( ::jmsd::cutf::UnitTest const &unit_test ) override final;
 	void OnTestIterationEnd( ::jmsd::cutf::UnitTest const &unit_test, int iteration ) override final;
 	void OnTestProgramEnd( ::jmsd::cutf::UnitTest const &unit_test ) override final;
@@ -44,7 +44,8 @@ Writable_command_line_arguments::Writable_command_line_arguments( int const p_ar
 		// they like it through their asses
 
 	_writable_argument_string_array = new char *[ _argument_counter ]; // for correct deletion
-	_copy_of_writable_argument_string_array = new char *[ _argument_counter ];
+	_copy_of_writable_argument_string_array = new char *[ _argument_counter + 1 ]; // argv is NULL terminated; flag parsing shifts the terminator too
+	_copy_of_writable_argument_string_array[ _argument_counter ] = nullptr;
 
 	for ( int argument_counter = 0; argument_counter < _argument_counter; ++argument_counter ) {
 		::std::size_t const length_of_argument_string = ::std::strlen( argument_string_array[ argument_counter ] ) + 1;
@@ -0,0 +1,201 @@
+#include "Benchmark_state.h"
+
+
+#include "Test.h"
+
+#include "gtest.h"
+
+#include "gtest-internal-inl.h"
+
+#include "internal/function_Streamable_to_string.hin"
+
+#include "Message.hin"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+
+namespace jmsd {
+namespace cutf {
+
+
+namespace {
+
+
+// A sample must take at least this long for the clock to measure it well.
+::testing::internal::TimeInNanos const kMinimumSampleNanos = 10 * 1000 * 1000;
+
+// The samples taken once the iteration count is calibrated.
+int const kSampleCount = 5;
+
+// Keeps a body that does nothing from looping forever.
+int64_t const kMaximumIterations = 1000 * 1000 * 1000;
+
+// The allocations made by the calling thread so far.
+thread_local int64_t allocation_count = 0;
+
+::std::atomic< bool > is_allocation_counting_enabled( false );
+
+::std::string FormatPerOperation( double const value ) {
+	::std::stringstream stream;
+	stream << ::std::fixed << ::std::setprecision( 3 ) << value;
+	return stream.str();
+}
+
+bool ShouldStop() {
+	return Test::HasFatalFailure() || Test::IsSkipped();
+}
+
+
+} // namespace
+
+
+// static
+void Benchmark_state::Run( ::std::function< void ( Benchmark_state & ) > const &body ) {
+	int64_t iterations = 1;
+
+	// Grows the iteration count until one run is long enough, aiming a bit
+	// past the minimum and never more than tenfold at a time.
+	for ( ;; ) {
+		Benchmark_state state( iterations );
+		body( state );
+
+		if ( ShouldStop() ) return;
+
+		if ( !state.is_started_ ) {
+			ADD_FAILURE() << "The benchmark body never calls state.KeepRunning().";
+			return;
+		}
+
+		if ( state.elapsed_nanos_ >= kMinimumSampleNanos || iterations >= kMaximumIterations ) break;
+
+		double const growth = state.elapsed_nanos_ <= 0 ? 10.0 :
+			::std::min( 10.0, 1.2 * static_cast< double >( kMinimumSampleNanos ) / static_cast< double >( state.elapsed_nanos_ ) );
+
+		iterations = ::std::min( kMaximumIterations, ::std::max( iterations + 1, static_cast< int64_t >( static_cast< double >( iterations ) * growth ) ) );
+	}
+
+	::std::vector< double > nanos_per_operation;
+	int64_t allocations = 0;
+
+	for ( int sample = 0; sample < kSampleCount; ++sample ) {
+		Benchmark_state state( iterations );
+		body( state );
+
+		if ( ShouldStop() ) return;
+
+		nanos_per_operation.push_back( static_cast< double >( state.elapsed_nanos_ ) / static_cast< double >( iterations ) );
+		allocations += state.allocations_;
+	}
+
+	double mean = 0;
+	for ( double const value : nanos_per_operation ) {
+		mean += value;
+	}
+	mean /= kSampleCount;
+
+	double variance = 0;
+	for ( double const value : nanos_per_operation ) {
+		variance += ( value - mean ) * ( value - mean );
+	}
+	variance /= kSampleCount - 1;
+
+	Test::RecordProperty( "iterations", internal::function_Streamable_to_string::StreamableToString( iterations ) );
+	Test::RecordProperty( "ns_per_op", FormatPerOperation( mean ) );
+	Test::RecordProperty( "ns_per_op_stddev", FormatPerOperation( ::std::sqrt( variance ) ) );
+
+	if ( IsAllocationCountingEnabled() ) {
+		Test::RecordProperty( "allocs_per_op", FormatPerOperation( static_cast< double >( allocations ) / static_cast< double >( iterations * kSampleCount ) ) );
+	}
+}
+
+void Benchmark_state::PauseTiming() {
+	if ( !is_started_ || is_finished_ || is_paused_ ) return;
+
+	elapsed_nanos_ += ::testing::internal::GetMonotonicTimeInNanos() - start_nanos_;
+	allocations_ += GetAllocationCount() - start_allocations_;
+	is_paused_ = true;
+}
+
+void Benchmark_state::ResumeTiming() {
+	if ( !is_started_ || is_finished_ || !is_paused_ ) return;
+
+	is_paused_ = false;
+	start_allocations_ = GetAllocationCount();
+	start_nanos_ = ::testing::internal::GetMonotonicTimeInNanos();
+}
+
+int64_t Benchmark_state::iterations() const {
+	return iterations_;
+}
+
+// static
+void Benchmark_state::CountAllocation() {
+	++allocation_count;
+}
+
+// static
+void Benchmark_state::EnableAllocationCounting() {
+	is_allocation_counting_enabled.store( true, ::std::memory_order_relaxed );
+}
+
+// static
+void Benchmark_state::DisableAllocationCounting() {
+	is_allocation_counting_enabled.store( false, ::std::memory_order_relaxed );
+}
+
+// static
+bool Benchmark_state::IsAllocationCountingEnabled() {
+	return is_allocation_counting_enabled.load( ::std::memory_order_relaxed );
+}
+
+Benchmark_state::Benchmark_state( int64_t const iterations )
+	:
+		iterations_( iterations ),
+		remaining_( 0 ),
+		is_started_( false ),
+		is_finished_( false ),
+		is_paused_( false ),
+		start_nanos_( 0 ),
+		elapsed_nanos_( 0 ),
+		start_allocations_( 0 ),
+		allocations_( 0 )
+{}
+
+// Called by KeepRunning() once the iterations run out: the first time to
+// start the timer, the second time to stop it.
+bool Benchmark_state::StartOrStop() {
+	if ( !is_started_ ) {
+		is_started_ = true;
+		remaining_ = iterations_ - 1;
+		start_allocations_ = GetAllocationCount();
+		start_nanos_ = ::testing::internal::GetMonotonicTimeInNanos();
+		return true;
+	}
+
+	if ( !is_finished_ ) {
+		PauseTiming();
+		is_finished_ = true;
+	}
+
+	return false;
+}
+
+// static
+int64_t Benchmark_state::GetAllocationCount() {
+	return allocation_count;
+}
+
+
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
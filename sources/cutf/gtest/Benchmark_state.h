@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Benchmark_state.hxx"
+
+
+#include "internal/gtest-port.h"
+
+#include <cstdint>
+#include <functional>
+
+
+#include "cutf.h"
+
+
+namespace jmsd {
+namespace cutf {
+
+
+// The state of a benchmark defined with BENCHMARK_F() or TEST_BENCH().  The
+// body of a benchmark loops while KeepRunning() returns true, and only the
+// time (and the allocations) spent inside that loop are measured:
+//
+//   TEST_BENCH(StringBench, Append) {
+//     while (state.KeepRunning()) {
+//       std::string s;
+//       s.append("x");
+//     }
+//   }
+//
+// Run() calls the body with growing iteration counts until one call takes
+// long enough to be measured, then takes a few samples at that count and
+// records the results as properties of the current test, so they appear in
+// the XML and JSON reports like any other RecordProperty() value:
+//
+//   iterations        - the iteration count of every sample;
+//   ns_per_op         - the mean time of one iteration, in nanoseconds;
+//   ns_per_op_stddev  - the standard deviation of ns_per_op over the samples;
+//   allocs_per_op     - the mean count of allocations of one iteration, only
+//                       when allocation counting is enabled (see
+//                       Benchmark_allocation_counting.hin).
+class JMSD_CUTF_SHARED_INTERFACE Benchmark_state {
+
+public:
+	// Calibrates and samples the body, then records its properties.  Stops
+	// early, without recording anything, if the body fails fatally or skips.
+	static void Run( ::std::function< void ( Benchmark_state & ) > const &body );
+
+	// Returns true while the body should do one more iteration.  The first
+	// call starts the timer and the last one stops it.
+	bool KeepRunning() {
+		if ( remaining_ > 0 ) {
+			--remaining_;
+			return true;
+		}
+
+		return StartOrStop();
+	}
+
+	// Excludes the work between the two calls (e.g. setting up the input of
+	// the next iteration) from the measurement.
+	void PauseTiming();
+	void ResumeTiming();
+
+	// The number of iterations of this call of the body.
+	int64_t iterations() const;
+
+	// Called by the replacement operator new of Benchmark_allocation_counting.hin
+	// for every allocation of the calling thread.
+	static void CountAllocation();
+
+	// Turns on the allocs_per_op property; called once the replacement
+	// operator new is in place.
+	static void EnableAllocationCounting();
+
+	// Turns the allocs_per_op property off again.
+	static void DisableAllocationCounting();
+
+	static bool IsAllocationCountingEnabled();
+
+private:
+	explicit Benchmark_state( int64_t iterations );
+
+	bool StartOrStop();
+
+	static int64_t GetAllocationCount();
+
+	int64_t const iterations_;
+
+	// The iterations left after the current one.
+	int64_t remaining_;
+
+	bool is_started_;
+	bool is_finished_;
+	bool is_paused_;
+
+	::testing::internal::TimeInNanos start_nanos_;
+	::testing::internal::TimeInNanos elapsed_nanos_;
+
+	int64_t start_allocations_;
+	int64_t allocations_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Benchmark_state );
+};
+
+
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
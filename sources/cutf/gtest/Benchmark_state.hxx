@@ -0,0 +1,18 @@
+#pragma once
+
+
+namespace jmsd {
+namespace cutf {
+
+
+class Benchmark_state;
+
+
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -8,6 +8,8 @@
 
 #include "internal/gtest-string.h"
 #include "internal/Colored_print.h"
+#include "internal/Console_output.h"
+#include "internal/Format_time.h"
 #include "internal/gtest-constants-internal.h"
 #include "internal/function_Print_test_part_result.h"
 #include "internal/function_Print_full_test_comment_if_present.h"
@@ -63,13 +65,13 @@ void PrettyUnitTestResultPrinter::OnTestIterationStart( ::jmsd::cutf::UnitTest c
 		 function_Format_countable::FormatTestCount( unit_test.test_to_run_count() ).c_str(),
 		 function_Format_countable::FormatTestSuiteCount( unit_test.test_suite_to_run_count() ).c_str());
 
-	::fflush( stdout );
+	internal::Console_output::FlushIfDue();
 }
 
 void PrettyUnitTestResultPrinter::OnEnvironmentsSetUpStart( ::jmsd::cutf::UnitTest const & /*unit_test*/ ) {
 	internal::Colored_print::ColoredPrintf( internal::GTestColor::COLOR_GREEN,  "[----------] " );
 	::printf( "Global test environment set-up.\n" );
-	::fflush( stdout );
+	internal::Console_output::FlushIfDue();
 }
 
 #ifdef GTEST_KEEP_LEGACY_TEST_CASEAPI_
@@ -83,7 +85,7 @@ void PrettyUnitTestResultPrinter::OnTestCaseStart(const TestCase& test_case) {
   } else {
 	printf(", where %s = %s\n", kTypeParamLabel, test_case.type_param());
   }
-  fflush(stdout);
+  internal::Console_output::FlushIfDue();
 }
 
 void PrettyUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
@@ -94,7 +96,7 @@ void PrettyUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
   internal::Colored_print::ColoredPrintf(COLOR_GREEN, "[----------] ");
   printf("%s from %s (%s ms total)\n\n", counts.c_str(), test_case.name(),
 		 internal::StreamableToString(test_case.elapsed_time()).c_str());
-  fflush(stdout);
+  internal::Console_output::FlushIfDue();
 }
 #endif // #ifdef GTEST_KEEP_LEGACY_TEST_CASEAPI_
 
@@ -107,7 +109,7 @@ void PrettyUnitTestResultPrinter::OnTestSuiteStart( ::jmsd::cutf::TestSuite cons
   } else {
 	printf(", where %s = %s\n", constants::internal::kTypeParamLabel, test_suite.type_param());
   }
-  fflush(stdout);
+  internal::Console_output::FlushIfDue();
 }
 
 
@@ -115,7 +117,7 @@ void PrettyUnitTestResultPrinter::OnTestStart(const ::jmsd::cutf::TestInfo& test
   internal::Colored_print::ColoredPrintf(internal::GTestColor::COLOR_GREEN,  "[ RUN      ] ");
   PrintTestName(test_info.test_suite_name(), test_info.name());
   printf("\n");
-  fflush(stdout);
+  internal::Console_output::FlushIfDue();
 }
 
 // Called after an assertion failure.
@@ -129,7 +131,7 @@ void PrettyUnitTestResultPrinter::OnTestPartResult(
 	  // Print failure message from the assertion
 	  // (e.g. expected this and got that).
 	  internal::function_Print_test_part_result::PrintTestPartResult( result );
-	  fflush(stdout);
+	  internal::Console_output::Flush();
   }
 }
 
@@ -146,11 +148,16 @@ void PrettyUnitTestResultPrinter::OnTestEnd(const ::jmsd::cutf::TestInfo& test_i
 	internal::function_Print_full_test_comment_if_present::PrintFullTestCommentIfPresent(test_info);
 
   if ( ::testing:: GTEST_FLAG( print_time ) ) {
-	printf(" (%s ms)\n", internal::function_Streamable_to_string::StreamableToString( test_info.result()->elapsed_time()).c_str() );
+	printf(" (%s ms)\n", internal::Format_time::FormatTimeInNanosAsMillis( test_info.result()->elapsed_time_nanos()).c_str() );
   } else {
 	printf("\n");
   }
-  fflush(stdout);
+
+  if (test_info.result()->Failed()) {
+	internal::Console_output::Flush();
+  } else {
+	internal::Console_output::FlushIfDue();
+  }
 }
 
 void PrettyUnitTestResultPrinter::OnTestSuiteEnd(const ::jmsd::cutf::TestSuite& test_suite) {
@@ -158,15 +165,15 @@ void PrettyUnitTestResultPrinter::OnTestSuiteEnd(const ::jmsd::cutf::TestSuite&
 
   const std::string counts = function_Format_countable::FormatCountableNoun(test_suite.test_to_run_count(), "test", "tests");
   internal::Colored_print::ColoredPrintf(internal::GTestColor::COLOR_GREEN, "[----------] ");
-  printf("%s from %s (%s ms total)\n\n", counts.c_str(), test_suite.name(), internal::function_Streamable_to_string::StreamableToString(test_suite.elapsed_time()).c_str());
-  fflush(stdout);
+  printf("%s from %s (%s ms total)\n\n", counts.c_str(), test_suite.name(), internal::Format_time::FormatTimeInNanosAsMillis(test_suite.elapsed_time_nanos()).c_str());
+  internal::Console_output::FlushIfDue();
 }
 
 void PrettyUnitTestResultPrinter::OnEnvironmentsTearDownStart(
 	const ::jmsd::cutf::UnitTest& /*unit_test*/) {
   internal::Colored_print::ColoredPrintf(internal::GTestColor::COLOR_GREEN,  "[----------] ");
   printf("Global test environment tear-down\n");
-  fflush(stdout);
+  internal::Console_output::FlushIfDue();
 }
 
 // Internal helper for printing the list of failed tests.
@@ -248,7 +255,7 @@ void PrettyUnitTestResultPrinter::OnTestIterationEnd(const ::jmsd::cutf::UnitTes
 		 function_Format_countable::FormatTestCount(unit_test.test_to_run_count()).c_str(),
 		 function_Format_countable::FormatTestSuiteCount(unit_test.test_suite_to_run_count()).c_str());
   if ( ::testing:: GTEST_FLAG( print_time ) ) {
-	printf(" (%s ms total)", internal::function_Streamable_to_string::StreamableToString(unit_test.elapsed_time()).c_str());
+	printf(" (%s ms total)", internal::Format_time::FormatTimeInNanosAsMillis(unit_test.elapsed_time_nanos()).c_str());
   }
   printf("\n");
   internal::Colored_print::ColoredPrintf(internal::GTestColor::COLOR_GREEN,  "[  PASSED  ] ");
@@ -277,7 +284,7 @@ void PrettyUnitTestResultPrinter::OnTestIterationEnd(const ::jmsd::cutf::UnitTes
 				  num_disabled == 1 ? "TEST" : "TESTS");
   }
   // Ensure that Google Test output is printed before, e.g., heapchecker output.
-  fflush(stdout);
+  internal::Console_output::Flush();
 }
 
 
@@ -9,6 +9,11 @@ TestEventListener::~TestEventListener()
 {}
 
 
+unsigned TestEventListener::event_interests() const {
+	return kAllEvents;
+}
+
+
 void TestEventListener::OnTestSuiteStart( TestSuite const & /*test_suite*/ )
 {}
 
@@ -20,8 +20,35 @@ namespace cutf {
 // The interface for tracing execution of tests. The methods are organized in the order the corresponding events are fired.
 class JMSD_DEPRECATED_GTEST_API_ TestEventListener {
 public:
+	// The events a listener can ask for, one bit each.  The legacy test case
+	// events go with the test suite ones.
+	enum Event_interest : unsigned {
+		kOnTestProgramStart = 1u << 0,
+		kOnTestIterationStart = 1u << 1,
+		kOnEnvironmentsSetUpStart = 1u << 2,
+		kOnEnvironmentsSetUpEnd = 1u << 3,
+		kOnTestSuiteStart = 1u << 4,
+		kOnTestStart = 1u << 5,
+		kOnTestPartResult = 1u << 6,
+		kOnTestEnd = 1u << 7,
+		kOnTestSuiteEnd = 1u << 8,
+		kOnEnvironmentsTearDownStart = 1u << 9,
+		kOnEnvironmentsTearDownEnd = 1u << 10,
+		kOnTestIterationEnd = 1u << 11,
+		kOnTestProgramEnd = 1u << 12,
+
+		kEventCount = 13,
+		kAllEvents = ( 1u << kEventCount ) - 1
+	};
+
 	virtual ~TestEventListener() = 0;
 
+	// The events this listener wants to receive, as a combination of
+	// Event_interest bits.  TestEventListeners asks once, when the listener is
+	// appended, and doesn't forward the other events to it.  All of them by
+	// default.
+	virtual unsigned event_interests() const;
+
 	// Fired before any test activity starts.
 	virtual void OnTestProgramStart( UnitTest const &unit_test ) = 0;
 
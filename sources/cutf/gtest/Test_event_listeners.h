@@ -11,6 +11,7 @@
 #include "internal/Test_event_repeater.hxx"
 #include "internal/Default_global_test_part_result_reporter.hxx"
 #include "internal/Unit_test_impl.hxx"
+#include "internal/Parallel_test_runner.hxx"
 
 #include "gtest-death-test.hxx"
 
@@ -68,6 +69,7 @@ class JMSD_DEPRECATED_GTEST_API_ TestEventListeners {
 	friend internal::UnitTestImpl;
 	friend ::testing::internal::NoExecDeathTest;
 	friend internal::DefaultGlobalTestPartResultReporter;
+	friend internal::Parallel_test_runner;
 
 private: // testing
 	friend ::testing::internal::TestEventListenersAccessor; // gtest_unittest.cc
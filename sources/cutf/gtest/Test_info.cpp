@@ -180,12 +180,14 @@ void TestInfo::Run() {
   internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
   impl->set_current_test_info(this);
 
-  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
+  // On a parallel worker the events are recorded and published when the unit is done.
+  TestEventListener* repeater = impl->event_sink();
 
   // Notifies the unit test event listeners that a test is about to start.
   repeater->OnTestStart(*this);
 
   ::testing::internal::TimeInMillis const start = ::testing::internal::GetTimeInMillis();
+  ::testing::internal::TimeInNanos const start_nanos = ::testing::internal::GetMonotonicTimeInNanos();
 
   impl->os_stack_trace_getter()->UponLeavingGTest();
 
@@ -209,7 +211,11 @@ void TestInfo::Run() {
   }
 
   result_->set_start_timestamp(start);
-  result_->set_elapsed_time(::testing::internal::GetTimeInMillis() - start);
+  result_->set_elapsed_time_nanos(::testing::internal::GetMonotonicTimeInNanos() - start_nanos);
+
+  // Takes the results of the threads the test started; those they report
+  // from now on go to the ad hoc test result.
+  impl->MergeAndClosePendingTestPartResults();
 
   // Notifies the unit test event listener that a test has just finished.
   repeater->OnTestEnd(*this);
@@ -8,6 +8,7 @@
 #include "internal/gtest-port.h"
 
 #include "internal/Unit_test_impl.hxx"
+#include "internal/Parallel_test_runner.hxx"
 #include "Test_suite.hxx"
 
 
@@ -106,6 +107,7 @@ class JMSD_DEPRECATED_GTEST_API_ TestInfo {
   friend Test;
   friend TestSuite;
   friend internal::UnitTestImpl;
+  friend internal::Parallel_test_runner;
   friend ::testing::internal::StreamingListenerTest;
 
   friend TestInfo* internal::function_Make_and_register_test_info::MakeAndRegisterTestInfo(
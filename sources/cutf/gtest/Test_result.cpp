@@ -1,10 +1,10 @@
 #include "Test_result.h"
 
 
-#include "internal/function_Stl_utilities.hin"
-
 #include "Text_output_utilities.hxx"
 
+#include <thread>
+
 
 namespace jmsd {
 namespace cutf {
@@ -12,12 +12,30 @@ namespace cutf {
 
 // class TestResult
 
+struct TestResult::PendingTestPartResult {
+  PendingTestPartResult(const ::testing::TestPartResult& a_result)
+	  : result(a_result), next(nullptr), is_counted(false) {}
+
+  ::testing::TestPartResult result;
+  PendingTestPartResult* next;
+  // Set once the result is in the counts, which is after it's listed.
+  std::atomic<bool> is_counted;
+};
+
 // Creates an empty TestResult.
 TestResult::TestResult()
-	: death_test_count_(0), start_timestamp_(0), elapsed_time_(0) {}
+	: pending_test_part_results_(nullptr),
+	  fatal_failure_count_(0),
+	  nonfatal_failure_count_(0),
+	  skip_count_(0),
+	  death_test_count_(0),
+	  start_timestamp_(0),
+	  elapsed_time_(0),
+	  elapsed_time_nanos_(0) {}
 
 // D'tor.
 TestResult::~TestResult() {
+  DiscardPendingTestPartResults();
 }
 
 // Returns the i-th test part result among all the results. i can
@@ -40,12 +58,127 @@ const TestProperty& TestResult::GetTestProperty(int i) const {
 
 // Clears the test part results.
 void TestResult::ClearTestPartResults() {
+  DiscardPendingTestPartResults();
   test_part_results_.clear();
+  fatal_failure_count_ = 0;
+  nonfatal_failure_count_ = 0;
+  skip_count_ = 0;
 }
 
 // Adds a test part result to the list.
 void TestResult::AddTestPartResult(const ::testing::TestPartResult& test_part_result) {
   test_part_results_.push_back(test_part_result);
+  CountTestPartResult(test_part_result, 1);
+}
+
+// Keeps a test part result reported by a thread that doesn't run the test
+// until MergePendingTestPartResults() is called, and counts it.
+bool TestResult::AddPendingTestPartResult(const ::testing::TestPartResult& test_part_result) {
+  PendingTestPartResult* const closed = closed_pending_test_part_results();
+  PendingTestPartResult* const pending = new PendingTestPartResult(test_part_result);
+  pending->next = pending_test_part_results_.load(std::memory_order_relaxed);
+
+  do {
+	if (pending->next == closed) {
+	  delete pending;
+	  return false;
+	}
+  } while (!pending_test_part_results_.compare_exchange_weak(
+	  pending->next, pending, std::memory_order_release, std::memory_order_relaxed));
+
+  // Only counted once listed, so a closed TestResult is never counted into;
+  // the merge waits for the count before the result leaves the list.
+  CountTestPartResult(test_part_result, 1);
+  pending->is_counted.store(true, std::memory_order_release);
+  return true;
+}
+
+// Appends the pending test part results to the list, in the order they were
+// reported, and returns how many there were.
+int TestResult::MergePendingTestPartResults() {
+  // The common case: nobody else reported anything.
+  PendingTestPartResult* const head = pending_test_part_results_.load(std::memory_order_relaxed);
+  if (head == nullptr || head == closed_pending_test_part_results()) {
+	return 0;
+  }
+
+  return MergePendingTestPartResults(nullptr);
+}
+
+// Appends the pending test part results to the list and closes the
+// TestResult.
+int TestResult::MergeAndClosePendingTestPartResults() {
+  return MergePendingTestPartResults(closed_pending_test_part_results());
+}
+
+// static
+TestResult::PendingTestPartResult* TestResult::closed_pending_test_part_results() {
+  static PendingTestPartResult closed(::testing::TestPartResult(
+	  ::testing::TestPartResult::kSuccess, nullptr, -1, ""));
+  return &closed;
+}
+
+// Takes the pending list, leaving the given one in its place, and appends it
+// to the list of test part results.
+int TestResult::MergePendingTestPartResults(PendingTestPartResult* replacement) {
+  PendingTestPartResult* pending = pending_test_part_results_.exchange(replacement, std::memory_order_acquire);
+  if (pending == closed_pending_test_part_results()) {
+	pending = nullptr;
+  }
+
+  // Reverses the list, which starts at the latest result.  A result whose
+  // reporter is yet to count it is waited for, so the counts never miss a
+  // listed result.
+  PendingTestPartResult* oldest = nullptr;
+  int count = 0;
+  while (pending != nullptr) {
+	while (!pending->is_counted.load(std::memory_order_acquire)) {
+	  std::this_thread::yield();
+	}
+	PendingTestPartResult* const next = pending->next;
+	pending->next = oldest;
+	oldest = pending;
+	pending = next;
+	++count;
+  }
+
+  test_part_results_.reserve(test_part_results_.size() + static_cast<size_t>(count));
+  while (oldest != nullptr) {
+	PendingTestPartResult* const next = oldest->next;
+	test_part_results_.push_back(oldest->result);
+	delete oldest;
+	oldest = next;
+  }
+
+  return count;
+}
+
+// Deletes the pending test part results without merging them, which also
+// reopens a closed TestResult.
+void TestResult::DiscardPendingTestPartResults() {
+  PendingTestPartResult* pending = pending_test_part_results_.exchange(nullptr, std::memory_order_acquire);
+  if (pending == closed_pending_test_part_results()) {
+	pending = nullptr;
+  }
+  while (pending != nullptr) {
+	while (!pending->is_counted.load(std::memory_order_acquire)) {
+	  std::this_thread::yield();
+	}
+	PendingTestPartResult* const next = pending->next;
+	delete pending;
+	pending = next;
+  }
+}
+
+// Adds delta to the count of the kind of the test part result.
+void TestResult::CountTestPartResult(const ::testing::TestPartResult& test_part_result, int delta) {
+  if (test_part_result.fatally_failed()) {
+	fatal_failure_count_.fetch_add(delta, std::memory_order_relaxed);
+  } else if (test_part_result.nonfatally_failed()) {
+	nonfatal_failure_count_.fetch_add(delta, std::memory_order_relaxed);
+  } else if (test_part_result.skipped()) {
+	skip_count_.fetch_add(delta, std::memory_order_relaxed);
+  }
 }
 
 // Adds a test property to the list. If a property with the same key as the
@@ -77,51 +210,39 @@ bool TestResult::ValidateTestProperty(const std::string& xml_element,
 								  ::jmsd::cutf::GetReservedAttributesForElement(xml_element));
 }
 
+// Sets the elapsed time, in nanoseconds; elapsed_time() is derived from it.
+void TestResult::set_elapsed_time_nanos(::testing::internal::TimeInNanos elapsed) {
+  elapsed_time_nanos_ = elapsed;
+  elapsed_time_ = ::testing::internal::NanosToMillis(elapsed);
+}
+
 // Clears the object.
 void TestResult::Clear() {
-  test_part_results_.clear();
+  ClearTestPartResults();
   test_properties_.clear();
   death_test_count_ = 0;
   elapsed_time_ = 0;
-}
-
-// Returns true off the test part was skipped.
-static bool TestPartSkipped(const ::testing::TestPartResult& result) {
-  return result.skipped();
+  elapsed_time_nanos_ = 0;
 }
 
 // Returns true if and only if the test was skipped.
 bool TestResult::Skipped() const {
-  return !Failed() && internal::function_Stl_utilities::CountIf(test_part_results_, TestPartSkipped) > 0;
+  return !Failed() && skip_count_.load(std::memory_order_relaxed) > 0;
 }
 
 // Returns true if and only if the test failed.
 bool TestResult::Failed() const {
-  for (int i = 0; i < total_part_count(); ++i) {
-	if (GetTestPartResult(i).failed())
-	  return true;
-  }
-  return false;
-}
-
-// Returns true if and only if the test part fatally failed.
-static bool TestPartFatallyFailed(const ::testing::TestPartResult& result) {
-  return result.fatally_failed();
+  return HasFatalFailure() || HasNonfatalFailure();
 }
 
 // Returns true if and only if the test fatally failed.
 bool TestResult::HasFatalFailure() const {
-  return internal::function_Stl_utilities::CountIf(test_part_results_, TestPartFatallyFailed) > 0;
-}
-
-// Returns true if and only if the test part non-fatally failed.
-static bool TestPartNonfatallyFailed(const ::testing::TestPartResult& result) {
-  return result.nonfatally_failed();
+  return fatal_failure_count_.load(std::memory_order_relaxed) > 0;
 }
 
 // Returns true if and only if the test has a non-fatal failure.
 bool TestResult::HasNonfatalFailure() const {
-  return internal::function_Stl_utilities::CountIf(test_part_results_, TestPartNonfatallyFailed) > 0;
+  return nonfatal_failure_count_.load(std::memory_order_relaxed) > 0;
 }
 
 // Gets the number of all test parts.  This is the sum of the number
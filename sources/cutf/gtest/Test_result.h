@@ -16,12 +16,15 @@
 #include "internal/Unit_test_impl.hxx"
 #include "internal/Windows_death_test.hxx"
 
+#include <atomic>
+
 
 namespace testing {
 namespace internal {
 
 
 class ExecDeathTest;
+class ForkServerDeathTest;
 
 
 } // namespace internal
@@ -38,6 +41,15 @@ namespace cutf {
 // death tests there are in the Test, and how much time it took to run
 // the Test.
 //
+// The outcome queries (Passed(), Failed(), HasFatalFailure(), ...) take
+// constant time: the results are counted by kind as they are added.
+//
+// Only the thread running the test appends to the list of test parts.  The
+// results reported by the other threads wait in a lock-free list until that
+// thread merges them, and are counted as soon as they are in it, so the
+// outcome queries see them before the list does (and never a count without
+// its result once the TestResult is closed).
+//
 // TestResult is not copyable.
 class JMSD_DEPRECATED_GTEST_API_ TestResult {
  public:
@@ -72,6 +84,9 @@ class JMSD_DEPRECATED_GTEST_API_ TestResult {
   // Returns the elapsed time, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time() const { return elapsed_time_; }
 
+  // Returns the elapsed time, in nanoseconds of a monotonic clock.
+  ::testing::internal::TimeInNanos elapsed_time_nanos() const { return elapsed_time_nanos_; }
+
   // Gets the time of the test case start, in ms from the start of the
   // UNIX epoch.
   ::testing::internal::TimeInMillis start_timestamp() const { return start_timestamp_; }
@@ -95,6 +110,7 @@ class JMSD_DEPRECATED_GTEST_API_ TestResult {
 
   friend internal::WindowsDeathTest;
   friend ::testing::internal::ExecDeathTest;
+  friend ::testing::internal::ForkServerDeathTest;
   //friend class internal::FuchsiaDeathTest;
 
   // Gets the vector of TestPartResults.
@@ -110,8 +126,8 @@ class JMSD_DEPRECATED_GTEST_API_ TestResult {
   // Sets the start time.
   void set_start_timestamp(::testing::internal::TimeInMillis start) { start_timestamp_ = start; }
 
-  // Sets the elapsed time.
-  void set_elapsed_time(::testing::internal::TimeInMillis elapsed) { elapsed_time_ = elapsed; }
+  // Sets the elapsed time, in nanoseconds; elapsed_time() is derived from it.
+  void set_elapsed_time_nanos(::testing::internal::TimeInNanos elapsed);
 
   // Adds a test property to the list. The property is validated and may add
   // a non-fatal failure if invalid (e.g., if it conflicts with reserved
@@ -131,6 +147,26 @@ class JMSD_DEPRECATED_GTEST_API_ TestResult {
   // Adds a test part result to the list.
   void AddTestPartResult(const ::testing::TestPartResult& test_part_result);
 
+  // Keeps a test part result reported by a thread that doesn't run the test
+  // until MergePendingTestPartResults() is called, and counts it.  Can be
+  // called by several threads at once.  Returns false, keeping nothing, if
+  // the result has been closed.
+  //
+  // The listeners only hear of such a result when the thread running the
+  // test merges it, so a test that hangs never prints the failures of the
+  // threads it started.
+  bool AddPendingTestPartResult(const ::testing::TestPartResult& test_part_result);
+
+  // Appends the pending test part results to the list, in the order they
+  // were reported, and returns how many there were.  Must be called by the
+  // thread running the test.
+  int MergePendingTestPartResults();
+
+  // Like MergePendingTestPartResults(), and makes AddPendingTestPartResult()
+  // refuse any result reported later, which would otherwise be counted but
+  // never listed.  Clearing the results reopens the TestResult.
+  int MergeAndClosePendingTestPartResults();
+
   // Returns the death test count.
   int death_test_count() const { return death_test_count_; }
 
@@ -147,8 +183,34 @@ class JMSD_DEPRECATED_GTEST_API_ TestResult {
   // properties, whose values may be updated.
   ::testing::internal::Mutex test_properites_mutex_;
 
+  // A test part result reported by another thread, in a list linked from
+  // the latest one.
+  struct PendingTestPartResult;
+
+  // Returns the marker that stands for the pending list of a closed
+  // TestResult.
+  static PendingTestPartResult* closed_pending_test_part_results();
+
+  // Takes the pending list, leaving the given one in its place, and appends
+  // it to test_part_results_.  Returns how many results there were.
+  int MergePendingTestPartResults(PendingTestPartResult* replacement);
+
+  // Deletes the pending test part results without merging them.
+  void DiscardPendingTestPartResults();
+
+  // Adds delta to the count of the kind of the test part result.
+  void CountTestPartResult(const ::testing::TestPartResult& test_part_result, int delta);
+
   // The vector of TestPartResults
   std::vector<::testing::TestPartResult> test_part_results_;
+  // The results reported by the other threads and not merged yet, or
+  // closed_pending_test_part_results().
+  std::atomic<PendingTestPartResult*> pending_test_part_results_;
+  // How many of them are fatal failures, non-fatal failures and skips,
+  // pending ones included.
+  std::atomic<int> fatal_failure_count_;
+  std::atomic<int> nonfatal_failure_count_;
+  std::atomic<int> skip_count_;
   // The vector of TestProperties
   std::vector< ::jmsd::cutf::TestProperty > test_properties_;
   // Running count of death tests.
@@ -157,6 +219,8 @@ class JMSD_DEPRECATED_GTEST_API_ TestResult {
   ::testing::internal::TimeInMillis start_timestamp_;
   // The elapsed time, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time_;
+  // The elapsed time, in nanoseconds.
+  ::testing::internal::TimeInNanos elapsed_time_nanos_;
 
   // We disallow copying TestResult.
   GTEST_DISALLOW_COPY_AND_ASSIGN_(TestResult);
@@ -69,6 +69,11 @@ bool TestSuite::Failed() const {
 	return elapsed_time_;
 }
 
+// Returns the elapsed time, in nanoseconds of a monotonic clock.
+::testing::internal::TimeInNanos TestSuite::elapsed_time_nanos() const {
+	return elapsed_time_nanos_;
+}
+
 // Gets the time of the test suite start, in ms from the start of the
 // UNIX epoch.
 ::testing::internal::TimeInMillis TestSuite::start_timestamp() const {
@@ -179,6 +184,7 @@ TestSuite::TestSuite(const char* a_name, const char* a_type_param,
 	  should_run_(false),
 	  start_timestamp_(0),
 	  elapsed_time_(0),
+	  elapsed_time_nanos_(0),
 	  ad_hoc_test_result_( new TestResult )
 {}
 
@@ -234,7 +240,8 @@ void TestSuite::Run() {
   internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
   impl->set_current_test_suite(this);
 
-  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
+  // On a parallel worker the events are recorded and published when the unit is done.
+  TestEventListener* repeater = impl->event_sink();
 
   // Call both legacy and the new API
   repeater->OnTestSuiteStart(*this);
@@ -248,17 +255,23 @@ void TestSuite::Run() {
   internal::HandleExceptionsInMethodIfSupported( this, &TestSuite::RunSetUpTestSuite, "SetUpTestSuite()" );
 
   start_timestamp_ = ::testing::internal::GetTimeInMillis();
+  const ::testing::internal::TimeInNanos start_nanos = ::testing::internal::GetMonotonicTimeInNanos();
 
   for (int i = 0; i < total_test_count(); i++) {
 	GetMutableTestInfo(i)->Run();
   }
 
-  elapsed_time_ = ::testing::internal::GetTimeInMillis() - start_timestamp_;
+  elapsed_time_nanos_ = ::testing::internal::GetMonotonicTimeInNanos() - start_nanos;
+  elapsed_time_ = ::testing::internal::NanosToMillis(elapsed_time_nanos_);
 
   impl->os_stack_trace_getter()->UponLeavingGTest();
 
   internal::HandleExceptionsInMethodIfSupported( this, &TestSuite::RunTearDownTestSuite, "TearDownTestSuite()");
 
+  // Takes the results of the threads SetUpTestSuite() and
+  // TearDownTestSuite() started.
+  impl->MergeAndClosePendingTestPartResults();
+
   // Call both legacy and the new API
   repeater->OnTestSuiteEnd(*this);
 //  Legacy API is deprecated but still available
@@ -12,6 +12,7 @@
 
 
 #include "internal/Unit_test_impl.hxx"
+#include "internal/Parallel_test_runner.hxx"
 #include "internal/Random_number_generator.hxx"
 
 #include <memory>
@@ -97,6 +98,9 @@ public:
   // Returns the elapsed time, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time() const;
 
+  // Returns the elapsed time, in nanoseconds of a monotonic clock.
+  ::testing::internal::TimeInNanos elapsed_time_nanos() const;
+
   // Gets the time of the test suite start, in ms from the start of the
   // UNIX epoch.
   ::testing::internal::TimeInMillis start_timestamp() const;
@@ -112,6 +116,7 @@ public:
  private:
   friend Test;
   friend internal::UnitTestImpl;
+  friend internal::Parallel_test_runner;
 
   // Gets the (mutable) vector of TestInfos in this TestSuite.
   std::vector< TestInfo * > &test_info_list();
@@ -197,6 +202,8 @@ public:
   ::testing::internal::TimeInMillis start_timestamp_;
   // Elapsed time, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time_;
+  // Elapsed time, in nanoseconds.
+  ::testing::internal::TimeInNanos elapsed_time_nanos_;
   // Holds test properties recorded during execution of SetUpTestSuite and
   // TearDownTestSuite.
   ::std::unique_ptr< TestResult > ad_hoc_test_result_; // originaly it was just a data field, not a smart pointer
@@ -15,6 +15,7 @@ namespace cutf {
 	"random_seed",
 	"tests",
 	"time",
+	"time_ns",
 	"timestamp"
 };
 
@@ -27,6 +28,7 @@ namespace cutf {
 	"name",
 	"tests",
 	"time",
+	"time_ns",
 	"timestamp"
 };
 
@@ -37,6 +39,7 @@ namespace cutf {
 	"name",
 	"status",
 	"time",
+	"time_ns",
 	"type_param",
 	"value_param",
 	"file",
@@ -50,6 +53,7 @@ namespace cutf {
 	"name",
 	"status",
 	"time",
+	"time_ns",
 	"type_param",
 	"value_param",
 	"file",
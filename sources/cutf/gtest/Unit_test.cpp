@@ -127,6 +127,11 @@ int UnitTest::test_to_run_count() const {
   return impl()->elapsed_time();
 }
 
+// Gets the elapsed time, in nanoseconds of a monotonic clock.
+::testing::internal::TimeInNanos UnitTest::elapsed_time_nanos() const {
+  return impl()->elapsed_time_nanos();
+}
+
 // Returns true if and only if the unit test passed (i.e. all test suites
 // passed).
 bool UnitTest::Passed() const {
@@ -209,10 +214,22 @@ void UnitTest::AddTestPartResult(
 	const std::string& message,
 	const std::string& os_stack_trace) GTEST_LOCK_EXCLUDED_(mutex_)
 {
+  AddTestPartResult(result_type, file_name, line_number, message, internal::Stack_trace(os_stack_trace));
+}
+
+void UnitTest::AddTestPartResult(
+	::testing::TestPartResult::Type result_type,
+	const char* file_name,
+	int line_number,
+	const std::string& message,
+	const internal::Stack_trace& os_stack_trace) GTEST_LOCK_EXCLUDED_(mutex_)
+{
+  // No lock is taken: the trace stack belongs to the calling thread, and the
+  // results of the threads that don't run tests are merged later on (see
+  // UnitTestImpl::MergePendingTestPartResults()).
   Message msg;
   msg << message;
 
-  ::testing::internal::MutexLock lock(&mutex_);
   if (impl_->gtest_trace_stack().size() > 0) {
 	msg << "\n" << GTEST_NAME_ << " trace:";
 
@@ -223,11 +240,9 @@ void UnitTest::AddTestPartResult(
 	}
   }
 
-  if (os_stack_trace.c_str() != nullptr && !os_stack_trace.empty()) {
-	msg << constants::internal::kStackTraceMarker << os_stack_trace;
-  }
-
-  const ::testing::TestPartResult result = ::testing::TestPartResult( result_type, file_name, line_number, msg.GetString().c_str() );
+  // The trace is kept apart from the message, and its frames are only
+  // symbolized when a printer reports the result.
+  const ::testing::TestPartResult result = ::testing::TestPartResult( result_type, file_name, line_number, msg.GetString().c_str(), os_stack_trace );
   impl_->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult( result );
 
   if ( result_type != ::testing::TestPartResult::kSuccess && result_type != ::testing::TestPartResult::kSkip ) {
@@ -418,13 +433,11 @@ UnitTest::~UnitTest() {
 // Google Test trace stack.
 void UnitTest::PushGTestTrace(const ::testing::internal::TraceInfo& trace)
 	GTEST_LOCK_EXCLUDED_(mutex_) {
-  ::testing::internal::MutexLock lock(&mutex_);
   impl_->gtest_trace_stack().push_back(trace);
 }
 
 // Pops a trace from the per-thread Google Test trace stack.
 void UnitTest::PopGTestTrace() GTEST_LOCK_EXCLUDED_(mutex_) {
-  ::testing::internal::MutexLock lock(&mutex_);
   impl_->gtest_trace_stack().pop_back();
 }
 
@@ -17,6 +17,7 @@
 #include "Environment.hxx"
 #include "function_Add_global_test_environment.hxx"
 #include "internal/Unit_test_impl.hxx"
+#include "internal/Stack_trace.hxx"
 
 
 namespace testing {
@@ -150,6 +151,9 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTest {
   // Gets the elapsed time, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time() const;
 
+  // Gets the elapsed time, in nanoseconds of a monotonic clock.
+  ::testing::internal::TimeInNanos elapsed_time_nanos() const;
+
   // Returns true if and only if the unit test passed (i.e. all test suites
   // passed).
   bool Passed() const;
@@ -198,6 +202,14 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTest {
 						 const std::string& os_stack_trace)
 	  GTEST_LOCK_EXCLUDED_(mutex_);
 
+  // The same, with a stack trace that may still have to be symbolized.
+  void AddTestPartResult(::testing::TestPartResult::Type result_type,
+						 const char* file_name,
+						 int line_number,
+						 const std::string& message,
+						 const internal::Stack_trace& os_stack_trace)
+	  GTEST_LOCK_EXCLUDED_(mutex_);
+
   // Adds a TestProperty to the current TestResult object when invoked from
   // inside a test, to current TestSuite's ad_hoc_test_result_ when invoked
   // from SetUpTestSuite or TearDownTestSuite, or to the global property set
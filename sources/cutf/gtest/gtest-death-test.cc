@@ -6,7 +6,10 @@
 
 #include "internal/Unit_test_impl.h"
 #include "internal/Death_test_impl.h"
+#include "internal/Console_output.h"
 #include "internal/Death_test_check.h"
+#include "internal/Death_test_reactor.h"
+#include "internal/Test_isolation.h"
 #include "internal/function_Get_last_errno_description.h"
 
 #include "Message.hin"
@@ -26,6 +29,7 @@
 
 
 #include <utility>
+#include <vector>
 
 
 #if GTEST_HAS_DEATH_TEST
@@ -48,6 +52,8 @@
 #  include "internal/custom/temporary_windows_include.h"
 # else
 #  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/uio.h>
 #  include <sys/wait.h>
 # endif  // GTEST_OS_WINDOWS
 
@@ -90,7 +96,10 @@ GTEST_DEFINE_FLAG_string_(
 	internal::StringFromGTestEnv("death_test_style", kDefaultDeathTestStyle),
 	"Indicates how to run a death test in a forked child process: "
 	"\"threadsafe\" (child process re-executes the test binary "
-	"from the beginning, running only the specific death test) or "
+	"from the beginning, running only the specific death test), "
+	"\"forkserver\" (like \"threadsafe\", but the child process is "
+	"forked from a copy of the test binary started once and stopped "
+	"right after it parsed the flags) or "
 	"\"fast\" (child process runs the death test immediately "
 	"after forking).");
 
@@ -115,6 +124,12 @@ GTEST_DEFINE_FLAG_string_(
 	"the '|' characters.  This flag is specified if and only if the "
 	"current process is a sub-process launched for running a thread-safe "
 	"death test.  FOR INTERNAL USE ONLY.");
+GTEST_DEFINE_FLAG_string_(
+	internal_death_test_server, "",
+	"Indicates the file descriptor of the connection on which the "
+	"server of fork-server style death tests takes its requests.  This "
+	"flag is specified if and only if the current process is that "
+	"server.  FOR INTERNAL USE ONLY.");
 }  // namespace internal
 
 #if GTEST_HAS_DEATH_TEST
@@ -141,7 +156,8 @@ bool InDeathTestChild() {
 
 # else
 
-  if (GTEST_FLAG(death_test_style) == "threadsafe")
+  const std::string style = ReadSavedFlag(GTEST_FLAG(death_test_style));
+  if (style == "threadsafe" || style == "forkserver")
 	return !GTEST_FLAG(internal_run_death_test).empty();
   else
 	return g_in_fast_death_test_child;
@@ -239,24 +255,39 @@ DeathTest::DeathTest() {
 }
 
 // Creates and returns a death test by dispatching to the current
-// death test factory.
+// death test factory.  Unless death tests run concurrently, the child
+// shares the stderr of the whole process, so the test runs alone from
+// here on.
 bool DeathTest::Create(const char* statement,
 					   Matcher<const std::string&> matcher, const char* file,
 					   int line, DeathTest** test) {
+# if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  if (!::jmsd::cutf::internal::Death_test_reactor::is_active())
+# endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  {
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+  }
+
   return ::jmsd::cutf::internal::GetUnitTestImpl()->death_test_factory()->Create(
 	  statement, std::move(matcher), file, line, test);
 }
 
+// A string containing a description of the outcome of the last death test
+// on this thread.  Death tests may run on several threads at once; see
+// --cutf_death_test_jobs.
+static std::string& LastDeathTestMessage() {
+  static thread_local std::string message;
+  return message;
+}
+
 const char* DeathTest::LastMessage() {
-  return last_death_test_message_.c_str();
+  return LastDeathTestMessage().c_str();
 }
 
 void DeathTest::set_last_death_test_message(const std::string& message) {
-  last_death_test_message_ = message;
+  LastDeathTestMessage() = message;
 }
 
-std::string DeathTest::last_death_test_message_;
-
 #if GTEST_OS_FUCHSIA
 
 class FuchsiaDeathTest : public DeathTestImpl {
@@ -518,6 +549,35 @@ std::string FuchsiaDeathTest::GetErrorLogs() {
 
 #else  // We are neither on Windows, nor on Fuchsia.
 
+// Creates a pipe whose ends are both closed on exec, so that a child that
+// another thread spawns meanwhile doesn't keep the write end open.  A child
+// meant to inherit an end gets it through ExecDeathTestSpawnChild().
+static void MakeCloseOnExecPipe(int (&pipe_fd)[2]) {
+# if GTEST_OS_LINUX
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(pipe2(pipe_fd, O_CLOEXEC));
+# else
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(pipe(pipe_fd));
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(pipe_fd[0], F_SETFD, FD_CLOEXEC));
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(pipe_fd[1], F_SETFD, FD_CLOEXEC));
+# endif  // GTEST_OS_LINUX
+}
+
+// Starts capturing what the next death test child writes to stderr.  While
+// death tests run concurrently, the child gets a pipe of its own: its write
+// end is to become the child's stderr, and its read end the stderr_fd() of
+// the death test.  Otherwise the stderr of this process, which the child
+// shares, is captured, and both ends are -1.
+static void CaptureDeathTestStderr(int (&stderr_pipe)[2]) {
+  stderr_pipe[0] = stderr_pipe[1] = -1;
+# if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  if (::jmsd::cutf::internal::Death_test_reactor::is_active()) {
+	MakeCloseOnExecPipe(stderr_pipe);
+	return;
+  }
+# endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  CaptureStderr();
+}
+
 // ForkingDeathTest provides implementations for most of the abstract
 // methods of the DeathTest interface.  Only the AssumeRole method is
 // left undefined.
@@ -568,16 +628,34 @@ class NoExecDeathTest : public ForkingDeathTest {
 // The AssumeRole process for a fork-and-run death test.  It implements a
 // straightforward fork, with a simple pipe to transmit the status byte.
 DeathTest::TestRole NoExecDeathTest::AssumeRole() {
-  const size_t thread_count = GetThreadCount();
+  // The workers of --cutf_jobs that wait for this test to end hold no locks
+  // and don't touch memory the child needs.  Neither does the thread of the
+  // reactor, which waits in epoll_wait(2) once started, nor the one that
+  // flushes the buffered console output, which stdout was flushed for.
+  ::jmsd::cutf::internal::Test_isolation* const isolation =
+	  ::jmsd::cutf::internal::Test_isolation::GetInstance();
+  size_t thread_count = GetThreadCount();
+  if (thread_count != 0 && isolation->is_isolated()) {
+	thread_count -= static_cast<size_t>(isolation->other_worker_count());
+  }
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  if (thread_count != 0 && ::jmsd::cutf::internal::Death_test_reactor::is_started()) {
+	--thread_count;
+  }
+#endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  if (thread_count != 0 && ::jmsd::cutf::internal::Console_output::is_buffered()) {
+	--thread_count;
+  }
   if (thread_count != 1) {
 	GTEST_LOG_(WARNING) << DeathTestThreadWarning(thread_count);
   }
 
   int pipe_fd[2];
-  GTEST_DEATH_TEST_CHECK_(pipe(pipe_fd) != -1);
+  MakeCloseOnExecPipe(pipe_fd);
 
   DeathTest::set_last_death_test_message("");
-  CaptureStderr();
+  int stderr_pipe[2];
+  CaptureDeathTestStderr(stderr_pipe);
   // When we fork the process below, the log file buffers are copied, but the
   // file descriptors are shared.  We flush all log files here so that closing
   // the file descriptors in the child process doesn't throw off the
@@ -593,6 +671,12 @@ DeathTest::TestRole NoExecDeathTest::AssumeRole() {
   if (child_pid == 0) {
 	GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[0]));
 	set_write_fd(pipe_fd[1]);
+	if (stderr_pipe[1] != -1) {
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(stderr_pipe[0]));
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(stderr_pipe[1],
+										   posix::FileNo(stderr)));
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(stderr_pipe[1]));
+	}
 	// Redirects all logging to stderr in the child process to prevent
 	// concurrent writes to the log files.  We capture stderr in the parent
 	// process and append the child process' output to a log.
@@ -604,6 +688,10 @@ DeathTest::TestRole NoExecDeathTest::AssumeRole() {
 	return EXECUTE_TEST;
   } else {
 	GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
+	if (stderr_pipe[1] != -1) {
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(stderr_pipe[1]));
+	  set_stderr_fd(stderr_pipe[0]);
+	}
 	set_read_fd(pipe_fd[0]);
 	set_spawned(true);
 	return OVERSEE_TEST;
@@ -622,7 +710,7 @@ class ExecDeathTest : public ForkingDeathTest {
 		line_(line) {}
   TestRole AssumeRole() override;
 
- private:
+ protected:
   static ::std::vector<std::string> GetArgvsForDeathTestChildProcess() {
 	::std::vector<std::string> args = GetInjectableArgvs();
 #  if defined(GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_)
@@ -673,7 +761,8 @@ class Arguments {
 // threadsafe-style death test process.
 struct ExecDeathTestArgs {
   char* const* argv;  // Command-line arguments for the child's call to exec
-  int close_fd;       // File descriptor to close; the read end of a pipe
+  int inherit_fd;     // The only file descriptor of the parent to keep open
+  int stderr_fd;      // File descriptor to use as stderr, or -1 to share it
 };
 
 #  if GTEST_OS_MAC
@@ -696,7 +785,11 @@ inline char** GetEnviron() { return environ; }
 // any potentially unsafe operations like malloc or libc functions.
 static int ExecDeathTestChildMain(void* child_arg) {
   ExecDeathTestArgs* const args = static_cast<ExecDeathTestArgs*>(child_arg);
-  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(args->close_fd));
+  // The pipes and sockets of death tests are all closed on exec.
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(args->inherit_fd, F_SETFD, 0));
+  if (args->stderr_fd != -1) {
+	GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(args->stderr_fd, STDERR_FILENO));
+  }
 
   // We need to execute the test program in the same environment where
   // it was originally invoked.  Therefore we change to the original
@@ -761,8 +854,9 @@ static bool StackGrowsDown() {
 // fork supports only single-threaded environments, so this function uses
 // spawn(2) there instead.  The function dies with an error message if
 // anything goes wrong.
-static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
-  ExecDeathTestArgs args = { argv, close_fd };
+static pid_t ExecDeathTestSpawnChild(char* const* argv, int inherit_fd,
+									 int stderr_fd) {
+  ExecDeathTestArgs args = { argv, inherit_fd, stderr_fd };
   pid_t child_pid = -1;
 
 #  if GTEST_OS_QNX
@@ -783,11 +877,8 @@ static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
 	return EXIT_FAILURE;
   }
 
-  int fd_flags;
-  // Set close_fd to be closed after spawn.
-  GTEST_DEATH_TEST_CHECK_SYSCALL_(fd_flags = fcntl(close_fd, F_GETFD));
-  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(close_fd, F_SETFD,
-										fd_flags | FD_CLOEXEC));
+  // Keep inherit_fd open after spawn; the rest is closed on exec.
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(inherit_fd, F_SETFD, 0));
   struct inheritance inherit = {0};
   // spawn is a system call.
   child_pid =
@@ -874,10 +965,7 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
   }
 
   int pipe_fd[2];
-  GTEST_DEATH_TEST_CHECK_(pipe(pipe_fd) != -1);
-  // Clear the close-on-exec flag on the write end of the pipe, lest
-  // it be closed when the child process does an exec:
-  GTEST_DEATH_TEST_CHECK_(fcntl(pipe_fd[1], F_SETFD, 0) != -1);
+  MakeCloseOnExecPipe(pipe_fd);
 
   const std::string filter_flag = std::string("--") + GTEST_FLAG_PREFIX_ +
 								  kFilterFlag + "=" + info->test_suite_name() +
@@ -894,21 +982,380 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
 
   DeathTest::set_last_death_test_message("");
 
-  CaptureStderr();
+  int stderr_pipe[2];
+  CaptureDeathTestStderr(stderr_pipe);
   // See the comment in NoExecDeathTest::AssumeRole for why the next line
   // is necessary.
   FlushInfoLog();
 
-  const pid_t child_pid = ExecDeathTestSpawnChild(args.Argv(), pipe_fd[0]);
+  const pid_t child_pid =
+	  ExecDeathTestSpawnChild(args.Argv(), pipe_fd[1], stderr_pipe[1]);
   GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
+  if (stderr_pipe[1] != -1) {
+	GTEST_DEATH_TEST_CHECK_SYSCALL_(close(stderr_pipe[1]));
+	set_stderr_fd(stderr_pipe[0]);
+  }
   set_child_pid(child_pid);
   set_read_fd(pipe_fd[0]);
   set_spawned(true);
   return OVERSEE_TEST;
 }
 
+// A server of fork-server style death tests: the connection to it and its
+// process.
+struct DeathTestServer {
+  int fd;
+  pid_t pid;
+};
+
+// Closes the connection to a server, which makes it exit, and waits for it.
+static void StopDeathTestServer(const DeathTestServer& server) {
+  close(server.fd);
+  int status_value;
+  while (waitpid(server.pid, &status_value, 0) == -1 && errno == EINTR) {}
+}
+
+// The servers of fork-server style death tests that no death test is using.
+// Death tests running at the same time (see --cutf_death_test_jobs) take a
+// server each, so that their requests and replies don't interleave, and
+// give it back when done.  A server is only started when none is idle, so
+// the servers serve every iteration of --gtest_repeat; they are stopped
+// when this process exits.
+class DeathTestServerPool {
+ public:
+  DeathTestServerPool() {}
+  ~DeathTestServerPool() {
+	for (const DeathTestServer& server : idle_servers_) {
+	  StopDeathTestServer(server);
+	}
+  }
+
+  // Takes an idle server, if there is one.
+  bool Take(DeathTestServer* server) {
+	MutexLock lock(&mutex_);
+	if (idle_servers_.empty()) return false;
+
+	*server = idle_servers_.back();
+	idle_servers_.pop_back();
+	return true;
+  }
+
+  void GiveBack(const DeathTestServer& server) {
+	MutexLock lock(&mutex_);
+	idle_servers_.push_back(server);
+  }
+
+ private:
+  Mutex mutex_;
+  std::vector<DeathTestServer> idle_servers_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(DeathTestServerPool);
+};
+
+static DeathTestServerPool g_death_test_server_pool;
+
+// The file descriptors a fork-server style death test child takes over from
+// the parent: the write end of the status pipe, stdout and stderr.
+static const size_t kDeathTestServerFdCount = 3;
+
+// Writes all the bytes, or dies.
+static void WriteFully(int fd, const void* data, size_t size) {
+  const char* const bytes = static_cast<const char*>(data);
+  for (size_t written = 0; written < size;) {
+	ssize_t count;
+	GTEST_DEATH_TEST_CHECK_SYSCALL_(count = write(fd, bytes + written,
+												  size - written));
+	written += static_cast<size_t>(count);
+  }
+}
+
+// Reads exactly size bytes.  Returns false if the end of the file comes
+// first; dies on errors.
+static bool ReadFully(int fd, void* data, size_t size) {
+  char* const bytes = static_cast<char*>(data);
+  for (size_t read_count = 0; read_count < size;) {
+	ssize_t count;
+	GTEST_DEATH_TEST_CHECK_SYSCALL_(count = read(fd, bytes + read_count,
+												 size - read_count));
+	if (count == 0) return false;
+	read_count += static_cast<size_t>(count);
+  }
+  return true;
+}
+
+// Sends a request for a death test child to the server: the size of the
+// request, carrying the file descriptors the child is to use, then the
+// request itself.
+static void SendDeathTestRequest(int server_fd, const std::string& request,
+								 const int (&fds)[kDeathTestServerFdCount]) {
+  uint32_t size = static_cast<uint32_t>(request.size());
+  struct iovec data = { &size, sizeof(size) };
+
+  union {
+	struct cmsghdr header;
+	char buffer[CMSG_SPACE(sizeof(fds))];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+
+  struct cmsghdr* const header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+  ssize_t sent;
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(sent = sendmsg(server_fd, &message, 0));
+  GTEST_DEATH_TEST_CHECK_(sent == static_cast<ssize_t>(sizeof(size)));
+  WriteFully(server_fd, request.data(), request.size());
+}
+
+// Receives a request sent by SendDeathTestRequest().  Returns false when
+// the connection has been closed.
+static bool ReceiveDeathTestRequest(int server_fd, std::string* request,
+									int (*fds)[kDeathTestServerFdCount]) {
+  uint32_t size = 0;
+  struct iovec data = { &size, sizeof(size) };
+
+  union {
+	struct cmsghdr header;
+	char buffer[CMSG_SPACE(sizeof(*fds))];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+
+  ssize_t received;
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(received = recvmsg(server_fd, &message, 0));
+  if (received == 0) return false;
+
+  const struct cmsghdr* const header = CMSG_FIRSTHDR(&message);
+  GTEST_DEATH_TEST_CHECK_(header != nullptr &&
+						  header->cmsg_type == SCM_RIGHTS &&
+						  header->cmsg_len == CMSG_LEN(sizeof(*fds)));
+  memcpy(*fds, CMSG_DATA(header), sizeof(*fds));
+
+  // The rest of the size, should the message have been split.
+  GTEST_DEATH_TEST_CHECK_(ReadFully(
+	  server_fd, reinterpret_cast<char*>(&size) + received,
+	  sizeof(size) - static_cast<size_t>(received)));
+
+  request->resize(size);
+  return size == 0 || ReadFully(server_fd, &(*request)[0], size);
+}
+
+// A concrete death test class that asks a server process to fork a child
+// which then runs the test the way a threadsafe-style death test child
+// does.  The server is the test program started once with
+// --gtest_internal_death_test_server: it stops right after parsing the
+// flags, while it is still single-threaded and before it runs any test,
+// and forks a child for every request.  Each death test thus saves the
+// start-up of a whole new process.
+class ForkServerDeathTest : public ExecDeathTest {
+ public:
+  ForkServerDeathTest(const char* a_statement,
+					  Matcher<const std::string&> matcher, const char* file,
+					  int line)
+	  : ExecDeathTest(a_statement, std::move(matcher), file, line),
+		has_server_(false),
+		is_server_reusable_(false) {}
+  ~ForkServerDeathTest() override;
+  TestRole AssumeRole() override;
+  int Wait() override;
+
+ private:
+  static DeathTestServer StartServer();
+
+  // The server this death test took from the pool or started, and whether
+  // it has sent everything it owes for this death test, so that another one
+  // can use it.
+  DeathTestServer server_;
+  bool has_server_;
+  bool is_server_reusable_;
+};
+
+// Gives the server back to the pool, or stops it if it may still send a
+// reply nobody would read.
+ForkServerDeathTest::~ForkServerDeathTest() {
+  if (!has_server_) return;
+
+  if (is_server_reusable_) {
+	g_death_test_server_pool.GiveBack(server_);
+  } else {
+	StopDeathTestServer(server_);
+  }
+}
+
+// Starts a server.
+DeathTestServer ForkServerDeathTest::StartServer() {
+  // Neither the server nor any other process started later may keep this
+  // end of the connection open, or the server would never see it closed.
+  int socket_fd[2];
+#  if GTEST_OS_LINUX
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(socketpair(
+	  AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socket_fd));
+#  else
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(socketpair(AF_UNIX, SOCK_STREAM, 0,
+											 socket_fd));
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(socket_fd[0], F_SETFD, FD_CLOEXEC));
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(socket_fd[1], F_SETFD, FD_CLOEXEC));
+#  endif  // GTEST_OS_LINUX
+
+  const std::string server_flag =
+	  std::string("--") + GTEST_FLAG_PREFIX_ + kInternalDeathTestServerFlag
+	  + "=" + ::jmsd::cutf::internal::function_Streamable_to_string::StreamableToString(socket_fd[1]);
+  Arguments args;
+  args.AddArguments(GetArgvsForDeathTestChildProcess());
+  args.AddArgument(server_flag.c_str());
+
+  FlushInfoLog();
+  DeathTestServer server;
+  server.pid = ExecDeathTestSpawnChild(args.Argv(), socket_fd[1], -1);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(socket_fd[1]));
+
+  server.fd = socket_fd[0];
+  return server;
+}
+
+// The AssumeRole process for a fork-server death test.  The child is told
+// which death test to run the same way a threadsafe-style one is, and
+// gets the status pipe, stdout and stderr (captured by then, or a pipe of
+// its own) of this process.
+DeathTest::TestRole ForkServerDeathTest::AssumeRole() {
+  const ::jmsd::cutf::internal::UnitTestImpl* const impl = ::jmsd::cutf::internal::GetUnitTestImpl();
+  const InternalRunDeathTestFlag* const flag =
+	  impl->internal_run_death_test_flag();
+  const ::jmsd::cutf::TestInfo* const info = impl->current_test_info();
+  const int death_test_index = info->result()->death_test_count();
+
+  if (flag != nullptr) {
+	set_write_fd(flag->write_fd());
+	return EXECUTE_TEST;
+  }
+
+  // Before stderr is captured, so that a new server keeps the original one.
+  if (!g_death_test_server_pool.Take(&server_)) {
+	server_ = StartServer();
+  }
+  has_server_ = true;
+
+  int pipe_fd[2];
+  MakeCloseOnExecPipe(pipe_fd);
+
+  // The filter, then what --gtest_internal_run_death_test says but the
+  // file descriptor.
+  const std::string request =
+	  std::string(info->test_suite_name()) + "." + info->name() + "\n"
+	  + file_ + "|" + ::jmsd::cutf::internal::function_Streamable_to_string::StreamableToString(line_) + "|"
+	  + ::jmsd::cutf::internal::function_Streamable_to_string::StreamableToString(death_test_index);
+
+  DeathTest::set_last_death_test_message("");
+
+  int stderr_pipe[2];
+  CaptureDeathTestStderr(stderr_pipe);
+  // See the comment in NoExecDeathTest::AssumeRole for why the next line
+  // is necessary.
+  FlushInfoLog();
+  fflush(stdout);
+
+  const int fds[kDeathTestServerFdCount] = {
+	  pipe_fd[1], posix::FileNo(stdout),
+	  stderr_pipe[1] != -1 ? stderr_pipe[1] : posix::FileNo(stderr) };
+  SendDeathTestRequest(server_.fd, request, fds);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
+  if (stderr_pipe[1] != -1) {
+	GTEST_DEATH_TEST_CHECK_SYSCALL_(close(stderr_pipe[1]));
+	set_stderr_fd(stderr_pipe[0]);
+  }
+  set_read_fd(pipe_fd[0]);
+  set_spawned(true);
+  return OVERSEE_TEST;
+}
+
+// The child isn't a child of this process; the server waits for it and
+// sends its exit status.
+int ForkServerDeathTest::Wait() {
+  if (!spawned())
+	return 0;
+
+  ReadAndInterpretStatusByte();
+
+  int status_value;
+  GTEST_DEATH_TEST_CHECK_(ReadFully(server_.fd, &status_value,
+									sizeof(status_value)));
+  is_server_reusable_ = true;
+  set_status(status_value);
+  return status_value;
+}
+
+// Runs the server of fork-server style death tests if this process has
+// been started as one.  The server only returns in the children it forks,
+// with the flags set for the death test to run.  Otherwise it exits when
+// the connection is closed.
+void ServeDeathTestsIfRequested() {
+  if (GTEST_FLAG(internal_death_test_server).empty()) return;
+
+  int server_fd = -1;
+  if (!ParseNaturalNumber(GTEST_FLAG(internal_death_test_server),
+						  &server_fd)) {
+	::jmsd::cutf::internal::DeathTestAbort("Bad --gtest_internal_death_test_server flag: "
+		+ GTEST_FLAG(internal_death_test_server));
+  }
+  GTEST_FLAG(internal_death_test_server) = "";
+
+  std::string request;
+  int fds[kDeathTestServerFdCount];
+  while (ReceiveDeathTestRequest(server_fd, &request, &fds)) {
+	const size_t newline = request.find('\n');
+	GTEST_DEATH_TEST_CHECK_(newline != std::string::npos);
+
+	const pid_t child_pid = fork();
+	GTEST_DEATH_TEST_CHECK_(child_pid != -1);
+
+	if (child_pid == 0) {
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(server_fd));
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(fds[1], posix::FileNo(stdout)));
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(fds[2], posix::FileNo(stderr)));
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fds[1]));
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fds[2]));
+
+	  GTEST_FLAG(filter) = request.substr(0, newline);
+	  GTEST_FLAG(internal_run_death_test) = request.substr(newline + 1) + "|"
+		  + ::jmsd::cutf::internal::function_Streamable_to_string::StreamableToString(fds[0]);
+	  return;
+	}
+
+	for (size_t i = 0; i != kDeathTestServerFdCount; ++i) {
+	  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fds[i]));
+	}
+
+	int status_value;
+	GTEST_DEATH_TEST_CHECK_SYSCALL_(waitpid(child_pid, &status_value, 0));
+	WriteFully(server_fd, &status_value, sizeof(status_value));
+  }
+
+  _exit(0);
+}
+
 # endif  // !GTEST_OS_WINDOWS
 
+# if GTEST_OS_WINDOWS || GTEST_OS_FUCHSIA
+// All death test styles re-execute the test program there; none needs a
+// server.
+void ServeDeathTestsIfRequested() {}
+# endif  // GTEST_OS_WINDOWS || GTEST_OS_FUCHSIA
+
 // Creates a concrete DeathTest-derived class that depends on the
 // --gtest_death_test_style flag, and sets the pointer pointed to
 // by the "test" argument to its address.  If the test should be
@@ -940,25 +1387,29 @@ bool DefaultDeathTestFactory::Create(const char* statement,
 	}
   }
 
+  // Death tests run on several threads at once under
+  // --cutf_death_test_jobs, so the style is read only once.
+  const std::string style = ReadSavedFlag(GTEST_FLAG(death_test_style));
+
 # if GTEST_OS_WINDOWS
 
-  if (GTEST_FLAG(death_test_style) == "threadsafe" ||
-	  GTEST_FLAG(death_test_style) == "fast") {
+  if (style == "threadsafe" || style == "forkserver" || style == "fast") {
 	*test = new ::jmsd::cutf::internal::WindowsDeathTest(statement, std::move(matcher), file, line);
   }
 
 # elif GTEST_OS_FUCHSIA
 
-  if (GTEST_FLAG(death_test_style) == "threadsafe" ||
-	  GTEST_FLAG(death_test_style) == "fast") {
+  if (style == "threadsafe" || style == "forkserver" || style == "fast") {
 	*test = new FuchsiaDeathTest(statement, std::move(matcher), file, line);
   }
 
 # else
 
-  if (GTEST_FLAG(death_test_style) == "threadsafe") {
+  if (style == "threadsafe") {
 	*test = new ExecDeathTest(statement, std::move(matcher), file, line);
-  } else if (GTEST_FLAG(death_test_style) == "fast") {
+  } else if (style == "forkserver") {
+	*test = new ForkServerDeathTest(statement, std::move(matcher), file, line);
+  } else if (style == "fast") {
 	*test = new NoExecDeathTest(statement, std::move(matcher));
   }
 
@@ -966,7 +1417,7 @@ bool DefaultDeathTestFactory::Create(const char* statement,
 
   else {  // NOLINT - this is more readable than unbalanced brackets inside #if.
 	DeathTest::set_last_death_test_message(
-		"Unknown death test style \"" + GTEST_FLAG(death_test_style)
+		"Unknown death test style \"" + style
 		+ "\" encountered");
 	return false;
   }
@@ -3,6 +3,7 @@
 
 #include "function_Get_default_filter.h"
 #include "gtest-constants.h"
+#include "gtest-internal-inl.h"
 
 
 namespace jmsd {
@@ -42,6 +43,20 @@ GTEST_DEFINE_FLAG_string_(
 	"being sent to a terminal and the TERM environment variable "
 	"is set to a terminal type that supports colors.");
 
+GTEST_DEFINE_FLAG_int32_(
+	console_buffer,
+	internal::Int32FromGTestEnv("console_buffer", 0),
+	"The size in bytes of the buffer the console output is kept in.  When it "
+	"is positive, the output is flushed every 100 ms, on failures and when "
+	"the tests end instead of after every test event.  0 (the default) "
+	"flushes after every event.");
+
+GTEST_DEFINE_FLAG_int32_(
+	death_test_jobs,
+	internal::Int32FromGTestEnv("death_test_jobs", 1),
+	"How many death tests run concurrently.  Their results are still "
+	"reported in the order the tests would have run in.");
+
 GTEST_DEFINE_FLAG_string_(
 	filter,
 	internal::StringFromGTestEnv("filter", ::jmsd::cutf::function_Get_default_filter::GetDefaultFilter()),
@@ -58,6 +73,25 @@ GTEST_DEFINE_FLAG_bool_(
 	"install a signal handler that dumps debugging information when fatal "
 	"signals are raised.");
 
+GTEST_DEFINE_FLAG_int32_(
+	jobs,
+	internal::Int32FromGTestEnv("jobs", 1),
+	"How many worker threads run the test suites.  Death test suites "
+	"always run first, as --cutf_death_test_jobs says.  A test that "
+	"captures stdout or stderr, runs a death test or intercepts the "
+	"failures of all threads runs alone from that point on.  A failure "
+	"reported by a thread that a test starts without ThreadWithParam (e.g. "
+	"a std::thread) can't be traced back to that test, so it fails every "
+	"test running at that moment.");
+
+GTEST_DEFINE_FLAG_bool_(
+	lazy_parameterized_tests,
+	internal::BoolFromGTestEnv("lazy_parameterized_tests", false),
+	"When this flag is specified, the filter is applied to the names of "
+	"the instances of value-parameterized tests before they are "
+	"registered, and only the matching ones are.  The others are left out "
+	"of the test counts altogether instead of being skipped.");
+
 GTEST_DEFINE_FLAG_bool_(list_tests, false,
 				   "List all tests without running them.");
 
@@ -99,6 +133,13 @@ GTEST_DEFINE_FLAG_int32_(
 	"How many times to repeat each test.  Specify a negative number "
 	"for repeating forever.  Useful for shaking out flaky tests.");
 
+GTEST_DEFINE_FLAG_string_(
+	shard_durations,
+	internal::StringFromGTestEnv("shard_durations", ""),
+	"Comma separated XML or JSON reports of an earlier run.  When the tests "
+	"are sharded, they are spread over the shards so that each shard takes "
+	"about the same time according to the durations in these reports.");
+
 GTEST_DEFINE_FLAG_bool_(show_internal_stack_frames, false,
 				   "True if and only if " GTEST_NAME_
 				   " should include internal stack frames when "
@@ -114,6 +155,15 @@ GTEST_DEFINE_FLAG_int32_(
 	"The maximum number of stack frames to print when an "
 	"assertion fails.  The valid range is 0 through 100, inclusive.");
 
+GTEST_DEFINE_FLAG_bool_(
+	stream_output,
+	internal::BoolFromGTestEnv("stream_output", false),
+	"When this flag is specified, the XML or JSON report is appended to as "
+	"each test ends and completed when the program ends, so that a run that "
+	"crashes still leaves the results of the tests that finished.  The "
+	"summary attributes known only at the end are left out of the XML "
+	"report.");
+
 GTEST_DEFINE_FLAG_string_(
 	stream_result_to,
 	internal::StringFromGTestEnv("stream_result_to", ""),
@@ -121,6 +171,21 @@ GTEST_DEFINE_FLAG_string_(
 	"test results. Example: \"localhost:555\". The flag is effective only on "
 	"Linux.");
 
+GTEST_DEFINE_FLAG_int32_(
+	stream_result_buffer,
+	internal::Int32FromGTestEnv("stream_result_buffer", 0),
+	"The number of events the streamed test results are buffered in.  When "
+	"it is positive, the events are sent by a thread of their own in batches "
+	"instead of one by one by the threads that run the tests.  0 (the "
+	"default) sends every event as it happens.");
+
+GTEST_DEFINE_FLAG_string_(
+	stream_result_overflow,
+	internal::StringFromGTestEnv("stream_result_overflow", "block"),
+	"What happens to a streamed test result event when the buffer given by "
+	"--cutf_stream_result_buffer is full: \"block\" (the default) waits for "
+	"room in the buffer, \"drop\" throws the event away and counts it.");
+
 GTEST_DEFINE_FLAG_bool_(
 	throw_on_failure,
 	internal::BoolFromGTestEnv("throw_on_failure", false),
@@ -136,5 +201,13 @@ GTEST_DEFINE_FLAG_string_(
 #endif  // GTEST_USE_OWN_FLAGFILE_FLAG_
 
 
+namespace internal {
+
+
+GTEST_DEFINE_STATIC_MUTEX_(g_gtest_flag_saver_mutex);
+
+
+} // namespace internal
+
 
 } // namespace testing
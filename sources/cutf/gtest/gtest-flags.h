@@ -36,6 +36,18 @@ GTEST_DECLARE_FLAG_bool_(catch_exceptions);
 // to let Google Test decide.
 GTEST_DECLARE_FLAG_string_(color);
 
+// When this flag is positive, the console output is buffered in that many
+// bytes and flushed now and then instead of after every test event.
+GTEST_DECLARE_FLAG_int32_(console_buffer);
+
+// This flag sets how many death tests run at the same time. The default
+// value of 1 runs the death test suites one test at a time on the main
+// thread. With more, their tests run on that many worker threads, each
+// waiting for its own death test child; the outcomes are still reported in
+// the run order. Only the threadsafe and forkserver styles run concurrently;
+// the same caveats as for --cutf_jobs apply to the tests.
+GTEST_DECLARE_FLAG_int32_(death_test_jobs);
+
 // This flag sets up the filter to select by name using a glob pattern
 // the tests to run. If the filter is not given all tests are executed.
 GTEST_DECLARE_FLAG_string_(filter);
@@ -44,6 +56,21 @@ GTEST_DECLARE_FLAG_string_(filter);
 // debugging information when fatal signals are raised.
 GTEST_DECLARE_FLAG_bool_(install_failure_signal_handler);
 
+// This flag sets how many worker threads run the test suites. The default
+// value of 1 runs every test suite serially on the main thread. Tests that
+// change process-wide state (flags, environment variables, captured stdout
+// or stderr, the global test part result reporter as *_ON_ALL_THREADS
+// assertions do) must not run in parallel with each other; exclude them with
+// a filter. The tests of a test suite without SetUpTestSuite() or
+// TearDownTestSuite() may run concurrently, so they must not share mutable
+// state either. A failure reported by a thread that a test starts without
+// ThreadWithParam fails every test running at that moment.
+GTEST_DECLARE_FLAG_int32_(jobs);
+
+// When this flag is specified, the instances of value-parameterized tests
+// that the filter leaves out are never registered.
+GTEST_DECLARE_FLAG_bool_(lazy_parameterized_tests);
+
 // This flag causes the Google Test to list tests. None of the tests listed
 // are actually run if the flag is provided.
 GTEST_DECLARE_FLAG_bool_(list_tests);
@@ -66,6 +93,12 @@ GTEST_DECLARE_FLAG_int32_(random_seed);
 // is 1. If the value is -1 the tests are repeating forever.
 GTEST_DECLARE_FLAG_int32_(repeat);
 
+// This flag names the XML or JSON reports (comma separated) of an earlier
+// run. When the tests are sharded, they are assigned to shards by the test
+// durations recorded there instead of round-robin. Every shard must be given
+// the same reports.
+GTEST_DECLARE_FLAG_string_(shard_durations);
+
 // This flag controls whether Google Test includes Google Test internal
 // stack frames in failure stack traces.
 GTEST_DECLARE_FLAG_bool_(show_internal_stack_frames);
@@ -87,6 +120,19 @@ GTEST_DECLARE_FLAG_bool_(throw_on_failure);
 // the specified host machine.
 GTEST_DECLARE_FLAG_string_(stream_result_to);
 
+// When this flag is positive, the streamed test results are buffered in
+// that many events and sent in batches by a thread of their own.
+GTEST_DECLARE_FLAG_int32_(stream_result_buffer);
+
+// What to do with a streamed event when the buffer is full: "block" or
+// "drop".
+GTEST_DECLARE_FLAG_string_(stream_result_overflow);
+
+// When this flag is specified, the XML or JSON report is written as the
+// tests run (whenever a test suite ends, and at least once a second) instead
+// of all at once when they are done.
+GTEST_DECLARE_FLAG_bool_(stream_output);
+
 #if GTEST_USE_OWN_FLAGFILE_FLAG_
 GTEST_DECLARE_FLAG_string_(flagfile);
 #endif  // GTEST_USE_OWN_FLAGFILE_FLAG_
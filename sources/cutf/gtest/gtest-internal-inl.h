@@ -16,6 +16,7 @@
 #include "gtest/gtest-spi.h"
 
 #include "internal/gtest-port.h"
+#include "internal/Stack_trace.h"
 
 #ifndef _WIN32_WCE
 # include <errno.h>
@@ -63,15 +64,23 @@ const char kAlsoRunDisabledTestsFlag[] = "also_run_disabled_tests";
 const char kBreakOnFailureFlag[] = "break_on_failure";
 const char kCatchExceptionsFlag[] = "catch_exceptions";
 const char kColorFlag[] = "color";
+const char kConsoleBufferFlag[] = "console_buffer";
+const char kDeathTestJobsFlag[] = "death_test_jobs";
 const char kFilterFlag[] = "filter";
+const char kJobsFlag[] = "jobs";
+const char kLazyParameterizedTestsFlag[] = "lazy_parameterized_tests";
 const char kListTestsFlag[] = "list_tests";
 const char kOutputFlag[] = "output";
 const char kPrintTimeFlag[] = "print_time";
 const char kPrintUTF8Flag[] = "print_utf8";
 const char kRandomSeedFlag[] = "random_seed";
 const char kRepeatFlag[] = "repeat";
+const char kShardDurationsFlag[] = "shard_durations";
 const char kShuffleFlag[] = "shuffle";
 const char kStackTraceDepthFlag[] = "stack_trace_depth";
+const char kStreamOutputFlag[] = "stream_output";
+const char kStreamResultBufferFlag[] = "stream_result_buffer";
+const char kStreamResultOverflowFlag[] = "stream_result_overflow";
 const char kStreamResultToFlag[] = "stream_result_to";
 const char kThrowOnFailureFlag[] = "throw_on_failure";
 const char kFlagfileFlag[] = "flagfile";
@@ -82,6 +91,38 @@ const int kMaxRandomSeed = 99999;
 // Returns the current time in milliseconds.
 JMSD_DEPRECATED_GTEST_API_ TimeInMillis GetTimeInMillis();
 
+// Returns the time of a monotonic clock in nanoseconds.  Only differences
+// between its values are meaningful; use it to measure durations.
+JMSD_DEPRECATED_GTEST_API_ TimeInNanos GetMonotonicTimeInNanos();
+
+// Converts a duration in nanoseconds to whole milliseconds.
+inline TimeInMillis NanosToMillis(TimeInNanos nanos) {
+  return nanos / 1000000;
+}
+
+// Parses a string as a command line flag, in the form of
+// "--<prefix><flag>=value", or of "--<prefix><flag>" as well when
+// def_optional is true.  Without a prefix, the flag is a Google Test one
+// and may start with GTEST_FLAG_PREFIX_ or JMSD_CUTF_FLAG_PREFIX_.
+//
+// Returns the value of the flag, or NULL if the parsing failed.
+JMSD_DEPRECATED_GTEST_API_ const char* ParseFlagValue(
+	const char* str, const char* prefix, const char* flag, bool def_optional);
+JMSD_DEPRECATED_GTEST_API_ const char* ParseFlagValue(
+	const char* str, const char* flag, bool def_optional);
+
+// Parses a string for a bool flag, in the form of either
+// "--<prefix><flag>=value" or "--<prefix><flag>"; the value is true
+// unless it starts with '0', 'f' or 'F'.  Without a prefix, the flag is a
+// Google Test one.
+//
+// On success, stores the value of the flag in *value, and returns
+// true.  On failure, returns false without changing *value.
+JMSD_DEPRECATED_GTEST_API_ bool ParseBoolFlag(
+	const char* str, const char* prefix, const char* flag, bool* value);
+JMSD_DEPRECATED_GTEST_API_ bool ParseBoolFlag(
+	const char* str, const char* flag, bool* value);
+
 // Parses a string for an Int32 flag, in the form of "--flag=value".
 //
 // On success, stores the value of the flag in *value, and returns
@@ -115,72 +156,124 @@ inline int GetNextRandomSeed(int seed) {
   return (next_seed > kMaxRandomSeed) ? 1 : next_seed;
 }
 
+// Serializes the GTestFlagSaver objects of the tests that run at the same
+// time on the worker threads of --cutf_jobs.
+JMSD_DEPRECATED_GTEST_API_ GTEST_DECLARE_STATIC_MUTEX_(g_gtest_flag_saver_mutex);
+
+// Returns the value of a Google Test flag that a GTestFlagSaver running on
+// another thread may restore meanwhile.  Read it once and use the copy.
+template <typename T>
+T ReadSavedFlag(const T& flag) {
+  MutexLock lock(&g_gtest_flag_saver_mutex);
+  return flag;
+}
+
 // This class saves the values of all Google Test flags in its c'tor, and
 // restores them in its d'tor.
+//
+// Only the flags that changed meanwhile are assigned back, so the savers of
+// tests that leave the flags alone never write to them while other tests,
+// running on other threads, read them.
 class GTestFlagSaver {
  public:
   // The c'tor.
   GTestFlagSaver() {
+	MutexLock lock(&g_gtest_flag_saver_mutex);
 	also_run_disabled_tests_ = GTEST_FLAG(also_run_disabled_tests);
 	break_on_failure_ = GTEST_FLAG(break_on_failure);
 	catch_exceptions_ = GTEST_FLAG(catch_exceptions);
 	color_ = GTEST_FLAG(color);
+	console_buffer_ = GTEST_FLAG(console_buffer);
+	death_test_jobs_ = GTEST_FLAG(death_test_jobs);
 	death_test_style_ = GTEST_FLAG(death_test_style);
 	death_test_use_fork_ = GTEST_FLAG(death_test_use_fork);
 	filter_ = GTEST_FLAG(filter);
+	internal_death_test_server_ = GTEST_FLAG(internal_death_test_server);
 	internal_run_death_test_ = GTEST_FLAG(internal_run_death_test);
+	jobs_ = GTEST_FLAG(jobs);
+	lazy_parameterized_tests_ = GTEST_FLAG(lazy_parameterized_tests);
 	list_tests_ = GTEST_FLAG(list_tests);
 	output_ = GTEST_FLAG(output);
 	print_time_ = GTEST_FLAG(print_time);
 	print_utf8_ = GTEST_FLAG(print_utf8);
 	random_seed_ = GTEST_FLAG(random_seed);
 	repeat_ = GTEST_FLAG(repeat);
+	shard_durations_ = GTEST_FLAG(shard_durations);
 	shuffle_ = GTEST_FLAG(shuffle);
 	stack_trace_depth_ = GTEST_FLAG(stack_trace_depth);
+	stream_output_ = GTEST_FLAG(stream_output);
+	stream_result_buffer_ = GTEST_FLAG(stream_result_buffer);
+	stream_result_overflow_ = GTEST_FLAG(stream_result_overflow);
 	stream_result_to_ = GTEST_FLAG(stream_result_to);
 	throw_on_failure_ = GTEST_FLAG(throw_on_failure);
   }
 
   // The d'tor is not virtual.  DO NOT INHERIT FROM THIS CLASS.
   ~GTestFlagSaver() {
-	GTEST_FLAG(also_run_disabled_tests) = also_run_disabled_tests_;
-	GTEST_FLAG(break_on_failure) = break_on_failure_;
-	GTEST_FLAG(catch_exceptions) = catch_exceptions_;
-	GTEST_FLAG(color) = color_;
-	GTEST_FLAG(death_test_style) = death_test_style_;
-	GTEST_FLAG(death_test_use_fork) = death_test_use_fork_;
-	GTEST_FLAG(filter) = filter_;
-	GTEST_FLAG(internal_run_death_test) = internal_run_death_test_;
-	GTEST_FLAG(list_tests) = list_tests_;
-	GTEST_FLAG(output) = output_;
-	GTEST_FLAG(print_time) = print_time_;
-	GTEST_FLAG(print_utf8) = print_utf8_;
-	GTEST_FLAG(random_seed) = random_seed_;
-	GTEST_FLAG(repeat) = repeat_;
-	GTEST_FLAG(shuffle) = shuffle_;
-	GTEST_FLAG(stack_trace_depth) = stack_trace_depth_;
-	GTEST_FLAG(stream_result_to) = stream_result_to_;
-	GTEST_FLAG(throw_on_failure) = throw_on_failure_;
+	MutexLock lock(&g_gtest_flag_saver_mutex);
+	Restore(&GTEST_FLAG(also_run_disabled_tests), also_run_disabled_tests_);
+	Restore(&GTEST_FLAG(break_on_failure), break_on_failure_);
+	Restore(&GTEST_FLAG(catch_exceptions), catch_exceptions_);
+	Restore(&GTEST_FLAG(color), color_);
+	Restore(&GTEST_FLAG(console_buffer), console_buffer_);
+	Restore(&GTEST_FLAG(death_test_jobs), death_test_jobs_);
+	Restore(&GTEST_FLAG(death_test_style), death_test_style_);
+	Restore(&GTEST_FLAG(death_test_use_fork), death_test_use_fork_);
+	Restore(&GTEST_FLAG(filter), filter_);
+	Restore(&GTEST_FLAG(internal_death_test_server), internal_death_test_server_);
+	Restore(&GTEST_FLAG(internal_run_death_test), internal_run_death_test_);
+	Restore(&GTEST_FLAG(jobs), jobs_);
+	Restore(&GTEST_FLAG(lazy_parameterized_tests), lazy_parameterized_tests_);
+	Restore(&GTEST_FLAG(list_tests), list_tests_);
+	Restore(&GTEST_FLAG(output), output_);
+	Restore(&GTEST_FLAG(print_time), print_time_);
+	Restore(&GTEST_FLAG(print_utf8), print_utf8_);
+	Restore(&GTEST_FLAG(random_seed), random_seed_);
+	Restore(&GTEST_FLAG(repeat), repeat_);
+	Restore(&GTEST_FLAG(shard_durations), shard_durations_);
+	Restore(&GTEST_FLAG(shuffle), shuffle_);
+	Restore(&GTEST_FLAG(stack_trace_depth), stack_trace_depth_);
+	Restore(&GTEST_FLAG(stream_output), stream_output_);
+	Restore(&GTEST_FLAG(stream_result_buffer), stream_result_buffer_);
+	Restore(&GTEST_FLAG(stream_result_overflow), stream_result_overflow_);
+	Restore(&GTEST_FLAG(stream_result_to), stream_result_to_);
+	Restore(&GTEST_FLAG(throw_on_failure), throw_on_failure_);
   }
 
  private:
+  template <typename T>
+  static void Restore(T* flag, const T& saved_value) {
+	if (*flag != saved_value) {
+	  *flag = saved_value;
+	}
+  }
+
   // Fields for saving the original values of flags.
   bool also_run_disabled_tests_;
   bool break_on_failure_;
   bool catch_exceptions_;
   std::string color_;
+  int32_t console_buffer_;
+  int32_t death_test_jobs_;
   std::string death_test_style_;
   bool death_test_use_fork_;
   std::string filter_;
+  std::string internal_death_test_server_;
   std::string internal_run_death_test_;
+  int32_t jobs_;
+  bool lazy_parameterized_tests_;
   bool list_tests_;
   std::string output_;
   bool print_time_;
   bool print_utf8_;
   int32_t random_seed_;
   int32_t repeat_;
+  std::string shard_durations_;
   bool shuffle_;
   int32_t stack_trace_depth_;
+  bool stream_output_;
+  int32_t stream_result_buffer_;
+  std::string stream_result_overflow_;
   std::string stream_result_to_;
   bool throw_on_failure_;
 } GTEST_ATTRIBUTE_UNUSED_;
@@ -223,6 +316,15 @@ class OsStackTraceGetterInterface {
   //                against max_depth.
   virtual std::string CurrentStackTrace(int max_depth, int skip_count) = 0;
 
+  // Captures the current OS stack for a failure.  Getters that can take the
+  // raw frames and symbolize them later override this; by default it is the
+  // text CurrentStackTrace() returns.
+  virtual ::jmsd::cutf::internal::Stack_trace CaptureStackTrace(int max_depth,
+																int skip_count) {
+	return ::jmsd::cutf::internal::Stack_trace(
+		CurrentStackTrace(max_depth, skip_count + 1));
+  }
+
   // UponLeavingGTest() should be called immediately before Google Test calls
   // user code. It saves some information about the current stack that
   // CurrentStackTrace() will use to find and hide Google Test stack frames.
@@ -242,6 +344,10 @@ class OsStackTraceGetter : public OsStackTraceGetterInterface {
   OsStackTraceGetter() {}
 
   std::string CurrentStackTrace(int max_depth, int skip_count) override;
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+  ::jmsd::cutf::internal::Stack_trace CaptureStackTrace(int max_depth,
+														int skip_count) override;
+#endif  // JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
   void UponLeavingGTest() override;
 
  private:
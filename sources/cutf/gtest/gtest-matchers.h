@@ -7,7 +7,9 @@
 #include "gtest/internal/gtest-internal.h"
 #include "gtest/internal/gtest-port.h"
 
+#include <atomic>
 #include <memory>
+#include <new>
 #include <ostream>
 #include <string>
 #include <type_traits>
@@ -145,29 +147,16 @@ class MatcherInterface : public MatcherDescriberInterface {
 
 namespace internal {
 
-// Converts a MatcherInterface<T> to a MatcherInterface<const T&>.
+// Implemented, besides MatcherInterface, by the matchers that match
+// exactly the values equal to a given one of the matched type, so that
+// those values can be found without trying the matcher on them.
 template <typename T>
-class MatcherInterfaceAdapter : public MatcherInterface<const T&> {
+class ExactValueMatcherInterface {
  public:
-  explicit MatcherInterfaceAdapter(const MatcherInterface<T>* impl)
-      : impl_(impl) {}
-  ~MatcherInterfaceAdapter() override { delete impl_; }
+  virtual ~ExactValueMatcherInterface() {}
 
-  void DescribeTo(::std::ostream* os) const override { impl_->DescribeTo(os); }
-
-  void DescribeNegationTo(::std::ostream* os) const override {
-    impl_->DescribeNegationTo(os);
-  }
-
-  bool MatchAndExplain(const T& x,
-                       MatchResultListener* listener) const override {
-    return impl_->MatchAndExplain(x, listener);
-  }
-
- private:
-  const MatcherInterface<T>* const impl_;
-
-  GTEST_DISALLOW_COPY_AND_ASSIGN_(MatcherInterfaceAdapter);
+  // Returns the only value (up to ==) the matcher matches.
+  virtual const T& exact_value() const = 0;
 };
 
 struct AnyEq {
@@ -216,16 +205,33 @@ class StreamMatchResultListener : public MatchResultListener {
   GTEST_DISALLOW_COPY_AND_ASSIGN_(StreamMatchResultListener);
 };
 
+// Whether M (once decayed) implements a matcher of T that a Matcher<T>
+// can hold by value.
+template <typename M, typename T>
+struct IsMatcherImplementation
+    : std::is_base_of<MatcherInterface<const T&>,
+                      typename std::decay<M>::type> {};
+
 // An internal class for implementing Matcher<T>, which will derive
 // from it.  We put functionalities common to all Matcher<T>
 // specializations here to avoid code duplication.
+//
+// The implementation is held by value.  One given by value that is
+// small enough (a comparison with a scalar or a short string, _, most
+// polymorphic matchers) lives in a buffer inside the matcher, so making,
+// copying and destroying the matcher never allocates, and it is called
+// through a per-type function table without a virtual call.  A bigger
+// one, or one given as a pointer to MatcherInterface, lives on the heap
+// and is shared by the copies of the matcher.
 template <typename T>
 class MatcherBase {
+  typedef GTEST_REMOVE_REFERENCE_AND_CONST_(T) RawT;
+
  public:
   // Returns true if and only if the matcher matches x; also explains the
   // match result to 'listener'.
   bool MatchAndExplain(const T& x, MatchResultListener* listener) const {
-    return impl_->MatchAndExplain(x, listener);
+    return vtable_->match_and_explain(buffer_, x, listener);
   }
 
   // Returns true if and only if this matcher matches x.
@@ -235,11 +241,11 @@ class MatcherBase {
   }
 
   // Describes this matcher to an ostream.
-  void DescribeTo(::std::ostream* os) const { impl_->DescribeTo(os); }
+  void DescribeTo(::std::ostream* os) const { GetDescriber()->DescribeTo(os); }
 
   // Describes the negation of this matcher to an ostream.
   void DescribeNegationTo(::std::ostream* os) const {
-    impl_->DescribeNegationTo(os);
+    GetDescriber()->DescribeNegationTo(os);
   }
 
   // Explains why x matches, or doesn't match, the matcher.
@@ -250,41 +256,272 @@ class MatcherBase {
 
   // Returns the describer for this matcher object; retains ownership
   // of the describer, which is only guaranteed to be alive when
-  // this matcher object is alive.
+  // this matcher object is alive and hasn't been moved or assigned to
+  // since (a small describer lives inside the matcher object).
   const MatcherDescriberInterface* GetDescriber() const {
-    return impl_.get();
+    return vtable_ == nullptr ? nullptr : vtable_->get_describer(buffer_);
+  }
+
+  // Returns the value this matcher requires its argument to be equal
+  // to, or NULL if it isn't such an equality matcher.  Without RTTI,
+  // an equality matcher given as a MatcherInterface pointer can't tell.
+  const RawT* GetExactValue() const {
+    return vtable_ == nullptr ? nullptr : vtable_->get_exact_value(buffer_);
   }
 
  protected:
-  MatcherBase() {}
+  MatcherBase() : vtable_(nullptr) {}
 
   // Constructs a matcher from its implementation.
-  explicit MatcherBase(const MatcherInterface<const T&>* impl) : impl_(impl) {}
+  explicit MatcherBase(const MatcherInterface<const T&>* impl) {
+    Init<SharedPolicy<OwnedImpl<MatcherInterface<const T&> > > >(
+        OwnedImpl<MatcherInterface<const T&> >(impl));
+  }
 
   template <typename U>
   explicit MatcherBase(
       const MatcherInterface<U>* impl,
       typename std::enable_if<!std::is_same<U, const U&>::value>::type* =
-          nullptr)
-      : impl_(new internal::MatcherInterfaceAdapter<U>(impl)) {}
+          nullptr) {
+    Init<SharedPolicy<OwnedImpl<MatcherInterface<U> > > >(
+        OwnedImpl<MatcherInterface<U> >(impl));
+  }
+
+  // Constructs a matcher holding a copy of its implementation.
+  template <typename M, typename = typename std::enable_if<
+                            IsMatcherImplementation<M, T>::value>::type>
+  explicit MatcherBase(M&& impl) {
+    typedef typename std::decay<M>::type Impl;
+    Init<typename std::conditional<FitsInline<Impl>::value,
+                                   InlinePolicy<Impl>,
+                                   SharedPolicy<Impl> >::type>(
+        std::forward<M>(impl));
+  }
+
+  MatcherBase(const MatcherBase& other) : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) vtable_->copy(other.buffer_, &buffer_);
+  }
+
+  MatcherBase& operator=(const MatcherBase& other) {
+    if (this != &other) {
+      MatcherBase copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
 
-  MatcherBase(const MatcherBase&) = default;
-  MatcherBase& operator=(const MatcherBase&) = default;
-  MatcherBase(MatcherBase&&) = default;
-  MatcherBase& operator=(MatcherBase&&) = default;
+  MatcherBase(MatcherBase&& other) noexcept : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) {
+      vtable_->move(&other.buffer_, &buffer_);
+      other.vtable_ = nullptr;
+    }
+  }
 
-  virtual ~MatcherBase() {}
+  MatcherBase& operator=(MatcherBase&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      vtable_ = other.vtable_;
+      if (vtable_ != nullptr) {
+        vtable_->move(&other.buffer_, &buffer_);
+        other.vtable_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  virtual ~MatcherBase() { Reset(); }
 
  private:
-  std::shared_ptr<const MatcherInterface<const T&>> impl_;
+  // Room for an implementation made of a vtable pointer and a std::string.
+  static const size_t kInlineSize = sizeof(void*) + sizeof(std::string);
+
+  union Buffer {
+    // Aligns the inline storage for anything whose alignment is no
+    // stricter than one of these.
+    void* pointer;
+    double floating_point;
+    long long integer;  // NOLINT
+
+    unsigned char inline_storage[kInlineSize];
+  };
+
+  // How a matcher calls, copies and destroys the implementation in its
+  // buffer.
+  struct VTable {
+    bool (*match_and_explain)(const Buffer& buffer, const T& x,
+                              MatchResultListener* listener);
+    const MatcherDescriberInterface* (*get_describer)(const Buffer& buffer);
+    const RawT* (*get_exact_value)(const Buffer& buffer);
+    void (*copy)(const Buffer& from, Buffer* to);
+    // Leaves nothing to destroy in 'from'.
+    void (*move)(Buffer* from, Buffer* to);
+    void (*destroy)(Buffer* buffer);
+  };
+
+  // An implementation given as a pointer, which the matcher owns.
+  template <typename Interface>
+  class OwnedImpl {
+   public:
+    explicit OwnedImpl(const Interface* impl) : impl_(impl) {}
+
+    const Interface& get() const { return *impl_; }
+
+   private:
+    std::unique_ptr<const Interface> impl_;
+  };
+
+  template <typename M>
+  struct FitsInline
+      : std::integral_constant<
+            bool, sizeof(M) <= sizeof(Buffer) &&
+                      alignof(Buffer) % alignof(M) == 0 &&
+                      std::is_copy_constructible<M>::value &&
+                      std::is_nothrow_move_constructible<M>::value> {};
+
+  // Calls an implementation held by value directly, which lets the
+  // compiler inline it; the other ones need the virtual call.
+  template <typename M>
+  static bool Call(const M& impl, const T& x, MatchResultListener* listener) {
+    return impl.M::MatchAndExplain(x, listener);
+  }
+  template <typename Interface>
+  static bool Call(const OwnedImpl<Interface>& impl, const T& x,
+                   MatchResultListener* listener) {
+    return impl.get().MatchAndExplain(x, listener);
+  }
+
+  template <typename M>
+  static const MatcherDescriberInterface* Describer(const M& impl) {
+    return &impl;
+  }
+  template <typename Interface>
+  static const MatcherDescriberInterface* Describer(
+      const OwnedImpl<Interface>& impl) {
+    return &impl.get();
+  }
+
+  template <typename M>
+  static const RawT* ExactValue(const M& impl) {
+    return ExactValue(
+        impl, std::is_base_of<ExactValueMatcherInterface<RawT>, M>());
+  }
+  template <typename M>
+  static const RawT* ExactValue(const M& impl,
+                                std::true_type /* is_exact_value */) {
+    return &static_cast<const ExactValueMatcherInterface<RawT>&>(impl)
+                .exact_value();
+  }
+  template <typename M>
+  static const RawT* ExactValue(const M& /* impl */,
+                                std::false_type /* is_exact_value */) {
+    return nullptr;
+  }
+  template <typename Interface>
+  static const RawT* ExactValue(const OwnedImpl<Interface>& impl) {
+#if GTEST_HAS_RTTI
+    const ExactValueMatcherInterface<RawT>* const exact =
+        dynamic_cast<const ExactValueMatcherInterface<RawT>*>(&impl.get());
+    return exact == nullptr ? nullptr : &exact->exact_value();
+#else
+    (void)impl;
+    return nullptr;
+#endif  // GTEST_HAS_RTTI
+  }
+
+  // Keeps an M in the buffer itself.
+  template <typename M>
+  struct InlinePolicy {
+    template <typename Arg>
+    static void Create(Buffer* buffer, Arg&& arg) {
+      new (buffer->inline_storage) M(std::forward<Arg>(arg));
+    }
+    static const M& Get(const Buffer& buffer) {
+      return *reinterpret_cast<const M*>(buffer.inline_storage);
+    }
+    static void Copy(const Buffer& from, Buffer* to) { Create(to, Get(from)); }
+    static void Move(Buffer* from, Buffer* to) {
+      Create(to, std::move(const_cast<M&>(Get(*from))));
+      Destroy(from);
+    }
+    static void Destroy(Buffer* buffer) { Get(*buffer).~M(); }
+  };
+
+  // Keeps an M on the heap, shared by the copies of the matcher.
+  template <typename M>
+  struct SharedPolicy {
+    struct Shared {
+      template <typename Arg>
+      explicit Shared(Arg&& arg) : ref_count(1), impl(std::forward<Arg>(arg)) {}
+
+      std::atomic<int> ref_count;
+      const M impl;
+    };
+
+    template <typename Arg>
+    static void Create(Buffer* buffer, Arg&& arg) {
+      buffer->pointer = new Shared(std::forward<Arg>(arg));
+    }
+    static const M& Get(const Buffer& buffer) {
+      return static_cast<const Shared*>(buffer.pointer)->impl;
+    }
+    static void Copy(const Buffer& from, Buffer* to) {
+      static_cast<Shared*>(from.pointer)
+          ->ref_count.fetch_add(1, std::memory_order_relaxed);
+      to->pointer = from.pointer;
+    }
+    static void Move(Buffer* from, Buffer* to) {
+      to->pointer = from->pointer;
+    }
+    static void Destroy(Buffer* buffer) {
+      Shared* const shared = static_cast<Shared*>(buffer->pointer);
+      if (shared->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete shared;
+      }
+    }
+  };
+
+  template <typename Policy>
+  static bool MatchAndExplainImpl(const Buffer& buffer, const T& x,
+                                  MatchResultListener* listener) {
+    return Call(Policy::Get(buffer), x, listener);
+  }
+  template <typename Policy>
+  static const MatcherDescriberInterface* GetDescriberImpl(
+      const Buffer& buffer) {
+    return Describer(Policy::Get(buffer));
+  }
+  template <typename Policy>
+  static const RawT* GetExactValueImpl(const Buffer& buffer) {
+    return ExactValue(Policy::Get(buffer));
+  }
+
+  template <typename Policy, typename Arg>
+  void Init(Arg&& arg) {
+    static const VTable kVTable = {
+        &MatchAndExplainImpl<Policy>, &GetDescriberImpl<Policy>,
+        &GetExactValueImpl<Policy>,   &Policy::Copy,
+        &Policy::Move,                &Policy::Destroy};
+    Policy::Create(&buffer_, std::forward<Arg>(arg));
+    vtable_ = &kVTable;
+  }
+
+  void Reset() {
+    if (vtable_ != nullptr) vtable_->destroy(&buffer_);
+    vtable_ = nullptr;
+  }
+
+  // NULL for a matcher that's not initialized yet or moved from.
+  const VTable* vtable_;
+  Buffer buffer_;
 };
 
 }  // namespace internal
 
 // A Matcher<T> is a copyable and IMMUTABLE (except by assignment)
 // object that can check whether a value of type T matches.  The
-// implementation of Matcher<T> is just a std::shared_ptr to const
-// MatcherInterface<T>.  Don't inherit from Matcher!
+// implementation of Matcher<T> is a MatcherInterface<const T&>, kept
+// inside the matcher when it's small (see MatcherBase).  Don't inherit
+// from Matcher!
 template <typename T>
 class Matcher : public internal::MatcherBase<T> {
  public:
@@ -304,6 +541,13 @@ class Matcher : public internal::MatcherBase<T> {
           nullptr)
       : internal::MatcherBase<T>(impl) {}
 
+  // Constructs a matcher holding a copy of its implementation, which
+  // doesn't allocate when the implementation is small.
+  template <typename M, typename = typename std::enable_if<
+                            internal::IsMatcherImplementation<M, T>::value>::type>
+  explicit Matcher(M&& impl)
+      : internal::MatcherBase<T>(std::forward<M>(impl)) {}
+
   // Implicit constructor here allows people to write
   // EXPECT_CALL(foo, Bar(5)) instead of EXPECT_CALL(foo, Bar(Eq(5))) sometimes
   Matcher(T value);  // NOLINT
@@ -321,6 +565,12 @@ class JMSD_DEPRECATED_GTEST_API_ Matcher<const std::string&>
   explicit Matcher(const MatcherInterface<const std::string&>* impl)
       : internal::MatcherBase<const std::string&>(impl) {}
 
+  template <typename M, typename = typename std::enable_if<
+                            internal::IsMatcherImplementation<
+                                M, const std::string&>::value>::type>
+  explicit Matcher(M&& impl)
+      : internal::MatcherBase<const std::string&>(std::forward<M>(impl)) {}
+
   // Allows the user to write str instead of Eq(str) sometimes, where
   // str is a std::string object.
   Matcher(const std::string& s);  // NOLINT
@@ -340,6 +590,12 @@ class JMSD_DEPRECATED_GTEST_API_ Matcher<std::string>
   explicit Matcher(const MatcherInterface<std::string>* impl)
       : internal::MatcherBase<std::string>(impl) {}
 
+  template <typename M, typename = typename std::enable_if<
+                            internal::IsMatcherImplementation<
+                                M, std::string>::value>::type>
+  explicit Matcher(M&& impl)
+      : internal::MatcherBase<std::string>(std::forward<M>(impl)) {}
+
   // Allows the user to write str instead of Eq(str) sometimes, where
   // str is a string object.
   Matcher(const std::string& s);  // NOLINT
@@ -361,6 +617,13 @@ class JMSD_DEPRECATED_GTEST_API_ Matcher<const absl::string_view&>
   explicit Matcher(const MatcherInterface<const absl::string_view&>* impl)
       : internal::MatcherBase<const absl::string_view&>(impl) {}
 
+  template <typename M, typename = typename std::enable_if<
+                            internal::IsMatcherImplementation<
+                                M, const absl::string_view&>::value>::type>
+  explicit Matcher(M&& impl)
+      : internal::MatcherBase<const absl::string_view&>(
+            std::forward<M>(impl)) {}
+
   // Allows the user to write str instead of Eq(str) sometimes, where
   // str is a std::string object.
   Matcher(const std::string& s);  // NOLINT
@@ -383,6 +646,12 @@ class JMSD_DEPRECATED_GTEST_API_ Matcher<absl::string_view>
   explicit Matcher(const MatcherInterface<absl::string_view>* impl)
       : internal::MatcherBase<absl::string_view>(impl) {}
 
+  template <typename M, typename = typename std::enable_if<
+                            internal::IsMatcherImplementation<
+                                M, absl::string_view>::value>::type>
+  explicit Matcher(M&& impl)
+      : internal::MatcherBase<absl::string_view>(std::forward<M>(impl)) {}
+
   // Allows the user to write str instead of Eq(str) sometimes, where
   // str is a std::string object.
   Matcher(const std::string& s);  // NOLINT
@@ -429,7 +698,7 @@ class PolymorphicMatcher {
 
   template <typename T>
   operator Matcher<T>() const {
-    return Matcher<T>(new MonomorphicImpl<const T&>(impl_));
+    return Matcher<T>(MonomorphicImpl<const T&>(impl_));
   }
 
  private:
@@ -495,7 +764,9 @@ class ComparisonBase {
   explicit ComparisonBase(const Rhs& rhs) : rhs_(rhs) {}
   template <typename Lhs>
   operator Matcher<Lhs>() const {
-    return Matcher<Lhs>(new Impl<const Lhs&>(rhs_));
+    return Matcher<Lhs>(typename std::conditional<
+                        IsExactValue<Lhs>::value, ExactValueImpl<const Lhs&>,
+                        Impl<const Lhs&>>::type(rhs_));
   }
 
  private:
@@ -521,9 +792,27 @@ class ComparisonBase {
       UniversalPrint(Unwrap(rhs_), os);
     }
 
-   private:
+   protected:
     Rhs rhs_;
   };
+
+  // Eq() on a value of the very type matched: such a matcher also
+  // reports that value.
+  template <typename Lhs>
+  struct IsExactValue
+      : std::integral_constant<
+            bool, std::is_same<Op, AnyEq>::value &&
+                      std::is_same<GTEST_REMOVE_REFERENCE_AND_CONST_(Lhs),
+                                   Rhs>::value> {};
+
+  template <typename Lhs>
+  class ExactValueImpl : public Impl<Lhs>,
+                         public ExactValueMatcherInterface<Rhs> {
+   public:
+    explicit ExactValueImpl(const Rhs& rhs) : Impl<Lhs>(rhs) {}
+    const Rhs& exact_value() const override { return this->rhs_; }
+  };
+
   Rhs rhs_;
 };
 
@@ -10,6 +10,7 @@
 #include "Assertion_result.hin"
 
 #include "gtest-internal-inl.h"
+#include "internal/Test_isolation.h"
 
 #include <limits.h>
 #include <stdio.h>
@@ -464,16 +465,20 @@ class ThreadWithParamSupport : public ThreadWithParamBase {
   struct ThreadMainParam {
 	ThreadMainParam(Runnable* runnable, Notification* thread_can_start)
 		: runnable_(runnable),
-		  thread_can_start_(thread_can_start) {
+		  thread_can_start_(thread_can_start),
+		  test_result_(GetTestResultOfCurrentThread()) {
 	}
 	std::unique_ptr<Runnable> runnable_;
 	// Does not own.
 	Notification* thread_can_start_;
+	// The test result of the thread that created this one.
+	void* test_result_;
   };
 
   static DWORD WINAPI ThreadMain(void* ptr) {
 	// Transfers ownership.
 	std::unique_ptr<ThreadMainParam> param(static_cast<ThreadMainParam*>(ptr));
+	SetTestResultOfCurrentThread(param->test_result_);
 	if (param->thread_can_start_ != nullptr)
 	  param->thread_can_start_->WaitForNotification();
 	param->runnable_->Run();
@@ -1139,9 +1144,11 @@ GTEST_DISABLE_MSC_DEPRECATED_POP_()
 static CapturedStream* g_captured_stderr = nullptr;
 static CapturedStream* g_captured_stdout = nullptr;
 
-// Starts capturing an output stream (stdout/stderr).
+// Starts capturing an output stream (stdout/stderr).  The streams belong
+// to the whole process, so the calling test runs alone from here on.
 static void CaptureStream(int fd, const char* stream_name,
 						  CapturedStream** stream) {
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
   if (*stream != nullptr) {
 	GTEST_LOG_(FATAL) << "Only one " << stream_name
 					  << " capturer can exist at a time.";
@@ -55,6 +55,8 @@ class JMSD_DEPRECATED_GTEST_API_ ScopedFakeTestPartResultReporter
   const InterceptMode intercept_mode_;
   TestPartResultReporterInterface* old_reporter_;
   TestPartResultArray* const result_;
+  // Serializes the threads appending to result_.
+  internal::Mutex mutex_;
 
   GTEST_DISALLOW_COPY_AND_ASSIGN_(ScopedFakeTestPartResultReporter);
 };
@@ -16,6 +16,15 @@ std::string TestPartResult::ExtractSummary(const char* message) {
   return stack_trace == nullptr ? message : std::string(message, stack_trace);
 }
 
+// Gets the message followed by the stack trace.
+std::string TestPartResult::message_with_stack_trace() const {
+  if (stack_trace_.empty()) {
+	return message_;
+  }
+
+  return message_ + ::jmsd::cutf::constants::internal::kStackTraceMarker + stack_trace_.ToString();
+}
+
 // Prints a TestPartResult object.
 std::ostream& operator<<(std::ostream& os, const TestPartResult& result) {
   return os << internal::FormatFileLocation(result.file_name(),
@@ -29,7 +38,7 @@ std::ostream& operator<<(std::ostream& os, const TestPartResult& result) {
 								? "Fatal failure"
 								: "Non-fatal failure")
 			<< ":\n"
-			<< result.message() << std::endl;
+			<< result.message_with_stack_trace() << std::endl;
 }
 
 // Appends a TestPartResult to the array.
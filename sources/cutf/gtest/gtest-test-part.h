@@ -3,6 +3,7 @@
 
 #include "gtest/internal/gtest-internal.h"
 #include "gtest/internal/gtest-string.h"
+#include "gtest/internal/Stack_trace.h"
 
 #include <iosfwd>
 #include <vector>
@@ -31,12 +32,15 @@ class JMSD_DEPRECATED_GTEST_API_ TestPartResult {
   // Always use this constructor (with parameters) to create a
   // TestPartResult object.
   TestPartResult(Type a_type, const char* a_file_name, int a_line_number,
-                 const char* a_message)
+                 const char* a_message,
+                 const ::jmsd::cutf::internal::Stack_trace& a_stack_trace =
+                     ::jmsd::cutf::internal::Stack_trace())
       : type_(a_type),
         file_name_(a_file_name == nullptr ? "" : a_file_name),
         line_number_(a_line_number),
         summary_(ExtractSummary(a_message)),
-        message_(a_message) {}
+        message_(a_message),
+        stack_trace_(a_stack_trace) {}
 
   // Gets the outcome of the test part.
   Type type() const { return type_; }
@@ -54,9 +58,20 @@ class JMSD_DEPRECATED_GTEST_API_ TestPartResult {
   // Gets the summary of the failure message.
   const char* summary() const { return summary_.c_str(); }
 
-  // Gets the message associated with the test part.
+  // Gets the message associated with the test part, without the stack
+  // trace.
   const char* message() const { return message_.c_str(); }
 
+  // Gets the message followed by the stack trace, which the result printers
+  // report.  The frames of the trace are symbolized by this call.
+  std::string message_with_stack_trace() const;
+
+  // Gets the stack of the failed assertion.  Empty for passed and skipped
+  // test parts.
+  const ::jmsd::cutf::internal::Stack_trace& stack_trace() const {
+    return stack_trace_;
+  }
+
   // Returns true if and only if the test part was skipped.
   bool skipped() const { return type_ == kSkip; }
 
@@ -87,6 +102,7 @@ class JMSD_DEPRECATED_GTEST_API_ TestPartResult {
   int line_number_;
   std::string summary_;  // The test failure summary.
   std::string message_;  // The test failure message.
+  ::jmsd::cutf::internal::Stack_trace stack_trace_;
 };
 
 // Prints a TestPartResult object.
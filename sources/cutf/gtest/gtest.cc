@@ -22,6 +22,8 @@
 #endif // #if GTEST_CAN_STREAM_RESULTS_
 
 #include "internal/Assertion_result_constructor.h"
+#include "internal/Compiled_filter.h"
+#include "internal/Test_isolation.h"
 
 #include "Assertion_result.hin"
 #include "Message.hin"
@@ -40,6 +42,7 @@
 #include <wctype.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <iomanip>
 #include <limits>
@@ -161,7 +164,10 @@ void AssertHelper::operator=(const ::jmsd::cutf::Message& message) const {
 		data_->file,
 		data_->line,
 		AppendUserMessage( data_->message, message ),
-		::jmsd::cutf::UnitTest::GetInstance()->impl()->CurrentOsStackTraceExceptTop( 1 ) );// Skips the stack frame for this function itself.
+		// Only failures have their stacks captured.
+		data_->type == TestPartResult::kNonFatalFailure || data_->type == TestPartResult::kFatalFailure ?
+			::jmsd::cutf::UnitTest::GetInstance()->impl()->CaptureOsStackTraceExceptTop( 1 ) :// Skips the stack frame for this function itself.
+			::jmsd::cutf::internal::Stack_trace() );
 }
 
 namespace {
@@ -224,6 +230,27 @@ void InsertSyntheticTestCase(const std::string &name, CodeLocation location) {
 	  });
 }
 
+// Returns false if --cutf_lazy_parameterized_tests is specified and the
+// filter leaves out the given instance of a value-parameterized test, which
+// then isn't registered at all.
+bool ShouldRegisterParameterizedTest(const std::string& test_suite_name,
+									 const std::string& test_name) {
+  if (!GTEST_FLAG(lazy_parameterized_tests)) return true;
+
+  // Compiled once for all the instances, and again only if the filter changes.
+  static std::string filter;
+  static std::unique_ptr<const ::jmsd::cutf::internal::Compiled_test_filter>
+	  compiled_filter;
+
+  if (compiled_filter == nullptr || filter != GTEST_FLAG(filter)) {
+	filter = GTEST_FLAG(filter);
+	compiled_filter.reset(
+		new ::jmsd::cutf::internal::Compiled_test_filter(filter));
+  }
+
+  return compiled_filter->Matches(test_suite_name + "." + test_name);
+}
+
 // A copy of all command line arguments.  Set by InitGoogleTest().
 static ::std::vector<std::string> g_argvs;
 
@@ -277,6 +304,8 @@ ScopedFakeTestPartResultReporter::ScopedFakeTestPartResultReporter(
 void ScopedFakeTestPartResultReporter::Init() {
   ::jmsd::cutf::internal::UnitTestImpl* const impl = ::jmsd::cutf::internal::GetUnitTestImpl();
   if (intercept_mode_ == INTERCEPT_ALL_THREADS) {
+	// The other tests running meanwhile would report here too.
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
 	old_reporter_ = impl->GetGlobalTestPartResultReporter();
 	impl->SetGlobalTestPartResultReporter(this);
   } else {
@@ -300,6 +329,8 @@ ScopedFakeTestPartResultReporter::~ScopedFakeTestPartResultReporter() {
 // This method is from the TestPartResultReporterInterface interface.
 void ScopedFakeTestPartResultReporter::ReportTestPartResult(
 	const TestPartResult& result) {
+  // With INTERCEPT_ALL_THREADS, several threads can report at once.
+  internal::MutexLock lock(&mutex_);
   result_->Append(result);
 }
 
@@ -418,6 +449,12 @@ TimeInMillis GetTimeInMillis() {
 #endif
 }
 
+// Returns the time of a monotonic clock in nanoseconds.
+TimeInNanos GetMonotonicTimeInNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	  std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // Utilities
 
 // class String.
@@ -960,13 +997,31 @@ std::string OsStackTraceGetter::CurrentStackTrace(int max_depth, int skip_count)
 
   return result;
 
-#else  // !GTEST_HAS_ABSL
+#elif JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+  // Skips the frames requested by the caller, plus this function.
+  return ::jmsd::cutf::internal::Stack_trace::Capture(
+	  std::min(max_depth, ::jmsd::cutf::constants::kMaxStackTraceDepth),
+	  skip_count + 1).ToString();
+
+#else  // !GTEST_HAS_ABSL && !JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
   static_cast<void>(max_depth);
   static_cast<void>(skip_count);
   return "";
 #endif  // GTEST_HAS_ABSL
 }
 
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+// Takes only the program counters; they are symbolized when the failure is
+// reported.
+::jmsd::cutf::internal::Stack_trace OsStackTraceGetter::CaptureStackTrace(
+	int max_depth, int skip_count) {
+  // Skips the frames requested by the caller, plus this function.
+  return ::jmsd::cutf::internal::Stack_trace::Capture(
+	  std::min(max_depth, ::jmsd::cutf::constants::kMaxStackTraceDepth),
+	  skip_count + 1);
+}
+#endif  // JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
 void OsStackTraceGetter::UponLeavingGTest() GTEST_LOCK_EXCLUDED_(mutex_) {
 #if GTEST_HAS_ABSL
   void* caller_frame = nullptr;
@@ -976,6 +1031,12 @@ void OsStackTraceGetter::UponLeavingGTest() GTEST_LOCK_EXCLUDED_(mutex_) {
 
   MutexLock lock(&mutex_);
   caller_frame_ = caller_frame;
+#elif JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+  // The functions calling user code are called from the same frame as this
+  // one, so they share its canonical frame address.  It is kept per thread,
+  // without a lock.
+  ::jmsd::cutf::internal::Stack_trace::set_leaving_gtest_frame(
+	  __builtin_dwarf_cfa());
 #endif  // GTEST_HAS_ABSL
 }
 
@@ -1027,22 +1088,22 @@ bool SkipPrefix(const char* prefix, const char** pstr) {
 }
 
 // Parses a string as a command line flag.  The string should have
-// the format "--flag=value".  When def_optional is true, the "=value"
-// part can be omitted.
+// the format "--<prefix><flag>=value".  When def_optional is true, the
+// "=value" part can be omitted.
 //
 // Returns the value of the flag, or NULL if the parsing failed.
-static const char* ParseFlagValue(const char* str, const char* flag,
-								  bool def_optional) {
-  // str and flag must not be NULL.
-  if (str == nullptr || flag == nullptr) return nullptr;
+const char* ParseFlagValue(const char* str, const char* prefix,
+						   const char* flag, bool def_optional) {
+  // str, prefix and flag must not be NULL.
+  if (str == nullptr || prefix == nullptr || flag == nullptr) return nullptr;
 
-  // The flag must start with "--" followed by GTEST_FLAG_PREFIX_.
-  const std::string flag_str = std::string("--") + GTEST_FLAG_PREFIX_ + flag;
+  // The flag must start with "--" followed by the prefix.
+  const std::string flag_str = std::string("--") + prefix + flag;
   const size_t flag_len = flag_str.length();
   if (strncmp(str, flag_str.c_str(), flag_len) != 0) return nullptr;
 
   // Skips the flag name.
-  const char* flag_end = str + flag_len;
+  const char* const flag_end = str + flag_len;
 
   // When def_optional is true, it's OK to not have a "=value" part.
   if (def_optional && (flag_end[0] == '\0')) {
@@ -1058,8 +1119,27 @@ static const char* ParseFlagValue(const char* str, const char* flag,
   return flag_end + 1;
 }
 
+// Parses a string as a Google Test flag, which starts with "--" followed
+// by GTEST_FLAG_PREFIX_ or JMSD_CUTF_FLAG_PREFIX_.
+//
+// Returns the value of the flag, or NULL if the parsing failed.
+const char* ParseFlagValue(const char* str, const char* flag,
+						   bool def_optional) {
+  for (const char* const prefix : {GTEST_FLAG_PREFIX_, JMSD_CUTF_FLAG_PREFIX_}) {
+	const char* const value_str = ParseFlagValue(str, prefix, flag, def_optional);
+	if (value_str != nullptr) return value_str;
+  }
+  return nullptr;
+}
+
+// Converts the value of a bool flag, which is true as long as it does
+// not start with '0', 'f', or 'F'.
+static bool ParseBoolFlagValue(const char* value_str) {
+  return !(*value_str == '0' || *value_str == 'f' || *value_str == 'F');
+}
+
 // Parses a string for a bool flag, in the form of either
-// "--flag=value" or "--flag".
+// "--<prefix><flag>=value" or "--<prefix><flag>".
 //
 // In the former case, the value is taken as true as long as it does
 // not start with '0', 'f', or 'F'.
@@ -1068,7 +1148,25 @@ static const char* ParseFlagValue(const char* str, const char* flag,
 //
 // On success, stores the value of the flag in *value, and returns
 // true.  On failure, returns false without changing *value.
-static bool ParseBoolFlag(const char* str, const char* flag, bool* value) {
+bool ParseBoolFlag(const char* str, const char* prefix, const char* flag,
+				   bool* value) {
+  // Gets the value of the flag as a string.
+  const char* const value_str = ParseFlagValue(str, prefix, flag, true);
+
+  // Aborts if the parsing failed.
+  if (value_str == nullptr) return false;
+
+  // Converts the string value to a bool.
+  *value = ParseBoolFlagValue(value_str);
+  return true;
+}
+
+// Parses a string for a bool Google Test flag, in the form of either
+// "--flag=value" or "--flag".
+//
+// On success, stores the value of the flag in *value, and returns
+// true.  On failure, returns false without changing *value.
+bool ParseBoolFlag(const char* str, const char* flag, bool* value) {
   // Gets the value of the flag as a string.
   const char* const value_str = ParseFlagValue(str, flag, true);
 
@@ -1076,7 +1174,7 @@ static bool ParseBoolFlag(const char* str, const char* flag, bool* value) {
   if (value_str == nullptr) return false;
 
   // Converts the string value to a bool.
-  *value = !(*value_str == '0' || *value_str == 'f' || *value_str == 'F');
+  *value = ParseBoolFlagValue(value_str);
   return true;
 }
 
@@ -1113,7 +1211,8 @@ static bool ParseStringFlag(const char* str, const char* flag, String* value) {
 }
 
 // Determines whether a string has a prefix that Google Test uses for its
-// flags, i.e., starts with GTEST_FLAG_PREFIX_ or GTEST_FLAG_PREFIX_DASH_.
+// flags, i.e., starts with GTEST_FLAG_PREFIX_, GTEST_FLAG_PREFIX_DASH_ or
+// JMSD_CUTF_FLAG_PREFIX_.
 // If Google Test detects that a command line flag has its prefix but is not
 // recognized, it will print its help message. Flags starting with
 // GTEST_INTERNAL_PREFIX_ followed by "internal_" are considered Google Test
@@ -1124,7 +1223,8 @@ static bool HasGoogleTestFlagPrefix(const char* str) {
 		  SkipPrefix("/", &str)) &&
 		 !SkipPrefix(GTEST_FLAG_PREFIX_ "internal_", &str) &&
 		 (SkipPrefix(GTEST_FLAG_PREFIX_, &str) ||
-		  SkipPrefix(GTEST_FLAG_PREFIX_DASH_, &str));
+		  SkipPrefix(GTEST_FLAG_PREFIX_DASH_, &str) ||
+		  SkipPrefix(JMSD_CUTF_FLAG_PREFIX_, &str));
 }
 
 static const char kColorEncodedHelpMessage[] =
@@ -1142,6 +1242,9 @@ static const char kColorEncodedHelpMessage[] =
 "      matches any substring; ':' separates two patterns.\n"
 "  @G--" GTEST_FLAG_PREFIX_ "also_run_disabled_tests@D\n"
 "      Run all disabled tests too.\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "lazy_parameterized_tests@D\n"
+"      Register only the instances of value-parameterized tests that match\n"
+"      the filter, which saves generating the tests that will not run.\n"
 "\n"
 "Test Execution:\n"
 "  @G--" GTEST_FLAG_PREFIX_ "repeat=@Y[COUNT]@D\n"
@@ -1151,10 +1254,23 @@ static const char kColorEncodedHelpMessage[] =
 "  @G--" GTEST_FLAG_PREFIX_ "random_seed=@Y[NUMBER]@D\n"
 "      Random number seed to use for shuffling test orders (between 1 and\n"
 "      99999, or 0 to use a seed based on the current time).\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "jobs=@Y[COUNT]@D\n"
+"      Run the test suites on COUNT worker threads. Death tests still run\n"
+"      first, as @G--" JMSD_CUTF_FLAG_PREFIX_ "death_test_jobs@D says. A failure in a\n"
+"      thread that a test starts itself fails every test running then.\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "death_test_jobs=@Y[COUNT]@D\n"
+"      Run up to COUNT death tests at the same time. Their results are still\n"
+"      reported in the run order.\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "shard_durations=@YREPORT[,REPORT...]@D\n"
+"      When sharding, balance the shards by the test durations recorded in\n"
+"      these XML or JSON reports of an earlier run.\n"
 "\n"
 "Test Output:\n"
 "  @G--" GTEST_FLAG_PREFIX_ "color=@Y(@Gyes@Y|@Gno@Y|@Gauto@Y)@D\n"
 "      Enable/disable colored output. The default is @Gauto@D.\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "console_buffer=@Y[BYTES]@D\n"
+"      Buffer the console output in BYTES and flush it every 100 ms and on\n"
+"      failures instead of after every test event.\n"
 "  -@G-" GTEST_FLAG_PREFIX_ "print_time=0@D\n"
 "      Don't print the elapsed time of each test.\n"
 "  @G--" GTEST_FLAG_PREFIX_ "output=@Y(@Gjson@Y|@Gxml@Y)[@G:@YDIRECTORY_PATH@G"
@@ -1164,11 +1280,20 @@ static const char kColorEncodedHelpMessage[] =
 # if GTEST_CAN_STREAM_RESULTS_
 "  @G--" GTEST_FLAG_PREFIX_ "stream_result_to=@YHOST@G:@YPORT@D\n"
 "      Stream test results to the given server.\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "stream_result_buffer=@Y[COUNT]@D\n"
+"      Buffer up to @YCOUNT@D streamed events and send them in batches from\n"
+"      a thread of their own.\n"
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "stream_result_overflow=@Y(@Gblock@Y|@Gdrop@Y)@D\n"
+"      Wait for room in a full buffer, or drop and count the event.\n"
 # endif  // GTEST_CAN_STREAM_RESULTS_
+"  @G--" JMSD_CUTF_FLAG_PREFIX_ "stream_output@D\n"
+"      Write the report as the tests run instead of when they are all done.\n"
+"      The XML report then leaves out the summary attributes known only at\n"
+"      the end, such as failure counts and times of the test suites.\n"
 "\n"
 "Assertion Behavior:\n"
 # if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
-"  @G--" GTEST_FLAG_PREFIX_ "death_test_style=@Y(@Gfast@Y|@Gthreadsafe@Y)@D\n"
+"  @G--" GTEST_FLAG_PREFIX_ "death_test_style=@Y(@Gfast@Y|@Gthreadsafe@Y|@Gforkserver@Y)@D\n"
 "      Set the default death test style.\n"
 # endif  // GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
 "  @G--" GTEST_FLAG_PREFIX_ "break_on_failure@D\n"
@@ -1200,22 +1325,35 @@ static bool ParseGoogleTestFlag(const char* const arg) {
 	  ParseBoolFlag(arg, kCatchExceptionsFlag,
 					&GTEST_FLAG(catch_exceptions)) ||
 	  ParseStringFlag(arg, kColorFlag, &GTEST_FLAG(color)) ||
+	  ParseInt32Flag(arg, kConsoleBufferFlag, &GTEST_FLAG(console_buffer)) ||
+	  ParseInt32Flag(arg, kDeathTestJobsFlag, &GTEST_FLAG(death_test_jobs)) ||
 	  ParseStringFlag(arg, kDeathTestStyleFlag,
 					  &GTEST_FLAG(death_test_style)) ||
 	  ParseBoolFlag(arg, kDeathTestUseFork,
 					&GTEST_FLAG(death_test_use_fork)) ||
 	  ParseStringFlag(arg, kFilterFlag, &GTEST_FLAG(filter)) ||
+	  ParseStringFlag(arg, kInternalDeathTestServerFlag,
+					  &GTEST_FLAG(internal_death_test_server)) ||
 	  ParseStringFlag(arg, kInternalRunDeathTestFlag,
 					  &GTEST_FLAG(internal_run_death_test)) ||
+	  ParseInt32Flag(arg, kJobsFlag, &GTEST_FLAG(jobs)) ||
+	  ParseBoolFlag(arg, kLazyParameterizedTestsFlag,
+					&GTEST_FLAG(lazy_parameterized_tests)) ||
 	  ParseBoolFlag(arg, kListTestsFlag, &GTEST_FLAG(list_tests)) ||
 	  ParseStringFlag(arg, kOutputFlag, &GTEST_FLAG(output)) ||
 	  ParseBoolFlag(arg, kPrintTimeFlag, &GTEST_FLAG(print_time)) ||
 	  ParseBoolFlag(arg, kPrintUTF8Flag, &GTEST_FLAG(print_utf8)) ||
 	  ParseInt32Flag(arg, kRandomSeedFlag, &GTEST_FLAG(random_seed)) ||
 	  ParseInt32Flag(arg, kRepeatFlag, &GTEST_FLAG(repeat)) ||
+	  ParseStringFlag(arg, kShardDurationsFlag, &GTEST_FLAG(shard_durations)) ||
 	  ParseBoolFlag(arg, kShuffleFlag, &GTEST_FLAG(shuffle)) ||
 	  ParseInt32Flag(arg, kStackTraceDepthFlag,
 					 &GTEST_FLAG(stack_trace_depth)) ||
+	  ParseBoolFlag(arg, kStreamOutputFlag, &GTEST_FLAG(stream_output)) ||
+	  ParseInt32Flag(arg, kStreamResultBufferFlag,
+					 &GTEST_FLAG(stream_result_buffer)) ||
+	  ParseStringFlag(arg, kStreamResultOverflowFlag,
+					  &GTEST_FLAG(stream_result_overflow)) ||
 	  ParseStringFlag(arg, kStreamResultToFlag,
 					  &GTEST_FLAG(stream_result_to)) ||
 	  ParseBoolFlag(arg, kThrowOnFailureFlag,
@@ -39,6 +39,7 @@
 #include "Assertion_result.h"
 #include "Test.h"
 #include "Scoped_trace.h"
+#include "Benchmark_state.h"
 
 #include "internal/Exception_handling.h"
 #include "internal/function_Make_and_register_test_info.h"
@@ -815,6 +816,28 @@ class TestWithParam : public ::jmsd::cutf::Test, public WithParamInterface<T> {
   GTEST_TEST_(test_fixture, test_name, test_fixture, \
 			  ::testing::internal::GetTypeId<test_fixture>())
 
+// Defines a benchmark.  The body is given a ::jmsd::cutf::Benchmark_state
+// named state and must loop while state.KeepRunning() returns true; the
+// calibrated timing of the loop is recorded as properties of the test (see
+// Benchmark_state.h).  A benchmark is otherwise an ordinary test: the
+// filter selects it and the reports list it by its suite and test names.
+//
+//   TEST_BENCH(VectorBench, PushBack) {
+//     std::vector<int> v;
+//     while (state.KeepRunning()) {
+//       v.push_back(1);
+//     }
+//   }
+//
+// BENCHMARK_F() is the same with a test fixture, like TEST_F().
+#define TEST_BENCH(test_suite_name, test_name)             \
+  GTEST_BENCHMARK_(test_suite_name, test_name, ::jmsd::cutf::Test, \
+				   ::testing::internal::GetTestTypeId())
+
+#define BENCHMARK_F(test_fixture, test_name)\
+  GTEST_BENCHMARK_(test_fixture, test_name, test_fixture, \
+				   ::testing::internal::GetTypeId<test_fixture>())
+
 // Returns a path to temporary directory.
 // Tries to determine an appropriate directory for the platform.
 JMSD_DEPRECATED_GTEST_API_ std::string TempDir();
@@ -9,6 +9,13 @@ namespace internal {
 AbstractSocketWriter::~AbstractSocketWriter()
 {}
 
+// Sends the given strings one after another.
+void AbstractSocketWriter::SendBatch( ::std::string const *const messages, ::std::size_t const count ) {
+	for ( ::std::size_t i = 0; i < count; ++i ) {
+		Send( messages[ i ] );
+	}
+}
+
 // Closes the socket.
 void AbstractSocketWriter::CloseConnection()
 {}
@@ -3,6 +3,7 @@
 #include "Abstract_socket_writer.hxx"
 
 
+#include <cstddef>
 #include <string>
 
 
@@ -20,6 +21,10 @@ public:
 	// Sends a string to the socket.
 	virtual void Send( ::std::string const &message ) = 0;
 
+	// Sends the given strings one after another.  The default sends them one
+	// by one; a writer that can hand them to the socket at once should.
+	virtual void SendBatch( ::std::string const *messages, ::std::size_t count );
+
 	// Closes the socket.
 	virtual void CloseConnection();
 
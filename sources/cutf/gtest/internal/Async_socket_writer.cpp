@@ -0,0 +1,216 @@
+#include "Async_socket_writer.h"
+
+
+#include <cstdint>
+#include <vector>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+namespace {
+
+// The most strings handed to the other writer at once.
+constexpr ::std::size_t kMaxBatchSize = 64;
+
+::std::size_t RoundUpToPowerOfTwo( ::std::size_t const value ) {
+	::std::size_t result = 2;
+
+	while ( result < value ) {
+		result <<= 1;
+	}
+
+	return result;
+}
+
+} // namespace
+
+
+// static
+bool AsyncSocketWriter::ParseOverflowPolicy( ::std::string const &name, OverflowPolicy *const policy ) {
+	if ( name == "block" ) {
+		*policy = kBlockOnOverflow;
+		return true;
+	}
+
+	if ( name == "drop" ) {
+		*policy = kDropOnOverflow;
+		return true;
+	}
+
+	return false;
+}
+
+AsyncSocketWriter::AsyncSocketWriter( AbstractSocketWriter *const socket_writer, ::std::size_t const capacity, OverflowPolicy const overflow_policy )
+	:
+		socket_writer_( socket_writer ),
+		overflow_policy_( overflow_policy ),
+		mask_( RoundUpToPowerOfTwo( capacity ) - 1 ),
+		cells_( new Cell[ mask_ + 1 ] ),
+		push_position_( 0 ),
+		pop_position_( 0 ),
+		dropped_count_( 0 ),
+		is_consumer_waiting_( false ),
+		waiting_producer_count_( 0 ),
+		is_stopping_( false )
+{
+	for ( ::std::size_t i = 0; i <= mask_; ++i ) {
+		cells_[ i ].sequence.store( i, ::std::memory_order_relaxed );
+	}
+
+	thread_ = ::std::thread( &AsyncSocketWriter::Loop, this );
+}
+
+AsyncSocketWriter::~AsyncSocketWriter() {
+	Stop();
+}
+
+void AsyncSocketWriter::Send( ::std::string const &message ) {
+	if ( !TryPush( message ) ) {
+		if ( overflow_policy_ == kDropOnOverflow ) {
+			dropped_count_.fetch_add( 1, ::std::memory_order_relaxed );
+			return;
+		}
+
+		::std::unique_lock< ::std::mutex > lock( mutex_ );
+		waiting_producer_count_.fetch_add( 1 );
+		::std::atomic_thread_fence( ::std::memory_order_seq_cst );
+
+		while ( !TryPush( message ) ) {
+			has_room_.wait( lock );
+		}
+
+		waiting_producer_count_.fetch_sub( 1 );
+	}
+
+	// Pairs with the fence in Loop(): either the thread sees the string, or
+	// this sees that the thread is going to sleep.
+	::std::atomic_thread_fence( ::std::memory_order_seq_cst );
+
+	if ( is_consumer_waiting_.load( ::std::memory_order_relaxed ) ) {
+		::std::lock_guard< ::std::mutex > const lock( mutex_ );
+		is_consumer_waiting_.store( false, ::std::memory_order_relaxed );
+		has_messages_.notify_one();
+	}
+}
+
+void AsyncSocketWriter::CloseConnection() {
+	Stop();
+
+	::std::size_t const dropped_count = this->dropped_count();
+
+	if ( dropped_count != 0 ) {
+		GTEST_LOG_( WARNING ) << "stream_result_to: dropped " << dropped_count << " events because the buffer was full.";
+	}
+
+	socket_writer_->CloseConnection();
+}
+
+::std::size_t AsyncSocketWriter::dropped_count() const {
+	return dropped_count_.load( ::std::memory_order_relaxed );
+}
+
+bool AsyncSocketWriter::TryPush( ::std::string const &message ) {
+	::std::size_t position = push_position_.load( ::std::memory_order_relaxed );
+	Cell *cell = nullptr;
+
+	for ( ;; ) {
+		cell = &cells_[ position & mask_ ];
+		::std::size_t const sequence = cell->sequence.load( ::std::memory_order_acquire );
+		::std::intptr_t const difference = static_cast< ::std::intptr_t >( sequence ) - static_cast< ::std::intptr_t >( position );
+
+		if ( difference == 0 ) {
+			if ( push_position_.compare_exchange_weak( position, position + 1, ::std::memory_order_relaxed ) ) {
+				break;
+			}
+		} else if ( difference < 0 ) {
+			return false; // the thread hasn't taken the string of the last round yet
+		} else {
+			position = push_position_.load( ::std::memory_order_relaxed );
+		}
+	}
+
+	// The cell keeps the buffer of a string the thread has sent, so this
+	// seldom allocates.
+	cell->message.assign( message );
+	cell->sequence.store( position + 1, ::std::memory_order_release );
+	return true;
+}
+
+::std::size_t AsyncSocketWriter::Pop( ::std::string *const messages, ::std::size_t const max_count ) {
+	::std::size_t count = 0;
+
+	while ( count < max_count ) {
+		Cell &cell = cells_[ pop_position_ & mask_ ];
+
+		if ( cell.sequence.load( ::std::memory_order_acquire ) != pop_position_ + 1 ) {
+			break;
+		}
+
+		messages[ count ].swap( cell.message );
+		cell.sequence.store( pop_position_ + mask_ + 1, ::std::memory_order_release );
+		++pop_position_;
+		++count;
+	}
+
+	return count;
+}
+
+void AsyncSocketWriter::Loop() {
+	::std::vector< ::std::string > batch( kMaxBatchSize );
+
+	for ( ;; ) {
+		::std::size_t const count = Pop( batch.data(), batch.size() );
+
+		if ( count != 0 ) {
+			::std::atomic_thread_fence( ::std::memory_order_seq_cst );
+
+			if ( waiting_producer_count_.load( ::std::memory_order_relaxed ) != 0 ) {
+				::std::lock_guard< ::std::mutex > const lock( mutex_ );
+				has_room_.notify_all();
+			}
+
+			socket_writer_->SendBatch( batch.data(), count );
+			continue;
+		}
+
+		::std::unique_lock< ::std::mutex > lock( mutex_ );
+		is_consumer_waiting_.store( true, ::std::memory_order_relaxed );
+		::std::atomic_thread_fence( ::std::memory_order_seq_cst );
+
+		Cell const &next = cells_[ pop_position_ & mask_ ];
+
+		if ( next.sequence.load( ::std::memory_order_acquire ) == pop_position_ + 1 ) {
+			is_consumer_waiting_.store( false, ::std::memory_order_relaxed );
+			continue;
+		}
+
+		if ( is_stopping_ ) {
+			break;
+		}
+
+		has_messages_.wait( lock, [ this ] { return !is_consumer_waiting_.load( ::std::memory_order_relaxed ) || is_stopping_; } );
+		is_consumer_waiting_.store( false, ::std::memory_order_relaxed );
+	}
+}
+
+void AsyncSocketWriter::Stop() {
+	if ( !thread_.joinable() ) {
+		return;
+	}
+
+	{
+		::std::lock_guard< ::std::mutex > const lock( mutex_ );
+		is_stopping_ = true;
+	}
+
+	has_messages_.notify_one();
+	thread_.join();
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
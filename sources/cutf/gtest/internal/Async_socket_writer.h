@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Async_socket_writer.hxx"
+
+
+#include "Abstract_socket_writer.h"
+
+#include "gtest-port.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// Sends the strings given to another socket writer from a thread of its own
+// (--cutf_stream_result_buffer), so that the threads running the tests don't
+// wait for the network.
+//
+// Send() only puts a copy of the string into a bounded ring; the writer's
+// thread takes whatever has gathered there and hands it to the other
+// writer's SendBatch() at once.  When the ring is full, Send() either waits
+// for room in it or drops the string and counts it, as the overflow policy
+// says.  CloseConnection() sends everything still in the ring before
+// closing the other writer, so nothing sent before the end of the test
+// program is lost.
+class AsyncSocketWriter :
+	public AbstractSocketWriter
+{
+
+public:
+	enum OverflowPolicy {
+		kBlockOnOverflow,
+		kDropOnOverflow
+	};
+
+	// Parses the value of --cutf_stream_result_overflow; returns false if
+	// it is neither "block" nor "drop".
+	static bool ParseOverflowPolicy( ::std::string const &name, OverflowPolicy *policy );
+
+	// Takes the ownership of the given writer.  The capacity is rounded up
+	// to a power of two.
+	AsyncSocketWriter( AbstractSocketWriter *socket_writer, ::std::size_t capacity, OverflowPolicy overflow_policy );
+
+	// Sends what is left in the ring, but doesn't close the other writer.
+	~AsyncSocketWriter() override;
+
+	// Puts the string into the ring.  Can be called from several threads.
+	void Send( ::std::string const &message ) override;
+
+	// Sends what is left in the ring, stops the thread and closes the other
+	// writer.
+	void CloseConnection() override;
+
+	// The number of strings dropped because the ring was full.
+	::std::size_t dropped_count() const;
+
+private:
+	// A slot of the ring.  Its sequence number tells whose turn it is: the
+	// producer of position p may fill it when the number is p, the consumer
+	// may take it when the number is p + 1.
+	struct Cell {
+		::std::atomic< ::std::size_t > sequence;
+		::std::string message;
+	};
+
+	bool TryPush( ::std::string const &message );
+
+	// Moves up to max_count strings out of the ring; returns their number.
+	::std::size_t Pop( ::std::string *messages, ::std::size_t max_count );
+
+	void Loop();
+
+	// Stops the thread after it has emptied the ring.
+	void Stop();
+
+	::std::unique_ptr< AbstractSocketWriter > const socket_writer_;
+	OverflowPolicy const overflow_policy_;
+
+	::std::size_t const mask_;
+	::std::unique_ptr< Cell[] > const cells_;
+	::std::atomic< ::std::size_t > push_position_;
+	::std::size_t pop_position_; // only used by the thread
+
+	::std::atomic< ::std::size_t > dropped_count_;
+
+	// The thread sleeps while the ring is empty, and so do the producers
+	// while it is full.  The flags tell the other side to wake them up.
+	::std::mutex mutex_;
+	::std::condition_variable has_messages_;
+	::std::condition_variable has_room_;
+	::std::atomic< bool > is_consumer_waiting_;
+	::std::atomic< int > waiting_producer_count_;
+	bool is_stopping_;
+
+	::std::thread thread_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( AsyncSocketWriter );
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
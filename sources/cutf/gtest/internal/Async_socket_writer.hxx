@@ -0,0 +1,20 @@
+#pragma once
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+class AsyncSocketWriter;
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
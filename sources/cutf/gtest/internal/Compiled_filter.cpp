@@ -0,0 +1,193 @@
+#include "Compiled_filter.h"
+
+
+#include "gtest/gtest-constants.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+Compiled_filter::Compiled_filter( std::string const &filter )
+	:
+		trie_( 1 )
+{
+	size_t start = 0;
+
+	for ( ;; ) {
+		size_t const colon = filter.find( ':', start );
+		AddPattern( filter.substr( start, colon == std::string::npos ? std::string::npos : colon - start ) );
+
+		if ( colon == std::string::npos ) break;
+
+		start = colon + 1;
+	}
+}
+
+bool Compiled_filter::Matches( std::string const &name ) const {
+	if ( literals_.count( name ) != 0 ) return true;
+
+	size_t node = 0;
+	for ( size_t i = 0; ; ++i ) {
+		for ( Glob const &glob : trie_[ node ].globs ) {
+			if ( GlobMatches( glob, name.c_str() + i, name.size() - i ) ) return true;
+		}
+
+		if ( i == name.size() ) break;
+
+		auto const child = trie_[ node ].children.find( name[ i ] );
+		if ( child == trie_[ node ].children.end() ) break;
+
+		node = child->second;
+	}
+
+	return false;
+}
+
+void Compiled_filter::AddPattern( std::string const &pattern ) {
+	size_t const wildcard = pattern.find_first_of( "*?" );
+
+	if ( wildcard == std::string::npos ) {
+		literals_.insert( pattern );
+		return;
+	}
+
+	// Walks (and grows) the trie along the literal prefix.
+	size_t node = 0;
+	for ( size_t i = 0; i < wildcard; ++i ) {
+		auto const child = trie_[ node ].children.find( pattern[ i ] );
+
+		if ( child != trie_[ node ].children.end() ) {
+			node = child->second;
+		} else {
+			trie_.push_back( Trie_node() );
+			trie_[ node ].children[ pattern[ i ] ] = trie_.size() - 1;
+			node = trie_.size() - 1;
+		}
+	}
+
+	// The rest of the pattern, starting at the first wildcard.
+	std::string const rest = pattern.substr( wildcard );
+
+	Glob glob;
+	glob.leading_star = rest.front() == '*';
+	glob.trailing_star = rest.back() == '*';
+
+	size_t start = 0;
+	for ( ;; ) {
+		size_t const star = rest.find( '*', start );
+		std::string const segment = rest.substr( start, star == std::string::npos ? std::string::npos : star - start );
+
+		if ( !segment.empty() ) {
+			glob.segments.push_back( segment );
+		}
+
+		if ( star == std::string::npos ) break;
+
+		start = star + 1;
+	}
+
+	trie_[ node ].globs.push_back( glob );
+}
+
+// Matches the name against the segments: the first one must be at the
+// start of the name unless the glob starts with '*', the last one at its
+// end unless the glob ends with '*', and the ones in between are taken at
+// their leftmost occurrence, which is never worse than any later one.
+// static
+bool Compiled_filter::GlobMatches( Glob const &glob, char const *const name, size_t const length ) {
+	if ( glob.segments.empty() ) return glob.leading_star || length == 0;
+
+	size_t begin = 0;
+	size_t end = length;
+	size_t first = 0;
+	size_t last = glob.segments.size();
+
+	if ( !glob.leading_star ) {
+		std::string const &segment = glob.segments.front();
+		if ( segment.size() > length || !SegmentMatchesAt( segment, name ) ) return false;
+
+		begin = segment.size();
+		first = 1;
+
+		// Without any '*', the only segment must cover the whole name.
+		if ( !glob.trailing_star && glob.segments.size() == 1 ) return begin == length;
+	}
+
+	if ( !glob.trailing_star ) {
+		std::string const &segment = glob.segments.back();
+		if ( segment.size() > end - begin || !SegmentMatchesAt( segment, name + length - segment.size() ) ) return false;
+
+		end = length - segment.size();
+		--last;
+	}
+
+	for ( size_t k = first; k < last; ++k ) {
+		std::string const &segment = glob.segments[ k ];
+		bool found = false;
+
+		for ( ; begin + segment.size() <= end; ++begin ) {
+			if ( SegmentMatchesAt( segment, name + begin ) ) {
+				found = true;
+				break;
+			}
+		}
+
+		if ( !found ) return false;
+
+		begin += segment.size();
+	}
+
+	return true;
+}
+
+// The caller makes sure the name has at least segment.size() characters left.
+// static
+bool Compiled_filter::SegmentMatchesAt( std::string const &segment, char const *const name ) {
+	for ( size_t i = 0; i < segment.size(); ++i ) {
+		if ( segment[ i ] != '?' && segment[ i ] != name[ i ] ) return false;
+	}
+
+	return true;
+}
+
+Compiled_test_filter::Compiled_test_filter( std::string const &filter )
+	:
+		positive_( PositivePart( filter ) ),
+		negative_( NegativePart( filter ) )
+{}
+
+bool Compiled_test_filter::Matches( std::string const &full_name ) const {
+	return positive_.Matches( full_name ) && !negative_.Matches( full_name );
+}
+
+// Everything up to the '-', if there is one.  '-test1' means '*-test1'.
+// static
+std::string Compiled_test_filter::PositivePart( std::string const &filter ) {
+	size_t const dash = filter.find( '-' );
+
+	if ( dash == std::string::npos ) return filter;
+	if ( dash == 0 ) return constants::kUniversalFilter;
+
+	return filter.substr( 0, dash );
+}
+
+// Everything after the '-', if there is one.
+// static
+std::string Compiled_test_filter::NegativePart( std::string const &filter ) {
+	size_t const dash = filter.find( '-' );
+
+	return dash == std::string::npos ? std::string() : filter.substr( dash + 1 );
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Compiled_filter.hxx"
+
+
+#include "gtest-port.h"
+
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+#include "cutf.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// A ':' separated list of glob patterns ('*' matches any string, '?' any
+// single character), parsed once so that many names can be matched against
+// it cheaply.  It matches a name if any of its patterns matches the whole
+// name, exactly like UnitTestOptions::MatchesFilter().
+//
+// Patterns without wildcards are looked up in a hash set.  The others are
+// indexed by their literal prefix in a trie, so a name is only tried against
+// the patterns whose prefix it starts with.  Each of those is matched by
+// finding its '*' separated segments left to right, which never backtracks
+// and takes time linear in the length of the name for every segment.
+class JMSD_CUTF_SHARED_INTERFACE Compiled_filter {
+
+public:
+	explicit Compiled_filter( std::string const &filter );
+
+	// Returns true if and only if a pattern of the filter matches the name.
+	bool Matches( std::string const &name ) const;
+
+private:
+	struct Glob {
+		// The pattern split at '*'s; empty segments are dropped.
+		std::vector< std::string > segments;
+
+		// Whether the pattern starts or ends with a '*'.
+		bool leading_star;
+		bool trailing_star;
+	};
+
+	struct Trie_node {
+		std::map< char, size_t > children;
+
+		// Globs whose literal prefix ends at this node.
+		std::vector< Glob > globs;
+	};
+
+	void AddPattern( std::string const &pattern );
+
+	static bool GlobMatches( Glob const &glob, char const *name, size_t length );
+	static bool SegmentMatchesAt( std::string const &segment, char const *name );
+
+	std::unordered_set< std::string > literals_;
+
+	// The root is the node of the empty prefix.
+	std::vector< Trie_node > trie_;
+};
+
+// The value of GTEST_FLAG(filter) compiled: positive patterns, optionally
+// followed by '-' and negative patterns.  A test runs if its full name
+// ("TestSuite.Test") matches a positive pattern and no negative one.
+class JMSD_CUTF_SHARED_INTERFACE Compiled_test_filter {
+
+public:
+	explicit Compiled_test_filter( std::string const &filter );
+
+	bool Matches( std::string const &full_name ) const;
+
+private:
+	static std::string PositivePart( std::string const &filter );
+	static std::string NegativePart( std::string const &filter );
+
+	Compiled_filter const positive_;
+	Compiled_filter const negative_;
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
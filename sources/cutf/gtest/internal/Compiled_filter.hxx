@@ -0,0 +1,21 @@
+#pragma once
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+class Compiled_filter;
+class Compiled_test_filter;
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,209 @@
+#include "Console_output.h"
+
+
+#include "gtest-port.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if !GTEST_OS_WINDOWS
+#include <signal.h>
+#endif // #if !GTEST_OS_WINDOWS
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+namespace {
+
+::std::atomic< bool > is_buffered_( false );
+::std::atomic< int64_t > flush_interval_nanos_( 0 );
+::std::atomic< int64_t > last_flush_nanos_( 0 );
+
+// Never freed: exit() flushes stdout after the static objects are
+// destroyed, and setvbuf() without a buffer of its own keeps using the one
+// it had.  A buffer is only deleted once a bigger one has replaced it.
+char *buffer_ = nullptr;
+::std::size_t buffer_capacity_ = 0;
+::std::size_t buffer_size_ = 0;
+
+// The thread that flushes stdout when it is due.  Left running, and never
+// freed, when the program exits while stdout is buffered.
+struct Flushing_thread {
+	::std::mutex mutex;
+	::std::condition_variable stop_requested;
+	bool is_stopping = false;
+	::std::thread thread;
+};
+
+Flushing_thread *flushing_thread_ = nullptr;
+
+int64_t NowInNanos() {
+	return ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( ::std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+#if !GTEST_OS_WINDOWS
+
+int const kFatalSignals[] = { SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGINT, SIGSEGV, SIGTERM };
+constexpr ::std::size_t kFatalSignalCount = sizeof( kFatalSignals ) / sizeof( kFatalSignals[ 0 ] );
+
+struct sigaction saved_actions_[ kFatalSignalCount ];
+
+// fflush() isn't async-signal-safe, but the program is about to die anyway,
+// and losing the output of the test that killed it is worse.
+void FlushAndReraise( int const signal_number ) {
+	fflush( stdout );
+
+	for ( ::std::size_t i = 0; i < kFatalSignalCount; ++i ) {
+		if ( kFatalSignals[ i ] == signal_number ) {
+			sigaction( signal_number, &saved_actions_[ i ], nullptr );
+			break;
+		}
+	}
+
+	raise( signal_number );
+}
+
+#endif // #if !GTEST_OS_WINDOWS
+
+} // namespace
+
+
+// static
+void Console_output::SetBuffered( ::std::size_t const buffer_size, int const flush_interval_millis ) {
+	THIS_STATIC::StopFlushingThread();
+	fflush( stdout );
+
+	if ( buffer_size == 0 ) {
+		bool const is_tty = ::testing::internal::posix::IsATTY( ::testing::internal::posix::FileNo( stdout ) ) != 0;
+		setvbuf( stdout, nullptr, is_tty ? _IOLBF : _IOFBF, BUFSIZ );
+		buffer_size_ = 0;
+		is_buffered_ = false;
+	} else {
+		char *replaced_buffer = nullptr;
+
+		if ( buffer_size > buffer_capacity_ ) {
+			replaced_buffer = buffer_;
+			buffer_ = new char[ buffer_size ];
+			buffer_capacity_ = buffer_size;
+		}
+
+		setvbuf( stdout, buffer_, _IOFBF, buffer_size );
+		delete[] replaced_buffer;
+
+		buffer_size_ = buffer_size;
+		flush_interval_nanos_ = static_cast< int64_t >( flush_interval_millis ) * 1000000;
+		last_flush_nanos_ = NowInNanos();
+		is_buffered_ = true;
+		THIS_STATIC::InstallCrashHooks();
+		THIS_STATIC::StartFlushingThread();
+	}
+}
+
+// static
+bool Console_output::is_buffered() {
+	return is_buffered_;
+}
+
+// static
+::std::size_t Console_output::buffer_size() {
+	return buffer_size_;
+}
+
+// static
+int Console_output::flush_interval_millis() {
+	return static_cast< int >( flush_interval_nanos_ / 1000000 );
+}
+
+// static
+void Console_output::FlushIfDue() {
+	if ( !is_buffered_ ) {
+		fflush( stdout );
+		return;
+	}
+
+	int64_t const now = NowInNanos();
+
+	if ( now - last_flush_nanos_.load( ::std::memory_order_relaxed ) >= flush_interval_nanos_.load( ::std::memory_order_relaxed ) ) {
+		last_flush_nanos_.store( now, ::std::memory_order_relaxed );
+		fflush( stdout );
+	}
+}
+
+// static
+void Console_output::Flush() {
+	last_flush_nanos_.store( NowInNanos(), ::std::memory_order_relaxed );
+	fflush( stdout );
+}
+
+// static
+void Console_output::InstallCrashHooks() {
+#if !GTEST_OS_WINDOWS
+	static bool is_installed = false;
+
+	if ( is_installed ) return;
+
+	is_installed = true;
+
+	struct sigaction action;
+	memset( &action, 0, sizeof( action ) );
+	sigemptyset( &action.sa_mask );
+	action.sa_handler = &FlushAndReraise;
+
+	for ( ::std::size_t i = 0; i < kFatalSignalCount; ++i ) {
+		sigaction( kFatalSignals[ i ], &action, &saved_actions_[ i ] );
+
+		// A program started in the background ignores SIGINT, and must keep
+		// doing so.
+		if ( saved_actions_[ i ].sa_handler == SIG_IGN ) {
+			sigaction( kFatalSignals[ i ], &saved_actions_[ i ], nullptr );
+		}
+	}
+#endif // #if !GTEST_OS_WINDOWS
+}
+
+// static
+void Console_output::StartFlushingThread() {
+	flushing_thread_ = new Flushing_thread;
+	Flushing_thread *const flushing_thread = flushing_thread_;
+
+	flushing_thread->thread = ::std::thread( [ flushing_thread ]() {
+		::std::unique_lock< ::std::mutex > lock( flushing_thread->mutex );
+
+		while ( !flushing_thread->stop_requested.wait_for(
+			lock,
+			::std::chrono::nanoseconds( flush_interval_nanos_.load( ::std::memory_order_relaxed ) ),
+			[ flushing_thread ]() { return flushing_thread->is_stopping; } ) )
+		{
+			THIS_STATIC::FlushIfDue();
+		}
+	} );
+}
+
+// static
+void Console_output::StopFlushingThread() {
+	if ( flushing_thread_ == nullptr ) return;
+
+	{
+		::std::lock_guard< ::std::mutex > const lock( flushing_thread_->mutex );
+		flushing_thread_->is_stopping = true;
+	}
+
+	flushing_thread_->stop_requested.notify_one();
+	flushing_thread_->thread.join();
+	delete flushing_thread_;
+	flushing_thread_ = nullptr;
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
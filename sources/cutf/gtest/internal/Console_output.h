@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Console_output.hxx"
+
+
+#include "cutf.h"
+
+#include <cstddef>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// Decides when the console output of the test program reaches stdout.
+//
+// By default every event of the result printer is flushed as soon as it is
+// printed.  With a buffer (--cutf_console_buffer), stdout is fully buffered
+// in that many bytes and FlushIfDue() flushes it only when the flush interval
+// has passed since the last flush, so that fast tests don't cost a write(2)
+// each.  Failures and the end of an iteration are flushed at once, and so
+// is whatever is left when the program is killed by a signal; exit()
+// flushes stdout by itself.  A thread of its own also calls FlushIfDue()
+// every flush interval, so the output of a test that hangs shows up too.
+class JMSD_CUTF_SHARED_INTERFACE Console_output {
+
+	typedef Console_output THIS_STATIC;
+
+public:
+	static constexpr int kDefaultFlushIntervalMillis = 100;
+
+	// Buffers stdout in buffer_size bytes, or, when buffer_size is 0, goes
+	// back to flushing every event.
+	static void SetBuffered( ::std::size_t buffer_size, int flush_interval_millis = kDefaultFlushIntervalMillis );
+
+	static bool is_buffered();
+
+	// The size of the buffer of stdout, or 0 when every event is flushed.
+	static ::std::size_t buffer_size();
+
+	static int flush_interval_millis();
+
+	// Flushes stdout if it isn't buffered or if it hasn't been flushed for
+	// the flush interval.
+	static void FlushIfDue();
+
+	// Flushes stdout now.
+	static void Flush();
+
+// = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = =
+private:
+	virtual ~Console_output() noexcept = delete;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+private:
+	Console_output() noexcept = delete;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+private:
+	Console_output( Console_output const &another ) noexcept = delete;
+	Console_output &operator =( Console_output const &another ) noexcept = delete;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+private:
+	Console_output( Console_output &&another ) noexcept = delete;
+	Console_output &operator =( Console_output &&another ) noexcept = delete;
+
+// # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # #
+private:
+	// Makes the signals that end the program flush stdout before they kill
+	// it.
+	static void InstallCrashHooks();
+
+	// Starts or stops the thread that flushes stdout when it is due.
+	static void StartFlushingThread();
+	static void StopFlushingThread();
+
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
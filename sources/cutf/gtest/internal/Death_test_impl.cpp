@@ -2,6 +2,7 @@
 
 
 #include "Death_test_check.h"
+#include "Death_test_reactor.h"
 
 #include "function_Fail_from_internal_error.h"
 
@@ -24,7 +25,9 @@ DeathTestImpl::DeathTestImpl( char const *a_statement, ::testing::Matcher< ::std
 		status_( -1 ),
 		outcome_( ::testing::internal::DeathTestOutcome::IN_PROGRESS ),
 		read_fd_( -1 ),
-		write_fd_( -1 )
+		write_fd_( -1 ),
+		stderr_fd_( -1 ),
+		stderr_collected_( false )
 {}
 
 // read_fd_ is expected to be closed and cleared by a derived class.
@@ -76,11 +79,24 @@ void DeathTestImpl::set_write_fd( int const fd ) {
 	write_fd_ = fd;
 }
 
+int DeathTestImpl::stderr_fd() const {
+	return stderr_fd_;
+}
+
+void DeathTestImpl::set_stderr_fd( int const fd ) {
+	stderr_fd_ = fd;
+}
+
 // Called in the parent process only. Reads the result code of the death
 // test child process via a pipe, interprets it to set the outcome_
 // member, and closes read_fd_.  Outputs diagnostics and terminates in
 // case of unexpected codes.
 void DeathTestImpl::ReadAndInterpretStatusByte() {
+  if (stderr_fd() != -1) {
+	CollectStatusAndStderr();
+	return;
+  }
+
   char flag;
   int bytes_read;
 
@@ -95,24 +111,10 @@ void DeathTestImpl::ReadAndInterpretStatusByte() {
   if (bytes_read == 0) {
 	set_outcome( ::testing::internal::DeathTestOutcome::DIED);
   } else if (bytes_read == 1) {
-	switch (flag) {
-	  case ::testing::internal::kDeathTestReturned:
-		set_outcome(::testing::internal::DeathTestOutcome::RETURNED);
-		break;
-	  case ::testing::internal::kDeathTestThrew:
-		set_outcome(::testing::internal::DeathTestOutcome::THREW);
-		break;
-	  case ::testing::internal::kDeathTestLived:
-		set_outcome(::testing::internal::DeathTestOutcome::LIVED);
-		break;
-	  case ::testing::internal::kDeathTestInternalError:
-		::jmsd::cutf::internal::function_Fail_from_internal_error::FailFromInternalError(read_fd());  // Does not return.
-		break;
-	  default:
-		GTEST_LOG_(FATAL) << "Death test child process reported "
-						  << "unexpected status byte ("
-						  << static_cast<unsigned int>(flag) << ")";
+	if (flag == ::testing::internal::kDeathTestInternalError) {
+	  ::jmsd::cutf::internal::function_Fail_from_internal_error::FailFromInternalError(read_fd());  // Does not return.
 	}
+	InterpretStatusByte(flag);
   } else {
 	GTEST_LOG_(FATAL) << "Read from death test child process failed: "
 					  << function_Get_last_errno_description::GetLastErrnoDescription();
@@ -121,7 +123,48 @@ void DeathTestImpl::ReadAndInterpretStatusByte() {
   set_read_fd(-1);
 }
 
+void DeathTestImpl::InterpretStatusByte(char const flag) {
+  switch (flag) {
+	case ::testing::internal::kDeathTestReturned:
+	  set_outcome(::testing::internal::DeathTestOutcome::RETURNED);
+	  break;
+	case ::testing::internal::kDeathTestThrew:
+	  set_outcome(::testing::internal::DeathTestOutcome::THREW);
+	  break;
+	case ::testing::internal::kDeathTestLived:
+	  set_outcome(::testing::internal::DeathTestOutcome::LIVED);
+	  break;
+	default:
+	  GTEST_LOG_(FATAL) << "Death test child process reported "
+						<< "unexpected status byte ("
+						<< static_cast<unsigned int>(flag) << ")";
+  }
+}
+
+void DeathTestImpl::CollectStatusAndStderr() {
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  std::string status_output;
+  Death_test_reactor::GetInstance()->Collect(read_fd(), &status_output, stderr_fd(), &stderr_output_);
+  set_read_fd(-1);
+  set_stderr_fd(-1);
+  stderr_collected_ = true;
+
+  if (status_output.empty()) {
+	set_outcome(::testing::internal::DeathTestOutcome::DIED);
+  } else if (status_output[0] == ::testing::internal::kDeathTestInternalError) {
+	// The rest is the message FailFromInternalError() would have read.
+	GTEST_LOG_(FATAL) << status_output.substr(1);
+  } else {
+	InterpretStatusByte(status_output[0]);
+  }
+#else
+  GTEST_LOG_(FATAL) << "Death test children can't have stderr pipes of their own here";
+#endif // #if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+}
+
 std::string DeathTestImpl::GetErrorLogs() {
+  if (stderr_collected_) return stderr_output_;
+
   return ::testing::internal::GetCapturedStderr();
 }
 
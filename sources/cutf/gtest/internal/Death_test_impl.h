@@ -34,17 +34,27 @@ protected:
 	void set_read_fd(int fd);
 	int write_fd() const;
 	void set_write_fd(int fd);
+	int stderr_fd() const;
+	void set_stderr_fd(int fd);
 
 	// Called in the parent process only. Reads the result code of the death
 	// test child process via a pipe, interprets it to set the outcome_
 	// member, and closes read_fd_.  Outputs diagnostics and terminates in
-	// case of unexpected codes.
+	// case of unexpected codes.  If the child has a stderr pipe of its own,
+	// it is read to its end at the same time.
 	void ReadAndInterpretStatusByte();
 
 	// Returns stderr output from the child process.
 	virtual std::string GetErrorLogs();
 
 private:
+	// Sets outcome_ from a status byte other than kDeathTestInternalError.
+	void InterpretStatusByte(char flag);
+
+	// ReadAndInterpretStatusByte() for a child with a stderr pipe: both pipes
+	// are read by the Death_test_reactor.
+	void CollectStatusAndStderr();
+
 	// The textual content of the code this object is testing.  This class
 	// doesn't own this string and should not attempt to delete it.
 	const char* const statement_;
@@ -70,6 +80,15 @@ private:
 	// It is always -1 in the parent process.  The parent keeps its end of the
 	// pipe in read_fd_.
 	int write_fd_;
+
+	// Descriptor to the read end of the child's stderr when that goes to a
+	// pipe of its own rather than to the captured stderr of this process;
+	// -1 otherwise.  See Death_test_reactor.
+	int stderr_fd_;
+
+	// True once the stderr output of the child is in stderr_output_.
+	bool stderr_collected_;
+	std::string stderr_output_;
 };
 
 
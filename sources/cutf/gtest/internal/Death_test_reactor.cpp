@@ -0,0 +1,146 @@
+#include "Death_test_reactor.h"
+
+
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+#include "Death_test_check.h"
+#include "function_Get_last_errno_description.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <thread>
+
+#endif // #if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+std::atomic< bool > Death_test_reactor::is_active_( false );
+std::atomic< bool > Death_test_reactor::is_started_( false );
+
+// The reactor and its thread live until the process exits.
+// static
+Death_test_reactor *Death_test_reactor::GetInstance() {
+	static Death_test_reactor *const instance = new Death_test_reactor;
+	return instance;
+}
+
+// static
+bool Death_test_reactor::is_active() {
+	return is_active_;
+}
+
+// static
+void Death_test_reactor::set_active( bool const is_active ) {
+	is_active_ = is_active;
+}
+
+// static
+bool Death_test_reactor::is_started() {
+	return is_started_;
+}
+
+Death_test_reactor::Death_test_reactor()
+	:
+		epoll_fd_( epoll_create1( EPOLL_CLOEXEC ) )
+{
+	GTEST_DEATH_TEST_CHECK_( epoll_fd_ != -1 );
+	std::thread( &Death_test_reactor::Loop, this ).detach();
+	is_started_ = true;
+}
+
+void Death_test_reactor::Collect( int const status_fd, std::string *const status_output, int const stderr_fd, std::string *const stderr_output ) {
+	Collection collection;
+	collection.open_count = 2;
+
+	Add( status_fd, status_output, &collection );
+	Add( stderr_fd, stderr_output, &collection );
+
+	std::unique_lock< std::mutex > lock( mutex_ );
+	collection.closed.wait( lock, [ &collection ]() { return collection.open_count == 0; } );
+}
+
+void Death_test_reactor::Add( int const fd, std::string *const output, Collection *const collection ) {
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		Reading const reading = { output, collection };
+		readings_[ fd ] = reading;
+	}
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	GTEST_DEATH_TEST_CHECK_SYSCALL_( epoll_ctl( epoll_fd_, EPOLL_CTL_ADD, fd, &event ) );
+}
+
+void Death_test_reactor::Loop() {
+	epoll_event events[ 16 ];
+
+	for ( ;; ) {
+		int const count = epoll_wait( epoll_fd_, events, sizeof( events ) / sizeof( events[ 0 ] ), -1 );
+
+		if ( count == -1 ) {
+			if ( errno == EINTR ) continue;
+
+			GTEST_LOG_( FATAL ) << "epoll_wait() for death test children failed: " << function_Get_last_errno_description::GetLastErrnoDescription();
+		}
+
+		for ( int i = 0; i < count; ++i ) {
+			Drain( events[ i ].data.fd );
+		}
+	}
+}
+
+void Death_test_reactor::Drain( int const fd ) {
+	Reading reading;
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		reading = readings_.find( fd )->second;
+	}
+
+	char buffer[ 4096 ];
+	ssize_t read_count;
+	do {
+		read_count = read( fd, buffer, sizeof( buffer ) );
+	} while ( read_count == -1 && errno == EINTR );
+
+	if ( read_count > 0 ) {
+		reading.output->append( buffer, static_cast< size_t >( read_count ) );
+		return;
+	}
+
+	GTEST_DEATH_TEST_CHECK_SYSCALL_( epoll_ctl( epoll_fd_, EPOLL_CTL_DEL, fd, nullptr ) );
+
+	// Forgotten before it is closed: once closed, its number may come back with a new pipe.
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		readings_.erase( fd );
+	}
+
+	GTEST_DEATH_TEST_CHECK_SYSCALL_( close( fd ) );
+
+	std::lock_guard< std::mutex > lock( mutex_ );
+	if ( --reading.collection->open_count == 0 ) {
+		reading.collection->closed.notify_all();
+	}
+}
+
+#endif // #if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
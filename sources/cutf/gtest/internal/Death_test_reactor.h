@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Death_test_reactor.hxx"
+
+
+#include "gtest-port.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+// Concurrent death tests (--cutf_death_test_jobs) wait for their children
+// through epoll(7).
+#if GTEST_HAS_DEATH_TEST && GTEST_OS_LINUX
+# define JMSD_CUTF_HAS_DEATH_TEST_REACTOR_ 1
+#else
+# define JMSD_CUTF_HAS_DEATH_TEST_REACTOR_ 0
+#endif
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+// Collects the status pipes and stderr output of death test children that
+// run at the same time.
+//
+// One thread, started on first use, waits on an epoll instance for all the
+// descriptors handed to Collect() and drains whichever is readable, so a
+// child never blocks on a full stderr pipe while its parent is waiting for
+// the status byte.  The caller of Collect() just sleeps until both of its
+// descriptors are closed by the child.
+//
+// While the reactor is active, death tests give every child a stderr pipe
+// of its own instead of capturing the stderr of the whole process, which
+// only works for one death test at a time.
+class Death_test_reactor {
+
+public:
+	static Death_test_reactor *GetInstance();
+
+	// Whether death tests run concurrently and hand their children's
+	// descriptors to the reactor.
+	static bool is_active();
+	static void set_active( bool is_active );
+
+	// Whether the thread of the reactor has been started; it runs until the
+	// process exits.
+	static bool is_started();
+
+	// Reads the status pipe and the stderr pipe of a death test child until
+	// the end of both, appends what was read to the given strings and closes
+	// the descriptors.
+	void Collect( int status_fd, std::string *status_output, int stderr_fd, std::string *stderr_output );
+
+private:
+	// The descriptors of one Collect() call.
+	struct Collection {
+		int open_count;
+		std::condition_variable closed;
+	};
+
+	struct Reading {
+		std::string *output;
+		Collection *collection;
+	};
+
+	Death_test_reactor();
+
+	void Add( int fd, std::string *output, Collection *collection );
+	void Loop();
+
+	// Reads once from a readable descriptor; at its end, forgets and closes it.
+	void Drain( int fd );
+
+	static std::atomic< bool > is_active_;
+	static std::atomic< bool > is_started_;
+
+	int const epoll_fd_;
+
+	// Guards readings_ and the open counts of the collections.
+	std::mutex mutex_;
+	std::map< int, Reading > readings_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Death_test_reactor );
+};
+
+#endif // #if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -3,6 +3,7 @@
 
 #include "Unit_test_impl.h"
 #include "gtest/Test_event_listener.h"
+#include "gtest/Test_result.h"
 
 
 namespace jmsd {
@@ -16,8 +17,17 @@ DefaultGlobalTestPartResultReporter::DefaultGlobalTestPartResultReporter( UnitTe
 {}
 
 void DefaultGlobalTestPartResultReporter::ReportTestPartResult( ::testing::TestPartResult const &result ) {
+	// Threads started by a test only count their results; the thread
+	// running the test lists them and tells the listeners when it merges
+	// them, at its next result or at the end of the test.
+	if ( !unit_test_->is_test_thread() ) {
+		unit_test_->AddPendingTestPartResult( result );
+		return;
+	}
+
+	unit_test_->MergePendingTestPartResults();
 	unit_test_->current_test_result()->AddTestPartResult(result);
-	unit_test_->listeners()->repeater()->OnTestPartResult(result);
+	unit_test_->event_sink()->OnTestPartResult(result);
 }
 
 
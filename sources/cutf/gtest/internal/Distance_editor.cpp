@@ -1,8 +1,9 @@
 #include "Distance_editor.h"
 
 
-#include <map>
-#include <list>
+#include <unordered_map>
+#include <functional>
+#include <cstddef>
 #include <sstream>
 #include <algorithm>
 #include <type_traits>
@@ -70,21 +71,184 @@ namespace internal {
   return best_path;
 }
 
-// Helper class to convert string into ids with deduplication.
+namespace {
+
+
+// Finds the shortest edits between two sequences the way Myers describes
+// in "An O(ND) Difference Algorithm and Its Variations", section 4b: the
+// middle snake of the edit graph splits the problem in two, each solved
+// recursively, so only the two furthest-reaching D-path arrays are kept.
+class Shortest_edit_finder {
+
+public:
+	Shortest_edit_finder( ::std::vector< size_t > const &left, ::std::vector< size_t > const &right )
+		:
+			left_( left ),
+			right_( right ),
+			offset_( static_cast< ::std::ptrdiff_t >( ( left.size() + right.size() + 1 ) / 2 + 1 ) ),
+			forward_( static_cast< size_t >( 2 * offset_ + 1 ) ),
+			backward_( static_cast< size_t >( 2 * offset_ + 1 ) )
+	{}
+
+	// Appends the edits from left[left_begin, left_end) to right[right_begin, right_end).
+	void Find(
+		::std::ptrdiff_t left_begin, ::std::ptrdiff_t right_begin,
+		::std::ptrdiff_t left_end, ::std::ptrdiff_t right_end,
+		::std::vector< Distance_editor::EditType > *edits )
+	{
+		while ( left_begin < left_end && right_begin < right_end && Equal( left_begin, right_begin ) ) {
+			edits->push_back( Distance_editor::kMatch );
+			++left_begin;
+			++right_begin;
+		}
+
+		size_t common_suffix = 0;
+		while ( left_begin < left_end && right_begin < right_end && Equal( left_end - 1, right_end - 1 ) ) {
+			--left_end;
+			--right_end;
+			++common_suffix;
+		}
+
+		if ( left_begin == left_end ) {
+			edits->insert( edits->end(), static_cast< size_t >( right_end - right_begin ), Distance_editor::kAdd );
+		} else if ( right_begin == right_end ) {
+			edits->insert( edits->end(), static_cast< size_t >( left_end - left_begin ), Distance_editor::kRemove );
+		} else {
+			Snake snake{};
+			FindMiddleSnake( left_begin, right_begin, left_end, right_end, &snake );
+
+			Find( left_begin, right_begin, snake.left_begin, snake.right_begin, edits );
+			edits->insert( edits->end(), static_cast< size_t >( snake.left_end - snake.left_begin ), Distance_editor::kMatch );
+			Find( snake.left_end, snake.right_end, left_end, right_end, edits );
+		}
+
+		edits->insert( edits->end(), common_suffix, Distance_editor::kMatch );
+	}
+
+private:
+	// A run of matches on one diagonal of the edit graph.
+	struct Snake {
+		::std::ptrdiff_t left_begin;
+		::std::ptrdiff_t right_begin;
+		::std::ptrdiff_t left_end;
+		::std::ptrdiff_t right_end;
+	};
+
+	bool Equal( ::std::ptrdiff_t const left_index, ::std::ptrdiff_t const right_index ) const {
+		return left_[ static_cast< size_t >( left_index ) ] == right_[ static_cast< size_t >( right_index ) ];
+	}
+
+	// The furthest left index reached on diagonal k (left index - right
+	// index) going forward, and the furthest (lowest) right index reached
+	// on diagonal c (relative to the end corner) going backward.
+	::std::ptrdiff_t &Forward( ::std::ptrdiff_t const k ) { return forward_[ static_cast< size_t >( offset_ + k ) ]; }
+	::std::ptrdiff_t &Backward( ::std::ptrdiff_t const c ) { return backward_[ static_cast< size_t >( offset_ + c ) ]; }
+
+	// Extends D-paths from both corners of the box, D growing by one each
+	// round, until a forward and a backward path overlap; the last snake
+	// of the path that reaches the other one is the middle snake.  The box
+	// has no common prefix or suffix, and neither side is empty.
+	void FindMiddleSnake(
+		::std::ptrdiff_t const left_begin, ::std::ptrdiff_t const right_begin,
+		::std::ptrdiff_t const left_end, ::std::ptrdiff_t const right_end,
+		Snake *const snake )
+	{
+		::std::ptrdiff_t const n = left_end - left_begin;
+		::std::ptrdiff_t const m = right_end - right_begin;
+		::std::ptrdiff_t const delta = n - m;
+		bool const is_delta_odd = delta % 2 != 0;
+		::std::ptrdiff_t const max_d = ( n + m + 1 ) / 2;
+
+		Forward( 1 ) = 0;
+		Backward( 1 ) = m;
+
+		for ( ::std::ptrdiff_t d = 0; d <= max_d; ++d ) {
+			for ( ::std::ptrdiff_t k = -d; k <= d; k += 2 ) {
+				// Moves down (an add) from diagonal k + 1, or right (a remove) from diagonal k - 1.
+				::std::ptrdiff_t x = k == -d || ( k != d && Forward( k - 1 ) < Forward( k + 1 ) ) ? Forward( k + 1 ) : Forward( k - 1 ) + 1;
+				::std::ptrdiff_t y = x - k;
+				::std::ptrdiff_t const snake_x = x;
+				::std::ptrdiff_t const snake_y = y;
+
+				while ( x < n && y < m && Equal( left_begin + x, right_begin + y ) ) {
+					++x;
+					++y;
+				}
+
+				Forward( k ) = x;
+
+				::std::ptrdiff_t const c = k - delta;
+				if ( is_delta_odd && c >= -( d - 1 ) && c <= d - 1 && y >= Backward( c ) ) {
+					*snake = Snake{ left_begin + snake_x, right_begin + snake_y, left_begin + x, right_begin + y };
+					return;
+				}
+			}
+
+			for ( ::std::ptrdiff_t c = -d; c <= d; c += 2 ) {
+				// Moves left (a remove) from diagonal c + 1, or up (an add) from diagonal c - 1.
+				::std::ptrdiff_t y = c == -d || ( c != d && Backward( c - 1 ) > Backward( c + 1 ) ) ? Backward( c + 1 ) : Backward( c - 1 ) - 1;
+				::std::ptrdiff_t const k = c + delta;
+				::std::ptrdiff_t x = y + k;
+				::std::ptrdiff_t const snake_x = x;
+				::std::ptrdiff_t const snake_y = y;
+
+				while ( x > 0 && y > 0 && Equal( left_begin + x - 1, right_begin + y - 1 ) ) {
+					--x;
+					--y;
+				}
+
+				Backward( c ) = y;
+
+				if ( !is_delta_odd && k >= -d && k <= d && x <= Forward( k ) ) {
+					*snake = Snake{ left_begin + x, right_begin + y, left_begin + snake_x, right_begin + snake_y };
+					return;
+				}
+			}
+		}
+	}
+
+	::std::vector< size_t > const &left_;
+	::std::vector< size_t > const &right_;
+
+	// Diagonals range over [-offset_, offset_].
+	::std::ptrdiff_t const offset_;
+	::std::vector< ::std::ptrdiff_t > forward_;
+	::std::vector< ::std::ptrdiff_t > backward_;
+};
+
+
+} // namespace
+
+
+::std::vector< Distance_editor::EditType > Distance_editor::CalculateShortestEdits(
+	::std::vector< size_t > const &left,
+	::std::vector< size_t > const &right )
+{
+	::std::vector< EditType > edits;
+	edits.reserve( ::std::max( left.size(), right.size() ) );
+
+	Shortest_edit_finder( left, right ).Find(
+		0, 0, static_cast< ::std::ptrdiff_t >( left.size() ), static_cast< ::std::ptrdiff_t >( right.size() ), &edits );
+
+	return edits;
+}
+
+// Helper class to convert string into ids with deduplication.  The table
+// refers to the strings, which must outlive it, instead of copying them.
 class Distance_editor::InternalStrings {
 public:
 	size_t GetId(const std::string& str);
 
 private:
-	typedef ::std::map< ::std::string, size_t > IdMap;
+	typedef ::std::unordered_map<
+		::std::reference_wrapper< ::std::string const >, size_t,
+		::std::hash< ::std::string >, ::std::equal_to< ::std::string > > IdMap;
 	IdMap ids_;
 };
 
 size_t Distance_editor::InternalStrings::GetId(const std::string& str) {
-	IdMap::iterator it = ids_.find(str);
-	if (it != ids_.end()) return it->second;
-	size_t id = ids_.size();
-	return ids_[ str ] = id;
+	size_t const id = ids_.size();
+	return ids_.emplace( ::std::cref( str ), id ).first->second;
 }
 
 
@@ -104,6 +268,28 @@ std::vector< Distance_editor::EditType > Distance_editor::CalculateOptimalEdits(
   return CalculateOptimalEdits(left_ids, right_ids);
 }
 
+::std::vector< Distance_editor::EditType > Distance_editor::CalculateShortestEdits(
+	::std::vector< ::std::string > const &left,
+	::std::vector< ::std::string > const &right )
+{
+	::std::vector< size_t > left_ids;
+	::std::vector< size_t > right_ids;
+	left_ids.reserve( left.size() );
+	right_ids.reserve( right.size() );
+
+	{
+		InternalStrings intern_table;
+		for ( ::std::string const &line : left ) {
+			left_ids.push_back( intern_table.GetId( line ) );
+		}
+		for ( ::std::string const &line : right ) {
+			right_ids.push_back( intern_table.GetId( line ) );
+		}
+	}
+
+	return CalculateShortestEdits( left_ids, right_ids );
+}
+
 // Helper class that holds the state for one hunk and prints it out to the stream.
 // It reorders adds/removes when possible to group all removes before all adds.
 // It also adds the hunk header before printint into the stream.
@@ -132,9 +318,9 @@ private:
 	size_t adds_;
 	size_t removes_;
 	size_t common_;
-	::std::list< ::std::pair< char, char const * > > hunk_;
-	::std::list< ::std::pair< char, char const * > > hunk_removes_;
-	::std::list< ::std::pair< char, char const * > > hunk_adds_;
+	::std::vector< ::std::pair< char, char const * > > hunk_;
+	::std::vector< ::std::pair< char, char const * > > hunk_removes_;
+	::std::vector< ::std::pair< char, char const * > > hunk_adds_;
 };
 
 Distance_editor::Hunk::Hunk( size_t const left_start, size_t const right_start )
@@ -170,8 +356,8 @@ void Distance_editor::Hunk::PrintTo( std::ostream *os ) {
 	PrintHeader( os );
 	FlushEdits();
 
-	for ( std::list< std::pair< char, const char * > >::const_iterator it = hunk_.begin(); it != hunk_.end(); ++it ) {
-		*os << it->first << it->second << "\n";
+	for ( ::std::pair< char, char const * > const &line : hunk_ ) {
+		*os << line.first << line.second << "\n";
 	}
 }
 
@@ -180,8 +366,10 @@ bool Distance_editor::Hunk::has_edits() const {
 }
 
 void Distance_editor::Hunk::FlushEdits() {
-	hunk_.splice( hunk_.end(), hunk_removes_ );
-	hunk_.splice( hunk_.end(), hunk_adds_ );
+	hunk_.insert( hunk_.end(), hunk_removes_.begin(), hunk_removes_.end() );
+	hunk_.insert( hunk_.end(), hunk_adds_.begin(), hunk_adds_.end() );
+	hunk_removes_.clear();
+	hunk_adds_.clear();
 }
 
 void Distance_editor::Hunk::PrintHeader( std::ostream *ss ) const {
@@ -209,12 +397,13 @@ void Distance_editor::Hunk::PrintHeader( std::ostream *ss ) const {
 // 'context' represents the desired unchanged prefix/suffix around the diff.
 // If two hunks are close enough that their contexts overlap, then they are
 // joined into one hunk.
+// The edits are the shortest ones, which keeps long inputs cheap to diff.
 std::string Distance_editor::CreateUnifiedDiff(
 	const std::vector<std::string>& left,
 	const std::vector<std::string>& right,
 	size_t context )
 {
-	const std::vector<EditType> edits = CalculateOptimalEdits(left, right);
+	const std::vector<EditType> edits = CalculateShortestEdits(left, right);
 
 	size_t l_i = 0;
 	size_t r_i = 0;
@@ -39,6 +39,19 @@ public:
 		::std::vector< ::std::string > const &left,
 		::std::vector< ::std::string > const &right);
 
+	// Returns the edits to go from 'left' to 'right' with the fewest adds and
+	// removes; there are no replaces.  Myers' algorithm, in O((N+M)D) time
+	// for D edits and linear space, so that it copes with long inputs.
+	// See http://www.xmailserver.org/diff2.pdf
+	static ::std::vector< EditType > CalculateShortestEdits(
+		::std::vector< size_t > const &left,
+		::std::vector< size_t > const &right );
+
+	// Same as above, but the input is represented as strings.
+	static ::std::vector< EditType > CalculateShortestEdits(
+		::std::vector< ::std::string > const &left,
+		::std::vector< ::std::string > const &right );
+
 	// Create a diff of the input strings in Unified diff format.
 	static ::std::string CreateUnifiedDiff(
 		::std::vector< ::std::string > const &left,
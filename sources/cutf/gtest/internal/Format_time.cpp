@@ -7,6 +7,7 @@
 
 #include "gtest/Message.hin"
 
+#include <iomanip>
 #include <sstream>
 
 
@@ -61,6 +62,14 @@ bool Format_time::PortableLocaltime( time_t seconds, struct tm *out ) {
   return ss.str();
 }
 
+// Formats the given time in nanoseconds as milliseconds, to the microsecond.
+// static
+::std::string Format_time::FormatTimeInNanosAsMillis( ::testing::internal::TimeInNanos ns ) {
+	::std::stringstream ss;
+	ss << ( ns / 1000000 ) << '.' << ::std::setfill( '0' ) << ::std::setw( 3 ) << ( ns / 1000 % 1000 );
+	return ss.str();
+}
+
 // Converts the given epoch time in milliseconds to a date string in the RFC3339 format, without the timezone information.
 // static
 ::std::string Format_time::FormatEpochTimeInMillisAsRFC3339( ::testing::internal::TimeInMillis ms) {
@@ -27,6 +27,7 @@ public:
 
 	static ::std::string FormatTimeInMillisAsSeconds( ::testing::internal::TimeInMillis ms );
 	static ::std::string FormatTimeInMillisAsDuration( ::testing::internal::TimeInMillis ms );
+	static ::std::string FormatTimeInNanosAsMillis( ::testing::internal::TimeInNanos ns );
 	static ::std::string FormatEpochTimeInMillisAsIso8601( ::testing::internal::TimeInMillis ms );
 	static ::std::string FormatEpochTimeInMillisAsRFC3339( ::testing::internal::TimeInMillis ms );
 
@@ -6,7 +6,8 @@
 
 #include "function_Open_file_for_writing.h"
 #include "Format_time.h"
-#include "function_String_stream_to_string.h"
+#include "Report_file_buffer.h"
+#include "gtest/gtest-flags.h"
 
 #include "gtest-string.h"
 
@@ -22,19 +23,160 @@ namespace internal {
 
 // Creates a new JsonUnitTestResultPrinter.
 JsonUnitTestResultPrinter::JsonUnitTestResultPrinter(const char* output_file)
-	: output_file_(output_file) {
+	: output_file_(output_file),
+	  is_streamed_(::testing::GTEST_FLAG(stream_output)),
+	  streamed_report_stream_(nullptr),
+	  has_streamed_test_suite_(false),
+	  has_streamed_test_(false) {
   if (output_file_.empty()) {
 	GTEST_LOG_(FATAL) << "JSON output file may not be null";
   }
 }
 
+JsonUnitTestResultPrinter::~JsonUnitTestResultPrinter() {
+}
+
+// Unless the report is streamed, it is written when the iteration ends, and
+// the events of the tests don't need to reach this printer.
+unsigned JsonUnitTestResultPrinter::event_interests() const {
+  if (is_streamed_) {
+	return kOnTestIterationStart | kOnTestSuiteStart | kOnTestEnd |
+		   kOnTestSuiteEnd | kOnTestIterationEnd | kOnTestProgramEnd;
+  }
+
+  return kOnTestIterationEnd | kOnTestProgramEnd;
+}
+
+// Called before each iteration; starts the streamed report (a new one for
+// every iteration, as the report of the last iteration is kept).
+void JsonUnitTestResultPrinter::OnTestIterationStart(const ::jmsd::cutf::UnitTest& unit_test,
+													 int /*iteration*/) {
+  if (!is_streamed_) {
+	return;
+  }
+
+  streamed_report_.reset();
+  streamed_report_.reset(new Report_file_buffer(function_Open_file_for_writing::OpenFileForWriting(output_file_)));
+  streamed_report_stream_.rdbuf(streamed_report_.get());
+  streamed_report_stream_.clear();
+  has_streamed_test_suite_ = false;
+
+  const std::string kTestsuites = "testsuites";
+  const std::string kIndent = Indent(2);
+  streamed_report_stream_ << "{\n";
+  OutputJsonKey(&streamed_report_stream_, kTestsuites, "tests", unit_test.reportable_test_count(),
+				kIndent);
+  OutputJsonKey(&streamed_report_stream_, kTestsuites, "name", "AllTests", kIndent);
+  streamed_report_stream_ << kIndent << "\"" << kTestsuites << "\": [\n";
+}
+
+void JsonUnitTestResultPrinter::OnTestSuiteStart(const ::jmsd::cutf::TestSuite& test_suite) {
+  if (streamed_report_ == nullptr) {
+	return;
+  }
+
+  const std::string kTestsuite = "testsuite";
+  const std::string kIndent = Indent(6);
+  if (has_streamed_test_suite_) {
+	streamed_report_stream_ << ",\n";
+  } else {
+	has_streamed_test_suite_ = true;
+  }
+  has_streamed_test_ = false;
+
+  streamed_report_stream_ << Indent(4) << "{\n";
+  OutputJsonKey(&streamed_report_stream_, kTestsuite, "name", test_suite.name(), kIndent);
+  OutputJsonKey(&streamed_report_stream_, kTestsuite, "tests",
+				test_suite.reportable_test_count(), kIndent);
+  streamed_report_stream_ << kIndent << "\"" << kTestsuite << "\": [\n";
+}
+
+void JsonUnitTestResultPrinter::OnTestEnd(const ::jmsd::cutf::TestInfo& test_info) {
+  if (streamed_report_ == nullptr || !test_info.is_reportable()) {
+	return;
+  }
+
+  if (has_streamed_test_) {
+	streamed_report_stream_ << ",\n";
+  } else {
+	has_streamed_test_ = true;
+  }
+  OutputJsonTestInfo(&streamed_report_stream_, test_info.test_suite_name(), test_info);
+  streamed_report_->FlushIfDue();
+}
+
+// Adds the tests of the suite that didn't run (disabled ones), which got
+// no OnTestEnd(), and ends the suite with its results.
+void JsonUnitTestResultPrinter::OnTestSuiteEnd(const ::jmsd::cutf::TestSuite& test_suite) {
+  if (streamed_report_ == nullptr) {
+	return;
+  }
+
+  const std::string kIndent = Indent(6);
+  for (int i = 0; i < test_suite.total_test_count(); ++i) {
+	const ::jmsd::cutf::TestInfo& test_info = *test_suite.GetTestInfo(i);
+	if (test_info.is_reportable() && !test_info.should_run()) {
+	  if (has_streamed_test_) {
+		streamed_report_stream_ << ",\n";
+	  } else {
+		has_streamed_test_ = true;
+	  }
+	  OutputJsonTestInfo(&streamed_report_stream_, test_suite.name(), test_info);
+	}
+  }
+
+  streamed_report_stream_ << "\n" << kIndent << "],\n";
+  OutputJsonTestSuiteResults(&streamed_report_stream_, test_suite, kIndent);
+  streamed_report_stream_ << "\n" << Indent(4) << "}";
+  FlushStreamedReport();
+}
+
 void JsonUnitTestResultPrinter::OnTestIterationEnd(const ::jmsd::cutf::UnitTest& unit_test,
 												  int /*iteration*/) {
-  FILE* jsonout = function_Open_file_for_writing::OpenFileForWriting(output_file_);
-  std::stringstream stream;
+  if (streamed_report_ != nullptr) {
+	// Suites with reportable tests but none to run got no OnTestSuiteStart().
+	for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
+	  const ::jmsd::cutf::TestSuite& test_suite = *unit_test.GetTestSuite(i);
+	  if (test_suite.reportable_test_count() > 0 && !test_suite.should_run()) {
+		if (has_streamed_test_suite_) {
+		  streamed_report_stream_ << ",\n";
+		} else {
+		  has_streamed_test_suite_ = true;
+		}
+		PrintJsonTestSuite(&streamed_report_stream_, test_suite);
+	  }
+	}
+
+	const std::string kIndent = Indent(2);
+	streamed_report_stream_ << "\n" << kIndent << "],\n";
+	OutputJsonUnitTestResults(&streamed_report_stream_, unit_test, kIndent);
+	streamed_report_stream_ << "\n";
+	FlushStreamedReport();
+	return;
+  }
+
+  if (is_streamed_) {
+	return;
+  }
+
+  Report_file_buffer jsonout(function_Open_file_for_writing::OpenFileForWriting(output_file_));
+  std::ostream stream(&jsonout);
   PrintJsonUnitTest(&stream, unit_test);
-  fprintf(jsonout, "%s", function_String_stream_to_string::StringStreamToString( stream ).c_str());
-  fclose(jsonout);
+}
+
+// Ends the streamed report.
+void JsonUnitTestResultPrinter::OnTestProgramEnd(const ::jmsd::cutf::UnitTest& /*unit_test*/) {
+  if (streamed_report_ == nullptr) {
+	return;
+  }
+
+  streamed_report_stream_ << "}\n";
+  streamed_report_stream_.rdbuf(nullptr);
+  streamed_report_.reset();
+}
+
+void JsonUnitTestResultPrinter::FlushStreamedReport() {
+  streamed_report_stream_.flush();
 }
 
 // static
@@ -44,42 +186,47 @@ void JsonUnitTestResultPrinter::OnTestIterationEnd(const ::jmsd::cutf::UnitTest&
 
 // Returns an JSON-escaped copy of the input string str.
 std::string JsonUnitTestResultPrinter::EscapeJson(const std::string& str) {
-  Message m;
+  std::stringstream stream;
+  OutputEscapedJson(&stream, str);
+  return stream.str();
+}
 
+// Streams str JSON-escaped, without building the escaped copy.
+void JsonUnitTestResultPrinter::OutputEscapedJson(std::ostream* stream,
+												  const std::string& str) {
   for (size_t i = 0; i < str.size(); ++i) {
 	const char ch = str[i];
 	switch (ch) {
 	  case '\\':
 	  case '"':
 	  case '/':
-		m << '\\' << ch;
+		stream->put('\\');
+		stream->put(ch);
 		break;
 	  case '\b':
-		m << "\\b";
+		*stream << "\\b";
 		break;
 	  case '\t':
-		m << "\\t";
+		*stream << "\\t";
 		break;
 	  case '\n':
-		m << "\\n";
+		*stream << "\\n";
 		break;
 	  case '\f':
-		m << "\\f";
+		*stream << "\\f";
 		break;
 	  case '\r':
-		m << "\\r";
+		*stream << "\\r";
 		break;
 	  default:
 		if (ch < ' ') {
-		  m << "\\u00" << ::testing::internal::String::FormatByte(static_cast<unsigned char>(ch));
+		  *stream << "\\u00" << ::testing::internal::String::FormatByte(static_cast<unsigned char>(ch));
 		} else {
-		  m << ch;
+		  stream->put(ch);
 		}
 		break;
 	}
   }
-
-  return m.GetString();
 }
 
 void JsonUnitTestResultPrinter::OutputJsonKey(
@@ -96,7 +243,9 @@ void JsonUnitTestResultPrinter::OutputJsonKey(
 	  << "Key \"" << name << "\" is not allowed for value \"" << element_name
 	  << "\".";
 
-  *stream << indent << "\"" << name << "\": \"" << EscapeJson(value) << "\"";
+  *stream << indent << "\"" << name << "\": \"";
+  OutputEscapedJson(stream, value);
+  *stream << "\"";
   if (comma)
 	*stream << ",\n";
 }
@@ -150,6 +299,7 @@ void JsonUnitTestResultPrinter::OutputJsonTestInfo(::std::ostream* stream,
   OutputJsonKey( stream, kTestsuite, "result", test_info.should_run() ? ( result.Skipped() ? "SKIPPED" : "COMPLETED" ) : "SUPPRESSED", kIndent );
   OutputJsonKey( stream, kTestsuite, "timestamp", Format_time::FormatEpochTimeInMillisAsRFC3339( result.start_timestamp() ), kIndent );
   OutputJsonKey( stream, kTestsuite, "time", Format_time::FormatTimeInMillisAsDuration(result.elapsed_time()), kIndent );
+  OutputJsonKey( stream, kTestsuite, "time_ns", function_Streamable_to_string::StreamableToString(result.elapsed_time_nanos()), kIndent );
   OutputJsonKey( stream, kTestsuite, "classname", test_suite_name, kIndent, false );
   *stream << TestPropertiesAsJson(result, kIndent);
 
@@ -164,9 +314,10 @@ void JsonUnitTestResultPrinter::OutputJsonTestInfo(::std::ostream* stream,
 	  const std::string location =
 		  ::testing::internal::FormatCompilerIndependentFileLocation(part.file_name(),
 														  part.line_number());
-	  const std::string message = EscapeJson(location + "\n" + part.message());
 	  *stream << kIndent << "  {\n"
-			  << kIndent << "    \"failure\": \"" << message << "\",\n"
+			  << kIndent << "    \"failure\": \"";
+	  OutputEscapedJson(stream, location + "\n" + part.message_with_stack_trace());
+	  *stream << "\",\n"
 			  << kIndent << "    \"type\": \"\"\n"
 			  << kIndent << "  }";
 	}
@@ -177,6 +328,31 @@ void JsonUnitTestResultPrinter::OutputJsonTestInfo(::std::ostream* stream,
   *stream << "\n" << Indent(8) << "}";
 }
 
+// Streams the members of a TestSuite object that are only known once the
+// suite has run.
+void JsonUnitTestResultPrinter::OutputJsonTestSuiteResults(
+	std::ostream* stream, const ::jmsd::cutf::TestSuite& test_suite,
+	const std::string& indent) {
+  const std::string kTestsuite = "testsuite";
+
+  OutputJsonKey(stream, kTestsuite, "failures",
+				test_suite.failed_test_count(), indent);
+  OutputJsonKey(stream, kTestsuite, "disabled",
+				test_suite.reportable_disabled_test_count(), indent);
+  OutputJsonKey(stream, kTestsuite, "errors", 0, indent);
+  OutputJsonKey(
+	  stream, kTestsuite, "timestamp",
+	  Format_time::FormatEpochTimeInMillisAsRFC3339(test_suite.start_timestamp()),
+	  indent);
+  OutputJsonKey(stream, kTestsuite, "time",
+				Format_time::FormatTimeInMillisAsDuration(test_suite.elapsed_time()),
+				indent);
+  OutputJsonKey(stream, kTestsuite, "time_ns",
+				function_Streamable_to_string::StreamableToString(test_suite.elapsed_time_nanos()),
+				indent, false);
+  *stream << TestPropertiesAsJson(test_suite.ad_hoc_test_result(), indent);
+}
+
 // Prints an JSON representation of a TestSuite object
 void JsonUnitTestResultPrinter::PrintJsonTestSuite(
 	std::ostream* stream, const ::jmsd::cutf::TestSuite& test_suite) {
@@ -188,20 +364,8 @@ void JsonUnitTestResultPrinter::PrintJsonTestSuite(
   OutputJsonKey(stream, kTestsuite, "tests", test_suite.reportable_test_count(),
 				kIndent);
   if (!::testing:: GTEST_FLAG(list_tests)) {
-	OutputJsonKey(stream, kTestsuite, "failures",
-				  test_suite.failed_test_count(), kIndent);
-	OutputJsonKey(stream, kTestsuite, "disabled",
-				  test_suite.reportable_disabled_test_count(), kIndent);
-	OutputJsonKey(stream, kTestsuite, "errors", 0, kIndent);
-	OutputJsonKey(
-		stream, kTestsuite, "timestamp",
-		Format_time::FormatEpochTimeInMillisAsRFC3339(test_suite.start_timestamp()),
-		kIndent);
-	OutputJsonKey(stream, kTestsuite, "time",
-				  Format_time::FormatTimeInMillisAsDuration(test_suite.elapsed_time()),
-				  kIndent, false);
-	*stream << TestPropertiesAsJson(test_suite.ad_hoc_test_result(), kIndent)
-			<< ",\n";
+	OutputJsonTestSuiteResults(stream, test_suite, kIndent);
+	*stream << ",\n";
   }
 
   *stream << kIndent << "\"" << kTestsuite << "\": [\n";
@@ -220,33 +384,45 @@ void JsonUnitTestResultPrinter::PrintJsonTestSuite(
   *stream << "\n" << kIndent << "]\n" << Indent(4) << "}";
 }
 
-// Prints a JSON summary of unit_test to output stream out.
-void JsonUnitTestResultPrinter::PrintJsonUnitTest(std::ostream* stream,
-												  const ::jmsd::cutf::UnitTest& unit_test) {
+// Streams the members of the UnitTest object that are only known once the
+// tests have run.
+void JsonUnitTestResultPrinter::OutputJsonUnitTestResults(
+	std::ostream* stream, const ::jmsd::cutf::UnitTest& unit_test,
+	const std::string& indent) {
   const std::string kTestsuites = "testsuites";
-  const std::string kIndent = Indent(2);
-  *stream << "{\n";
 
-  OutputJsonKey(stream, kTestsuites, "tests", unit_test.reportable_test_count(),
-				kIndent);
   OutputJsonKey(stream, kTestsuites, "failures", unit_test.failed_test_count(),
-				kIndent);
+				indent);
   OutputJsonKey(stream, kTestsuites, "disabled",
-				unit_test.reportable_disabled_test_count(), kIndent);
-  OutputJsonKey(stream, kTestsuites, "errors", 0, kIndent);
+				unit_test.reportable_disabled_test_count(), indent);
+  OutputJsonKey(stream, kTestsuites, "errors", 0, indent);
   if ( ::testing:: GTEST_FLAG(shuffle)) {
 	OutputJsonKey(stream, kTestsuites, "random_seed", unit_test.random_seed(),
-				  kIndent);
+				  indent);
   }
   OutputJsonKey(stream, kTestsuites, "timestamp",
 				Format_time::FormatEpochTimeInMillisAsRFC3339(unit_test.start_timestamp()),
-				kIndent);
+				indent);
   OutputJsonKey(stream, kTestsuites, "time",
-				Format_time::FormatTimeInMillisAsDuration(unit_test.elapsed_time()), kIndent,
+				Format_time::FormatTimeInMillisAsDuration(unit_test.elapsed_time()), indent);
+  OutputJsonKey(stream, kTestsuites, "time_ns",
+				function_Streamable_to_string::StreamableToString(unit_test.elapsed_time_nanos()), indent,
 				false);
 
-  *stream << TestPropertiesAsJson(unit_test.ad_hoc_test_result(), kIndent)
-		  << ",\n";
+  *stream << TestPropertiesAsJson(unit_test.ad_hoc_test_result(), indent);
+}
+
+// Prints a JSON summary of unit_test to output stream out.
+void JsonUnitTestResultPrinter::PrintJsonUnitTest(std::ostream* stream,
+												  const ::jmsd::cutf::UnitTest& unit_test) {
+  const std::string kTestsuites = "testsuites";
+  const std::string kIndent = Indent(2);
+  *stream << "{\n";
+
+  OutputJsonKey(stream, kTestsuites, "tests", unit_test.reportable_test_count(),
+				kIndent);
+  OutputJsonUnitTestResults(stream, unit_test, kIndent);
+  *stream << ",\n";
 
   OutputJsonKey(stream, kTestsuites, "name", "AllTests", kIndent);
   *stream << kIndent << "\"" << kTestsuites << "\": [\n";
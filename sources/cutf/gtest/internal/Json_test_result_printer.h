@@ -7,6 +7,11 @@
 
 #include "gtest/Test_result.hxx"
 
+#include "Report_file_buffer.hxx"
+
+
+#include <memory>
+#include <ostream>
 #include <string>
 
 
@@ -16,11 +21,24 @@ namespace internal {
 
 
 // This class generates an JSON output file.
-class JsonUnitTestResultPrinter : public EmptyTestEventListener {
+//
+// With --cutf_stream_output, the file is written as the tests run, like
+// the XML one: the members known only once a test suite (or the whole run)
+// has ended follow its "testsuite" (or "testsuites") array, and the
+// document is closed when the program ends.
+class JMSD_CUTF_SHARED_INTERFACE JsonUnitTestResultPrinter : public EmptyTestEventListener {
  public:
   explicit JsonUnitTestResultPrinter(const char* output_file);
+  ~JsonUnitTestResultPrinter() override;
+
+  unsigned event_interests() const override;
 
+  void OnTestIterationStart(const ::jmsd::cutf::UnitTest& unit_test, int iteration) override;
+  void OnTestSuiteStart(const ::jmsd::cutf::TestSuite& test_suite) override;
+  void OnTestEnd(const ::jmsd::cutf::TestInfo& test_info) override;
+  void OnTestSuiteEnd(const ::jmsd::cutf::TestSuite& test_suite) override;
   void OnTestIterationEnd(const ::jmsd::cutf::UnitTest& unit_test, int iteration) override;
+  void OnTestProgramEnd(const ::jmsd::cutf::UnitTest& unit_test) override;
 
   // Prints an JSON summary of all unit tests.
   static void PrintJsonTestList(::std::ostream* stream,
@@ -32,6 +50,9 @@ private:
   // Returns an JSON-escaped copy of the input string str.
   static std::string EscapeJson(const std::string& str);
 
+  // Streams str JSON-escaped, as EscapeJson() returns it.
+  static void OutputEscapedJson(std::ostream* stream, const std::string& str);
+
   //// Verifies that the given attribute belongs to the given element and
   //// streams the attribute as JSON.
   static void OutputJsonKey(std::ostream* stream,
@@ -52,10 +73,22 @@ private:
 								 const char* test_suite_name,
 								 const ::jmsd::cutf::TestInfo& test_info);
 
+  // Streams the members of a TestSuite object that are only known once
+  // the suite has run, without a trailing comma.
+  static void OutputJsonTestSuiteResults(::std::ostream* stream,
+										 const ::jmsd::cutf::TestSuite& test_suite,
+										 const std::string& indent);
+
   // Prints a JSON representation of a TestSuite object
   static void PrintJsonTestSuite(::std::ostream* stream,
 								 const ::jmsd::cutf::TestSuite& test_suite);
 
+  // Streams the members of the UnitTest object that are only known once
+  // the tests have run, without a trailing comma.
+  static void OutputJsonUnitTestResults(::std::ostream* stream,
+										const ::jmsd::cutf::UnitTest& unit_test,
+										const std::string& indent);
+
   // Prints a JSON summary of unit_test to output stream out.
   static void PrintJsonUnitTest(::std::ostream* stream,
 								const ::jmsd::cutf::UnitTest& unit_test);
@@ -65,9 +98,28 @@ private:
   static std::string TestPropertiesAsJson(const TestResult& result,
 										  const std::string& indent);
 
+  // Flushes the streamed report to its file, as a test suite or the
+  // iteration ends.  In between, the report buffer writes itself out when
+  // it fills up, and OnTestEnd() flushes it when it's due, so a crash only
+  // loses the tests that ended within the flush interval of the last flush.
+  void FlushStreamedReport();
+
   // The output file.
   const std::string output_file_;
 
+  // Whether the report is streamed (--cutf_stream_output).
+  const bool is_streamed_;
+
+  // The file of the streamed report, while it is written, and the
+  // stream writing to it.
+  std::unique_ptr<Report_file_buffer> streamed_report_;
+  std::ostream streamed_report_stream_;
+
+  // Whether a test suite (a test of the current test suite) has been
+  // streamed, and so the next one needs a separating comma.
+  bool has_streamed_test_suite_;
+  bool has_streamed_test_;
+
   GTEST_DISALLOW_COPY_AND_ASSIGN_(JsonUnitTestResultPrinter);
 };
 
@@ -0,0 +1,285 @@
+#include "Parallel_test_runner.h"
+
+
+#include "Test_execution_context.h"
+#include "Test_isolation.h"
+#include "Unit_test_impl.h"
+
+#include "gtest/Test_info.h"
+#include "gtest/Test_suite.h"
+#include "gtest/Test_event_listener.h"
+
+#include "gtest/gtest-internal-inl.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+void Parallel_test_runner::Work_queue::Push( Work_unit const &unit ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	units_.push_back( unit );
+}
+
+bool Parallel_test_runner::Work_queue::PopFront( Work_unit *const unit ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+
+	if ( units_.empty() ) return false;
+
+	*unit = units_.front();
+	units_.pop_front();
+	return true;
+}
+
+bool Parallel_test_runner::Work_queue::StealBack( Work_unit *const unit ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+
+	if ( units_.empty() ) return false;
+
+	*unit = units_.back();
+	units_.pop_back();
+	return true;
+}
+
+void Parallel_test_runner::Orphan_event_sink::OnTestSuiteStart( TestSuite const &test_suite ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	recorder_.OnTestSuiteStart( test_suite );
+}
+
+void Parallel_test_runner::Orphan_event_sink::OnTestStart( TestInfo const &test_info ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	recorder_.OnTestStart( test_info );
+}
+
+void Parallel_test_runner::Orphan_event_sink::OnTestPartResult( ::testing::TestPartResult const &test_part_result ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	recorder_.OnTestPartResult( test_part_result );
+}
+
+void Parallel_test_runner::Orphan_event_sink::OnTestEnd( TestInfo const &test_info ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	recorder_.OnTestEnd( test_info );
+}
+
+void Parallel_test_runner::Orphan_event_sink::OnTestSuiteEnd( TestSuite const &test_suite ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	recorder_.OnTestSuiteEnd( test_suite );
+}
+
+void Parallel_test_runner::Orphan_event_sink::ReplayAndClear( TestEventListener *const listener ) {
+	::testing::internal::MutexLock lock( &mutex_ );
+	recorder_.Replay( listener );
+	recorder_.Clear();
+}
+
+Parallel_test_runner::Parallel_test_runner( UnitTestImpl *const impl, int const jobs, bool const in_run_order )
+	:
+		impl_( impl ),
+		jobs_( jobs > 1 ? static_cast< size_t >( jobs ) : 1u ),
+		in_run_order_( in_run_order ),
+		next_publication_( 0 )
+{}
+
+Parallel_test_runner::~Parallel_test_runner()
+{}
+
+void Parallel_test_runner::Schedule( TestSuite *const test_suite ) {
+	if ( !test_suite->should_run() ) return;
+
+	publications_.emplace_back();
+	Publication &publication = publications_.back();
+	publication.split_suite = nullptr;
+	publication.is_ready = false;
+
+	if ( test_suite->set_up_tc_ != nullptr || test_suite->tear_down_tc_ != nullptr ) {
+		publication.recorder.reset( new Test_event_recorder );
+		Work_unit const unit = { test_suite, nullptr, -1, publications_.size() - 1 };
+		scheduled_units_.push_back( unit );
+		return;
+	}
+
+	std::unique_ptr< Split_suite > split_suite( new Split_suite );
+	split_suite->test_suite = test_suite;
+	split_suite->publication = publications_.size() - 1;
+	publication.split_suite = split_suite.get();
+	split_suite->recorders.resize( static_cast< size_t >( test_suite->total_test_count() ) );
+	split_suite->start_nanos.resize( static_cast< size_t >( test_suite->total_test_count() ) );
+	split_suite->end_nanos.resize( static_cast< size_t >( test_suite->total_test_count() ) );
+	int pending = 0;
+
+	for ( int i = 0; i < test_suite->total_test_count(); ++i ) {
+		if ( !test_suite->GetMutableTestInfo( i )->should_run() ) continue;
+
+		split_suite->recorders[ static_cast< size_t >( i ) ].reset( new Test_event_recorder );
+		Work_unit const unit = { test_suite, split_suite.get(), i, split_suite->publication };
+		scheduled_units_.push_back( unit );
+		++pending;
+	}
+
+	split_suite->pending = pending;
+	split_suites_.push_back( std::move( split_suite ) );
+}
+
+void Parallel_test_runner::Run() {
+	if ( scheduled_units_.empty() ) return;
+
+	size_t const worker_count = ( std::min )( jobs_, scheduled_units_.size() );
+
+	queues_.clear();
+	for ( size_t i = 0; i < worker_count; ++i ) {
+		queues_.emplace_back( new Work_queue );
+	}
+
+	for ( size_t i = 0; i < scheduled_units_.size(); ++i ) {
+		queues_[ i % worker_count ]->Push( scheduled_units_[ i ] );
+	}
+
+	// The stack trace getter is created lazily; make sure the workers don't race to create it.
+	impl_->os_stack_trace_getter();
+	impl_->set_orphan_event_sink( &orphan_events_ );
+	Test_isolation::GetInstance()->AddWorkers( static_cast< int >( worker_count ) );
+
+	std::vector< std::thread > workers;
+	for ( size_t i = 1; i < worker_count; ++i ) {
+		workers.emplace_back( &Parallel_test_runner::WorkerLoop, this, i );
+	}
+
+	WorkerLoop( 0 );
+
+	for ( std::thread &worker : workers ) {
+		worker.join();
+	}
+
+	impl_->set_orphan_event_sink( nullptr );
+	orphan_events_.ReplayAndClear( impl_->listeners()->repeater() );
+	scheduled_units_.clear();
+	split_suites_.clear();
+	publications_.clear();
+	next_publication_ = 0;
+}
+
+void Parallel_test_runner::WorkerLoop( size_t const worker_index ) {
+	Test_execution_context context;
+	impl_->set_execution_context( &context );
+
+	Test_isolation *const isolation = Test_isolation::GetInstance();
+
+	Work_unit unit;
+	while ( TakeUnit( worker_index, &unit ) ) {
+		isolation->EnterUnit();
+		RunUnit( unit, &context );
+		isolation->LeaveUnit();
+	}
+
+	isolation->LeavePool();
+	impl_->set_execution_context( nullptr );
+}
+
+bool Parallel_test_runner::TakeUnit( size_t const worker_index, Work_unit *const unit ) {
+	if ( queues_[ worker_index ]->PopFront( unit ) ) return true;
+
+	for ( size_t i = 1; i < queues_.size(); ++i ) {
+		if ( queues_[ ( worker_index + i ) % queues_.size() ]->StealBack( unit ) ) return true;
+	}
+
+	// Units are never added once Run() has started, so empty queues mean we are done.
+	return false;
+}
+
+void Parallel_test_runner::RunUnit( Work_unit const &unit, Test_execution_context *const context ) {
+	if ( unit.split_suite == nullptr ) {
+		context->event_sink = publications_[ unit.publication ].recorder.get();
+		unit.test_suite->Run();
+		context->event_sink = nullptr;
+
+		Publish( unit.publication );
+		return;
+	}
+
+	Split_suite *const split_suite = unit.split_suite;
+	context->current_test_suite = unit.test_suite;
+	context->event_sink = split_suite->recorders[ static_cast< size_t >( unit.test_index ) ].get();
+	split_suite->start_nanos[ static_cast< size_t >( unit.test_index ) ] = ::testing::internal::GetMonotonicTimeInNanos();
+	unit.test_suite->GetMutableTestInfo( unit.test_index )->Run();
+	split_suite->end_nanos[ static_cast< size_t >( unit.test_index ) ] = ::testing::internal::GetMonotonicTimeInNanos();
+	context->event_sink = nullptr;
+	context->current_test_suite = nullptr;
+
+	if ( --split_suite->pending == 0 ) {
+		PublishSplitSuite( split_suite );
+	}
+}
+
+void Parallel_test_runner::PublishSplitSuite( Split_suite *const split_suite ) {
+	TestSuite *const test_suite = split_suite->test_suite;
+
+	// The suite ran as independent pieces; report the span they covered.
+	::testing::internal::TimeInMillis start = ( std::numeric_limits< ::testing::internal::TimeInMillis >::max )();
+	::testing::internal::TimeInNanos start_nanos = ( std::numeric_limits< ::testing::internal::TimeInNanos >::max )();
+	::testing::internal::TimeInNanos end_nanos = ( std::numeric_limits< ::testing::internal::TimeInNanos >::min )();
+
+	for ( int i = 0; i < test_suite->total_test_count(); ++i ) {
+		size_t const position = static_cast< size_t >( i );
+		if ( split_suite->recorders[ position ] == nullptr ) continue;
+
+		start = ( std::min )( start, test_suite->GetMutableTestInfo( i )->result()->start_timestamp() );
+		start_nanos = ( std::min )( start_nanos, split_suite->start_nanos[ position ] );
+		end_nanos = ( std::max )( end_nanos, split_suite->end_nanos[ position ] );
+	}
+
+	test_suite->start_timestamp_ = start;
+	test_suite->elapsed_time_nanos_ = end_nanos - start_nanos;
+	test_suite->elapsed_time_ = ::testing::internal::NanosToMillis( test_suite->elapsed_time_nanos_ );
+
+	Publish( split_suite->publication );
+}
+
+void Parallel_test_runner::Publish( size_t const publication ) {
+	::testing::internal::MutexLock lock( &event_mutex_ );
+	publications_[ publication ].is_ready = true;
+
+	if ( !in_run_order_ ) {
+		Deliver( publications_[ publication ] );
+		return;
+	}
+
+	while ( next_publication_ < publications_.size() && publications_[ next_publication_ ].is_ready ) {
+		Deliver( publications_[ next_publication_ ] );
+		++next_publication_;
+	}
+}
+
+void Parallel_test_runner::Deliver( Publication const &publication ) {
+	TestEventListener *const repeater = impl_->listeners()->repeater();
+
+	if ( publication.split_suite == nullptr ) {
+		publication.recorder->Replay( repeater );
+		return;
+	}
+
+	TestSuite const &test_suite = *publication.split_suite->test_suite;
+
+	repeater->OnTestSuiteStart( test_suite );
+	for ( std::unique_ptr< Test_event_recorder > const &recorder : publication.split_suite->recorders ) {
+		if ( recorder != nullptr ) {
+			recorder->Replay( repeater );
+		}
+	}
+	repeater->OnTestSuiteEnd( test_suite );
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Parallel_test_runner.hxx"
+
+
+#include "Test_event_recorder.h"
+#include "Test_execution_context.hxx"
+#include "Unit_test_impl.hxx"
+
+#include "gtest/Test_suite.hxx"
+
+#include "gtest-port.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// Runs test suites on a pool of worker threads (the --cutf_jobs mode).
+//
+// A test suite that has SetUpTestSuite() or TearDownTestSuite() is scheduled
+// as one unit of work, because its tests share the state those functions set
+// up.  Any other test suite is split into one unit per test that should run.
+// Units are dealt round-robin onto per-worker queues in the current (possibly
+// shuffled) order; a worker takes units from the front of its own queue and,
+// once that is empty, steals from the back of the others.
+//
+// Every worker installs a Test_execution_context, so the "current test" seen
+// by assertions is per thread, and records the events of a unit into a
+// Test_event_recorder.  A finished unit is then replayed to the listeners
+// under one lock, so printers see each test suite as a contiguous block even
+// though suites complete out of order.  A split suite is published by
+// whichever worker finishes its last test.
+//
+// In run order, a finished unit or split suite is held back until everything
+// scheduled before it has been published, so the listeners see the same
+// sequence as from a serial run.  RunAllTests() runs the death test suites
+// this way on their own runner (the --cutf_death_test_jobs mode), before the
+// pool for the other suites starts.
+//
+// A test that touches process-wide state runs alone through Test_isolation;
+// the other workers wait while it runs.
+//
+// The calling thread acts as the first worker.
+class Parallel_test_runner {
+
+public:
+	Parallel_test_runner( UnitTestImpl *impl, int jobs, bool in_run_order );
+	~Parallel_test_runner();
+
+	// Queues the tests of the given test suite that should run.
+	void Schedule( TestSuite *test_suite );
+
+	// Runs every scheduled unit and returns when all of them have finished
+	// and their events have been delivered to the listeners.
+	void Run();
+
+private:
+	struct Split_suite {
+		TestSuite *test_suite;
+
+		// One recorder per test position, in the suite's current order; null for tests that don't run.
+		std::vector< std::unique_ptr< Test_event_recorder > > recorders;
+
+		// When each test started and ended, on the monotonic clock; written by the worker that runs the test.
+		std::vector< ::testing::internal::TimeInNanos > start_nanos;
+		std::vector< ::testing::internal::TimeInNanos > end_nanos;
+
+		// Number of scheduled tests that haven't finished yet.
+		std::atomic< int > pending;
+
+		size_t publication;
+	};
+
+	struct Work_unit {
+		TestSuite *test_suite;
+
+		// Null when the unit is the whole test suite.
+		Split_suite *split_suite;
+
+		// Position of the test within the test suite; unused for whole suites.
+		int test_index;
+
+		// Unused for split suites, which have one publication for all their units.
+		size_t publication;
+	};
+
+	// What a whole suite unit or a split suite delivers to the listeners once it is done.
+	struct Publication {
+		// The events of a whole suite unit; null for a split suite.
+		std::unique_ptr< Test_event_recorder > recorder;
+
+		Split_suite *split_suite;
+
+		bool is_ready;
+	};
+
+	// Records the events raised by threads that are not workers, whichever
+	// thread raises them.
+	class Orphan_event_sink :
+		public EmptyTestEventListener
+	{
+	public:
+		void OnTestSuiteStart( TestSuite const &test_suite ) override;
+		void OnTestStart( TestInfo const &test_info ) override;
+		void OnTestPartResult( ::testing::TestPartResult const &test_part_result ) override;
+		void OnTestEnd( TestInfo const &test_info ) override;
+		void OnTestSuiteEnd( TestSuite const &test_suite ) override;
+
+		// Forwards the recorded events to the given listener and forgets them.
+		void ReplayAndClear( TestEventListener *listener );
+
+	private:
+		::testing::internal::Mutex mutex_;
+		Test_event_recorder recorder_;
+	};
+
+	class Work_queue {
+	public:
+		void Push( Work_unit const &unit );
+
+		// The owning worker takes the oldest unit ...
+		bool PopFront( Work_unit *unit );
+
+		// ... while thieves take the newest one, so they rarely contend with the owner.
+		bool StealBack( Work_unit *unit );
+
+	private:
+		::testing::internal::Mutex mutex_;
+		std::deque< Work_unit > units_;
+	};
+
+	void WorkerLoop( size_t worker_index );
+	bool TakeUnit( size_t worker_index, Work_unit *unit );
+	void RunUnit( Work_unit const &unit, Test_execution_context *context );
+	void PublishSplitSuite( Split_suite *split_suite );
+	void Publish( size_t publication );
+	void Deliver( Publication const &publication );
+
+	UnitTestImpl *const impl_;
+	size_t const jobs_;
+	bool const in_run_order_;
+
+	std::vector< Work_unit > scheduled_units_;
+	std::vector< std::unique_ptr< Split_suite > > split_suites_;
+	std::vector< std::unique_ptr< Work_queue > > queues_;
+
+	// In the order of scheduling.
+	std::vector< Publication > publications_;
+
+	// Serializes delivery of recorded events to the listeners.
+	::testing::internal::Mutex event_mutex_;
+
+	// In run order, the first publication not delivered yet; guarded by event_mutex_.
+	size_t next_publication_;
+
+	// Collects events raised by threads that are not workers, e.g. threads
+	// spawned by a test.  Such events are delivered once the pool is done.
+	Orphan_event_sink orphan_events_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Parallel_test_runner );
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,99 @@
+#include "Report_file_buffer.h"
+
+
+#include <chrono>
+#include <cstring>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+namespace {
+
+
+size_t const kBufferSize = 64 * 1024;
+
+int64_t NowInNanos() {
+	return ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( ::std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+} // namespace
+
+
+Report_file_buffer::Report_file_buffer( FILE *const file, int const flush_interval_millis )
+	:
+		file_( file ),
+		buffer_( kBufferSize ),
+		flush_interval_nanos_( static_cast< int64_t >( flush_interval_millis ) * 1000000 ),
+		last_write_nanos_( NowInNanos() )
+{
+	setvbuf( file_, nullptr, _IONBF, 0 );
+	setp( buffer_.data(), buffer_.data() + buffer_.size() );
+}
+
+Report_file_buffer::~Report_file_buffer() {
+	WriteBuffer();
+	fclose( file_ );
+}
+
+void Report_file_buffer::FlushIfDue() {
+	if ( pptr() != pbase() && NowInNanos() - last_write_nanos_ >= flush_interval_nanos_ ) {
+		sync();
+	}
+}
+
+Report_file_buffer::int_type Report_file_buffer::overflow( int_type const character ) {
+	if ( !WriteBuffer() ) return traits_type::eof();
+	if ( traits_type::eq_int_type( character, traits_type::eof() ) ) return traits_type::not_eof( character );
+
+	*pptr() = traits_type::to_char_type( character );
+	pbump( 1 );
+	return character;
+}
+
+::std::streamsize Report_file_buffer::xsputn( char const *const data, ::std::streamsize const size ) {
+	if ( size <= epptr() - pptr() ) {
+		memcpy( pptr(), data, static_cast< size_t >( size ) );
+		pbump( static_cast< int >( size ) );
+		return size;
+	}
+
+	if ( !WriteBuffer() ) return 0;
+
+	// What doesn't fit in the buffer skips it.
+	if ( static_cast< size_t >( size ) >= buffer_.size() ) {
+		return static_cast< ::std::streamsize >( fwrite( data, 1, static_cast< size_t >( size ), file_ ) );
+	}
+
+	memcpy( pptr(), data, static_cast< size_t >( size ) );
+	pbump( static_cast< int >( size ) );
+	return size;
+}
+
+int Report_file_buffer::sync() {
+	return WriteBuffer() && fflush( file_ ) == 0 ? 0 : -1;
+}
+
+bool Report_file_buffer::WriteBuffer() {
+	size_t const size = static_cast< size_t >( pptr() - pbase() );
+	bool const is_written = size == 0 || fwrite( pbase(), 1, size, file_ ) == size;
+
+	last_write_nanos_ = NowInNanos();
+
+	setp( buffer_.data(), buffer_.data() + buffer_.size() );
+	return is_written;
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Report_file_buffer.hxx"
+
+
+#include "gtest-port.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <streambuf>
+#include <vector>
+
+
+#include "cutf.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// A stream buffer that writes a report file through one fixed-size buffer,
+// so that a report can be streamed to its file as it is produced instead of
+// being assembled in memory first.  The file's own buffering is turned off;
+// sync() (e.g. ::std::ostream::flush()) hands everything written so far to
+// the operating system, and FlushIfDue() does so when nothing has been
+// handed over for a while.
+class JMSD_CUTF_SHARED_INTERFACE Report_file_buffer :
+	public ::std::streambuf
+{
+
+public:
+	// The interval FlushIfDue() flushes at by default.
+	static int const kDefaultFlushIntervalMillis = 1000;
+
+	// Takes the ownership of the file, which is closed on destruction.
+	explicit Report_file_buffer( FILE *file, int flush_interval_millis = kDefaultFlushIntervalMillis );
+	~Report_file_buffer() override;
+
+	// Flushes the buffer if it holds anything and has last been written out
+	// at least the flush interval ago, so that a crash loses little of the
+	// report without every small piece of it costing a write.
+	void FlushIfDue();
+
+protected:
+	int_type overflow( int_type character ) override;
+	::std::streamsize xsputn( char const *data, ::std::streamsize size ) override;
+	int sync() override;
+
+private:
+	// Writes the buffered characters to the file and empties the buffer.
+	bool WriteBuffer();
+
+	FILE *const file_;
+	::std::vector< char > buffer_;
+
+	int64_t const flush_interval_nanos_;
+
+	// When the buffer was last written out.
+	int64_t last_write_nanos_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Report_file_buffer );
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,373 @@
+#include "Shard_planner.h"
+
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <queue>
+#include <utility>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+namespace {
+
+
+// Every test costs at least this much (in seconds), so that tests recorded
+// as taking no time are still spread over the shards.
+double const kNominalTestCost = 0.0001;
+
+// One test as recorded in a report.
+struct Report_entry {
+	std::string test_suite_name;
+	std::string test_name;
+	std::string status;
+	std::string time;
+	std::string time_ns;
+};
+
+// Appends the UTF-8 encoding of the given code point.
+void AppendUtf8( uint32_t const code_point, std::string *const output ) {
+	if ( code_point < 0x80 ) {
+		output->push_back( static_cast< char >( code_point ) );
+	} else if ( code_point < 0x800 ) {
+		output->push_back( static_cast< char >( 0xC0 | ( code_point >> 6 ) ) );
+		output->push_back( static_cast< char >( 0x80 | ( code_point & 0x3F ) ) );
+	} else {
+		output->push_back( static_cast< char >( 0xE0 | ( code_point >> 12 ) ) );
+		output->push_back( static_cast< char >( 0x80 | ( ( code_point >> 6 ) & 0x3F ) ) );
+		output->push_back( static_cast< char >( 0x80 | ( code_point & 0x3F ) ) );
+	}
+}
+
+// Undoes XmlUnitTestResultPrinter::EscapeXmlAttribute().
+std::string UnescapeXml( std::string const &value ) {
+	std::string result;
+	result.reserve( value.size() );
+
+	for ( size_t i = 0; i < value.size(); ++i ) {
+		if ( value[ i ] != '&' ) {
+			result.push_back( value[ i ] );
+			continue;
+		}
+
+		size_t const end = value.find( ';', i );
+		if ( end == std::string::npos ) {
+			result.push_back( value[ i ] );
+			continue;
+		}
+
+		std::string const entity = value.substr( i + 1, end - i - 1 );
+		if ( entity == "lt" ) result.push_back( '<' );
+		else if ( entity == "gt" ) result.push_back( '>' );
+		else if ( entity == "amp" ) result.push_back( '&' );
+		else if ( entity == "apos" ) result.push_back( '\'' );
+		else if ( entity == "quot" ) result.push_back( '"' );
+		else if ( entity.size() > 1 && entity[ 0 ] == '#' ) {
+			bool const is_hex = entity[ 1 ] == 'x' || entity[ 1 ] == 'X';
+			AppendUtf8( static_cast< uint32_t >( strtoul( entity.c_str() + ( is_hex ? 2 : 1 ), nullptr, is_hex ? 16 : 10 ) ), &result );
+		} else {
+			result.append( value, i, end - i + 1 );
+		}
+
+		i = end;
+	}
+
+	return result;
+}
+
+// Collects the <testcase> elements of an XML report.
+bool ReadXmlReport( std::string const &content, std::vector< Report_entry > *const entries ) {
+	static char const kTestcaseTag[] = "<testcase";
+
+	if ( content.find( "<testsuites" ) == std::string::npos ) return false;
+
+	size_t position = 0;
+	while ( ( position = content.find( kTestcaseTag, position ) ) != std::string::npos ) {
+		position += sizeof( kTestcaseTag ) - 1;
+		std::map< std::string, std::string > attributes;
+
+		for ( ;; ) {
+			while ( position < content.size() && isspace( static_cast< unsigned char >( content[ position ] ) ) ) ++position;
+			if ( position >= content.size() || content[ position ] == '>' || content[ position ] == '/' ) break;
+
+			size_t const equals = content.find( '=', position );
+			if ( equals == std::string::npos || equals + 1 >= content.size() ) return false;
+
+			char const quote = content[ equals + 1 ];
+			size_t const value_end = content.find( quote, equals + 2 );
+			if ( ( quote != '"' && quote != '\'' ) || value_end == std::string::npos ) return false;
+
+			attributes[ content.substr( position, equals - position ) ] = UnescapeXml( content.substr( equals + 2, value_end - equals - 2 ) );
+			position = value_end + 1;
+		}
+
+		Report_entry const entry = { attributes[ "classname" ], attributes[ "name" ], attributes[ "status" ], attributes[ "time" ], attributes[ "time_ns" ] };
+		entries->push_back( entry );
+	}
+
+	return true;
+}
+
+// A minimal JSON reader that collects every object with "classname",
+// "name" and "time" members, which is how JsonUnitTestResultPrinter
+// writes a test.
+class Json_report_reader {
+
+public:
+	Json_report_reader( std::string const &content, std::vector< Report_entry > *const entries )
+		:
+			content_( content ),
+			position_( 0 ),
+			entries_( entries )
+	{}
+
+	bool Read() {
+		SkipSpace();
+		if ( position_ >= content_.size() || content_[ position_ ] != '{' ) return false;
+		if ( !ReadValue( nullptr ) ) return false;
+
+		SkipSpace();
+		return position_ == content_.size();
+	}
+
+private:
+	void SkipSpace() {
+		while ( position_ < content_.size() && isspace( static_cast< unsigned char >( content_[ position_ ] ) ) ) ++position_;
+	}
+
+	bool Expect( char const expected ) {
+		SkipSpace();
+		if ( position_ >= content_.size() || content_[ position_ ] != expected ) return false;
+
+		++position_;
+		return true;
+	}
+
+	// Reads any value; stores it in string_value when it is a string.
+	bool ReadValue( std::string *const string_value ) {
+		SkipSpace();
+		if ( position_ >= content_.size() ) return false;
+
+		switch ( content_[ position_ ] ) {
+			case '{': return ReadObject();
+			case '[': return ReadArray();
+			case '"': return ReadString( string_value );
+			default: return ReadScalar();
+		}
+	}
+
+	bool ReadObject() {
+		std::map< std::string, std::string > members;
+		++position_;
+
+		SkipSpace();
+		if ( position_ < content_.size() && content_[ position_ ] == '}' ) {
+			++position_;
+			return true;
+		}
+
+		for ( ;; ) {
+			std::string key;
+			std::string value;
+			SkipSpace();
+			if ( !ReadString( &key ) || !Expect( ':' ) || !ReadValue( &value ) ) return false;
+
+			members[ key ] = value;
+
+			SkipSpace();
+			if ( position_ >= content_.size() ) return false;
+			if ( content_[ position_ ] == '}' ) break;
+			if ( content_[ position_ ] != ',' ) return false;
+			++position_;
+		}
+
+		++position_;
+
+		if ( members.count( "classname" ) != 0 && members.count( "name" ) != 0 && members.count( "time" ) != 0 ) {
+			Report_entry const entry = { members[ "classname" ], members[ "name" ], members[ "status" ], members[ "time" ], members[ "time_ns" ] };
+			entries_->push_back( entry );
+		}
+
+		return true;
+	}
+
+	bool ReadArray() {
+		++position_;
+
+		SkipSpace();
+		if ( position_ < content_.size() && content_[ position_ ] == ']' ) {
+			++position_;
+			return true;
+		}
+
+		for ( ;; ) {
+			if ( !ReadValue( nullptr ) ) return false;
+
+			SkipSpace();
+			if ( position_ >= content_.size() ) return false;
+			if ( content_[ position_ ] == ']' ) break;
+			if ( content_[ position_ ] != ',' ) return false;
+			++position_;
+		}
+
+		++position_;
+		return true;
+	}
+
+	bool ReadString( std::string *const value ) {
+		if ( position_ >= content_.size() || content_[ position_ ] != '"' ) return false;
+
+		std::string result;
+		for ( ++position_; position_ < content_.size(); ++position_ ) {
+			char const ch = content_[ position_ ];
+
+			if ( ch == '"' ) {
+				++position_;
+				if ( value != nullptr ) value->swap( result );
+				return true;
+			}
+
+			if ( ch != '\\' ) {
+				result.push_back( ch );
+				continue;
+			}
+
+			if ( ++position_ >= content_.size() ) return false;
+
+			switch ( content_[ position_ ] ) {
+				case 'b': result.push_back( '\b' ); break;
+				case 'f': result.push_back( '\f' ); break;
+				case 'n': result.push_back( '\n' ); break;
+				case 'r': result.push_back( '\r' ); break;
+				case 't': result.push_back( '\t' ); break;
+				case 'u':
+					if ( position_ + 4 >= content_.size() ) return false;
+					AppendUtf8( static_cast< uint32_t >( strtoul( content_.substr( position_ + 1, 4 ).c_str(), nullptr, 16 ) ), &result );
+					position_ += 4;
+					break;
+				default: result.push_back( content_[ position_ ] ); break;
+			}
+		}
+
+		return false;
+	}
+
+	// Numbers, true, false and null.
+	bool ReadScalar() {
+		size_t const start = position_;
+		while ( position_ < content_.size() && ( isalnum( static_cast< unsigned char >( content_[ position_ ] ) ) || strchr( "+-.", content_[ position_ ] ) != nullptr ) ) ++position_;
+
+		return position_ != start;
+	}
+
+	std::string const &content_;
+	size_t position_;
+	std::vector< Report_entry > *const entries_;
+};
+
+
+} // namespace
+
+
+Shard_planner::Shard_planner()
+{}
+
+bool Shard_planner::LoadReport( std::string const &path ) {
+	FILE *const file = ::testing::internal::posix::FOpen( path.c_str(), "r" );
+	if ( file == nullptr ) return false;
+
+	std::string const content = ::testing::internal::ReadEntireFile( file );
+	::testing::internal::posix::FClose( file );
+
+	return LoadReportContent( content );
+}
+
+bool Shard_planner::LoadReportContent( std::string const &content ) {
+	std::vector< Report_entry > entries;
+
+	size_t const first = content.find_first_not_of( " \t\r\n" );
+	if ( first == std::string::npos ) return false;
+
+	bool const is_read =
+		content[ first ] == '<' ? ReadXmlReport( content, &entries ) :
+		content[ first ] == '{' ? Json_report_reader( content, &entries ).Read() :
+		false;
+
+	if ( !is_read ) return false;
+
+	for ( Report_entry const &entry : entries ) {
+		// Tests that didn't run (filtered out, disabled, in another shard) say nothing about their cost.
+		if ( !entry.status.empty() && entry.status != "run" && entry.status != "RUN" ) continue;
+
+		// Prefer the nanoseconds of newer reports; otherwise XML gives seconds ("0.25"), JSON a duration ("0.25s").
+		durations_[ entry.test_suite_name + "." + entry.test_name ] = !entry.time_ns.empty() ?
+			strtod( entry.time_ns.c_str(), nullptr ) * 1e-9 :
+			strtod( entry.time.c_str(), nullptr );
+	}
+
+	return true;
+}
+
+size_t Shard_planner::known_test_count() const {
+	return durations_.size();
+}
+
+std::vector< int > Shard_planner::Plan( std::vector< std::string > const &test_full_names, int const total_shards ) const {
+	double total_known_duration = 0;
+	for ( auto const &duration : durations_ ) {
+		total_known_duration += duration.second;
+	}
+
+	double const average_duration = durations_.empty() ? 0 : total_known_duration / static_cast< double >( durations_.size() );
+
+	std::vector< double > costs( test_full_names.size() );
+	std::vector< size_t > order( test_full_names.size() );
+
+	for ( size_t i = 0; i < test_full_names.size(); ++i ) {
+		auto const found = durations_.find( test_full_names[ i ] );
+		costs[ i ] = ( found != durations_.end() ? found->second : average_duration ) + kNominalTestCost;
+		order[ i ] = i;
+	}
+
+	// Most expensive first; equal costs keep the run order so that every shard computes the same plan.
+	std::stable_sort( order.begin(), order.end(), [ &costs ]( size_t const left, size_t const right ) { return costs[ left ] > costs[ right ]; } );
+
+	// Least loaded shard on top; equal loads go to the lower shard index.
+	typedef std::pair< double, int > Shard_load;
+	std::priority_queue< Shard_load, std::vector< Shard_load >, std::greater< Shard_load > > shards;
+	for ( int shard_index = 0; shard_index < total_shards; ++shard_index ) {
+		shards.push( Shard_load( 0, shard_index ) );
+	}
+
+	std::vector< int > plan( test_full_names.size(), 0 );
+	for ( size_t const test_index : order ) {
+		Shard_load least_loaded = shards.top();
+		shards.pop();
+
+		plan[ test_index ] = least_loaded.second;
+		least_loaded.first += costs[ test_index ];
+		shards.push( least_loaded );
+	}
+
+	return plan;
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Shard_planner.hxx"
+
+
+#include "gtest-port.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+#include "cutf.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// Assigns tests to shards so that the shards take about the same time,
+// judging by the test durations recorded in the XML or JSON report of an
+// earlier run (the --cutf_shard_durations flag).
+//
+// Round-robin sharding balances the number of tests per shard, which is
+// far from balancing the time when a few tests dominate the run.  The
+// planner instead hands the most expensive remaining test to the least
+// loaded shard (longest processing time first), which keeps the slowest
+// shard within 4/3 of the optimum.
+//
+// Every shard process computes the whole plan on its own and keeps its
+// part, so all shards must be given the same reports and the same filter.
+class JMSD_CUTF_SHARED_INTERFACE Shard_planner {
+
+public:
+	Shard_planner();
+
+	// Adds the durations of the tests that ran according to the XML or JSON
+	// report in the given file.  Returns false if the file can't be read or
+	// doesn't look like a report.
+	bool LoadReport( std::string const &path );
+
+	// Same as LoadReport(), for a report that is already in memory.
+	bool LoadReportContent( std::string const &content );
+
+	// Returns the number of tests whose duration is known.
+	size_t known_test_count() const;
+
+	// Given the full names ("TestSuite.Test") of the tests to shard in run
+	// order, returns the shard, in [0, total_shards), each one runs on.
+	// Tests missing from the reports are assumed to take the average time.
+	std::vector< int > Plan( std::vector< std::string > const &test_full_names, int total_shards ) const;
+
+private:
+	// Durations in seconds, keyed by the full test name.
+	std::unordered_map< std::string, double > durations_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Shard_planner );
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -6,6 +6,9 @@
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <climits>
+#include <errno.h>
 #endif
 
 
@@ -44,6 +47,60 @@ void SocketWriter::Send(const std::string& message) {
 	}
 }
 
+// Sends the strings with as few writev() calls as they fit in.
+void SocketWriter::SendBatch(const std::string* messages, size_t count) {
+	GTEST_CHECK_(sockfd_ != -1) << "SendBatch() can be called only when there is a connection.";
+
+#ifdef IOV_MAX
+	static size_t const kMaxIovecs = IOV_MAX < 64 ? IOV_MAX : 64;
+#else
+	static size_t const kMaxIovecs = 16;
+#endif
+
+	iovec iovecs[ kMaxIovecs ];
+
+	while ( count > 0 ) {
+		size_t const iovec_count = count < kMaxIovecs ? count : kMaxIovecs;
+
+		for ( size_t i = 0; i < iovec_count; ++i ) {
+			iovecs[ i ].iov_base = const_cast< char * >( messages[ i ].data() );
+			iovecs[ i ].iov_len = messages[ i ].length();
+		}
+
+		// writev() may stop short of the end; skip what it has written and
+		// write the rest.
+		iovec *remaining = iovecs;
+		size_t remaining_count = iovec_count;
+
+		while ( remaining_count > 0 ) {
+			ssize_t const written = writev( sockfd_, remaining, static_cast< int >( remaining_count ) );
+
+			if ( written < 0 ) {
+				if ( errno == EINTR ) continue;
+
+				GTEST_LOG_(WARNING) << "stream_result_to: failed to stream to " << host_name_ << ":" << port_num_;
+				return;
+			}
+
+			size_t left = static_cast< size_t >( written );
+
+			while ( remaining_count > 0 && left >= remaining->iov_len ) {
+				left -= remaining->iov_len;
+				++remaining;
+				--remaining_count;
+			}
+
+			if ( remaining_count > 0 ) {
+				remaining->iov_base = static_cast< char * >( remaining->iov_base ) + left;
+				remaining->iov_len -= left;
+			}
+		}
+
+		messages += iovec_count;
+		count -= iovec_count;
+	}
+}
+
 // Creates a client socket and connects to the server.
 void SocketWriter::MakeConnection() {
 	GTEST_CHECK_(sockfd_ == -1) << "MakeConnection() can't be called when there is already a connection.";
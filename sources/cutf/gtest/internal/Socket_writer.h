@@ -27,6 +27,9 @@ public:
 	// Sends a string to the socket.
 	void Send(const std::string& message) override;
 
+	// Sends the strings with as few writev() calls as they fit in.
+	void SendBatch(const std::string* messages, size_t count) override;
+
 private:
 	// Creates a client socket and connects to the server.
 	void MakeConnection();
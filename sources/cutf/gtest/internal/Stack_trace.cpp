@@ -0,0 +1,216 @@
+#include "Stack_trace.h"
+
+
+#include "gtest/gtest-flags.h"
+#include "gtest/gtest-internal-inl.h"
+
+#include <cstdio>
+#include <utility>
+
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <unwind.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
+namespace {
+
+thread_local void const *leaving_gtest_frame_ = nullptr;
+
+struct Unwinding {
+	::std::vector< void * > *frames;
+	int skip_count;
+	int max_depth;
+	void const *leaving_gtest_frame;
+	bool is_elided;
+};
+
+_Unwind_Reason_Code AddFrame( _Unwind_Context *const context, void *const argument ) {
+	Unwinding &unwinding = *static_cast< Unwinding * >( argument );
+
+	if ( unwinding.skip_count > 0 ) {
+		--unwinding.skip_count;
+		return _URC_NO_REASON;
+	}
+
+	if ( unwinding.leaving_gtest_frame != nullptr &&
+		reinterpret_cast< void const * >( _Unwind_GetCFA( context ) ) >= unwinding.leaving_gtest_frame )
+	{
+		unwinding.is_elided = true;
+		return _URC_END_OF_STACK;
+	}
+
+	void *const pc = reinterpret_cast< void * >( _Unwind_GetIP( context ) );
+
+	if ( pc == nullptr ) {
+		return _URC_END_OF_STACK;
+	}
+
+	unwinding.frames->push_back( pc );
+	return static_cast< int >( unwinding.frames->size() ) < unwinding.max_depth ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+
+// Guards symbols().
+::std::mutex &symbols_mutex() {
+	static ::std::mutex *const mutex = new ::std::mutex;
+	return *mutex;
+}
+
+// The symbols already looked up, by program counter.
+::std::unordered_map< void *, ::std::string > &symbols() {
+	static ::std::unordered_map< void *, ::std::string > *const symbols = new ::std::unordered_map< void *, ::std::string >;
+	return *symbols;
+}
+
+// Looks up the function a program counter is in, demangled, or the module
+// and the offset in it when the function isn't exported.  Each program
+// counter is only looked up once.
+::std::string Symbolize( void *const pc ) {
+	::std::lock_guard< ::std::mutex > const lock( symbols_mutex() );
+	auto const found = symbols().find( pc );
+
+	if ( found != symbols().end() ) {
+		return found->second;
+	}
+
+	::std::string symbol = "(unknown)";
+	Dl_info info;
+
+	if ( dladdr( pc, &info ) != 0 ) {
+		if ( info.dli_sname != nullptr ) {
+			int status = -1;
+			char *const demangled = abi::__cxa_demangle( info.dli_sname, nullptr, nullptr, &status );
+			symbol = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+			free( demangled );
+		} else if ( info.dli_fname != nullptr ) {
+			char offset[ 32 ];
+			snprintf( offset, sizeof( offset ), "+0x%zx", static_cast< size_t >( static_cast< char * >( pc ) - static_cast< char * >( info.dli_fbase ) ) );
+			symbol = ::std::string( info.dli_fname ) + offset;
+		}
+	}
+
+	return symbols().emplace( pc, ::std::move( symbol ) ).first->second;
+}
+
+} // namespace
+
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
+
+Stack_trace::Stack_trace()
+	:
+		is_elided_( false )
+{}
+
+Stack_trace::Stack_trace( ::std::string text )
+	:
+		text_( ::std::move( text ) ),
+		is_elided_( false )
+{}
+
+// static
+Stack_trace Stack_trace::Capture( int const max_depth, int const skip_count ) {
+	Stack_trace trace;
+
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+	if ( max_depth <= 0 ) {
+		return trace;
+	}
+
+	trace.frames_.reserve( static_cast< size_t >( max_depth ) );
+
+	Unwinding unwinding = {
+		&trace.frames_,
+		skip_count + 1, // this function
+		max_depth,
+		::testing:: GTEST_FLAG( show_internal_stack_frames ) ? nullptr : leaving_gtest_frame_,
+		false };
+
+	_Unwind_Backtrace( &AddFrame, &unwinding );
+	trace.is_elided_ = unwinding.is_elided;
+#else
+	static_cast< void >( max_depth );
+	static_cast< void >( skip_count );
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
+	return trace;
+}
+
+// static
+void Stack_trace::set_leaving_gtest_frame( void const *const canonical_frame_address ) {
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+	leaving_gtest_frame_ = canonical_frame_address;
+#else
+	static_cast< void >( canonical_frame_address );
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+}
+
+// static
+void Stack_trace::mark_leaving_gtest_in_caller() {
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+	// As with UponLeavingGTest(), the user code is called from the same frame
+	// as this function and shares its canonical frame address.
+	leaving_gtest_frame_ = __builtin_dwarf_cfa();
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+}
+
+bool Stack_trace::empty() const {
+	return frames_.empty() && text_.empty();
+}
+
+::std::vector< void * > const &Stack_trace::frames() const {
+	return frames_;
+}
+
+::std::string Stack_trace::ToString() const {
+	if ( frames_.empty() ) {
+		return text_;
+	}
+
+	::std::string result;
+
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+	for ( void *const pc : frames_ ) {
+		char address[ 32 ];
+		snprintf( address, sizeof( address ), "  %p: ", pc );
+		result += address;
+		result += Symbolize( pc );
+		result += "\n";
+	}
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
+	if ( is_elided_ ) {
+		result += ::testing::internal::OsStackTraceGetterInterface::kElidedFramesMarker;
+		result += "\n";
+	}
+
+	return result;
+}
+
+// static
+size_t Stack_trace::cached_symbol_count() {
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+	::std::lock_guard< ::std::mutex > const lock( symbols_mutex() );
+	return symbols().size();
+#else
+	return 0;
+#endif // #if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Stack_trace.hxx"
+
+
+#include "gtest-port.h"
+
+#include "cutf.h"
+
+#include <string>
+#include <vector>
+
+
+// Failures capture their stacks with the unwinder of the C++ runtime and
+// symbolize them with dladdr(3).  Builds with absl keep using absl.
+#if GTEST_OS_LINUX && ( defined( __GNUC__ ) || defined( __clang__ ) ) && !GTEST_HAS_ABSL
+# define JMSD_CUTF_HAS_NATIVE_STACK_TRACE_ 1
+#else
+# define JMSD_CUTF_HAS_NATIVE_STACK_TRACE_ 0
+#endif
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// The stack of a failed assertion.
+//
+// Capturing only records the program counters, which is cheap; the frames
+// are looked up in the symbol tables when a printer reports the failure
+// (see TestPartResult::message_with_stack_trace()), and the symbols of the
+// addresses already seen come from a cache shared by all the traces.
+// Executables that don't export their symbols show the module and the
+// offset in it instead of the function.  A trace can also carry the text given by a custom
+// OsStackTraceGetterInterface instead.
+class JMSD_CUTF_SHARED_INTERFACE Stack_trace {
+
+public:
+	Stack_trace();
+	explicit Stack_trace( ::std::string text );
+
+	// Captures at most max_depth frames of the calling thread's stack after
+	// skipping skip_count frames besides this function.  Unless
+	// --gtest_show_internal_stack_frames is given, stops at the frame that
+	// set_leaving_gtest_frame() marked, which belongs to Google Test.
+	static Stack_trace Capture( int max_depth, int skip_count ) GTEST_NO_INLINE_;
+
+	// Marks where the user code called on this thread starts: the frames
+	// whose canonical frame address is not below the given one are Google
+	// Test's.  Just stores the address, so it costs nothing to do it before
+	// every call of user code.
+	static void set_leaving_gtest_frame( void const *canonical_frame_address );
+
+	// Marks the calling frame as the last one of Google Test before the user
+	// code it calls next.
+	static void mark_leaving_gtest_in_caller() GTEST_NO_INLINE_;
+
+	bool empty() const;
+
+	// The captured program counters, innermost first.
+	::std::vector< void * > const &frames() const;
+
+	// One line per frame, as CurrentStackTrace() returns it.
+	::std::string ToString() const;
+
+	// The number of addresses symbolized so far, each of which ToString()
+	// looks up only once.
+	static size_t cached_symbol_count();
+
+private:
+	::std::vector< void * > frames_;
+	::std::string text_;
+
+	// Whether the frames of Google Test under the user code were left out.
+	bool is_elided_;
+
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
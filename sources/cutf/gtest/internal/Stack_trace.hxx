@@ -0,0 +1,14 @@
+#pragma once
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+class Stack_trace;
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
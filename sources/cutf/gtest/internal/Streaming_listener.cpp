@@ -114,7 +114,7 @@ void StreamingListener::OnTestPartResult(const ::testing::TestPartResult& test_p
 
   SendLn("event=TestPartResult&file=" + UrlEncode(file_name) +
 		 "&line=" + function_Streamable_to_string::StreamableToString(test_part_result.line_number()) +
-		 "&message=" + UrlEncode(test_part_result.message()));
+		 "&message=" + UrlEncode(test_part_result.message_with_stack_trace().c_str()));
 }
 
 // Sends the given message and a newline to the socket.
@@ -0,0 +1,83 @@
+#include "Test_event_recorder.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+Test_event_recorder::Test_event_recorder()
+{}
+
+void Test_event_recorder::OnTestSuiteStart( TestSuite const &test_suite ) {
+	Record( kTestSuiteStart, &test_suite, nullptr );
+}
+
+void Test_event_recorder::OnTestStart( TestInfo const &test_info ) {
+	Record( kTestStart, nullptr, &test_info );
+}
+
+void Test_event_recorder::OnTestPartResult( ::testing::TestPartResult const &test_part_result ) {
+	Record( kTestPartResult, nullptr, nullptr );
+	events_.back().test_part_result_index = test_part_results_.size();
+	test_part_results_.push_back( test_part_result );
+}
+
+void Test_event_recorder::OnTestEnd( TestInfo const &test_info ) {
+	Record( kTestEnd, nullptr, &test_info );
+}
+
+void Test_event_recorder::OnTestSuiteEnd( TestSuite const &test_suite ) {
+	Record( kTestSuiteEnd, &test_suite, nullptr );
+}
+
+void Test_event_recorder::Replay( TestEventListener *const listener ) const {
+	for ( Recorded_event const &event : events_ ) {
+		switch ( event.kind ) {
+			case kTestSuiteStart:
+				listener->OnTestSuiteStart( *event.test_suite );
+				break;
+
+			case kTestStart:
+				listener->OnTestStart( *event.test_info );
+				break;
+
+			case kTestPartResult:
+				listener->OnTestPartResult( test_part_results_[ event.test_part_result_index ] );
+				break;
+
+			case kTestEnd:
+				listener->OnTestEnd( *event.test_info );
+				break;
+
+			case kTestSuiteEnd:
+				listener->OnTestSuiteEnd( *event.test_suite );
+				break;
+		}
+	}
+}
+
+bool Test_event_recorder::empty() const {
+	return events_.empty();
+}
+
+void Test_event_recorder::Clear() {
+	events_.clear();
+	test_part_results_.clear();
+}
+
+void Test_event_recorder::Record( Event_kind const kind, TestSuite const *const test_suite, TestInfo const *const test_info ) {
+	Recorded_event const event = { kind, test_suite, test_info, 0 };
+	events_.push_back( event );
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
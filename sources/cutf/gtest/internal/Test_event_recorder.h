@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Test_event_recorder.hxx"
+
+
+#include "gtest/Empty_test_event_listener.h"
+#include "gtest/gtest-test-part.h"
+
+#include <vector>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// Buffers the test suite, test and test part events raised while a test runs
+// so that they can be forwarded to the real listeners later as one unbroken
+// block.  The parallel test runner gives one recorder to every unit of work,
+// which keeps printers from seeing events of concurrently running tests
+// interleaved.
+//
+// A recorder is not synchronized; it must only be fed from one thread at a
+// time.
+class Test_event_recorder :
+	public EmptyTestEventListener
+{
+public:
+	Test_event_recorder();
+
+	void OnTestSuiteStart( TestSuite const &test_suite ) override;
+	void OnTestStart( TestInfo const &test_info ) override;
+	void OnTestPartResult( ::testing::TestPartResult const &test_part_result ) override;
+	void OnTestEnd( TestInfo const &test_info ) override;
+	void OnTestSuiteEnd( TestSuite const &test_suite ) override;
+
+	// Forwards the recorded events, in the order they were raised, to the given listener.
+	void Replay( TestEventListener *listener ) const;
+
+	// Returns true if and only if nothing has been recorded since construction or the last Clear().
+	bool empty() const;
+
+	// Forgets all recorded events.
+	void Clear();
+
+private:
+	enum Event_kind {
+		kTestSuiteStart,
+		kTestStart,
+		kTestPartResult,
+		kTestEnd,
+		kTestSuiteEnd
+	};
+
+	struct Recorded_event {
+		Event_kind kind;
+		TestSuite const *test_suite;
+		TestInfo const *test_info;
+		size_t test_part_result_index;
+	};
+
+	void Record( Event_kind kind, TestSuite const *test_suite, TestInfo const *test_info );
+
+	std::vector< Recorded_event > events_;
+	std::vector< ::testing::TestPartResult > test_part_results_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Test_event_recorder );
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
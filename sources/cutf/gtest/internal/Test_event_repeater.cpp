@@ -4,6 +4,8 @@
 #include "function_Stl_utilities.hin"
 #include "function_Delete.hin"
 
+#include <algorithm>
+
 
 namespace jmsd {
 namespace cutf {
@@ -16,12 +18,26 @@ TestEventRepeater::~TestEventRepeater() {
 
 void TestEventRepeater::Append(TestEventListener *listener) {
   listeners_.push_back(listener);
+
+  const unsigned interests = listener->event_interests();
+  for (size_t i = 0; i < TestEventListener::kEventCount; ++i) {
+	if ((interests & (1u << i)) != 0) {
+	  dispatch_lists_[i].push_back(listener);
+	}
+  }
 }
 
 TestEventListener* TestEventRepeater::Release(TestEventListener *listener) {
   for (size_t i = 0; i < listeners_.size(); ++i) {
 	if (listeners_[i] == listener) {
 	  listeners_.erase(listeners_.begin() + static_cast<int>(i));
+
+	  for (std::vector<TestEventListener*>& dispatch_list : dispatch_lists_) {
+		dispatch_list.erase(
+			std::remove(dispatch_list.begin(), dispatch_list.end(), listener),
+			dispatch_list.end());
+	  }
+
 	  return listener;
 	}
   }
@@ -32,8 +48,10 @@ TestEventListener* TestEventRepeater::Release(TestEventListener *listener) {
 void TestEventRepeater::OnTestIterationStart(const UnitTest& unit_test,
 											 int iteration) {
   if (forwarding_enabled_) {
-	for (size_t i = 0; i < listeners_.size(); i++) {
-	  listeners_[i]->OnTestIterationStart(unit_test, iteration);
+	const std::vector<TestEventListener*>& listeners =
+		dispatch_lists_[IndexOf(TestEventListener::kOnTestIterationStart)];
+	for (size_t i = 0; i < listeners.size(); i++) {
+	  listeners[i]->OnTestIterationStart(unit_test, iteration);
 	}
   }
 }
@@ -41,52 +59,64 @@ void TestEventRepeater::OnTestIterationStart(const UnitTest& unit_test,
 void TestEventRepeater::OnTestIterationEnd(const UnitTest& unit_test,
 										   int iteration) {
   if (forwarding_enabled_) {
-	for (size_t i = listeners_.size(); i > 0; i--) {
-	  listeners_[i - 1]->OnTestIterationEnd(unit_test, iteration);
+	const std::vector<TestEventListener*>& listeners =
+		dispatch_lists_[IndexOf(TestEventListener::kOnTestIterationEnd)];
+	for (size_t i = listeners.size(); i > 0; i--) {
+	  listeners[i - 1]->OnTestIterationEnd(unit_test, iteration);
 	}
   }
 }
 
 // Since most methods are very similar, use macros to reduce boilerplate.
-// This defines a member that forwards the call to all listeners.
-#define GTEST_REPEATER_METHOD_(Name, Type) \
+// This defines a member that forwards the call to all listeners interested
+// in Event.
+#define GTEST_REPEATER_METHOD_(Name, Type, Event) \
 void TestEventRepeater::Name(const Type& parameter) { \
   if (forwarding_enabled_) { \
-	for (size_t i = 0; i < listeners_.size(); i++) { \
-	  listeners_[i]->Name(parameter); \
+	const std::vector<TestEventListener*>& listeners = \
+		dispatch_lists_[IndexOf(TestEventListener::Event)]; \
+	for (size_t i = 0; i < listeners.size(); i++) { \
+	  listeners[i]->Name(parameter); \
 	} \
   } \
 }
-// This defines a member that forwards the call to all listeners in reverse
-// order.
-#define GTEST_REVERSE_REPEATER_METHOD_(Name, Type)      \
-  void TestEventRepeater::Name(const Type& parameter) { \
-	if (forwarding_enabled_) {                          \
-	  for (size_t i = listeners_.size(); i != 0; i--) { \
-		listeners_[i - 1]->Name(parameter);             \
-	  }                                                 \
-	}                                                   \
+// This defines a member that forwards the call to all listeners interested
+// in Event in reverse order.
+#define GTEST_REVERSE_REPEATER_METHOD_(Name, Type, Event)      \
+  void TestEventRepeater::Name(const Type& parameter) {        \
+	if (forwarding_enabled_) {                                 \
+	  const std::vector<TestEventListener*>& listeners =       \
+		  dispatch_lists_[IndexOf(TestEventListener::Event)];  \
+	  for (size_t i = listeners.size(); i != 0; i--) {         \
+		listeners[i - 1]->Name(parameter);                     \
+	  }                                                        \
+	}                                                          \
   }
 
-GTEST_REPEATER_METHOD_(OnTestProgramStart, UnitTest)
-GTEST_REPEATER_METHOD_(OnEnvironmentsSetUpStart, UnitTest)
+GTEST_REPEATER_METHOD_(OnTestProgramStart, UnitTest, kOnTestProgramStart)
+GTEST_REPEATER_METHOD_(OnEnvironmentsSetUpStart, UnitTest,
+					   kOnEnvironmentsSetUpStart)
 //  Legacy API is deprecated but still available
 #ifdef GTEST_KEEP_LEGACY_TEST_CASEAPI_
-GTEST_REPEATER_METHOD_(OnTestCaseStart, TestSuite)
+GTEST_REPEATER_METHOD_(OnTestCaseStart, TestSuite, kOnTestSuiteStart)
 #endif  //  GTEST_REMOVE_LEGACY_TEST_CASEAPI_
-GTEST_REPEATER_METHOD_(OnTestSuiteStart, TestSuite)
-GTEST_REPEATER_METHOD_(OnTestStart, TestInfo)
-GTEST_REPEATER_METHOD_(OnTestPartResult, ::testing::TestPartResult)
-GTEST_REPEATER_METHOD_(OnEnvironmentsTearDownStart, UnitTest)
-GTEST_REVERSE_REPEATER_METHOD_(OnEnvironmentsSetUpEnd, UnitTest)
-GTEST_REVERSE_REPEATER_METHOD_(OnEnvironmentsTearDownEnd, UnitTest)
-GTEST_REVERSE_REPEATER_METHOD_(OnTestEnd, TestInfo)
+GTEST_REPEATER_METHOD_(OnTestSuiteStart, TestSuite, kOnTestSuiteStart)
+GTEST_REPEATER_METHOD_(OnTestStart, TestInfo, kOnTestStart)
+GTEST_REPEATER_METHOD_(OnTestPartResult, ::testing::TestPartResult,
+					   kOnTestPartResult)
+GTEST_REPEATER_METHOD_(OnEnvironmentsTearDownStart, UnitTest,
+					   kOnEnvironmentsTearDownStart)
+GTEST_REVERSE_REPEATER_METHOD_(OnEnvironmentsSetUpEnd, UnitTest,
+							   kOnEnvironmentsSetUpEnd)
+GTEST_REVERSE_REPEATER_METHOD_(OnEnvironmentsTearDownEnd, UnitTest,
+							   kOnEnvironmentsTearDownEnd)
+GTEST_REVERSE_REPEATER_METHOD_(OnTestEnd, TestInfo, kOnTestEnd)
 //  Legacy API is deprecated but still available
 #ifdef GTEST_KEEP_LEGACY_TEST_CASEAPI_
-GTEST_REVERSE_REPEATER_METHOD_(OnTestCaseEnd, TestSuite)
+GTEST_REVERSE_REPEATER_METHOD_(OnTestCaseEnd, TestSuite, kOnTestSuiteEnd)
 #endif  //  GTEST_REMOVE_LEGACY_TEST_CASEAPI_
-GTEST_REVERSE_REPEATER_METHOD_(OnTestSuiteEnd, TestSuite)
-GTEST_REVERSE_REPEATER_METHOD_(OnTestProgramEnd, UnitTest)
+GTEST_REVERSE_REPEATER_METHOD_(OnTestSuiteEnd, TestSuite, kOnTestSuiteEnd)
+GTEST_REVERSE_REPEATER_METHOD_(OnTestProgramEnd, UnitTest, kOnTestProgramEnd)
 
 #undef GTEST_REPEATER_METHOD_
 #undef GTEST_REVERSE_REPEATER_METHOD_
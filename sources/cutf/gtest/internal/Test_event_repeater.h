@@ -12,6 +12,10 @@ namespace internal {
 
 
 // This class forwards events to other event listeners.
+//
+// Each event has its own list of the listeners that asked for it in
+// event_interests(), so that the events most listeners ignore, such as those
+// of every test, only cost a call to each listener that handles them.
 class TestEventRepeater :
 	public TestEventListener
 {
@@ -52,9 +56,17 @@ private:
 	// Controls whether events will be forwarded to listeners_. Set to false in death test child processes.
 	bool forwarding_enabled_;
 
+	// Returns the position of the bit of an event in event_interests().
+	static constexpr size_t IndexOf(unsigned event) {
+		return event == 1u ? 0 : 1 + IndexOf(event >> 1);
+	}
+
 	// The list of listeners that receive events.
 	std::vector<TestEventListener*> listeners_;
 
+	// The listeners interested in each event, in the order of listeners_.
+	std::vector<TestEventListener*> dispatch_lists_[TestEventListener::kEventCount];
+
 	GTEST_DISALLOW_COPY_AND_ASSIGN_(TestEventRepeater);
 };
 
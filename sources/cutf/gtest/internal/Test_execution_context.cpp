@@ -0,0 +1,19 @@
+#include "Test_execution_context.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+Test_execution_context::Test_execution_context()
+	:
+		current_test_suite( nullptr ),
+		current_test_info( nullptr ),
+		event_sink( nullptr )
+{}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Test_execution_context.hxx"
+
+
+#include "gtest/Test_event_listener.hxx"
+#include "gtest/Test_info.hxx"
+#include "gtest/Test_suite.hxx"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// The per-thread view of "what is running right now" used by the parallel
+// test runner.  While a worker thread has a context installed, UnitTestImpl
+// answers current_test_suite(), current_test_info() and current_test_result()
+// from it instead of from its process-wide pointers, and test events raised on
+// that thread go to event_sink rather than straight to the listeners.
+struct Test_execution_context {
+	Test_execution_context();
+
+	TestSuite *current_test_suite;
+	TestInfo *current_test_info;
+	TestEventListener *event_sink;
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
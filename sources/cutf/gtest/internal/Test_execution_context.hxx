@@ -0,0 +1,14 @@
+#pragma once
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+struct Test_execution_context;
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
@@ -0,0 +1,106 @@
+#include "Test_isolation.h"
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+namespace {
+
+
+enum Unit_claim {
+	kNoClaim,
+	kSharedClaim,
+	kExclusiveClaim
+};
+
+// The claim of the unit of work the calling thread runs.  A thread started
+// by a test doesn't inherit it.
+thread_local Unit_claim unit_claim_ = kNoClaim;
+
+
+} // namespace
+
+
+// The instance lives until the process exits.
+// static
+Test_isolation *Test_isolation::GetInstance() {
+	static Test_isolation *const instance = new Test_isolation;
+	return instance;
+}
+
+Test_isolation::Test_isolation()
+	:
+		running_unit_count_( 0 ),
+		isolating_unit_count_( 0 ),
+		is_unit_isolated_( false ),
+		worker_count_( 0 )
+{}
+
+void Test_isolation::Require() {
+	if ( unit_claim_ != kSharedClaim ) return;
+
+	std::unique_lock< std::mutex > lock( mutex_ );
+	--running_unit_count_;
+	++isolating_unit_count_;
+	changed_.notify_all();
+
+	changed_.wait( lock, [ this ]() { return running_unit_count_ == 0 && !is_unit_isolated_; } );
+	--isolating_unit_count_;
+	is_unit_isolated_ = true;
+	unit_claim_ = kExclusiveClaim;
+}
+
+bool Test_isolation::is_isolated() const {
+	return unit_claim_ == kExclusiveClaim;
+}
+
+int Test_isolation::other_worker_count() {
+	std::lock_guard< std::mutex > const lock( mutex_ );
+	return unit_claim_ == kNoClaim ? worker_count_ : worker_count_ - 1;
+}
+
+void Test_isolation::AddWorkers( int const worker_count ) {
+	std::lock_guard< std::mutex > const lock( mutex_ );
+	worker_count_ += worker_count;
+}
+
+// A worker that leaves waits for an isolated unit to end, so it doesn't
+// exit while that unit counts the threads of the process.
+void Test_isolation::LeavePool() {
+	std::unique_lock< std::mutex > lock( mutex_ );
+	changed_.wait( lock, [ this ]() { return !is_unit_isolated_ && isolating_unit_count_ == 0; } );
+	--worker_count_;
+}
+
+void Test_isolation::EnterUnit() {
+	std::unique_lock< std::mutex > lock( mutex_ );
+	changed_.wait( lock, [ this ]() { return !is_unit_isolated_ && isolating_unit_count_ == 0; } );
+	++running_unit_count_;
+	unit_claim_ = kSharedClaim;
+}
+
+void Test_isolation::LeaveUnit() {
+	std::lock_guard< std::mutex > const lock( mutex_ );
+
+	if ( unit_claim_ == kExclusiveClaim ) {
+		is_unit_isolated_ = false;
+	} else {
+		--running_unit_count_;
+	}
+
+	unit_claim_ = kNoClaim;
+	changed_.notify_all();
+}
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Test_isolation.hxx"
+
+
+#include "cutf.h"
+
+#include "gtest-port.h"
+
+#include <condition_variable>
+#include <mutex>
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+// Lets a test that touches process-wide state run alone while the other
+// tests run on the worker threads of a Parallel_test_runner (--cutf_jobs).
+//
+// Process-wide state is anything that two tests running at the same time
+// would trample on: the captured stdout and stderr, the environment, the
+// Google Test flags, the reporter that intercepts the failures of all
+// threads, or a death test child forked off the whole process.
+//
+// A worker holds a shared claim while it runs a unit of work.  Require()
+// trades the claim of the calling worker for an exclusive one: it waits
+// until the units running on the other workers have ended, and no other unit
+// starts before the calling one ends.  The workers that have to wait stay
+// parked until then, so the thread count of the process doesn't change while
+// a unit runs alone.
+//
+// Outside of a parallel run, and on threads that are not workers (e.g. the
+// threads a test starts), Require() does nothing.
+class JMSD_CUTF_SHARED_INTERFACE Test_isolation {
+
+public:
+	static Test_isolation *GetInstance();
+
+	// Makes the rest of the calling worker's unit of work the only one running.
+	void Require();
+
+	// Whether the calling thread runs a unit of work alone.
+	bool is_isolated() const;
+
+	// How many worker threads there are besides the calling one.  While the
+	// calling thread runs a unit alone, all of them wait.
+	int other_worker_count();
+
+	// Called before a pool of worker_count worker threads, the calling one
+	// included, starts.
+	void AddWorkers( int worker_count );
+
+	// Called by a worker thread that has run out of units of work before it
+	// exits.
+	void LeavePool();
+
+	// Called by a worker thread before and after each unit of work.
+	void EnterUnit();
+	void LeaveUnit();
+
+private:
+	Test_isolation();
+
+	std::mutex mutex_;
+	std::condition_variable changed_;
+
+	// Units holding a shared claim.
+	int running_unit_count_;
+
+	// Units waiting for an exclusive claim; while there are any, no unit starts.
+	int isolating_unit_count_;
+
+	bool is_unit_isolated_;
+	int worker_count_;
+
+	GTEST_DISALLOW_COPY_AND_ASSIGN_( Test_isolation );
+};
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
+
+
+namespace testing {
+
+
+} // namespace testing
@@ -0,0 +1,14 @@
+#pragma once
+
+
+namespace jmsd {
+namespace cutf {
+namespace internal {
+
+
+class Test_isolation;
+
+
+} // namespace internal
+} // namespace cutf
+} // namespace jmsd
@@ -19,6 +19,26 @@ void TestResultAccessor::RecordProperty(
 	test_result->RecordProperty(xml_element, property);
 }
 
+// static
+void TestResultAccessor::AddTestPartResult(TestResult* test_result, const testing::TestPartResult& test_part_result) {
+	test_result->AddTestPartResult(test_part_result);
+}
+
+// static
+bool TestResultAccessor::AddPendingTestPartResult(TestResult* test_result, const testing::TestPartResult& test_part_result) {
+	return test_result->AddPendingTestPartResult(test_part_result);
+}
+
+// static
+int TestResultAccessor::MergePendingTestPartResults(TestResult* test_result) {
+	return test_result->MergePendingTestPartResults();
+}
+
+// static
+int TestResultAccessor::MergeAndClosePendingTestPartResults(TestResult* test_result) {
+	return test_result->MergeAndClosePendingTestPartResults();
+}
+
 // static
 void TestResultAccessor::ClearTestPartResults(TestResult* test_result) {
 	test_result->ClearTestPartResults();
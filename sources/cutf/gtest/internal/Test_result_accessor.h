@@ -30,6 +30,10 @@ class JMSD_CUTF_SHARED_INTERFACE TestResultAccessor {
 
 public:
 	static void RecordProperty( TestResult* test_result, ::std::string const &xml_element, TestProperty const &property );
+	static void AddTestPartResult( TestResult *test_result, testing::TestPartResult const &test_part_result );
+	static bool AddPendingTestPartResult( TestResult *test_result, testing::TestPartResult const &test_part_result );
+	static int MergePendingTestPartResults( TestResult *test_result );
+	static int MergeAndClosePendingTestPartResults( TestResult *test_result );
 	static void ClearTestPartResults( TestResult *test_result );
 	static ::std::vector< testing::TestPartResult > const &test_part_results( TestResult const &test_result );
 
@@ -10,13 +10,22 @@
 #include "Json_test_result_printer.h"
 #include "Unit_test_options.h"
 #include "Colored_print.h"
+#include "Console_output.h"
 #include "function_Open_file_for_writing.h"
 #include "function_Is_initialized.h"
 #include "function_Int32_from_environment_or_die.h"
 #include "function_Write_to_shard_status_file_if_needed.h"
 #include "function_Should_run_test_on_shard.h"
-#include "function_String_stream_to_string.h"
+#include "function_Should_shard.h"
+#include "Shard_planner.h"
+#include "Compiled_filter.h"
+#include "Report_file_buffer.h"
 #include "Streaming_listener.h"
+#include "Async_socket_writer.h"
+#include "Stack_trace.h"
+#include "Parallel_test_runner.h"
+#include "Death_test_reactor.h"
+#include "Test_execution_context.h"
 
 #include "gtest-flags-internal.h"
 #include "gtest-constants-internal.h"
@@ -26,6 +35,8 @@
 
 #include "gtest-death-test-internal.h"
 
+#include <algorithm>
+
 
 namespace jmsd {
 namespace cutf {
@@ -136,6 +147,11 @@ int UnitTestImpl::test_to_run_count() const {
 	return elapsed_time_;
 }
 
+// Gets the elapsed time, in nanoseconds of a monotonic clock.
+::testing::internal::TimeInNanos UnitTestImpl::elapsed_time_nanos() const {
+	return elapsed_time_nanos_;
+}
+
 // Returns true if and only if the unit test passed (i.e. all test suites passed).
 bool UnitTestImpl::Passed() const {
 	return !Failed();
@@ -214,14 +230,130 @@ TestSuite *UnitTestImpl::GetMutableSuiteCase(int i) {
 
 // Sets the TestSuite object for the test that's currently running.
 void UnitTestImpl::set_current_test_suite( TestSuite *a_current_test_suite ) {
-	current_test_suite_ = a_current_test_suite;
+	Test_execution_context *const context = execution_context_.get();
+
+	if ( context != nullptr ) {
+		::testing::internal::MutexLock lock( &worker_contexts_mutex_ );
+		context->current_test_suite = a_current_test_suite;
+	} else {
+		current_test_suite_ = a_current_test_suite;
+	}
 }
 
 // Sets the TestInfo object for the test that's currently running.  If
 // current_test_info is NULL, the assertion results will be stored in
 // ad_hoc_test_result_.
 void UnitTestImpl::set_current_test_info( TestInfo *a_current_test_info ) {
-	current_test_info_ = a_current_test_info;
+	Test_execution_context *const context = execution_context_.get();
+
+	if ( context != nullptr ) {
+		::testing::internal::MutexLock lock( &worker_contexts_mutex_ );
+		context->current_test_info = a_current_test_info;
+	} else {
+		current_test_info_ = a_current_test_info;
+	}
+}
+
+// Installs the execution context of a parallel worker for the calling thread.
+void UnitTestImpl::set_execution_context( Test_execution_context *const context ) {
+	::testing::internal::MutexLock lock( &worker_contexts_mutex_ );
+
+	if ( context != nullptr ) {
+		worker_contexts_.push_back( context );
+	} else {
+		worker_contexts_.erase( ::std::remove( worker_contexts_.begin(), worker_contexts_.end(), execution_context_.get() ), worker_contexts_.end() );
+	}
+
+	execution_context_.set( context );
+}
+
+// Returns the listener that events raised on the calling thread must be sent to.
+TestEventListener *UnitTestImpl::event_sink() {
+	Test_execution_context const *const context = execution_context_.get();
+
+	if ( context != nullptr && context->event_sink != nullptr ) {
+		return context->event_sink;
+	}
+
+	if ( orphan_event_sink_ != nullptr ) {
+		return orphan_event_sink_;
+	}
+
+	return listeners()->repeater();
+}
+
+// Makes the calling thread report to the given TestResult.
+void UnitTestImpl::set_adopted_test_result( TestResult *const test_result ) {
+	adopted_test_result_.set( test_result );
+}
+
+// Sets the listener that collects events of non-worker threads during a parallel run.
+void UnitTestImpl::set_orphan_event_sink( TestEventListener *const sink ) {
+	orphan_event_sink_ = sink;
+}
+
+// Returns true if and only if the calling thread runs tests.
+bool UnitTestImpl::is_test_thread() const {
+	return execution_context_.get() != nullptr || ::std::this_thread::get_id() == main_thread_id_;
+}
+
+// Keeps a test part result of a thread that doesn't run tests until a thread running tests merges it.
+void UnitTestImpl::AddPendingTestPartResult( ::testing::TestPartResult const &result ) {
+	if ( execution_context_.get() == nullptr && adopted_test_result_.get() == nullptr ) {
+		// A thread that a test started without ThreadWithParam can't be told
+		// apart from the threads of the other tests running on the workers.
+		::testing::internal::MutexLock lock( &worker_contexts_mutex_ );
+
+		if ( !worker_contexts_.empty() ) {
+			bool is_kept = false;
+
+			for ( Test_execution_context const *const context : worker_contexts_ ) {
+				TestResult *const test_result =
+					context->current_test_info != nullptr ? context->current_test_info->result_.get() :
+					context->current_test_suite != nullptr ? context->current_test_suite->ad_hoc_test_result_.get() :
+					nullptr;
+
+				if ( test_result != nullptr && test_result->AddPendingTestPartResult( result ) ) {
+					is_kept = true;
+				}
+			}
+
+			if ( !is_kept ) {
+				ad_hoc_test_result_.AddPendingTestPartResult( result );
+			}
+
+			return;
+		}
+	}
+
+	if ( !current_test_result()->AddPendingTestPartResult( result ) ) {
+		ad_hoc_test_result_.AddPendingTestPartResult( result );
+	}
+}
+
+// Adds the test part results that other threads reported to the current TestResult.
+void UnitTestImpl::MergePendingTestPartResults() {
+	TestResult *const result = current_test_result();
+	SendMergedTestPartResults( *result, result->MergePendingTestPartResults() );
+}
+
+// Adds the test part results that other threads reported to the current TestResult and closes it.
+void UnitTestImpl::MergeAndClosePendingTestPartResults() {
+	TestResult *const result = current_test_result();
+	SendMergedTestPartResults( *result, result->MergeAndClosePendingTestPartResults() );
+}
+
+// Sends the last count test part results of the TestResult to event_sink().
+void UnitTestImpl::SendMergedTestPartResults( TestResult const &result, int const count ) {
+	if ( count == 0 ) {
+		return;
+	}
+
+	TestEventListener *const sink = event_sink();
+
+	for ( int i = result.total_part_count() - count; i < result.total_part_count(); ++i ) {
+		sink->OnTestPartResult( result.GetTestPartResult( i ) );
+	}
 }
 
 // Provides access to the event listener list.
@@ -248,6 +380,14 @@ std::string UnitTestImpl::CurrentOsStackTraceExceptTop(int skip_count) {
 	  );  // NOLINT
 }
 
+// Like CurrentOsStackTraceExceptTop(), but leaves the symbolization of the
+// frames for when the trace is printed, if the getter can.
+Stack_trace UnitTestImpl::CaptureOsStackTraceExceptTop(int skip_count) {
+  return os_stack_trace_getter()->CaptureStackTrace(
+	  static_cast<int>( ::testing:: GTEST_FLAG(stack_trace_depth)),
+	  skip_count + 1);  // Skips this function too.
+}
+
 UnitTestImpl::UnitTestImpl(UnitTest* parent)
 	: parent_(parent),
 	  GTEST_DISABLE_MSC_WARNINGS_PUSH_(4355 /* using this in initializer */)
@@ -262,6 +402,10 @@ UnitTestImpl::UnitTestImpl(UnitTest* parent)
 	  last_death_test_suite_(-1),
 	  current_test_suite_(nullptr),
 	  current_test_info_(nullptr),
+	  execution_context_(nullptr),
+	  adopted_test_result_(nullptr),
+	  orphan_event_sink_(nullptr),
+	  main_thread_id_(::std::this_thread::get_id()),
 	  ad_hoc_test_result_(),
 	  os_stack_trace_getter_(nullptr),
 	  post_flag_parse_init_performed_(false),
@@ -269,6 +413,7 @@ UnitTestImpl::UnitTestImpl(UnitTest* parent)
 	  random_(0),       // Will be reseeded before first use.
 	  start_timestamp_(0),
 	  elapsed_time_(0),
+	  elapsed_time_nanos_(0),
 #if GTEST_HAS_DEATH_TEST
 	  death_test_factory_(new ::testing::internal::DefaultDeathTestFactory),
 #endif
@@ -293,13 +438,16 @@ UnitTestImpl::~UnitTestImpl() {
 void UnitTestImpl::RecordProperty(const TestProperty& test_property) {
   std::string xml_element;
   TestResult* test_result;  // TestResult appropriate for property recording.
+  Test_execution_context* const context = execution_context_.get();
+  TestInfo* const test_info = context != nullptr ? context->current_test_info : current_test_info_;
+  TestSuite* const test_suite = context != nullptr ? context->current_test_suite : current_test_suite_;
 
-  if (current_test_info_ != nullptr) {
+  if (test_info != nullptr) {
 	xml_element = "testcase";
-	test_result = current_test_info_->result_.get();
-  } else if (current_test_suite_ != nullptr) {
+	test_result = test_info->result_.get();
+  } else if (test_suite != nullptr) {
 	xml_element = "testsuite";
-	test_result = current_test_suite_->ad_hoc_test_result_.get();
+	test_result = test_suite->ad_hoc_test_result_.get();
   } else {
 	xml_element = "testsuites";
 	test_result = &ad_hoc_test_result_;
@@ -310,6 +458,9 @@ void UnitTestImpl::RecordProperty(const TestProperty& test_property) {
 #if GTEST_HAS_DEATH_TEST
 
 void UnitTestImpl::InitDeathTestSubprocessControlInfo() {
+	// A death test server gets here once, after parsing the flags, and only
+	// returns in the children it forks.
+	::testing::internal::ServeDeathTestsIfRequested();
 	internal_run_death_test_flag_.reset( ::testing::internal::ParseInternalRunDeathTestFlag() );
 }
 // Returns a pointer to the parsed --gtest_internal_run_death_test
@@ -355,8 +506,22 @@ void UnitTestImpl::ConfigureStreamingOutput() {
   if (!target.empty()) {
 	const size_t pos = target.find(':');
 	if (pos != std::string::npos) {
-	  listeners()->Append(new ::jmsd::cutf::internal::StreamingListener(target.substr(0, pos),
-												target.substr(pos+1)));
+	  AbstractSocketWriter* socket_writer =
+		  new SocketWriter(target.substr(0, pos), target.substr(pos + 1));
+	  const int32_t buffer_size = ::testing:: GTEST_FLAG(stream_result_buffer);
+	  if (buffer_size > 0) {
+		AsyncSocketWriter::OverflowPolicy overflow_policy =
+			AsyncSocketWriter::kBlockOnOverflow;
+		if (!AsyncSocketWriter::ParseOverflowPolicy(
+				::testing:: GTEST_FLAG(stream_result_overflow), &overflow_policy)) {
+		  GTEST_LOG_(WARNING) << "unrecognized stream_result_overflow \""
+							  << ::testing:: GTEST_FLAG(stream_result_overflow)
+							  << "\", \"block\" used instead.";
+		}
+		socket_writer = new AsyncSocketWriter(
+			socket_writer, static_cast<size_t>(buffer_size), overflow_policy);
+	  }
+	  listeners()->Append(new ::jmsd::cutf::internal::StreamingListener(socket_writer));
 	} else {
 	  GTEST_LOG_(WARNING) << "unrecognized streaming target \"" << target
 						  << "\" ignored.";
@@ -394,6 +559,11 @@ void UnitTestImpl::PostFlagParsingInit() {
 	// to shut down the default XML output before invoking RUN_ALL_TESTS.
 	ConfigureXmlOutput();
 
+	// Buffers the console output if asked to.
+	if (::testing:: GTEST_FLAG(console_buffer) > 0) {
+	  Console_output::SetBuffered(static_cast<size_t>(::testing:: GTEST_FLAG(console_buffer)));
+	}
+
 #if GTEST_CAN_STREAM_RESULTS_
 	// Configures listeners for streaming test results to the specified server.
 	ConfigureStreamingOutput();
@@ -418,29 +588,6 @@ internal::Random *UnitTestImpl::random() {
 	return &random_;
 }
 
-// A predicate that checks the name of a TestSuite against a known
-// value.
-//
-// This is used for implementation of the UnitTest class only.  We put
-// it in the anonymous namespace to prevent polluting the outer
-// namespace.
-//
-// TestSuiteNameIs is copyable.
-class TestSuiteNameIs {
- public:
-  // Constructor.
-  explicit TestSuiteNameIs(const std::string& name) : name_(name) {}
-
-  // Returns true if and only if the name of test_suite matches name_.
-  bool operator()(const TestSuite* test_suite) const {
-	return test_suite != nullptr &&
-		   strcmp(test_suite->name(), name_.c_str()) == 0;
-  }
-
- private:
-  std::string name_;
-};
-
 // Finds and returns a TestSuite with the given name.  If one doesn't
 // exist, creates one and returns it.  It's the CALLER'S
 // RESPONSIBILITY to ensure that this function is only called WHEN THE
@@ -458,33 +605,41 @@ TestSuite* UnitTestImpl::GetTestSuite(
 	::testing::internal::SetUpTestSuiteFunc set_up_tc,
 	::testing::internal::TearDownTestSuiteFunc tear_down_tc) {
   // Can we find a TestSuite with the given name?
-  const auto test_suite =
-	  std::find_if(test_suites_.rbegin(), test_suites_.rend(),
-				   TestSuiteNameIs(test_suite_name));
+  TestSuite*& test_suite = test_suites_by_name_[test_suite_name];
 
-  if (test_suite != test_suites_.rend()) return *test_suite;
+  if (test_suite != nullptr) return test_suite;
 
-  // No.  Let's create one.
-  auto* const new_test_suite =
+  // No.  Let's create one and append it to the list; death test suites
+  // are moved to the front by OrderDeathTestSuitesFirst() before the
+  // tests run.
+  test_suite =
 	  new TestSuite(test_suite_name, type_param, set_up_tc, tear_down_tc);
 
-  // Is this a death test suite?
-  if (internal::UnitTestOptions::MatchesFilter(test_suite_name,
-											   constants::kDeathTestSuiteFilter)) {
-	// Yes.  Inserts the test suite after the last death test suite
-	// defined so far.  This only works when the test suites haven't
-	// been shuffled.  Otherwise we may end up running a death test
-	// after a non-death test.
-	++last_death_test_suite_;
-	test_suites_.insert(test_suites_.begin() + last_death_test_suite_,
-						new_test_suite);
-  } else {
-	// No.  Appends to the end of the list.
-	test_suites_.push_back(new_test_suite);
-  }
-
+  test_suites_.push_back(test_suite);
   test_suite_indices_.push_back(static_cast<int>(test_suite_indices_.size()));
-  return new_test_suite;
+  return test_suite;
+}
+
+// Moves the death test suites to the front of the list, keeping the
+// registration order among the death test suites and among the others,
+// so that no death test runs after a non-death test (which may have
+// started threads).  Registration only ever appends, which keeps it cheap
+// for large programs; the order is fixed here instead, once per run.
+// Must be called when the tests are not shuffled.
+void UnitTestImpl::OrderDeathTestSuitesFirst() {
+  const Compiled_filter death_test_suite_filter(constants::kDeathTestSuiteFilter);
+  const auto first_non_death_test_suite = std::stable_partition(
+	  test_suites_.begin(), test_suites_.end(),
+	  [&death_test_suite_filter](const TestSuite* test_suite) {
+		return death_test_suite_filter.Matches(test_suite->name());
+	  });
+
+  last_death_test_suite_ =
+	  static_cast<int>(first_non_death_test_suite - test_suites_.begin()) - 1;
+
+  for (size_t i = 0; i < test_suite_indices_.size(); i++) {
+	test_suite_indices_[i] = static_cast<int>(i);
+  }
 }
 
 // Helpers for setting up / tearing down the given environment.  They
@@ -514,6 +669,13 @@ bool UnitTestImpl::RunAllTests() {
   // user didn't call InitGoogleTest.
   PostFlagParsingInit();
 
+  // The results of this thread go straight to the TestResult.
+  main_thread_id_ = ::std::this_thread::get_id();
+  MergePendingTestPartResults();
+
+  // All the test suites are registered by now, parameterized ones included.
+  OrderDeathTestSuitesFirst();
+
   // Even if sharding is not on, test runners may want to use the
   // GTEST_SHARD_STATUS_FILE to query whether the test supports the sharding
   // protocol.
@@ -532,12 +694,8 @@ bool UnitTestImpl::RunAllTests() {
   }
 # endif  // defined(GTEST_EXTRA_DEATH_TEST_CHILD_SETUP_)
 #endif  // GTEST_HAS_DEATH_TEST
-  /*/
-  const bool should_shard = ShouldShard(kTestTotalShards, kTestShardIndex,
+  const bool should_shard = function_Should_shard::ShouldShard(constants::kTestTotalShards, constants::kTestShardIndex,
 										in_subprocess_for_death_test);
-  /*/
-  const bool should_shard = false;
-  //*/
 
   // Compares the full test names with the filter to decide which
   // tests to run.
@@ -566,6 +724,9 @@ bool UnitTestImpl::RunAllTests() {
   // How many times to repeat the tests?  We don't want to repeat them
   // when we are inside the subprocess of a death test.
   const int repeat = in_subprocess_for_death_test ? 1 : ::testing::GTEST_FLAG(repeat);
+  // The subprocess of a death test runs a single test; it never needs workers.
+  const int jobs = in_subprocess_for_death_test ? 1 : ::testing::GTEST_FLAG(jobs);
+  const int death_test_jobs = in_subprocess_for_death_test ? 1 : ConcurrentDeathTestJobs();
   // Repeats forever if the repeat count is negative.
   const bool gtest_repeat_forever = repeat < 0;
   for (int i = 0; gtest_repeat_forever || i != repeat; i++) {
@@ -573,7 +734,7 @@ bool UnitTestImpl::RunAllTests() {
 	// assertions executed before RUN_ALL_TESTS().
 	ClearNonAdHocTestResult();
 
-	const ::testing::internal::TimeInMillis start = ::testing::internal::GetTimeInMillis();
+	const ::testing::internal::TimeInNanos start = ::testing::internal::GetMonotonicTimeInNanos();
 
 	// Shuffles test suites and tests if requested.
 	if (has_tests_to_run && ::testing::GTEST_FLAG(shuffle)) {
@@ -611,9 +772,13 @@ bool UnitTestImpl::RunAllTests() {
 		}
 		fflush(stdout);
 	  } else if (!Test::HasFatalFailure()) {
-		for (int test_index = 0; test_index < total_test_suite_count();
-			 test_index++) {
-		  GetMutableSuiteCase(test_index)->Run();
+		if (jobs > 1 || death_test_jobs > 1) {
+		  RunTestSuitesInParallel(jobs, death_test_jobs);
+		} else {
+		  for (int test_index = 0; test_index < total_test_suite_count();
+			   test_index++) {
+			GetMutableSuiteCase(test_index)->Run();
+		  }
 		}
 	  }
 
@@ -624,7 +789,10 @@ bool UnitTestImpl::RunAllTests() {
 	  repeater->OnEnvironmentsTearDownEnd(*parent_);
 	}
 
-	elapsed_time_ = ::testing::internal::GetTimeInMillis() - start;
+	MergePendingTestPartResults();
+
+	elapsed_time_nanos_ = ::testing::internal::GetMonotonicTimeInNanos() - start;
+	elapsed_time_ = ::testing::internal::NanosToMillis(elapsed_time_nanos_);
 
 	// Tells the unit test event listener that the tests have just finished.
 	repeater->OnTestIterationEnd(*parent_, i);
@@ -667,6 +835,61 @@ bool UnitTestImpl::RunAllTests() {
   return !failed;
 }
 
+// Runs the death test suites on a pool of death_test_jobs worker threads,
+// reporting them in run order, then the remaining test suites on a pool of
+// jobs worker threads.  A pool of one is the calling thread running the
+// suites serially.  Death test suites are always at the front of the run
+// order, shuffled or not.
+void UnitTestImpl::RunTestSuitesInParallel(int const jobs,
+										   int const death_test_jobs) {
+  RunTestSuiteRange(0, last_death_test_suite_ + 1, death_test_jobs, true);
+  RunTestSuiteRange(last_death_test_suite_ + 1, total_test_suite_count(),
+					jobs, false);
+}
+
+// Runs the test suites in [begin, end) of the run order on jobs worker
+// threads, or serially on the calling thread if jobs is 1.
+void UnitTestImpl::RunTestSuiteRange(int const begin, int const end,
+									 int const jobs,
+									 bool const are_death_test_suites) {
+  if (jobs <= 1) {
+	for (int test_index = begin; test_index < end; test_index++) {
+	  GetMutableSuiteCase(test_index)->Run();
+	}
+	return;
+  }
+
+  Parallel_test_runner runner(this, jobs, are_death_test_suites);
+
+  for (int test_index = begin; test_index < end; test_index++) {
+	runner.Schedule(GetMutableSuiteCase(test_index));
+  }
+
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  Death_test_reactor::set_active(are_death_test_suites);
+#endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+  runner.Run();
+
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  Death_test_reactor::set_active(false);
+#endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+}
+
+// Returns how many death tests may run concurrently: the value of
+// --cutf_death_test_jobs, unless the death tests can't run concurrently.
+// "fast" style death tests fork the whole process, which isn't safe while
+// other threads run.
+int UnitTestImpl::ConcurrentDeathTestJobs() {
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+  if (::testing::internal::ReadSavedFlag(::testing::GTEST_FLAG(death_test_style)) == "fast") return 1;
+
+  return ::testing::GTEST_FLAG(death_test_jobs);
+#else
+  return 1;
+#endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+}
+
 // Clears the results of all tests, except the ad hoc tests.
 void UnitTestImpl::ClearNonAdHocTestResult() {
 	function_Stl_utilities::ForEach(test_suites_, TestSuite::ClearTestSuiteResult);
@@ -683,19 +906,24 @@ void UnitTestImpl::ClearAdHocTestResult() {
 // If shard_tests == true, further filters tests based on sharding
 // variables in the environment - see
 // https://github.com/google/googletest/blob/master/googletest/docs/advanced.md
-// . Returns the number of tests that should run.
+// . The runnable tests are dealt round-robin, or by the plan of a
+// Shard_planner when GTEST_FLAG(shard_durations) names earlier reports.
+// Returns the number of tests that should run.
 int UnitTestImpl::FilterTests(ReactionToSharding shard_tests) {
   const int32_t total_shards = shard_tests == HONOR_SHARDING_PROTOCOL ? function_Int32_from_environment_or_die::Int32FromEnvOrDie( constants::kTestTotalShards, -1) : -1;
   const int32_t shard_index = shard_tests == HONOR_SHARDING_PROTOCOL ? function_Int32_from_environment_or_die::Int32FromEnvOrDie( constants::kTestShardIndex, -1) : -1;
 
-  // num_runnable_tests are the number of tests that will
-  // run across all shards (i.e., match filter and are not disabled).
-  // num_selected_tests are the number of tests to be run on
-  // this shard.
-  int num_runnable_tests = 0;
-  int num_selected_tests = 0;
+  // Both filters are parsed once here rather than once per test.
+  const Compiled_filter disabled_filter(constants::kDisableTestFilter);
+  const Compiled_test_filter test_filter(::testing::GTEST_FLAG(filter));
+
+  // The tests that will run across all shards (i.e., match filter and
+  // are not disabled), in run order, together with their test suites.
+  std::vector< std::pair< TestSuite *, TestInfo * > > runnable_tests;
+  std::string full_name;
   for (auto* test_suite : test_suites_) {
 	const std::string& test_suite_name = test_suite->name();
+	const bool is_test_suite_disabled = disabled_filter.Matches(test_suite_name);
 	test_suite->set_should_run(false);
 
 	for (size_t j = 0; j < test_suite->test_info_list().size(); j++) {
@@ -703,36 +931,88 @@ int UnitTestImpl::FilterTests(ReactionToSharding shard_tests) {
 	  const std::string test_name(test_info->name());
 	  // A test is disabled if test suite name or test name matches
 	  // kDisableTestFilter.
-	  const bool is_disabled = internal::UnitTestOptions::MatchesFilter(
-								   test_suite_name, constants::kDisableTestFilter) ||
-							   internal::UnitTestOptions::MatchesFilter(
-								   test_name, constants::kDisableTestFilter);
+	  const bool is_disabled = is_test_suite_disabled || disabled_filter.Matches(test_name);
 	  test_info->is_disabled_ = is_disabled;
 
-	  const bool matches_filter = internal::UnitTestOptions::FilterMatchesTest(
-		  test_suite_name, test_name);
+	  full_name.assign(test_suite_name).append(1, '.').append(test_name);
+	  const bool matches_filter = test_filter.Matches(full_name);
 	  test_info->matches_filter_ = matches_filter;
 
 	  const bool is_runnable =
 		  ( ::testing::GTEST_FLAG(also_run_disabled_tests) || !is_disabled) &&
 		  matches_filter;
 
-	  const bool is_in_another_shard =
+	  // A test that doesn't run is still reported, by exactly one shard.
+	  test_info->is_in_another_shard_ =
 		  shard_tests != IGNORE_SHARDING_PROTOCOL &&
-		  !function_Should_run_test_on_shard::ShouldRunTestOnShard(total_shards, shard_index, num_runnable_tests);
-	  test_info->is_in_another_shard_ = is_in_another_shard;
-	  const bool is_selected = is_runnable && !is_in_another_shard;
-
-	  num_runnable_tests += is_runnable;
-	  num_selected_tests += is_selected;
+		  !function_Should_run_test_on_shard::ShouldRunTestOnShard(total_shards, shard_index, static_cast<int>(runnable_tests.size()));
+	  test_info->should_run_ = false;
 
-	  test_info->should_run_ = is_selected;
-	  test_suite->set_should_run(test_suite->should_run() || is_selected);
+	  if (is_runnable) {
+		runnable_tests.push_back(std::make_pair(test_suite, test_info));
+	  }
 	}
   }
+
+  std::vector<int> shard_plan;
+  if (shard_tests != IGNORE_SHARDING_PROTOCOL && !::testing::GTEST_FLAG(shard_durations).empty()) {
+	shard_plan = PlanShards(runnable_tests, total_shards);
+  }
+
+  // num_selected_tests are the number of tests to be run on this shard.
+  int num_selected_tests = 0;
+  for (size_t test_id = 0; test_id < runnable_tests.size(); ++test_id) {
+	TestSuite* const test_suite = runnable_tests[test_id].first;
+	TestInfo* const test_info = runnable_tests[test_id].second;
+
+	const bool is_in_another_shard =
+		shard_tests != IGNORE_SHARDING_PROTOCOL &&
+		(shard_plan.empty() ?
+			!function_Should_run_test_on_shard::ShouldRunTestOnShard(total_shards, shard_index, static_cast<int>(test_id)) :
+			shard_plan[test_id] != shard_index);
+	test_info->is_in_another_shard_ = is_in_another_shard;
+	const bool is_selected = !is_in_another_shard;
+
+	num_selected_tests += is_selected;
+
+	test_info->should_run_ = is_selected;
+	test_suite->set_should_run(test_suite->should_run() || is_selected);
+  }
   return num_selected_tests;
 }
 
+// Assigns the given runnable tests to shards by the durations recorded in
+// the reports named by GTEST_FLAG(shard_durations).  Reports that can't be
+// read are skipped with a warning; tests without a recorded duration are
+// assumed to take the average time.
+std::vector<int> UnitTestImpl::PlanShards(
+	const std::vector< std::pair< TestSuite *, TestInfo * > >& runnable_tests,
+	int total_shards) {
+  Shard_planner planner;
+
+  const std::string& reports = ::testing::GTEST_FLAG(shard_durations);
+  for (size_t start = 0; start <= reports.size();) {
+	const size_t comma = std::min(reports.find(',', start), reports.size());
+	const std::string path = reports.substr(start, comma - start);
+
+	if (!path.empty() && !planner.LoadReport(path)) {
+	  GTEST_LOG_(WARNING) << "shard_durations: cannot read a test report from "
+						  << path;
+	}
+
+	start = comma + 1;
+  }
+
+  std::vector<std::string> test_full_names;
+  test_full_names.reserve(runnable_tests.size());
+  for (const auto& runnable_test : runnable_tests) {
+	test_full_names.push_back(std::string(runnable_test.first->name()) + "." +
+							  runnable_test.second->name());
+  }
+
+  return planner.Plan(test_full_names, total_shards);
+}
+
 // Prints the given C-string on a single line by replacing all '\n'
 // characters with string "\\n".  If the output takes more than
 // max_length characters, only prints the first max_length characters
@@ -791,9 +1071,9 @@ void UnitTestImpl::ListTestsMatchingFilter() {
   fflush(stdout);
   const std::string& output_format = UnitTestOptions::GetOutputFormat();
   if (output_format == "xml" || output_format == "json") {
-	FILE* fileout = function_Open_file_for_writing::OpenFileForWriting(
-		UnitTestOptions::GetAbsolutePathToOutputFile().c_str());
-	std::stringstream stream;
+	Report_file_buffer fileout(function_Open_file_for_writing::OpenFileForWriting(
+		UnitTestOptions::GetAbsolutePathToOutputFile().c_str()));
+	std::ostream stream(&fileout);
 	if (output_format == "xml") {
 	  XmlUnitTestResultPrinter(
 		  UnitTestOptions::GetAbsolutePathToOutputFile().c_str())
@@ -803,14 +1083,23 @@ void UnitTestImpl::ListTestsMatchingFilter() {
 		  UnitTestOptions::GetAbsolutePathToOutputFile().c_str())
 		  .PrintJsonTestList(&stream, test_suites_);
 	}
-	fprintf(fileout, "%s", ::jmsd::cutf::internal::function_String_stream_to_string::StringStreamToString( stream ).c_str());
-	fclose(fileout);
   }
 }
 
-const TestSuite *UnitTestImpl::current_test_suite() const { return current_test_suite_; }
-TestInfo *UnitTestImpl::current_test_info() { return current_test_info_; }
-const TestInfo *UnitTestImpl::current_test_info() const { return current_test_info_; }
+const TestSuite *UnitTestImpl::current_test_suite() const {
+	Test_execution_context const *const context = execution_context_.get();
+	return context != nullptr ? context->current_test_suite : current_test_suite_;
+}
+
+TestInfo *UnitTestImpl::current_test_info() {
+	Test_execution_context const *const context = execution_context_.get();
+	return context != nullptr ? context->current_test_info : current_test_info_;
+}
+
+const TestInfo *UnitTestImpl::current_test_info() const {
+	Test_execution_context const *const context = execution_context_.get();
+	return context != nullptr ? context->current_test_info : current_test_info_;
+}
 
 // Returns the vector of environments that need to be set-up/torn-down before/after the tests are run.
 ::std::vector< Environment * > &UnitTestImpl::environments() {
@@ -854,13 +1143,22 @@ void UnitTestImpl::set_os_stack_trace_getter(
   return os_stack_trace_getter_;
 }
 
-// Returns the most specific TestResult currently running.
+// Returns the most specific TestResult currently running.  A thread that
+// adopted the TestResult of the thread that started it reports there.
 TestResult *UnitTestImpl::current_test_result() {
-  if (current_test_info_ != nullptr) {
-	return current_test_info_->result_.get();
+  Test_execution_context* const context = execution_context_.get();
+  if (context == nullptr && adopted_test_result_.get() != nullptr) {
+	return adopted_test_result_.get();
+  }
+
+  TestInfo* const test_info = context != nullptr ? context->current_test_info : current_test_info_;
+  TestSuite* const test_suite = context != nullptr ? context->current_test_suite : current_test_suite_;
+
+  if (test_info != nullptr) {
+	return test_info->result_.get();
   }
-  if (current_test_suite_ != nullptr) {
-	return current_test_suite_->ad_hoc_test_result_.get();
+  if (test_suite != nullptr) {
+	return test_suite->ad_hoc_test_result_.get();
   }
   return &ad_hoc_test_result_;
 }
@@ -907,3 +1205,20 @@ void UnitTestImpl::set_catch_exceptions( bool const value) {
 } // namespace internal
 } // namespace cutf
 } // namespace jmsd
+
+
+namespace testing {
+namespace internal {
+
+
+void *GetTestResultOfCurrentThread() {
+	return ::jmsd::cutf::internal::GetUnitTestImpl()->current_test_result();
+}
+
+void SetTestResultOfCurrentThread( void *const test_result ) {
+	::jmsd::cutf::internal::GetUnitTestImpl()->set_adopted_test_result( static_cast< ::jmsd::cutf::TestResult * >( test_result ) );
+}
+
+
+} // namespace internal
+} // namespace testing
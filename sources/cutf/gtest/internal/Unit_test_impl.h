@@ -7,9 +7,15 @@
 
 #include "gtest-port.h"
 
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "Default_global_test_part_result_reporter.h"
 #include "Default_per_thread_test_part_result_reporter.h"
 #include "Random_number_generator.h"
+#include "Test_execution_context.hxx"
 
 #include "gtest/Test_suite.h"
 #include "gtest/Test_event_listeners.h"
@@ -96,6 +102,9 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // Gets the elapsed time, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time() const;
 
+  // Gets the elapsed time, in nanoseconds of a monotonic clock.
+  ::testing::internal::TimeInNanos elapsed_time_nanos() const;
+
   // Returns true if and only if the unit test passed (i.e. all test suites
   // passed).
   bool Passed() const;
@@ -151,6 +160,10 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // trace but Bar() and CurrentOsStackTraceExceptTop() won't.
   std::string CurrentOsStackTraceExceptTop(int skip_count) GTEST_NO_INLINE_;
 
+  // Like CurrentOsStackTraceExceptTop(), but leaves the symbolization of
+  // the frames for when the trace is printed, if the getter can.
+  Stack_trace CaptureOsStackTraceExceptTop(int skip_count) GTEST_NO_INLINE_;
+
   // Finds and returns a TestSuite with the given name.  If one doesn't
   // exist, creates one and returns it.
   //
@@ -195,6 +208,56 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // ad_hoc_test_result_.
   void set_current_test_info(TestInfo* a_current_test_info);
 
+  // Installs the execution context of a parallel worker for the calling
+  // thread.  While a context is installed, the current test suite, the
+  // current test and the destination of test events are taken from it
+  // instead of from the shared fields.  Pass NULL to uninstall it.
+  void set_execution_context(Test_execution_context* context);
+
+  // Returns the listener that test suite, test and test part events raised
+  // on the calling thread must be sent to: the worker's recorder on a
+  // parallel worker, the orphan sink on any other thread while a parallel
+  // run is in progress, and the listener repeater otherwise.
+  TestEventListener* event_sink();
+
+  // Sets the listener that collects events of non-worker threads during a
+  // parallel run; NULL when no parallel run is in progress.
+  void set_orphan_event_sink(TestEventListener* sink);
+
+  // Makes current_test_result() return the given TestResult on the calling
+  // thread, which doesn't run tests; NULL goes back to the default.  A thread
+  // started by ThreadWithParam adopts the TestResult of the thread that
+  // started it this way.
+  void set_adopted_test_result(TestResult* test_result);
+
+  // Returns true if and only if the calling thread runs tests: the thread
+  // that runs RUN_ALL_TESTS() or a parallel worker.  The test part results
+  // of the other threads wait in the TestResult until a thread running
+  // tests merges them.
+  bool is_test_thread() const;
+
+  // Keeps a test part result that a thread which doesn't run tests
+  // reported in the current TestResult until a thread running tests merges
+  // it.  Once that TestResult is closed, the result goes to the ad hoc test
+  // result instead, which is merged at the end of the iteration.
+  //
+  // During a parallel run, a thread that a test started without
+  // ThreadWithParam doesn't know that test, so its result is kept in the
+  // TestResult of every test running on the workers at that moment.
+  void AddPendingTestPartResult(const ::testing::TestPartResult& result);
+
+  // Adds the test part results that other threads reported to the current
+  // TestResult and sends them to event_sink().  Done before every result
+  // the calling thread reports and before the end of every test, test
+  // suite and iteration is reported.  The listeners thus hear of those
+  // results only then: a test that hangs never prints them.
+  void MergePendingTestPartResults();
+
+  // Like MergePendingTestPartResults(), and closes the current TestResult
+  // so that results reported later go to the ad hoc test result.  Done
+  // right before the end of a test or test suite is reported.
+  void MergeAndClosePendingTestPartResults();
+
   // Registers all parameterized tests defined using TEST_P and
   // INSTANTIATE_TEST_SUITE_P, creating regular tests for each test/parameter
   // combination. This method can be called more then once; it has guards
@@ -296,6 +359,9 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // Restores the test suites and tests to their order before the first shuffle.
   void UnshuffleTests();
 
+  // Moves the death test suites ahead of the others, in registration order.
+  void OrderDeathTestSuitesFirst();
+
   // Returns the value of GTEST_FLAG(catch_exceptions) at the moment
   // UnitTest::Run() starts.
   bool catch_exceptions() const;
@@ -307,6 +373,25 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // GTEST_FLAG(catch_exceptions) at the moment it starts.
   void set_catch_exceptions(bool value);
 
+  // Sends the last count test part results of the TestResult, just merged,
+  // to event_sink().
+  void SendMergedTestPartResults(const TestResult& result, int count);
+
+  // Runs the test suites of one iteration on jobs worker threads, and the
+  // death test suites on death_test_jobs ones; see Parallel_test_runner.
+  void RunTestSuitesInParallel(int jobs, int death_test_jobs);
+  void RunTestSuiteRange(int begin, int end, int jobs,
+						 bool are_death_test_suites);
+
+  // The number of death tests to run at the same time.
+  static int ConcurrentDeathTestJobs();
+
+  // Used by FilterTests() to balance the shards by the test durations
+  // recorded in earlier reports.  Returns the shard of every given test.
+  std::vector<int> PlanShards(
+	  const std::vector< std::pair< TestSuite *, TestInfo * > >& runnable_tests,
+	  int total_shards);
+
   // The UnitTest object that owns this implementation object.
   ::jmsd::cutf::UnitTest* const parent_;
 
@@ -334,6 +419,10 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // elements in the vector.
   std::vector< TestSuite * > test_suites_;
 
+  // The TestSuites of test_suites_ by name, so that registering a test
+  // finds its suite in constant time.
+  std::unordered_map< std::string, TestSuite * > test_suites_by_name_;
+
   // Provides a level of indirection for the test suite list to allow
   // easy shuffling and restoring the test suite order.  The i-th
   // element of this vector is the index of the i-th test suite in the
@@ -346,7 +435,8 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // Indicates whether RegisterParameterizedTests() has been called already.
   bool parameterized_tests_registered_;
 
-  // Index of the last death test suite registered.  Initially -1.
+  // Index of the last death test suite once OrderDeathTestSuitesFirst()
+  // has moved them to the front.  Initially -1.
   int last_death_test_suite_;
 
   // This points to the TestSuite for the currently running test.  It
@@ -361,6 +451,25 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // assertion results in ad_hoc_test_result_.  Initially NULL.
   TestInfo* current_test_info_;
 
+  // The execution context of the calling thread when it is a parallel
+  // worker, NULL otherwise.
+  ::testing::internal::ThreadLocal< Test_execution_context * > execution_context_;
+
+  // The TestResult adopted by the calling thread, NULL if none.
+  ::testing::internal::ThreadLocal< TestResult * > adopted_test_result_;
+
+  // The execution contexts of the running parallel workers.  The mutex also
+  // guards what the workers set in them, which the other threads read.
+  ::testing::internal::Mutex worker_contexts_mutex_;
+  std::vector< Test_execution_context * > worker_contexts_;
+
+  // Collects events raised outside the workers during a parallel run.
+  TestEventListener* orphan_event_sink_;
+
+  // The thread that runs RUN_ALL_TESTS(), or that created the UnitTest
+  // before it is called.
+  ::std::thread::id main_thread_id_;
+
   // Normally, a user only writes assertions inside a TEST or TEST_F,
   // or inside a function called by a TEST or TEST_F.  Since Google
   // Test keeps track of which test is current running, it can
@@ -395,6 +504,9 @@ class JMSD_DEPRECATED_GTEST_API_ UnitTestImpl {
   // How long the test took to run, in milliseconds.
   ::testing::internal::TimeInMillis elapsed_time_;
 
+  // How long the test took to run, in nanoseconds.
+  ::testing::internal::TimeInNanos elapsed_time_nanos_;
+
 #if GTEST_HAS_DEATH_TEST
   // The decomposed components of the gtest_internal_run_death_test flag,
   // parsed when RUN_ALL_TESTS is called.
@@ -5,6 +5,7 @@
 #include "gtest/gtest-constants.h"
 #include "gtest/gtest-flags.h"
 
+#include "Compiled_filter.h"
 #include "gtest-filepath.h"
 
 
@@ -69,67 +70,46 @@ std::string UnitTestOptions::GetOutputFormat() {
 // Returns true if and only if the wildcard pattern matches the string.
 // The first ':' or '\0' character in pattern marks the end of it.
 //
-// This recursive algorithm isn't very efficient, but is clear and
-// works well enough for matching test names, which are short.
-bool UnitTestOptions::PatternMatchesString( char const *const pattern, char const *const str ) {
-	switch (*pattern) {
-		case '\0':
-		case ':':
-			return *str == '\0'; // Either ':' or '\0' marks the end of the pattern.
-		case '?':
-			return *str != '\0' && PatternMatchesString( pattern + 1, str + 1 ); // Matches any single character.
-		case '*':
-			return ( *str != '\0' && PatternMatchesString( pattern, str + 1 ) ) || PatternMatchesString( pattern + 1, str ); // Matches any string (possibly empty) of characters.
-		default:
-			return *pattern == *str && PatternMatchesString( pattern + 1, str + 1 ); // Non-special character. Matches itself.
+// On a mismatch only the last '*' seen needs to be retried, one character
+// further into the string: whatever an earlier '*' could absorb instead,
+// the last one can absorb too.  So this never takes more than
+// O(pattern length * string length) steps, however many '*'s there are.
+bool UnitTestOptions::PatternMatchesString( char const *pattern, char const *str ) {
+	char const *star_pattern = nullptr; // Just past the last '*' seen.
+	char const *star_str = nullptr; // Where the string stood when it was seen.
+
+	for ( ;; ) {
+		if ( *pattern == '*' ) {
+			star_pattern = ++pattern;
+			star_str = str;
+			continue;
+		}
+
+		bool const is_pattern_end = *pattern == '\0' || *pattern == ':'; // Either ':' or '\0' marks the end of the pattern.
+
+		if ( *str == '\0' ) {
+			if ( is_pattern_end ) return true;
+		} else if ( !is_pattern_end && ( *pattern == '?' || *pattern == *str ) ) {
+			++pattern;
+			++str;
+			continue;
+		}
+
+		// Lets the last '*' match one more character, if it can.
+		if ( star_pattern == nullptr || *star_str == '\0' ) return false;
+
+		pattern = star_pattern;
+		str = ++star_str;
 	}
 }
 
 // Returns true if and only if the user-specified filter matches the test suite name and the test name.
 bool UnitTestOptions::FilterMatchesTest( std::string const &test_suite_name, ::std::string const &test_name ) {
-	::std::string const &full_name = test_suite_name + "." + test_name.c_str();
-
-  // Split --gtest_filter at '-', if there is one, to separate into
-  // positive filter and negative filter portions
-  const char* const p = ::testing:: GTEST_FLAG(filter).c_str();
-  const char* const dash = strchr(p, '-');
-  std::string positive;
-  std::string negative;
-  if (dash == nullptr) {
-	positive = ::testing:: GTEST_FLAG(filter).c_str();  // Whole string is a positive filter
-	negative = "";
-  } else {
-	positive = std::string(p, dash);   // Everything up to the dash
-	negative = std::string(dash + 1);  // Everything after the dash
-	if (positive.empty()) {
-	  // Treat '-test1' as the same as '*-test1'
-	  positive = constants::kUniversalFilter;
-	}
-  }
-
-  // A filter is a colon-separated list of patterns.  It matches a
-  // test if any pattern in it matches the test.
-  return (MatchesFilter(full_name, positive.c_str()) && !MatchesFilter(full_name, negative.c_str()));
+	return Compiled_test_filter( ::testing:: GTEST_FLAG( filter ) ).Matches( test_suite_name + "." + test_name );
 }
 
-bool UnitTestOptions::MatchesFilter( ::std::string const &name, char const *const filter) {
-  const char *cur_pattern = filter;
-  for (;;) {
-	if (PatternMatchesString(cur_pattern, name.c_str())) {
-	  return true;
-	}
-
-	// Finds the next pattern in the filter.
-	cur_pattern = strchr(cur_pattern, ':');
-
-	// Returns if no more pattern can be found.
-	if (cur_pattern == nullptr) {
-	  return false;
-	}
-
-	// Skips the pattern separater (the ':' character).
-	cur_pattern++;
-  }
+bool UnitTestOptions::MatchesFilter( ::std::string const &name, char const *const filter ) {
+	return Compiled_filter( filter ).Matches( name );
 }
 
 #if GTEST_HAS_SEH
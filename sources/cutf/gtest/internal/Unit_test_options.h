@@ -37,13 +37,13 @@ public:
 
 	// Returns true if and only if the wildcard pattern matches the string.
 	// The first ':' or '\0' character in pattern marks the end of it.
-	//
-	// This recursive algorithm isn't very efficient, but is clear and
-	// works well enough for matching test names, which are short.
+	// It doesn't recurse, and takes at most O(pattern length * string
+	// length) steps.
 	static bool PatternMatchesString(const char *pattern, const char *str);
 
 	// Returns true if and only if the user-specified filter matches the test
-	// suite name and the test name.
+	// suite name and the test name.  Code matching many tests should compile
+	// the filter once into a Compiled_test_filter instead.
 	static bool FilterMatchesTest(const ::std::string& test_suite_name, const ::std::string& test_name);
 
 	// Returns true if "name" matches the ':' separated list of glob-style
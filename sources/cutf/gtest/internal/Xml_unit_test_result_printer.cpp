@@ -8,8 +8,9 @@
 
 #include "function_Open_file_for_writing.h"
 #include "Format_time.h"
-#include "function_String_stream_to_string.h"
 #include "function_Streamable_to_string.hin"
+#include "Report_file_buffer.h"
+#include "gtest/gtest-flags.h"
 
 #include "gtest/Message.hin"
 
@@ -20,29 +21,120 @@ namespace internal {
 
 
 XmlUnitTestResultPrinter::XmlUnitTestResultPrinter(const char* output_file)
-	: output_file_(output_file) {
+	: output_file_(output_file),
+	  is_streamed_(::testing::GTEST_FLAG(stream_output)),
+	  streamed_report_stream_(nullptr) {
   if (output_file_.empty()) {
 	GTEST_LOG_(FATAL) << "XML output file may not be null";
   }
 }
 
+XmlUnitTestResultPrinter::~XmlUnitTestResultPrinter() {
+}
+
+// Unless the report is streamed, it is written when the iteration ends, and
+// the events of the tests don't need to reach this printer.
+unsigned XmlUnitTestResultPrinter::event_interests() const {
+  if (is_streamed_) {
+	return kOnTestIterationStart | kOnTestSuiteStart | kOnTestEnd |
+		   kOnTestSuiteEnd | kOnTestIterationEnd | kOnTestProgramEnd;
+  }
+
+  return kOnTestIterationEnd | kOnTestProgramEnd;
+}
+
+// Called before each iteration; starts the streamed report (a new one for
+// every iteration, as the report of the last iteration is kept).
+void XmlUnitTestResultPrinter::OnTestIterationStart(const ::jmsd::cutf::UnitTest& unit_test,
+													int /*iteration*/) {
+  if (!is_streamed_) {
+	return;
+  }
+
+  streamed_report_.reset();
+  streamed_report_.reset(new Report_file_buffer(function_Open_file_for_writing::OpenFileForWriting(output_file_)));
+  streamed_report_stream_.rdbuf(streamed_report_.get());
+  streamed_report_stream_.clear();
+
+  OutputXmlUnitTestStart(&streamed_report_stream_, unit_test, false);
+}
+
+void XmlUnitTestResultPrinter::OnTestSuiteStart(const ::jmsd::cutf::TestSuite& test_suite) {
+  if (streamed_report_ == nullptr) {
+	return;
+  }
+
+  OutputXmlTestSuiteStart(&streamed_report_stream_, test_suite, false);
+}
+
+void XmlUnitTestResultPrinter::OnTestEnd(const ::jmsd::cutf::TestInfo& test_info) {
+  if (streamed_report_ == nullptr || !test_info.is_reportable()) {
+	return;
+  }
+
+  OutputXmlTestInfo(&streamed_report_stream_, test_info.test_suite_name(), test_info);
+  streamed_report_->FlushIfDue();
+}
+
+// Adds the tests of the suite that didn't run (disabled ones), which got
+// no OnTestEnd(), and ends the suite.
+void XmlUnitTestResultPrinter::OnTestSuiteEnd(const ::jmsd::cutf::TestSuite& test_suite) {
+  if (streamed_report_ == nullptr) {
+	return;
+  }
+
+  for (int i = 0; i < test_suite.total_test_count(); ++i) {
+	const ::jmsd::cutf::TestInfo& test_info = *test_suite.GetTestInfo(i);
+	if (test_info.is_reportable() && !test_info.should_run())
+	  OutputXmlTestInfo(&streamed_report_stream_, test_suite.name(), test_info);
+  }
+  streamed_report_stream_ << "  </testsuite>\n";
+  FlushStreamedReport();
+}
+
 // Called after the unit test ends.
 void XmlUnitTestResultPrinter::OnTestIterationEnd(const ::jmsd::cutf::UnitTest& unit_test,
 												  int /*iteration*/) {
-  FILE* xmlout = function_Open_file_for_writing::OpenFileForWriting(output_file_);
-  std::stringstream stream;
+  if (streamed_report_ != nullptr) {
+	// Suites with reportable tests but none to run got no OnTestSuiteStart().
+	for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
+	  const ::jmsd::cutf::TestSuite& test_suite = *unit_test.GetTestSuite(i);
+	  if (test_suite.reportable_test_count() > 0 && !test_suite.should_run())
+		PrintXmlTestSuite(&streamed_report_stream_, test_suite);
+	}
+	FlushStreamedReport();
+	return;
+  }
+
+  if (is_streamed_) {
+	return;
+  }
+
+  Report_file_buffer xmlout(function_Open_file_for_writing::OpenFileForWriting(output_file_));
+  std::ostream stream(&xmlout);
   PrintXmlUnitTest(&stream, unit_test);
-  fprintf(xmlout, "%s", function_String_stream_to_string::StringStreamToString( stream ).c_str());
-  fclose(xmlout);
+}
+
+// Ends the streamed report.
+void XmlUnitTestResultPrinter::OnTestProgramEnd(const ::jmsd::cutf::UnitTest& /*unit_test*/) {
+  if (streamed_report_ == nullptr) {
+	return;
+  }
+
+  streamed_report_stream_ << "</testsuites>\n";
+  streamed_report_stream_.rdbuf(nullptr);
+  streamed_report_.reset();
 }
 
 void XmlUnitTestResultPrinter::ListTestsMatchingFilter(
 	const std::vector<::jmsd::cutf::TestSuite*>& test_suites) {
-  FILE* xmlout = function_Open_file_for_writing::OpenFileForWriting(output_file_);
-  std::stringstream stream;
+  Report_file_buffer xmlout(function_Open_file_for_writing::OpenFileForWriting(output_file_));
+  std::ostream stream(&xmlout);
   PrintXmlTestsList(&stream, test_suites);
-  fprintf(xmlout, "%s", function_String_stream_to_string::StringStreamToString( stream ).c_str());
-  fclose(xmlout);
+}
+
+void XmlUnitTestResultPrinter::FlushStreamedReport() {
+  streamed_report_stream_.flush();
 }
 
 // Returns an XML-escaped copy of the input string str.  If is_attribute
@@ -56,45 +148,50 @@ void XmlUnitTestResultPrinter::ListTestsMatchingFilter(
 // If this module is ever modified to produce version 1.1 XML output,
 // most invalid characters can be retained using character references.
 std::string XmlUnitTestResultPrinter::EscapeXml( ::std::string const &str, bool const is_attribute ) {
-  Message m;
+  std::stringstream stream;
+  OutputEscapedXml(&stream, str, is_attribute);
+  return stream.str();
+}
 
+// Streams str XML-escaped, without building the escaped copy.
+void XmlUnitTestResultPrinter::OutputEscapedXml(std::ostream* stream,
+												const std::string& str,
+												bool is_attribute) {
   for (size_t i = 0; i < str.size(); ++i) {
 	const char ch = str[i];
 	switch (ch) {
 	  case '<':
-		m << "&lt;";
+		*stream << "&lt;";
 		break;
 	  case '>':
-		m << "&gt;";
+		*stream << "&gt;";
 		break;
 	  case '&':
-		m << "&amp;";
+		*stream << "&amp;";
 		break;
 	  case '\'':
 		if (is_attribute)
-		  m << "&apos;";
+		  *stream << "&apos;";
 		else
-		  m << '\'';
+		  stream->put('\'');
 		break;
 	  case '"':
 		if (is_attribute)
-		  m << "&quot;";
+		  *stream << "&quot;";
 		else
-		  m << '"';
+		  stream->put('"');
 		break;
 	  default:
 		if (IsValidXmlCharacter(ch)) {
 		  if (is_attribute && IsNormalizableWhitespace(ch))
-			m << "&#x" << ::testing::internal::String::FormatByte(static_cast<unsigned char>(ch))
-			  << ";";
+			*stream << "&#x" << ::testing::internal::String::FormatByte(static_cast<unsigned char>(ch))
+					<< ";";
 		  else
-			m << ch;
+			stream->put(ch);
 		}
 		break;
 	}
   }
-
-  return m.GetString();
 }
 
 // Returns the given string with all characters invalid in XML removed.
@@ -144,7 +241,9 @@ void XmlUnitTestResultPrinter::OutputXmlAttribute(
 	  << "Attribute " << name << " is not allowed for element <" << element_name
 	  << ">.";
 
-  *stream << " " << name << "=\"" << EscapeXmlAttribute(value) << "\"";
+  *stream << " " << name << "=\"";
+  OutputEscapedXml(stream, value, true);
+  *stream << "\"";
 }
 
 // Prints an XML representation of a TestInfo object.
@@ -185,6 +284,8 @@ void XmlUnitTestResultPrinter::OutputXmlTestInfo(::std::ostream* stream,
 						 : "suppressed");
   OutputXmlAttribute(stream, kTestsuite, "time",
 					 Format_time::FormatTimeInMillisAsSeconds(result.elapsed_time()));
+  OutputXmlAttribute(stream, kTestsuite, "time_ns",
+					 function_Streamable_to_string::StreamableToString(result.elapsed_time_nanos()));
   OutputXmlAttribute(
 	  stream, kTestsuite, "timestamp",
 	  Format_time::FormatEpochTimeInMillisAsIso8601(result.start_timestamp()));
@@ -201,10 +302,10 @@ void XmlUnitTestResultPrinter::OutputXmlTestInfo(::std::ostream* stream,
 		  ::testing::internal::FormatCompilerIndependentFileLocation(part.file_name(),
 														  part.line_number());
 	  const std::string summary = location + "\n" + part.summary();
-	  *stream << "      <failure message=\""
-			  << EscapeXmlAttribute(summary.c_str())
-			  << "\" type=\"\">";
-	  const std::string detail = location + "\n" + part.message();
+	  *stream << "      <failure message=\"";
+	  OutputEscapedXml(stream, summary, true);
+	  *stream << "\" type=\"\">";
+	  const std::string detail = location + "\n" + part.message_with_stack_trace();
 	  OutputXmlCDataSection(stream, RemoveInvalidXmlCharacters(detail).c_str());
 	  *stream << "</failure>\n";
 	}
@@ -221,28 +322,42 @@ void XmlUnitTestResultPrinter::OutputXmlTestInfo(::std::ostream* stream,
   }
 }
 
-// Prints an XML representation of a TestSuite object
-void XmlUnitTestResultPrinter::PrintXmlTestSuite(std::ostream* stream, const TestSuite& test_suite) {
+// Streams the start tag of a TestSuite element.
+void XmlUnitTestResultPrinter::OutputXmlTestSuiteStart(std::ostream* stream,
+													   const TestSuite& test_suite,
+													   bool with_results) {
   const std::string kTestsuite = "testsuite";
   *stream << "  <" << kTestsuite;
   OutputXmlAttribute(stream, kTestsuite, "name", test_suite.name());
   OutputXmlAttribute(stream, kTestsuite, "tests",
 					 function_Streamable_to_string::StreamableToString(test_suite.reportable_test_count()));
   if (!::testing::GTEST_FLAG(list_tests)) {
-	OutputXmlAttribute(stream, kTestsuite, "failures",
-					   function_Streamable_to_string::StreamableToString(test_suite.failed_test_count()));
+	if (with_results) {
+	  OutputXmlAttribute(stream, kTestsuite, "failures",
+						 function_Streamable_to_string::StreamableToString(test_suite.failed_test_count()));
+	}
 	OutputXmlAttribute(
 		stream, kTestsuite, "disabled",
 		function_Streamable_to_string::StreamableToString(test_suite.reportable_disabled_test_count()));
-	OutputXmlAttribute(stream, kTestsuite, "errors", "0");
-	OutputXmlAttribute(stream, kTestsuite, "time",
-					   Format_time::FormatTimeInMillisAsSeconds(test_suite.elapsed_time()));
-	OutputXmlAttribute(
-		stream, kTestsuite, "timestamp",
-		Format_time::FormatEpochTimeInMillisAsIso8601(test_suite.start_timestamp()));
-	*stream << TestPropertiesAsXmlAttributes(test_suite.ad_hoc_test_result());
+	if (with_results) {
+	  OutputXmlAttribute(stream, kTestsuite, "errors", "0");
+	  OutputXmlAttribute(stream, kTestsuite, "time",
+						 Format_time::FormatTimeInMillisAsSeconds(test_suite.elapsed_time()));
+	  OutputXmlAttribute(stream, kTestsuite, "time_ns",
+						 function_Streamable_to_string::StreamableToString(test_suite.elapsed_time_nanos()));
+	  OutputXmlAttribute(
+		  stream, kTestsuite, "timestamp",
+		  Format_time::FormatEpochTimeInMillisAsIso8601(test_suite.start_timestamp()));
+	  *stream << TestPropertiesAsXmlAttributes(test_suite.ad_hoc_test_result());
+	}
   }
   *stream << ">\n";
+}
+
+// Prints an XML representation of a TestSuite object
+void XmlUnitTestResultPrinter::PrintXmlTestSuite(std::ostream* stream, const TestSuite& test_suite) {
+  const std::string kTestsuite = "testsuite";
+  OutputXmlTestSuiteStart(stream, test_suite, true);
   for (int i = 0; i < test_suite.total_test_count(); ++i) {
 	if (test_suite.GetTestInfo(i)->is_reportable())
 	  OutputXmlTestInfo(stream, test_suite.name(), *test_suite.GetTestInfo(i));
@@ -250,9 +365,11 @@ void XmlUnitTestResultPrinter::PrintXmlTestSuite(std::ostream* stream, const Tes
   *stream << "  </" << kTestsuite << ">\n";
 }
 
-// Prints an XML summary of unit_test to output stream out.
-void XmlUnitTestResultPrinter::PrintXmlUnitTest(std::ostream* stream,
-												const ::jmsd::cutf::UnitTest& unit_test) {
+// Streams the start of the document, up to the start tag of the
+// UnitTest element.
+void XmlUnitTestResultPrinter::OutputXmlUnitTestStart(std::ostream* stream,
+													  const ::jmsd::cutf::UnitTest& unit_test,
+													  bool with_results) {
   const std::string kTestsuites = "testsuites";
 
   *stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
@@ -260,14 +377,20 @@ void XmlUnitTestResultPrinter::PrintXmlUnitTest(std::ostream* stream,
 
   OutputXmlAttribute(stream, kTestsuites, "tests",
 					 function_Streamable_to_string::StreamableToString(unit_test.reportable_test_count()));
-  OutputXmlAttribute(stream, kTestsuites, "failures",
-					 function_Streamable_to_string::StreamableToString(unit_test.failed_test_count()));
+  if (with_results) {
+	OutputXmlAttribute(stream, kTestsuites, "failures",
+					   function_Streamable_to_string::StreamableToString(unit_test.failed_test_count()));
+  }
   OutputXmlAttribute(
 	  stream, kTestsuites, "disabled",
 	  function_Streamable_to_string::StreamableToString(unit_test.reportable_disabled_test_count()));
-  OutputXmlAttribute(stream, kTestsuites, "errors", "0");
-  OutputXmlAttribute(stream, kTestsuites, "time",
-					 Format_time::FormatTimeInMillisAsSeconds(unit_test.elapsed_time()));
+  if (with_results) {
+	OutputXmlAttribute(stream, kTestsuites, "errors", "0");
+	OutputXmlAttribute(stream, kTestsuites, "time",
+					   Format_time::FormatTimeInMillisAsSeconds(unit_test.elapsed_time()));
+	OutputXmlAttribute(stream, kTestsuites, "time_ns",
+					   function_Streamable_to_string::StreamableToString(unit_test.elapsed_time_nanos()));
+  }
   OutputXmlAttribute(
 	  stream, kTestsuites, "timestamp",
 	  Format_time::FormatEpochTimeInMillisAsIso8601(unit_test.start_timestamp()));
@@ -276,10 +399,20 @@ void XmlUnitTestResultPrinter::PrintXmlUnitTest(std::ostream* stream,
 	OutputXmlAttribute(stream, kTestsuites, "random_seed",
 					   function_Streamable_to_string::StreamableToString(unit_test.random_seed()));
   }
-  *stream << TestPropertiesAsXmlAttributes(unit_test.ad_hoc_test_result());
+  if (with_results) {
+	*stream << TestPropertiesAsXmlAttributes(unit_test.ad_hoc_test_result());
+  }
 
   OutputXmlAttribute(stream, kTestsuites, "name", "AllTests");
   *stream << ">\n";
+}
+
+// Prints an XML summary of unit_test to output stream out.
+void XmlUnitTestResultPrinter::PrintXmlUnitTest(std::ostream* stream,
+												const ::jmsd::cutf::UnitTest& unit_test) {
+  const std::string kTestsuites = "testsuites";
+
+  OutputXmlUnitTestStart(stream, unit_test, true);
 
   for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
 	if (unit_test.GetTestSuite(i)->reportable_test_count() > 0)
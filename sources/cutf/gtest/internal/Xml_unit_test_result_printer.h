@@ -7,7 +7,11 @@
 
 #include "gtest/Test_result.hxx"
 
+#include "Report_file_buffer.hxx"
 
+
+#include <memory>
+#include <ostream>
 #include <string>
 
 
@@ -33,13 +37,27 @@ namespace internal {
 // </testsuites>
 
 // This class generates an XML output file.
-class XmlUnitTestResultPrinter :
+//
+// With --cutf_stream_output, the file is written as the tests run: the
+// start of the document and each <testsuite> by the time its suite ends,
+// and the end of the document when the program ends.  The start
+// tags can then only carry the attributes known before the tests run (no
+// failure counts, times or properties of the suites and of the whole run).
+class JMSD_CUTF_SHARED_INTERFACE XmlUnitTestResultPrinter :
 	public EmptyTestEventListener
 {
 public:
   explicit XmlUnitTestResultPrinter(const char* output_file);
+  ~XmlUnitTestResultPrinter() override;
+
+  unsigned event_interests() const override;
 
+  void OnTestIterationStart(const UnitTest& unit_test, int iteration) override;
+  void OnTestSuiteStart(const TestSuite& test_suite) override;
+  void OnTestEnd(const TestInfo& test_info) override;
+  void OnTestSuiteEnd(const TestSuite& test_suite) override;
   void OnTestIterationEnd(const UnitTest& unit_test, int iteration) override;
+  void OnTestProgramEnd(const UnitTest& unit_test) override;
   void ListTestsMatchingFilter(const std::vector<TestSuite*>& test_suites);
 
   // Prints an XML summary of all unit tests.
@@ -64,6 +82,10 @@ public:
   // with character references.
   static std::string EscapeXml(const std::string& str, bool is_attribute);
 
+  // Streams str XML-escaped, as EscapeXml() returns it.
+  static void OutputEscapedXml(std::ostream* stream, const std::string& str,
+							   bool is_attribute);
+
   // Returns the given string with all characters invalid in XML removed.
   static std::string RemoveInvalidXmlCharacters(const std::string& str);
 
@@ -92,10 +114,23 @@ public:
 								const char* test_suite_name,
 								const ::jmsd::cutf::TestInfo& test_info);
 
+  // Streams the start tag of a TestSuite element; with_results tells
+  // whether to include the attributes only known once the suite has run.
+  static void OutputXmlTestSuiteStart(::std::ostream* stream,
+									  const ::jmsd::cutf::TestSuite& test_suite,
+									  bool with_results);
+
   // Prints an XML representation of a TestSuite object
   static void PrintXmlTestSuite(::std::ostream* stream,
 								const ::jmsd::cutf::TestSuite& test_suite);
 
+  // Streams the start of the document, up to the start tag of the
+  // UnitTest element; with_results tells whether to include the
+  // attributes only known once the tests have run.
+  static void OutputXmlUnitTestStart(::std::ostream* stream,
+									 const ::jmsd::cutf::UnitTest& unit_test,
+									 bool with_results);
+
   // Prints an XML summary of unit_test to output stream out.
   static void PrintXmlUnitTest(::std::ostream* stream,
 							   const ::jmsd::cutf::UnitTest& unit_test);
@@ -111,9 +146,23 @@ public:
   static void OutputXmlTestProperties(std::ostream* stream,
 									  const ::jmsd::cutf::TestResult& result);
 
+  // Flushes the streamed report to its file, as a test suite or the
+  // iteration ends.  In between, the report buffer writes itself out when
+  // it fills up, and OnTestEnd() flushes it when it's due, so a crash only
+  // loses the tests that ended within the flush interval of the last flush.
+  void FlushStreamedReport();
+
   // The output file.
   const std::string output_file_;
 
+  // Whether the report is streamed (--cutf_stream_output).
+  const bool is_streamed_;
+
+  // The file of the streamed report, while it is written, and the
+  // stream writing to it.
+  std::unique_ptr<Report_file_buffer> streamed_report_;
+  std::ostream streamed_report_stream_;
+
   GTEST_DISALLOW_COPY_AND_ASSIGN_(XmlUnitTestResultPrinter);
 };
 
@@ -18,7 +18,7 @@ namespace internal {
 		  ::testing::internal::FormatFileLocation( test_part_result.file_name(), test_part_result.line_number() ) <<
 		  " " <<
 		  ::jmsd::cutf::TestPartResultTypeToString( test_part_result.type() ) <<
-		  test_part_result.message() ).GetString();
+		  test_part_result.message_with_stack_trace() ).GetString();
 }
 
 
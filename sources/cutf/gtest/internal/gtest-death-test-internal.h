@@ -45,11 +45,13 @@
 namespace testing {
 namespace internal {
 
+GTEST_DECLARE_FLAG_string_(internal_death_test_server);
 GTEST_DECLARE_FLAG_string_(internal_run_death_test);
 
 // Names of the flags (needed for parsing Google Test flags).
 const char kDeathTestStyleFlag[] = "death_test_style";
 const char kDeathTestUseFork[] = "death_test_use_fork";
+const char kInternalDeathTestServerFlag[] = "internal_death_test_server";
 const char kInternalRunDeathTestFlag[] = "internal_run_death_test";
 
 // Flag characters for reporting a death test that did not die.
@@ -148,9 +150,6 @@ class JMSD_DEPRECATED_GTEST_API_ DeathTest {
   static void set_last_death_test_message(const std::string& message);
 
  private:
-  // A string containing a description of the outcome of the last death test.
-  static std::string last_death_test_message_;
-
   GTEST_DISALLOW_COPY_AND_ASSIGN_(DeathTest);
 };
 
@@ -310,6 +309,12 @@ class InternalRunDeathTestFlag {
 // the flag is specified; otherwise returns NULL.
 InternalRunDeathTestFlag* ParseInternalRunDeathTestFlag();
 
+// Turns this process into the server of "forkserver" style death tests if
+// the GTEST_FLAG(internal_death_test_server) flag is specified.  Returns
+// right away otherwise.  The server never returns; the children it forks
+// do, with the flags set for the single death test they are to run.
+void ServeDeathTestsIfRequested();
+
 #endif  // GTEST_HAS_DEATH_TEST
 
 }  // namespace internal
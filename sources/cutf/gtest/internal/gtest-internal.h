@@ -1075,3 +1075,42 @@ constexpr bool InstantiateTypedTestCase_P_IsDeprecated() { return true; }
 		  new ::testing::internal::TestFactoryImpl<GTEST_TEST_CLASS_NAME_(    \
 			  test_suite_name, test_name)>);                                  \
   void GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)::TestBody()
+
+// Helper macro for defining benchmarks.  The test it defines passes the
+// body, as BenchmarkBody(), to ::jmsd::cutf::Benchmark_state::Run().
+#define GTEST_BENCHMARK_(test_suite_name, test_name, parent_class, parent_id) \
+  static_assert(sizeof(GTEST_STRINGIFY_(test_suite_name)) > 1,                \
+				"test_suite_name must not be empty");                         \
+  static_assert(sizeof(GTEST_STRINGIFY_(test_name)) > 1,                      \
+				"test_name must not be empty");                               \
+  class GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)                    \
+	  : public parent_class {                                                 \
+   public:                                                                    \
+	GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)() {}                   \
+																			  \
+   private:                                                                   \
+	void TestBody() override {                                                \
+	  ::jmsd::cutf::Benchmark_state::Run(                                     \
+		  [this](::jmsd::cutf::Benchmark_state& state) {                      \
+			BenchmarkBody(state);                                             \
+		  });                                                                 \
+	}                                                                         \
+	void BenchmarkBody(::jmsd::cutf::Benchmark_state& state);                 \
+	static ::jmsd::cutf::TestInfo* const test_info_ GTEST_ATTRIBUTE_UNUSED_;     \
+	GTEST_DISALLOW_COPY_AND_ASSIGN_(GTEST_TEST_CLASS_NAME_(test_suite_name,   \
+														   test_name));       \
+  };                                                                          \
+																			  \
+  ::jmsd::cutf::TestInfo* const GTEST_TEST_CLASS_NAME_(test_suite_name,          \
+													test_name)::test_info_ =  \
+	  ::jmsd::cutf::internal::function_Make_and_register_test_info::MakeAndRegisterTestInfo( \
+		  #test_suite_name, #test_name, nullptr, nullptr,                     \
+		  ::testing::internal::CodeLocation(__FILE__, __LINE__), (parent_id), \
+		  ::testing::internal::SuiteApiResolver<                              \
+			  parent_class>::GetSetUpCaseOrSuite(__FILE__, __LINE__),         \
+		  ::testing::internal::SuiteApiResolver<                              \
+			  parent_class>::GetTearDownCaseOrSuite(__FILE__, __LINE__),      \
+		  new ::testing::internal::TestFactoryImpl<GTEST_TEST_CLASS_NAME_(    \
+			  test_suite_name, test_name)>);                                  \
+  void GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)::BenchmarkBody(     \
+	  ::jmsd::cutf::Benchmark_state& state)
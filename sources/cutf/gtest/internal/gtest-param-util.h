@@ -17,6 +17,7 @@
 #include <iterator>
 #include <memory>
 #include <set>
+#include <unordered_set>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -52,6 +53,29 @@ namespace internal {
 template <typename> class ParamGeneratorInterface;
 template <typename> class ParamGenerator;
 
+// Receives the elements of a generator, one call per element, from
+// ParamGeneratorInterface<T>::Generate().  The element is only valid
+// during the call.
+template <typename T>
+class ParamConsumer {
+ public:
+  virtual ~ParamConsumer() {}
+
+  virtual void Accept(const T& value) = 0;
+};
+
+// A ParamConsumer<T> calling a function object.
+template <typename T, typename Function>
+class FunctionParamConsumer : public ParamConsumer<T> {
+ public:
+  explicit FunctionParamConsumer(Function* function) : function_(function) {}
+
+  void Accept(const T& value) override { (*function_)(value); }
+
+ private:
+  Function* const function_;
+};
+
 // Interface for iterating over elements provided by an implementation
 // of ParamGeneratorInterface<T>.
 template <typename T>
@@ -137,6 +161,17 @@ class ParamGeneratorInterface {
   // Generator interface definition
   virtual ParamIteratorInterface<T>* Begin() const = 0;
   virtual ParamIteratorInterface<T>* End() const = 0;
+
+  // Passes every element to the consumer, in order.  This default walks
+  // the iterators; the generators defined here override it with a loop
+  // over their own state, which neither allocates nor clones iterators.
+  virtual void Generate(ParamConsumer<T>* consumer) const {
+    const std::unique_ptr<ParamIteratorInterface<T> > end(End());
+    for (std::unique_ptr<ParamIteratorInterface<T> > it(Begin());
+         !it->Equals(*end); it->Advance()) {
+      consumer->Accept(*it->Current());
+    }
+  }
 };
 
 // Wraps ParamGeneratorInterface<T> and provides general generator syntax
@@ -160,6 +195,15 @@ class ParamGenerator {
   iterator begin() const { return iterator(impl_->Begin()); }
   iterator end() const { return iterator(impl_->End()); }
 
+  // Calls function(element) for every element, in order.  Unlike going
+  // from begin() to end(), this costs one indirect call per element and
+  // no allocations; parameterized tests are registered this way.
+  template <typename Function>
+  void ForEach(Function function) const {
+    FunctionParamConsumer<T, Function> consumer(&function);
+    impl_->Generate(&consumer);
+  }
+
  private:
   std::shared_ptr<const ParamGeneratorInterface<T> > impl_;
 };
@@ -182,6 +226,13 @@ class RangeGenerator : public ParamGeneratorInterface<T> {
   ParamIteratorInterface<T>* End() const override {
     return new Iterator(this, end_, end_index_, step_);
   }
+  void Generate(ParamConsumer<T>* consumer) const override {
+    T value = begin_;
+    for (int index = 0; index < end_index_;
+         ++index, value = static_cast<T>(value + step_)) {
+      consumer->Accept(value);
+    }
+  }
 
  private:
   class Iterator : public ParamIteratorInterface<T> {
@@ -256,9 +307,14 @@ class RangeGenerator : public ParamGeneratorInterface<T> {
 template <typename T>
 class ValuesInIteratorRangeGenerator : public ParamGeneratorInterface<T> {
  public:
+  typedef typename ::std::vector<T> ContainerType;
+
   template <typename ForwardIterator>
   ValuesInIteratorRangeGenerator(ForwardIterator begin, ForwardIterator end)
       : container_(begin, end) {}
+  // Takes over the values, e.g. the ones Values() has just converted.
+  explicit ValuesInIteratorRangeGenerator(ContainerType&& values)
+      : container_(std::move(values)) {}
   ~ValuesInIteratorRangeGenerator() override {}
 
   ParamIteratorInterface<T>* Begin() const override {
@@ -267,9 +323,13 @@ class ValuesInIteratorRangeGenerator : public ParamGeneratorInterface<T> {
   ParamIteratorInterface<T>* End() const override {
     return new Iterator(this, container_.end());
   }
+  void Generate(ParamConsumer<T>* consumer) const override {
+    for (const T& value : container_) {
+      consumer->Accept(value);
+    }
+  }
 
  private:
-  typedef typename ::std::vector<T> ContainerType;
 
   class Iterator : public ParamIteratorInterface<T> {
    public:
@@ -442,6 +502,12 @@ class ParameterizedTestSuiteInfoBase {
 JMSD_DEPRECATED_GTEST_API_ void InsertSyntheticTestCase(const std::string& name,
                                         CodeLocation location);
 
+// Returns true if the given instance of a value-parameterized test is to
+// be registered: always, unless --cutf_lazy_parameterized_tests is
+// specified, in which case only if the filter selects it.
+JMSD_DEPRECATED_GTEST_API_ bool ShouldRegisterParameterizedTest(
+    const std::string& test_suite_name, const std::string& test_name);
+
 // INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
 //
 // ParameterizedTestSuiteInfo accumulates tests obtained from TEST_P
@@ -517,16 +583,13 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
         test_suite_name += test_info->test_suite_base_name;
 
         size_t i = 0;
-        std::set<std::string> test_param_names;
-        for (typename ParamGenerator<ParamType>::iterator param_it =
-                 generator.begin();
-             param_it != generator.end(); ++param_it, ++i) {
+        std::unordered_set<std::string> test_param_names;
+        generator.ForEach([&](const ParamType& param) {
+          const size_t index = i++;
           generated_instantiations = true;
 
-          ::jmsd::cutf::Message test_name_stream;
-
           std::string param_name = name_func(
-              TestParamInfo<ParamType>(*param_it, i));
+              TestParamInfo<ParamType>(param, index));
 
           GTEST_CHECK_(IsValidParamName(param_name))
               << "Parameterized test name '" << param_name
@@ -539,16 +602,24 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
 
           test_param_names.insert(param_name);
 
-          test_name_stream << test_info->test_base_name << "/" << param_name;
+          std::string test_name = test_info->test_base_name;
+          test_name += "/";
+          test_name += param_name;
+
+          // The instances left out don't get a TestInfo or a factory,
+          // and their parameter is never printed.
+          if (!ShouldRegisterParameterizedTest(test_suite_name, test_name))
+            return;
+
           ::jmsd::cutf::internal::function_Make_and_register_test_info::MakeAndRegisterTestInfo(
-              test_suite_name.c_str(), test_name_stream.GetString().c_str(),
+              test_suite_name.c_str(), test_name.c_str(),
               nullptr,  // No type parameter.
-              PrintToString(*param_it).c_str(), code_location_,
+              PrintToString(param).c_str(), code_location_,
               GetTestSuiteTypeId(),
               SuiteApiResolver<TestSuite>::GetSetUpCaseOrSuite(file, line),
               SuiteApiResolver<TestSuite>::GetTearDownCaseOrSuite(file, line),
-              test_info->test_meta_factory->CreateTestFactory(*param_it));
-        }  // for param_it
+              test_info->test_meta_factory->CreateTestFactory(param));
+        });  // ForEach param
       }  // for gen_it
     }  // for test_it
 
@@ -711,7 +782,8 @@ class ValueArray {
 
   template <typename T>
   operator ParamGenerator<T>() const {  // NOLINT
-    return ValuesIn(MakeVector<T>(MakeIndexSequence<sizeof...(Ts)>()));
+    return ParamGenerator<T>(new ValuesInIteratorRangeGenerator<T>(
+        MakeVector<T>(MakeIndexSequence<sizeof...(Ts)>())));
   }
 
  private:
@@ -740,7 +812,41 @@ class CartesianProductGenerator
     return new Iterator(this, generators_, true);
   }
 
+  // Nested loops over the component generators, the last one innermost.
+  // The tuple is built from the current element of every loop right before
+  // it is passed on, so no iterator state lives on the heap.
+  void Generate(ParamConsumer<ParamType>* consumer) const override {
+    std::tuple<const T*...> current;
+    GenerateFrom<0>(&current, consumer);
+  }
+
  private:
+  template <size_t K>
+  typename std::enable_if<(K < sizeof...(T))>::type GenerateFrom(
+      std::tuple<const T*...>* current,
+      ParamConsumer<ParamType>* consumer) const {
+    using ValueType = typename std::tuple_element<K, ParamType>::type;
+
+    std::get<K>(generators_).ForEach([this, current, consumer](
+                                         const ValueType& value) {
+      std::get<K>(*current) = &value;
+      GenerateFrom<K + 1>(current, consumer);
+    });
+  }
+
+  template <size_t K>
+  typename std::enable_if<(K == sizeof...(T))>::type GenerateFrom(
+      std::tuple<const T*...>* current,
+      ParamConsumer<ParamType>* consumer) const {
+    Accept(*current, consumer, MakeIndexSequence<sizeof...(T)>());
+  }
+
+  template <size_t... I>
+  static void Accept(const std::tuple<const T*...>& current,
+                     ParamConsumer<ParamType>* consumer, IndexSequence<I...>) {
+    consumer->Accept(ParamType(*std::get<I>(current)...));
+  }
+
   template <class I>
   class IteratorImpl;
   template <size_t... I>
@@ -195,6 +195,7 @@
 // Integer types:
 //   TypeWithSize   - maps an integer to a int type.
 //   TimeInMillis   - integers of known sizes.
+//   TimeInNanos
 //   BiggestInt     - the biggest signed integer type.
 //
 // Command-line utilities:
@@ -252,6 +253,11 @@
 # define GTEST_PROJECT_URL_ "https://github.com/google/googletest/"
 #endif  // !defined(GTEST_DEV_EMAIL_)
 
+// Flags can also be spelled with the framework's own prefix, e.g. --cutf_jobs.
+#if !defined(JMSD_CUTF_FLAG_PREFIX_)
+# define JMSD_CUTF_FLAG_PREFIX_ "cutf_"
+#endif  // !defined(JMSD_CUTF_FLAG_PREFIX_)
+
 #if !defined(GTEST_INIT_GOOGLE_TEST_NAME_)
 # define GTEST_INIT_GOOGLE_TEST_NAME_ "testing::InitGoogleTest"
 #endif  // !defined(GTEST_INIT_GOOGLE_TEST_NAME_)
@@ -1229,6 +1235,13 @@ class JMSD_DEPRECATED_GTEST_API_ Notification {
 };
 # endif  // GTEST_HAS_NOTIFICATION_
 
+// The test result that the failures of the calling thread go to, as an
+// opaque pointer.  A thread started by ThreadWithParam adopts the one of the
+// thread that started it, so its failures go to the test that started it
+// even when that test runs on a worker thread of --cutf_jobs.
+JMSD_DEPRECATED_GTEST_API_ void* GetTestResultOfCurrentThread();
+JMSD_DEPRECATED_GTEST_API_ void SetTestResultOfCurrentThread(void* test_result);
+
 // On MinGW, we can have both GTEST_OS_WINDOWS and GTEST_HAS_PTHREAD
 // defined, but we don't want to use MinGW's pthreads implementation, which
 // has conformance problems with some versions of the POSIX standard.
@@ -1277,6 +1290,7 @@ class ThreadWithParam : public ThreadWithParamBase {
       : func_(func),
         param_(param),
         thread_can_start_(thread_can_start),
+        test_result_(GetTestResultOfCurrentThread()),
         finished_(false) {
     ThreadWithParamBase* const base = this;
     // The thread can be created only after all fields except thread_
@@ -1294,6 +1308,7 @@ class ThreadWithParam : public ThreadWithParamBase {
   }
 
   void Run() override {
+    SetTestResultOfCurrentThread(test_result_);
     if (thread_can_start_ != nullptr) thread_can_start_->WaitForNotification();
     func_(param_);
   }
@@ -1304,6 +1319,8 @@ class ThreadWithParam : public ThreadWithParamBase {
   // When non-NULL, used to block execution until the controller thread
   // notifies.
   Notification* const thread_can_start_;
+  // The test result of the thread that created this one.
+  void* const test_result_;
   bool finished_;  // true if and only if we know that the thread function has
                    // finished.
   pthread_t thread_;  // The native thread object.
@@ -2118,6 +2135,7 @@ class TypeWithSize<8> {
 
 // Integer types of known sizes.
 using TimeInMillis = int64_t;  // Represents time in milliseconds.
+using TimeInNanos = int64_t;  // Represents time in nanoseconds.
 
 // Utilities for command line flags and environment variables.
 
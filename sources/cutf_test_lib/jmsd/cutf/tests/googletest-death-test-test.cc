@@ -59,6 +59,7 @@ using testing::internal::AlwaysTrue;
 
 # include "gtest/gtest-spi.h"
 # include "src/gtest-internal-inl.h"
+# include "gtest/internal/Death_test_reactor.h"
 
 namespace posix = ::testing::internal::posix;
 
@@ -9,6 +9,7 @@
 #include "gtest/internal/gtest-filepath.h"
 #include "gtest/gtest.h"
 #include "gtest/gtest-internal-inl.h"
+#include "gtest/internal/Test_isolation.h"
 
 #include "gtest/Assertion_result.hin"
 #include "gtest/Message.hin"
@@ -45,6 +46,9 @@ int _rmdir(const char* path) {
 #else
 
 TEST(GetCurrentDirTest, ReturnsCurrentDir) {
+  // The working directory belongs to the whole process.
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+
   const FilePath original_dir = FilePath::GetCurrentDir();
   EXPECT_FALSE(original_dir.IsEmpty());
 
@@ -50,6 +50,7 @@ EXPECTED_1 = {
         0,
     u'time':
         u'*',
+    u'time_ns': u'*',
     u'timestamp':
         u'*',
     u'name':
@@ -67,6 +68,7 @@ EXPECTED_1 = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -74,6 +76,7 @@ EXPECTED_1 = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'PropertyOne',
             u'SetUpProp': u'1',
@@ -94,6 +97,7 @@ EXPECTED_2 = {
         0,
     u'time':
         u'*',
+    u'time_ns': u'*',
     u'timestamp':
         u'*',
     u'name':
@@ -111,6 +115,7 @@ EXPECTED_2 = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -119,6 +124,7 @@ EXPECTED_2 = {
             u'result': u'COMPLETED',
             u'timestamp': u'*',
             u'time': u'*',
+            u'time_ns': u'*',
             u'classname': u'PropertyTwo',
             u'SetUpProp': u'2',
             u'TestSomeProperty': u'2',
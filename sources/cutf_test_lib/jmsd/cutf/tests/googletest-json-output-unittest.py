@@ -46,7 +46,8 @@ GTEST_OUTPUT_FLAG = '--gtest_output'
 GTEST_DEFAULT_OUTPUT_FILE = 'test_detail.json'
 GTEST_PROGRAM_NAME = 'gtest_xml_output_unittest_'
 
-# The flag indicating stacktraces are not supported
+# The flag indicating stacktraces are not supported.  Builds with absl and
+# Linux builds with GCC or Clang print them; the other builds need the flag.
 NO_STACKTRACE_SUPPORT_FLAG = '--no_stacktrace_support'
 
 SUPPORTS_STACK_TRACES = NO_STACKTRACE_SUPPORT_FLAG not in sys.argv
@@ -69,6 +70,7 @@ EXPECTED_NON_EMPTY = {
         u'*',
     u'time':
         u'*',
+    u'time_ns': u'*',
     u'ad_hoc_property':
         u'42',
     u'name':
@@ -86,6 +88,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -93,6 +96,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'SuccessfulTest'
         }]
@@ -109,6 +113,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -120,6 +125,7 @@ EXPECTED_NON_EMPTY = {
                 u'COMPLETED',
             u'time':
                 u'*',
+            u'time_ns': u'*',
             u'timestamp':
                 u'*',
             u'classname':
@@ -144,6 +150,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -151,6 +158,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'NOTRUN',
             u'result': u'SUPPRESSED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'DisabledTest'
         }]
@@ -167,6 +175,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -174,6 +183,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'SKIPPED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'SkippedTest'
         }]
@@ -190,6 +200,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -197,6 +208,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'MixedResultTest'
         }, {
@@ -208,6 +220,7 @@ EXPECTED_NON_EMPTY = {
                 u'COMPLETED',
             u'time':
                 u'*',
+            u'time_ns': u'*',
             u'timestamp':
                 u'*',
             u'classname':
@@ -228,6 +241,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'NOTRUN',
             u'result': u'SUPPRESSED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'MixedResultTest'
         }]
@@ -244,6 +258,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -255,6 +270,7 @@ EXPECTED_NON_EMPTY = {
                 u'COMPLETED',
             u'time':
                 u'*',
+            u'time_ns': u'*',
             u'timestamp':
                 u'*',
             u'classname':
@@ -280,6 +296,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -291,6 +308,7 @@ EXPECTED_NON_EMPTY = {
                 u'COMPLETED',
             u'time':
                 u'*',
+            u'time_ns': u'*',
             u'timestamp':
                 u'*',
             u'classname':
@@ -315,6 +333,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'SetUpTestSuite':
@@ -326,6 +345,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'PropertyRecordingTest',
             u'key_1': u'1'
@@ -334,6 +354,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'PropertyRecordingTest',
             u'key_int': u'1'
@@ -342,6 +363,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'PropertyRecordingTest',
             u'key_1': u'1',
@@ -352,6 +374,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'PropertyRecordingTest',
             u'key_1': u'2'
@@ -369,6 +392,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -376,6 +400,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'NoFixtureTest',
             u'key': u'1'
@@ -384,6 +409,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'NoFixtureTest',
             u'key_for_utility_int': u'1'
@@ -392,6 +418,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'NoFixtureTest',
             u'key_for_utility_string': u'1'
@@ -409,6 +436,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -417,6 +445,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'TypedTest/0'
         }]
@@ -433,6 +462,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -441,6 +471,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'TypedTest/1'
         }]
@@ -457,6 +488,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -465,6 +497,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'Single/TypeParameterizedTestSuite/0'
         }]
@@ -481,6 +514,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -489,6 +523,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'Single/TypeParameterizedTestSuite/1'
         }]
@@ -505,6 +540,7 @@ EXPECTED_NON_EMPTY = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -513,6 +549,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'Single/ValueParamTest'
         }, {
@@ -521,6 +558,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'Single/ValueParamTest'
         }, {
@@ -529,6 +567,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'Single/ValueParamTest'
         }, {
@@ -537,6 +576,7 @@ EXPECTED_NON_EMPTY = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'Single/ValueParamTest'
         }]
@@ -554,6 +594,7 @@ EXPECTED_FILTERED = {
         0,
     u'time':
         u'*',
+    u'time_ns': u'*',
     u'timestamp':
         u'*',
     u'name':
@@ -573,6 +614,7 @@ EXPECTED_FILTERED = {
             0,
         u'time':
             u'*',
+        u'time_ns': u'*',
         u'timestamp':
             u'*',
         u'testsuite': [{
@@ -580,6 +622,7 @@ EXPECTED_FILTERED = {
             u'status': u'RUN',
             u'result': u'COMPLETED',
             u'time': u'*',
+            u'time_ns': u'*',
             u'timestamp': u'*',
             u'classname': u'SuccessfulTest',
         }]
@@ -592,6 +635,7 @@ EXPECTED_EMPTY = {
     u'disabled': 0,
     u'errors': 0,
     u'time': u'*',
+    u'time_ns': u'*',
     u'timestamp': u'*',
     u'name': u'AllTests',
     u'testsuites': [],
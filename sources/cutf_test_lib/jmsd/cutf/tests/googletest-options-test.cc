@@ -13,6 +13,7 @@
 #include "gtest/Assertion_result.hin"
 #include "gtest/Message.hin"
 
+#include "gtest/internal/Test_isolation.h"
 #include "gtest/internal/Unit_test_options.h"
 
 #include "gtest/gtest-internal-inl.h"
@@ -36,29 +37,37 @@ FilePath GetAbsolutePathOf(const FilePath& relative_path) {
 
 // Testing UnitTestOptions::GetOutputFormat/GetOutputFile.
 
-TEST(XmlOutputTest, GetOutputFormatDefault) {
+// The tests change the output flag.
+class XmlOutputTest : public ::jmsd::cutf::Test {
+ protected:
+  void SetUp() override {
+    ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+  }
+};
+
+TEST_F(XmlOutputTest, GetOutputFormatDefault) {
   GTEST_FLAG(output) = "";
   EXPECT_STREQ("", ::jmsd::cutf::internal::UnitTestOptions::GetOutputFormat().c_str());
 }
 
-TEST(XmlOutputTest, GetOutputFormat) {
+TEST_F(XmlOutputTest, GetOutputFormat) {
   GTEST_FLAG(output) = "xml:filename";
   EXPECT_STREQ("xml", ::jmsd::cutf::internal::UnitTestOptions::GetOutputFormat().c_str());
 }
 
-TEST(XmlOutputTest, GetOutputFileDefault) {
+TEST_F(XmlOutputTest, GetOutputFileDefault) {
   GTEST_FLAG(output) = "";
   EXPECT_EQ(GetAbsolutePathOf(FilePath("test_detail.xml")).string(),
             ::jmsd::cutf::internal::UnitTestOptions::GetAbsolutePathToOutputFile());
 }
 
-TEST(XmlOutputTest, GetOutputFileSingleFile) {
+TEST_F(XmlOutputTest, GetOutputFileSingleFile) {
   GTEST_FLAG(output) = "xml:filename.abc";
   EXPECT_EQ(GetAbsolutePathOf(FilePath("filename.abc")).string(),
             ::jmsd::cutf::internal::UnitTestOptions::GetAbsolutePathToOutputFile());
 }
 
-TEST(XmlOutputTest, GetOutputFileFromDirectoryPath) {
+TEST_F(XmlOutputTest, GetOutputFileFromDirectoryPath) {
   GTEST_FLAG(output) = "xml:path" GTEST_PATH_SEP_;
   const std::string expected_output_file =
       GetAbsolutePathOf(
@@ -104,7 +113,9 @@ TEST(OutputFileHelpersTest, DISABLED_GetCurrentExecutableName) {
 
 class XmlOutputChangeDirTest : public ::jmsd::cutf::Test {
  protected:
+  // The working directory and the output flag belong to the whole process.
   void SetUp() override {
+    ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
     original_working_dir_ = FilePath::GetCurrentDir();
     posix::ChDir("..");
     // This will make the test fail if run from the root directory.
@@ -49,7 +49,8 @@ import gtest_test_utils
 GENGOLDEN_FLAG = '--gengolden'
 CATCH_EXCEPTIONS_ENV_VAR_NAME = 'GTEST_CATCH_EXCEPTIONS'
 
-# The flag indicating stacktraces are not supported
+# The flag indicating stacktraces are not supported.  Builds with absl and
+# Linux builds with GCC or Clang print them; the other builds need the flag.
 NO_STACKTRACE_SUPPORT_FLAG = '--no_stacktrace_support'
 
 IS_LINUX = os.name == 'posix' and os.uname()[0] == 'Linux'
@@ -122,7 +123,7 @@ def RemoveStackTraces(output):
 def RemoveTime(output):
   """Removes all time information from a Google Test program's output."""
 
-  return re.sub(r'\(\d+ ms', '(? ms', output)
+  return re.sub(r'\(\d+(\.\d+)? ms', '(? ms', output)
 
 
 def RemoveTypeInfoDetails(test_output):
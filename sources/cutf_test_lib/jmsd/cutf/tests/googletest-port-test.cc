@@ -10,6 +10,7 @@
 #include "gtest/Static_assert_type_sameness.hin"
 
 #include "gtest/internal/Random_number_generator.h"
+#include "gtest/internal/Test_isolation.h"
 
 #include "gtest/internal/gtest-port.h"
 
@@ -259,6 +260,9 @@ void* ThreadFunc(void* data) {
 }
 
 TEST(GetThreadCountTest, ReturnsCorrectValue) {
+  // The threads of the tests running meanwhile would be counted too.
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+
   const size_t starting_count = GetThreadCount();
   pthread_t       thread_id;
 
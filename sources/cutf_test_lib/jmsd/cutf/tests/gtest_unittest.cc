@@ -44,12 +44,24 @@ TEST(CommandLineFlagsTest, CanBeAccessedInCodeOnceGTestHIsIncluded) {
 #include "gtest/internal/function_Int32_from_environment_or_die.h"
 #include "gtest/internal/function_Should_shard.h"
 #include "gtest/internal/function_Should_run_test_on_shard.h"
+#include "gtest/internal/Shard_planner.h"
+#include "gtest/internal/Compiled_filter.h"
+#include "gtest/internal/Xml_unit_test_result_printer.h"
+#include "gtest/internal/Json_test_result_printer.h"
+#include "gtest/internal/Report_file_buffer.h"
+#include "gtest/internal/Unit_test_options.h"
 #include "gtest/internal/Format_time.h"
 #include "gtest/internal/Colored_print.h"
+#include "gtest/internal/Console_output.h"
+#include "gtest/internal/Stack_trace.h"
 #include "gtest/internal/Distance_editor.h"
+#include "gtest/internal/Test_isolation.h"
+#include "gtest/internal/Death_test_reactor.h"
 #include "gtest/internal/Assertion_result_constructor.h"
 //#include "gtest/Floating_point_comparator.h"
 #include "gtest/internal/Abstract_socket_writer.h"
+#include "gtest/internal/Async_socket_writer.h"
+#include "gtest/internal/Socket_writer.h"
 #include "gtest/internal/Streaming_listener.h"
 #include "gtest/internal/utf8_utilities.h"
 #include "gtest/internal/gtest-flags-internal.h"
@@ -61,14 +73,34 @@ TEST(CommandLineFlagsTest, CanBeAccessedInCodeOnceGTestHIsIncluded) {
 #include "gtest/internal/Floating_point_comparator.hin"
 #include "gtest/internal/Floating_point_type.hin"
 
+#include "jmsd/ctf/modification/Configurable_event_listener.h"
+
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#if GTEST_OS_LINUX
+#include <dirent.h>
+#include <stdio_ext.h>
+#include <unistd.h>
+#endif  // GTEST_OS_LINUX
+
+#if GTEST_CAN_STREAM_RESULTS_
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <ostream>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
 #include <vector>
@@ -151,6 +183,157 @@ TEST_F(StreamingListenerTest, OnTestPartResult) {
 	  *output());
 }
 
+// A socket writer whose SendBatch() waits until it is let go, to keep the
+// thread of an AsyncSocketWriter busy while the ring fills up.
+class GatedSocketWriter : public ::jmsd::cutf::internal::AbstractSocketWriter {
+ public:
+  GatedSocketWriter(std::string* output, bool* is_closed)
+	  : output_(output), is_closed_(is_closed), is_entered_(false), is_open_(false) {}
+
+  void Send(const std::string& message) override { *output_ += message; }
+
+  void SendBatch(const std::string* messages, size_t count) override {
+	std::unique_lock<std::mutex> lock(mutex_);
+	is_entered_ = true;
+	entered_.notify_all();
+	opened_.wait(lock, [this] { return is_open_; });
+	AbstractSocketWriter::SendBatch(messages, count);
+  }
+
+  void CloseConnection() override { *is_closed_ = true; }
+
+  void WaitUntilEntered() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	entered_.wait(lock, [this] { return is_entered_; });
+  }
+
+  void Open() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	is_open_ = true;
+	opened_.notify_all();
+  }
+
+ private:
+  std::string* const output_;
+  bool* const is_closed_;
+  std::mutex mutex_;
+  std::condition_variable entered_;
+  std::condition_variable opened_;
+  bool is_entered_;
+  bool is_open_;
+};
+
+// Tests that AsyncSocketWriter sends everything it was given, in order,
+// before it closes the writer it wraps.
+TEST(AsyncSocketWriterTest, FlushesBeforeClosing) {
+  std::string output;
+  bool is_closed = false;
+  GatedSocketWriter* const gated_writer = new GatedSocketWriter(&output, &is_closed);
+  gated_writer->Open();
+  ::jmsd::cutf::internal::AsyncSocketWriter writer(
+	  gated_writer, 4, ::jmsd::cutf::internal::AsyncSocketWriter::kBlockOnOverflow);
+
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+	const std::string message = "event=" + std::to_string(i);
+	writer.SendLn(message);
+	expected += message + "\n";
+  }
+  writer.CloseConnection();
+
+  EXPECT_TRUE(is_closed);
+  EXPECT_EQ(expected, output);
+  EXPECT_EQ(0u, writer.dropped_count());
+}
+
+// Tests that AsyncSocketWriter with the drop policy counts the strings that
+// don't fit into the ring instead of waiting.
+TEST(AsyncSocketWriterTest, DropsWhenFull) {
+  std::string output;
+  bool is_closed = false;
+  GatedSocketWriter* const gated_writer = new GatedSocketWriter(&output, &is_closed);
+  ::jmsd::cutf::internal::AsyncSocketWriter writer(
+	  gated_writer, 2, ::jmsd::cutf::internal::AsyncSocketWriter::kDropOnOverflow);
+
+  writer.Send("a");
+  gated_writer->WaitUntilEntered();
+  writer.Send("b");
+  writer.Send("c");
+  writer.Send("d");
+  writer.Send("e");
+  EXPECT_EQ(2u, writer.dropped_count());
+
+  gated_writer->Open();
+  writer.CloseConnection();
+
+  EXPECT_TRUE(is_closed);
+  EXPECT_EQ("abc", output);
+}
+
+TEST(AsyncSocketWriterTest, ParsesOverflowPolicy) {
+  ::jmsd::cutf::internal::AsyncSocketWriter::OverflowPolicy policy =
+	  ::jmsd::cutf::internal::AsyncSocketWriter::kBlockOnOverflow;
+  EXPECT_TRUE(::jmsd::cutf::internal::AsyncSocketWriter::ParseOverflowPolicy("drop", &policy));
+  EXPECT_EQ(::jmsd::cutf::internal::AsyncSocketWriter::kDropOnOverflow, policy);
+  EXPECT_TRUE(::jmsd::cutf::internal::AsyncSocketWriter::ParseOverflowPolicy("block", &policy));
+  EXPECT_EQ(::jmsd::cutf::internal::AsyncSocketWriter::kBlockOnOverflow, policy);
+  EXPECT_FALSE(::jmsd::cutf::internal::AsyncSocketWriter::ParseOverflowPolicy("wait", &policy));
+}
+
+// Tests streaming through an AsyncSocketWriter and a real socket to a
+// collector listening on the loopback interface.
+TEST(AsyncSocketWriterTest, StreamsToLoopbackCollector) {
+  const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_NE(-1, listen_fd);
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  socklen_t address_length = sizeof(address);
+  ASSERT_EQ(0, bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+  ASSERT_EQ(0, listen(listen_fd, 1));
+  ASSERT_EQ(0, getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &address_length));
+
+  std::string expected;
+  {
+	::jmsd::cutf::internal::StreamingListener streamer(
+		new ::jmsd::cutf::internal::AsyncSocketWriter(
+			new ::jmsd::cutf::internal::SocketWriter(
+				"127.0.0.1", std::to_string(ntohs(address.sin_port))),
+			4, ::jmsd::cutf::internal::AsyncSocketWriter::kBlockOnOverflow));
+	expected += "gtest_streaming_protocol_version=1.0\n";
+
+	for (int i = 0; i < 50; ++i) {
+	  streamer.OnTestSuiteStart( ::jmsd::cutf::TestSuite( "FooTest", "Bar", nullptr, nullptr ) );
+	  expected += "event=TestSuiteStart&name=FooTest\n";
+	}
+
+	// Closes the connection after sending everything streamed so far.
+	// The result depends on the tests run before this one.
+	streamer.OnTestProgramEnd(*::jmsd::cutf::UnitTest::GetInstance());
+	expected += "event=TestProgramEnd&passed=";
+  }
+
+  const int collector_fd = accept(listen_fd, nullptr, nullptr);
+  ASSERT_NE(-1, collector_fd);
+
+  std::string received;
+  char buffer[256];
+  for (;;) {
+	const ssize_t length = read(collector_fd, buffer, sizeof(buffer));
+	if (length <= 0) break;
+	received.append(buffer, static_cast<size_t>(length));
+  }
+  close(collector_fd);
+  close(listen_fd);
+
+  ASSERT_EQ(expected.length() + 2, received.length());
+  EXPECT_EQ(expected, received.substr(0, expected.length()));
+  EXPECT_EQ('\n', received.back());
+}
+
 #endif  // GTEST_CAN_STREAM_RESULTS_
 
 // Provides access to otherwise private parts of the TestEventListeners class
@@ -202,16 +385,24 @@ using ::testing::GTEST_FLAG(also_run_disabled_tests);
 using ::testing::GTEST_FLAG(break_on_failure);
 using ::testing::GTEST_FLAG(catch_exceptions);
 using ::testing::GTEST_FLAG(color);
+using ::testing::GTEST_FLAG(console_buffer);
+using ::testing::GTEST_FLAG(death_test_jobs);
 using ::testing::GTEST_FLAG(death_test_use_fork);
 using ::testing::GTEST_FLAG(filter);
+using ::testing::GTEST_FLAG(jobs);
+using ::testing::GTEST_FLAG(lazy_parameterized_tests);
 using ::testing::GTEST_FLAG(list_tests);
 using ::testing::GTEST_FLAG(output);
 using ::testing::GTEST_FLAG(print_time);
 using ::testing::GTEST_FLAG(random_seed);
 using ::testing::GTEST_FLAG(repeat);
+using ::testing::GTEST_FLAG(shard_durations);
 using ::testing::GTEST_FLAG(show_internal_stack_frames);
 using ::testing::GTEST_FLAG(shuffle);
 using ::testing::GTEST_FLAG(stack_trace_depth);
+using ::testing::GTEST_FLAG(stream_output);
+using ::testing::GTEST_FLAG(stream_result_buffer);
+using ::testing::GTEST_FLAG(stream_result_overflow);
 using ::testing::GTEST_FLAG(stream_result_to);
 using ::testing::GTEST_FLAG(throw_on_failure);
 
@@ -403,6 +594,16 @@ TEST(FormatTimeInMillisAsSecondsTest, FormatsNegativeNumber) {
   EXPECT_EQ("-3", ::jmsd::cutf::internal::Format_time::FormatTimeInMillisAsSeconds(-3000));
 }
 
+// Tests FormatTimeInNanosAsMillis().
+TEST(FormatTimeInNanosAsMillisTest, FormatsToTheMicrosecond) {
+  EXPECT_EQ("0.000", ::jmsd::cutf::internal::Format_time::FormatTimeInNanosAsMillis(0));
+  EXPECT_EQ("0.000", ::jmsd::cutf::internal::Format_time::FormatTimeInNanosAsMillis(999));
+  EXPECT_EQ("0.001", ::jmsd::cutf::internal::Format_time::FormatTimeInNanosAsMillis(1000));
+  EXPECT_EQ("0.250", ::jmsd::cutf::internal::Format_time::FormatTimeInNanosAsMillis(250000));
+  EXPECT_EQ("12.345", ::jmsd::cutf::internal::Format_time::FormatTimeInNanosAsMillis(12345678));
+  EXPECT_EQ("3000.000", ::jmsd::cutf::internal::Format_time::FormatTimeInNanosAsMillis(3000000000));
+}
+
 // Tests FormatEpochTimeInMillisAsIso8601().  The correctness of conversion
 // for particular dates below was verified in Python using
 // datetime.datetime.fromutctimestamp(<timetamp>/1000).
@@ -438,6 +639,9 @@ class FormatEpochTimeInMillisAsIso8601Test : public Test {
   }
 
   static void SetTimeZone(const char* time_zone) {
+	// The time zone belongs to the whole process.
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+
 	// tzset() distinguishes between the TZ variable being present and empty
 	// and not being present, so we have to consider the case of time_zone
 	// being NULL.
@@ -1362,8 +1566,6 @@ TEST(TestPropertyTest, SetValue) {
 // The test fixture for testing TestResult.
 class TestResultTest : public Test {
  protected:
-  typedef std::vector<TestPartResult> TPRVector;
-
   // We make use of 2 TestPartResult objects,
   TestPartResult * pr1, * pr2;
 
@@ -1388,23 +1590,14 @@ class TestResultTest : public Test {
 	r1 = new ::jmsd::cutf::TestResult();
 	r2 = new ::jmsd::cutf::TestResult();
 
-	// In order to test TestResult, we need to modify its internal
-	// state, in particular the TestPartResult vector it holds.
-	// test_part_results() returns a const reference to this vector.
-	// We cast it to a non-const object s.t. it can be modified
-	TPRVector* results1 = const_cast<TPRVector*>(
-		&::jmsd::cutf::internal::TestResultAccessor::test_part_results(*r1));
-	TPRVector* results2 = const_cast<TPRVector*>(
-		&::jmsd::cutf::internal::TestResultAccessor::test_part_results(*r2));
-
 	// r0 is an empty TestResult.
 
 	// r1 contains a single SUCCESS TestPartResult.
-	results1->push_back(*pr1);
+	::jmsd::cutf::internal::TestResultAccessor::AddTestPartResult(r1, *pr1);
 
 	// r2 contains a SUCCESS, and a FAILURE.
-	results2->push_back(*pr1);
-	results2->push_back(*pr2);
+	::jmsd::cutf::internal::TestResultAccessor::AddTestPartResult(r2, *pr1);
+	::jmsd::cutf::internal::TestResultAccessor::AddTestPartResult(r2, *pr2);
   }
 
   void TearDown() override {
@@ -1452,6 +1645,184 @@ TEST_F(TestResultTest, Failed) {
   ASSERT_TRUE(r2->Failed());
 }
 
+// Tests TestResult::HasFatalFailure(), HasNonfatalFailure() and
+// Skipped(), which count the results as they are added.
+TEST_F(TestResultTest, TracksFailuresAndSkipsByKind) {
+  const TestPartResult nonfatal(TestPartResult::kNonFatalFailure, "foo/bar.cc",
+								10, "Failure!");
+  const TestPartResult skip(TestPartResult::kSkip, "foo/bar.cc", 10, "Skip!");
+
+  EXPECT_TRUE(r2->HasFatalFailure());
+  EXPECT_FALSE(r2->HasNonfatalFailure());
+
+  ::jmsd::cutf::internal::TestResultAccessor::AddTestPartResult(r0, skip);
+  EXPECT_TRUE(r0->Skipped());
+  EXPECT_FALSE(r0->Failed());
+
+  ::jmsd::cutf::internal::TestResultAccessor::AddTestPartResult(r0, nonfatal);
+  EXPECT_FALSE(r0->Skipped());
+  EXPECT_TRUE(r0->Failed());
+  EXPECT_TRUE(r0->HasNonfatalFailure());
+  EXPECT_FALSE(r0->HasFatalFailure());
+
+  ::jmsd::cutf::internal::TestResultAccessor::ClearTestPartResults(r0);
+  EXPECT_TRUE(r0->Passed());
+  EXPECT_FALSE(r0->Skipped());
+  EXPECT_FALSE(r0->HasNonfatalFailure());
+}
+
+// Tests that the results of other threads count at once but are listed only
+// when they are merged, in the order they were reported.
+TEST_F(TestResultTest, MergesPendingResultsInOrder) {
+  const TestPartResult fatal(TestPartResult::kFatalFailure, "foo/bar.cc",
+							 10, "First");
+  const TestPartResult nonfatal(TestPartResult::kNonFatalFailure, "foo/bar.cc",
+								20, "Second");
+
+  ::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(r0, fatal);
+  ::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(r0, nonfatal);
+  EXPECT_TRUE(r0->HasFatalFailure());
+  EXPECT_TRUE(r0->HasNonfatalFailure());
+  EXPECT_EQ(0, r0->total_part_count());
+
+  EXPECT_EQ(2, ::jmsd::cutf::internal::TestResultAccessor::MergePendingTestPartResults(r0));
+  ASSERT_EQ(2, r0->total_part_count());
+  CompareTestPartResult(fatal, r0->GetTestPartResult(0));
+  CompareTestPartResult(nonfatal, r0->GetTestPartResult(1));
+  EXPECT_EQ(0, ::jmsd::cutf::internal::TestResultAccessor::MergePendingTestPartResults(r0));
+
+  ::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(r0, nonfatal);
+  ::jmsd::cutf::internal::TestResultAccessor::ClearTestPartResults(r0);
+  EXPECT_TRUE(r0->Passed());
+  EXPECT_EQ(0, ::jmsd::cutf::internal::TestResultAccessor::MergePendingTestPartResults(r0));
+}
+
+// Tests that a closed TestResult refuses the results of other threads
+// without counting them, and that clearing it reopens it.
+TEST_F(TestResultTest, RefusesPendingResultsOnceClosed) {
+  const TestPartResult nonfatal(TestPartResult::kNonFatalFailure, "foo/bar.cc",
+								20, "Late");
+
+  ASSERT_TRUE(::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(r0, nonfatal));
+  EXPECT_EQ(1, ::jmsd::cutf::internal::TestResultAccessor::MergeAndClosePendingTestPartResults(r0));
+  EXPECT_EQ(1, r0->total_part_count());
+
+  EXPECT_FALSE(::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(r0, nonfatal));
+  EXPECT_EQ(0, ::jmsd::cutf::internal::TestResultAccessor::MergePendingTestPartResults(r0));
+  EXPECT_EQ(1, r0->total_part_count());
+
+  ::jmsd::cutf::internal::TestResultAccessor::ClearTestPartResults(r0);
+  EXPECT_TRUE(::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(r0, nonfatal));
+  EXPECT_TRUE(r0->HasNonfatalFailure());
+  EXPECT_EQ(1, ::jmsd::cutf::internal::TestResultAccessor::MergePendingTestPartResults(r0));
+  ::jmsd::cutf::internal::TestResultAccessor::ClearTestPartResults(r0);
+}
+
+#if GTEST_IS_THREADSAFE
+
+static void SucceedInOtherThread(const char* message) {
+  SUCCEED() << message;
+}
+
+// Tests that a test lists the results of the threads it starts once its own
+// thread reports something.
+TEST(PendingTestPartResultTest, ListsResultsOfOtherThreadsWhenMerged) {
+  const ::jmsd::cutf::TestResult& result =
+	  *::jmsd::cutf::UnitTest::GetInstance()->current_test_info()->result();
+  const int count_before = result.total_part_count();
+
+  ::testing::internal::ThreadWithParam<const char*> thread(
+	  &SucceedInOtherThread, "in the other thread", nullptr);
+  thread.Join();
+  const int count_before_merge = result.total_part_count();
+
+  SUCCEED() << "in this thread";
+  ASSERT_EQ(count_before + 2, result.total_part_count());
+  EXPECT_EQ(count_before, count_before_merge);
+  EXPECT_PRED_FORMAT2(::jmsd::cutf::Substring_assertions::IsSubstring,
+					  "in the other thread",
+					  result.GetTestPartResult(count_before).message());
+  EXPECT_PRED_FORMAT2(::jmsd::cutf::Substring_assertions::IsSubstring,
+					  "in this thread",
+					  result.GetTestPartResult(count_before + 1).message());
+}
+
+static void GetTestResultInOtherThread(const ::jmsd::cutf::TestResult** result) {
+  *result = ::jmsd::cutf::internal::GetUnitTestImpl()->current_test_result();
+}
+
+// Tests that the threads a test starts report to that test, also when it
+// runs on a worker thread.
+TEST(PendingTestPartResultTest, OtherThreadsReportToTheTestThatStartedThem) {
+  const ::jmsd::cutf::TestResult* result_in_other_thread = nullptr;
+
+  ::testing::internal::ThreadWithParam<const ::jmsd::cutf::TestResult**> thread(
+	  &GetTestResultInOtherThread, &result_in_other_thread, nullptr);
+  thread.Join();
+
+  EXPECT_EQ(::jmsd::cutf::UnitTest::GetInstance()->current_test_info()->result(),
+			result_in_other_thread);
+}
+
+// Tests that a thread that a test starts without ThreadWithParam reports to
+// that test, also when it runs on a worker thread (where the thread can't
+// be told apart from those of the other running tests, so this one runs
+// alone).
+TEST(PendingTestPartResultTest, StdThreadsReportToTheRunningTest) {
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+  const ::jmsd::cutf::TestResult& result =
+	  *::jmsd::cutf::UnitTest::GetInstance()->current_test_info()->result();
+  const int count_before = result.total_part_count();
+
+  std::thread thread([] { SUCCEED() << "in a std::thread"; });
+  thread.join();
+
+  SUCCEED() << "in this thread";
+  ASSERT_EQ(count_before + 2, result.total_part_count());
+  EXPECT_PRED_FORMAT2(::jmsd::cutf::Substring_assertions::IsSubstring,
+					  "in a std::thread",
+					  result.GetTestPartResult(count_before).message());
+}
+
+static void AddPendingFailureInOtherThread(::jmsd::cutf::TestResult* result) {
+  ::jmsd::cutf::internal::TestResultAccessor::AddPendingTestPartResult(
+	  result, TestPartResult(TestPartResult::kNonFatalFailure, "foo/bar.cc",
+							 10, "Racing"));
+}
+
+// Tests that a TestResult closed while another thread reports to it fails
+// if and only if it lists the failure.
+TEST(PendingTestPartResultTest, ClosedResultCountsOnlyListedResults) {
+  for (int i = 0; i < 200; ++i) {
+	::jmsd::cutf::TestResult result;
+	::testing::internal::ThreadWithParam<::jmsd::cutf::TestResult*> thread(
+		&AddPendingFailureInOtherThread, &result, nullptr);
+	::jmsd::cutf::internal::TestResultAccessor::MergeAndClosePendingTestPartResults(&result);
+	const bool failed = result.Failed();
+	const int count = result.total_part_count();
+	thread.Join();
+
+	ASSERT_EQ(failed, count > 0) << "iteration " << i;
+	ASSERT_EQ(failed, result.Failed()) << "iteration " << i;
+  }
+}
+
+#endif  // GTEST_IS_THREADSAFE
+
+// Tests that a test runs alone on the workers of --cutf_jobs once it
+// requires it, and that outside of them nothing happens.
+TEST(TestIsolationTest, IsolatesTheCallingTestOnlyOnAWorker) {
+  ::jmsd::cutf::internal::Test_isolation* const isolation =
+	  ::jmsd::cutf::internal::Test_isolation::GetInstance();
+
+  isolation->Require();
+  EXPECT_EQ(GTEST_FLAG(jobs) > 1, isolation->is_isolated());
+  if (isolation->is_isolated()) {
+	// A pool has no more workers than units of work.
+	EXPECT_LT(isolation->other_worker_count(), GTEST_FLAG(jobs));
+  }
+}
+
 // Tests TestResult::GetTestPartResult().
 
 typedef TestResultTest TestResultDeathTest;
@@ -1564,14 +1935,20 @@ class GTestFlagSaverTest : public Test {
   // then sets them to their default values.  This will be called
   // before the first test in this test case is run.
   static void SetUpTestSuite() {
+	// The flags are read by the tests running on the other workers.
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
 	saver_ = new GTestFlagSaver;
 
 	GTEST_FLAG(also_run_disabled_tests) = false;
 	GTEST_FLAG(break_on_failure) = false;
 	GTEST_FLAG(catch_exceptions) = false;
+	GTEST_FLAG(death_test_jobs) = 1;
 	GTEST_FLAG(death_test_use_fork) = false;
 	GTEST_FLAG(color) = "auto";
+	GTEST_FLAG(console_buffer) = 0;
 	GTEST_FLAG(filter) = "";
+	GTEST_FLAG(jobs) = 1;
+	GTEST_FLAG(lazy_parameterized_tests) = false;
 	GTEST_FLAG(list_tests) = false;
 	GTEST_FLAG(output) = "";
 	GTEST_FLAG(print_time) = true;
@@ -1579,6 +1956,9 @@ class GTestFlagSaverTest : public Test {
 	GTEST_FLAG(repeat) = 1;
 	GTEST_FLAG(shuffle) = false;
 	GTEST_FLAG(stack_trace_depth) = ::jmsd::cutf::constants::kMaxStackTraceDepth;
+	GTEST_FLAG(stream_output) = false;
+	GTEST_FLAG(stream_result_buffer) = 0;
+	GTEST_FLAG(stream_result_overflow) = "block";
 	GTEST_FLAG(stream_result_to) = "";
 	GTEST_FLAG(throw_on_failure) = false;
   }
@@ -1597,8 +1977,12 @@ class GTestFlagSaverTest : public Test {
 	EXPECT_FALSE(GTEST_FLAG(break_on_failure));
 	EXPECT_FALSE(GTEST_FLAG(catch_exceptions));
 	EXPECT_STREQ("auto", GTEST_FLAG(color).c_str());
+	EXPECT_EQ(0, GTEST_FLAG(console_buffer));
+	EXPECT_EQ(1, GTEST_FLAG(death_test_jobs));
 	EXPECT_FALSE(GTEST_FLAG(death_test_use_fork));
 	EXPECT_STREQ("", GTEST_FLAG(filter).c_str());
+	EXPECT_EQ(1, GTEST_FLAG(jobs));
+	EXPECT_FALSE(GTEST_FLAG(lazy_parameterized_tests));
 	EXPECT_FALSE(GTEST_FLAG(list_tests));
 	EXPECT_STREQ("", GTEST_FLAG(output).c_str());
 	EXPECT_TRUE(GTEST_FLAG(print_time));
@@ -1606,6 +1990,9 @@ class GTestFlagSaverTest : public Test {
 	EXPECT_EQ(1, GTEST_FLAG(repeat));
 	EXPECT_FALSE(GTEST_FLAG(shuffle));
 	EXPECT_EQ(::jmsd::cutf::constants::kMaxStackTraceDepth, GTEST_FLAG(stack_trace_depth));
+	EXPECT_FALSE(GTEST_FLAG(stream_output));
+	EXPECT_EQ(0, GTEST_FLAG(stream_result_buffer));
+	EXPECT_STREQ("block", GTEST_FLAG(stream_result_overflow).c_str());
 	EXPECT_STREQ("", GTEST_FLAG(stream_result_to).c_str());
 	EXPECT_FALSE(GTEST_FLAG(throw_on_failure));
 
@@ -1613,8 +2000,12 @@ class GTestFlagSaverTest : public Test {
 	GTEST_FLAG(break_on_failure) = true;
 	GTEST_FLAG(catch_exceptions) = true;
 	GTEST_FLAG(color) = "no";
+	GTEST_FLAG(console_buffer) = 1 << 16;
+	GTEST_FLAG(death_test_jobs) = 4;
 	GTEST_FLAG(death_test_use_fork) = true;
 	GTEST_FLAG(filter) = "abc";
+	GTEST_FLAG(jobs) = 8;
+	GTEST_FLAG(lazy_parameterized_tests) = true;
 	GTEST_FLAG(list_tests) = true;
 	GTEST_FLAG(output) = "xml:foo.xml";
 	GTEST_FLAG(print_time) = false;
@@ -1622,6 +2013,9 @@ class GTestFlagSaverTest : public Test {
 	GTEST_FLAG(repeat) = 100;
 	GTEST_FLAG(shuffle) = true;
 	GTEST_FLAG(stack_trace_depth) = 1;
+	GTEST_FLAG(stream_output) = true;
+	GTEST_FLAG(stream_result_buffer) = 256;
+	GTEST_FLAG(stream_result_overflow) = "drop";
 	GTEST_FLAG(stream_result_to) = "localhost:1234";
 	GTEST_FLAG(throw_on_failure) = true;
   }
@@ -1650,7 +2044,10 @@ TEST_F(GTestFlagSaverTest, VerifyGTestFlags) {
 // Sets an environment variable with the given name to the given
 // value.  If the value argument is "", unsets the environment
 // variable.  The caller must ensure that both arguments are not NULL.
+// The environment belongs to the whole process, so the calling test runs
+// alone from here on.
 static void SetEnv(const char* name, const char* value) {
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
 #if GTEST_OS_WINDOWS_MOBILE
   // Environment variables are not supported on Windows CE.
   return;
@@ -1851,7 +2248,7 @@ class ShouldShardTest : public Test {
 
 // Tests that sharding is disabled if neither of the environment variables
 // are set.
-TEST_F(ShouldShardTest, DISABLED_ReturnsFalseWhenNeitherEnvVarIsSet) {
+TEST_F(ShouldShardTest, ReturnsFalseWhenNeitherEnvVarIsSet) {
   SetEnv(index_var_, "");
   SetEnv(total_var_, "");
 
@@ -1860,7 +2257,7 @@ TEST_F(ShouldShardTest, DISABLED_ReturnsFalseWhenNeitherEnvVarIsSet) {
 }
 
 // Tests that sharding is not enabled if total_shards  == 1.
-TEST_F(ShouldShardTest, DISABLED_ReturnsFalseWhenTotalShardIsOne) {
+TEST_F(ShouldShardTest, ReturnsFalseWhenTotalShardIsOne) {
   SetEnv(index_var_, "0");
   SetEnv(total_var_, "1");
   EXPECT_FALSE(::jmsd::cutf::internal::function_Should_shard::ShouldShard(total_var_, index_var_, false));
@@ -1871,7 +2268,7 @@ TEST_F(ShouldShardTest, DISABLED_ReturnsFalseWhenTotalShardIsOne) {
 // we are not in a death test subprocess.
 // Environment variables are not supported on Windows CE.
 #if !GTEST_OS_WINDOWS_MOBILE
-TEST_F(ShouldShardTest, DISABLED_WorksWhenShardEnvVarsAreValid) {
+TEST_F(ShouldShardTest, WorksWhenShardEnvVarsAreValid) {
   SetEnv(index_var_, "4");
   SetEnv(total_var_, "22");
   EXPECT_TRUE(::jmsd::cutf::internal::function_Should_shard::ShouldShard(total_var_, index_var_, false));
@@ -1893,7 +2290,7 @@ TEST_F(ShouldShardTest, DISABLED_WorksWhenShardEnvVarsAreValid) {
 
 typedef ShouldShardTest ShouldShardDeathTest;
 
-TEST_F(ShouldShardDeathTest, DISABLED_AbortsWhenShardingEnvVarsAreInvalid) {
+TEST_F(ShouldShardDeathTest, AbortsWhenShardingEnvVarsAreInvalid) {
   SetEnv(index_var_, "4");
   SetEnv(total_var_, "4");
   EXPECT_DEATH_IF_SUPPORTED(::jmsd::cutf::internal::function_Should_shard::ShouldShard(total_var_, index_var_, false), ".*");
@@ -1913,7 +2310,7 @@ TEST_F(ShouldShardDeathTest, DISABLED_AbortsWhenShardingEnvVarsAreInvalid) {
 
 // Tests that ShouldRunTestOnShard is a partition when 5
 // shards are used.
-TEST(ShouldRunTestOnShardTest, DISABLED_IsPartitionWhenThereAreFiveShards) {
+TEST(ShouldRunTestOnShardTest, IsPartitionWhenThereAreFiveShards) {
   // Choose an arbitrary number of tests and shards.
   const int num_tests = 17;
   const int num_shards = 5;
@@ -1945,6 +2342,519 @@ TEST(ShouldRunTestOnShardTest, DISABLED_IsPartitionWhenThereAreFiveShards) {
   }
 }
 
+// Tests that Shard_planner reads the durations of the tests that ran from
+// an XML report.
+TEST(ShardPlannerTest, ReadsXmlReport) {
+  ::jmsd::cutf::internal::Shard_planner planner;
+  ASSERT_TRUE(planner.LoadReportContent(
+	  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	  "<testsuites tests=\"3\" name=\"AllTests\">\n"
+	  "  <testsuite name=\"A\" tests=\"3\">\n"
+	  "    <testcase name=\"Slow\" status=\"run\" result=\"completed\" time=\"2.5\" classname=\"A\" />\n"
+	  "    <testcase name=\"Fast&amp;Small\" status=\"run\" result=\"completed\" time=\"0.001\" classname=\"A\" />\n"
+	  "    <testcase name=\"Filtered\" status=\"notrun\" result=\"suppressed\" time=\"0\" classname=\"A\" />\n"
+	  "  </testsuite>\n"
+	  "</testsuites>\n"));
+  EXPECT_EQ(2u, planner.known_test_count());
+
+  // The slow test gets a shard of its own.
+  const std::vector<int> plan = planner.Plan({"A.Fast&Small", "A.Slow", "A.Fast&Small"}, 2);
+  EXPECT_EQ(plan[0], plan[2]);
+  EXPECT_NE(plan[0], plan[1]);
+}
+
+// Tests that Shard_planner reads the durations of the tests that ran from
+// a JSON report.
+TEST(ShardPlannerTest, ReadsJsonReport) {
+  ::jmsd::cutf::internal::Shard_planner planner;
+  ASSERT_TRUE(planner.LoadReportContent(
+	  "{\n"
+	  "  \"tests\": 2,\n"
+	  "  \"name\": \"AllTests\",\n"
+	  "  \"testsuites\": [\n"
+	  "    {\n"
+	  "      \"name\": \"A\",\n"
+	  "      \"testsuite\": [\n"
+	  "        { \"name\": \"Slow\", \"status\": \"RUN\", \"time\": \"2.5s\", \"classname\": \"A\" },\n"
+	  "        { \"name\": \"Fast\\/Small\", \"status\": \"RUN\", \"time\": \"0.001s\", \"classname\": \"A\" },\n"
+	  "        { \"name\": \"Filtered\", \"status\": \"NOTRUN\", \"time\": \"0s\", \"classname\": \"A\" }\n"
+	  "      ]\n"
+	  "    }\n"
+	  "  ]\n"
+	  "}\n"));
+  EXPECT_EQ(2u, planner.known_test_count());
+
+  const std::vector<int> plan = planner.Plan({"A.Fast/Small", "A.Slow", "A.Fast/Small"}, 2);
+  EXPECT_EQ(plan[0], plan[2]);
+  EXPECT_NE(plan[0], plan[1]);
+}
+
+// Tests that Shard_planner prefers the nanosecond durations of a report,
+// which tell apart tests that all took "0" seconds.
+TEST(ShardPlannerTest, PrefersNanosecondDurations) {
+  ::jmsd::cutf::internal::Shard_planner planner;
+  ASSERT_TRUE(planner.LoadReportContent(
+	  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	  "<testsuites tests=\"4\" name=\"AllTests\">\n"
+	  "  <testsuite name=\"A\" tests=\"4\">\n"
+	  "    <testcase name=\"Slow\" status=\"run\" time=\"0\" time_ns=\"900000\" classname=\"A\" />\n"
+	  "    <testcase name=\"Fast1\" status=\"run\" time=\"0\" time_ns=\"1000\" classname=\"A\" />\n"
+	  "    <testcase name=\"Fast2\" status=\"run\" time=\"0\" time_ns=\"1000\" classname=\"A\" />\n"
+	  "    <testcase name=\"Fast3\" status=\"run\" time=\"0\" time_ns=\"1000\" classname=\"A\" />\n"
+	  "  </testsuite>\n"
+	  "</testsuites>\n"));
+
+  // The slow test gets a shard of its own.
+  const std::vector<int> plan = planner.Plan({"A.Fast1", "A.Fast2", "A.Slow", "A.Fast3"}, 2);
+  EXPECT_EQ(plan[0], plan[1]);
+  EXPECT_EQ(plan[0], plan[3]);
+  EXPECT_NE(plan[0], plan[2]);
+}
+
+// Tests that Shard_planner rejects content that isn't a test report.
+TEST(ShardPlannerTest, RejectsWhatIsNotAReport) {
+  ::jmsd::cutf::internal::Shard_planner planner;
+  EXPECT_FALSE(planner.LoadReportContent(""));
+  EXPECT_FALSE(planner.LoadReportContent("A.Slow 2.5"));
+  EXPECT_FALSE(planner.LoadReportContent("{ \"testsuites\": [ "));
+  EXPECT_FALSE(planner.LoadReport("this/file/does/not/exist.xml"));
+  EXPECT_EQ(0u, planner.known_test_count());
+}
+
+// Tests that the plan balances the recorded durations where round-robin
+// sharding would put both slow tests on the same shard.
+TEST(ShardPlannerTest, BalancesDurations) {
+  ::jmsd::cutf::internal::Shard_planner planner;
+  ASSERT_TRUE(planner.LoadReportContent(
+	  "{ \"testsuites\": [ { \"name\": \"A\", \"testsuite\": [\n"
+	  "  { \"name\": \"t0\", \"time\": \"10s\", \"classname\": \"A\" },\n"
+	  "  { \"name\": \"t1\", \"time\": \"1s\", \"classname\": \"A\" },\n"
+	  "  { \"name\": \"t2\", \"time\": \"10s\", \"classname\": \"A\" },\n"
+	  "  { \"name\": \"t3\", \"time\": \"1s\", \"classname\": \"A\" },\n"
+	  "  { \"name\": \"t4\", \"time\": \"1s\", \"classname\": \"A\" },\n"
+	  "  { \"name\": \"t5\", \"time\": \"1s\", \"classname\": \"A\" } ] } ] }"));
+
+  const int kDurations[] = {10, 1, 10, 1, 1, 1};
+  const std::vector<int> plan = planner.Plan({"A.t0", "A.t1", "A.t2", "A.t3", "A.t4", "A.t5"}, 2);
+  ASSERT_EQ(6u, plan.size());
+
+  int load[2] = {0, 0};
+  for (size_t i = 0; i < plan.size(); ++i) {
+	ASSERT_GE(plan[i], 0);
+	ASSERT_LT(plan[i], 2);
+	load[plan[i]] += kDurations[i];
+  }
+
+  EXPECT_EQ(12, load[0]);
+  EXPECT_EQ(12, load[1]);
+}
+
+// Tests that tests missing from the reports are assumed to take the
+// average time, and that equal costs are dealt in run order.
+TEST(ShardPlannerTest, AssumesAverageDurationForUnknownTests) {
+  ::jmsd::cutf::internal::Shard_planner planner;
+  ASSERT_TRUE(planner.LoadReportContent(
+	  "{ \"testsuites\": [ { \"name\": \"A\", \"testsuite\": [\n"
+	  "  { \"name\": \"a\", \"time\": \"4s\", \"classname\": \"A\" } ] } ] }"));
+
+  const std::vector<int> plan = planner.Plan({"A.a", "B.b", "B.c"}, 2);
+  EXPECT_EQ((std::vector<int>{0, 1, 0}), plan);
+}
+
+// Tests Compiled_filter with literal and wildcard patterns.
+TEST(CompiledFilterTest, MatchesAnyPattern) {
+  const ::jmsd::cutf::internal::Compiled_filter filter("Foo.Bar:Foo.B?z:Qux.*:*Death*:*.Last");
+
+  EXPECT_TRUE(filter.Matches("Foo.Bar"));
+  EXPECT_TRUE(filter.Matches("Foo.Baz"));
+  EXPECT_TRUE(filter.Matches("Qux."));
+  EXPECT_TRUE(filter.Matches("Qux.Anything"));
+  EXPECT_TRUE(filter.Matches("MyDeathTest.Dies"));
+  EXPECT_TRUE(filter.Matches("A.Last"));
+
+  EXPECT_FALSE(filter.Matches("Foo.Ba"));
+  EXPECT_FALSE(filter.Matches("Foo.Barr"));
+  EXPECT_FALSE(filter.Matches("Foo.Bz"));
+  EXPECT_FALSE(filter.Matches("Qux"));
+  EXPECT_FALSE(filter.Matches("A.LastOne"));
+  EXPECT_FALSE(filter.Matches(""));
+}
+
+// Tests that an empty pattern matches only the empty name.
+TEST(CompiledFilterTest, EmptyPatternMatchesEmptyName) {
+  EXPECT_TRUE(::jmsd::cutf::internal::Compiled_filter("").Matches(""));
+  EXPECT_FALSE(::jmsd::cutf::internal::Compiled_filter("").Matches("a"));
+  EXPECT_TRUE(::jmsd::cutf::internal::Compiled_filter("a::b").Matches(""));
+}
+
+// Tests that a pattern with many '*'s takes no exponential time.
+TEST(CompiledFilterTest, DoesNotBacktrack) {
+  const std::string name(10000, 'a');
+  const char pattern[] = "*a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*b";
+
+  EXPECT_FALSE(::jmsd::cutf::internal::Compiled_filter(pattern).Matches(name));
+  EXPECT_TRUE(::jmsd::cutf::internal::Compiled_filter(pattern).Matches(name + "b"));
+  EXPECT_FALSE(::jmsd::cutf::internal::UnitTestOptions::PatternMatchesString(pattern, name.c_str()));
+  EXPECT_TRUE(::jmsd::cutf::internal::UnitTestOptions::PatternMatchesString(pattern, (name + "b").c_str()));
+}
+
+// Tests that Compiled_filter agrees with PatternMatchesString.
+TEST(CompiledFilterTest, AgreesWithPatternMatchesString) {
+  const char* const patterns[] = {
+	  "", "*", "?", "a", "a*", "*a", "*a*", "a?c", "a*c", "*?", "?*",
+	  "**", "a**c", "*b*c*", "ab*bc", "a?*?c", "*abc", "abc*abc"};
+  const char* const names[] = {
+	  "", "a", "b", "ab", "abc", "abbc", "aXc", "abcabc", "cba", "abcbc"};
+
+  for (const char* pattern : patterns) {
+	const ::jmsd::cutf::internal::Compiled_filter filter(pattern);
+
+	for (const char* name : names) {
+	  EXPECT_EQ(::jmsd::cutf::internal::UnitTestOptions::PatternMatchesString(pattern, name),
+				filter.Matches(name))
+		  << "pattern: \"" << pattern << "\", name: \"" << name << "\"";
+	}
+  }
+}
+
+// Tests the positive and negative parts of Compiled_test_filter.
+TEST(CompiledTestFilterTest, HonorsNegativePatterns) {
+  const ::jmsd::cutf::internal::Compiled_test_filter filter("Foo.*:Bar.*-*.Slow:Bar.B*");
+
+  EXPECT_TRUE(filter.Matches("Foo.Fast"));
+  EXPECT_TRUE(filter.Matches("Bar.Abc"));
+  EXPECT_FALSE(filter.Matches("Foo.Slow"));
+  EXPECT_FALSE(filter.Matches("Bar.Baz"));
+  EXPECT_FALSE(filter.Matches("Qux.Fast"));
+
+  // '-Foo.*' means '*-Foo.*'.
+  EXPECT_TRUE(::jmsd::cutf::internal::Compiled_test_filter("-Foo.*").Matches("Bar.Baz"));
+  EXPECT_FALSE(::jmsd::cutf::internal::Compiled_test_filter("-Foo.*").Matches("Foo.Bar"));
+}
+
+// Tests that only --cutf_lazy_parameterized_tests makes the filter decide
+// which instances of value-parameterized tests are registered.
+TEST(LazyParameterizedTestsTest, RegistersOnlyInstancesMatchingTheFilter) {
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+  GTestFlagSaver saver;
+  GTEST_FLAG(filter) = "Prefix/FooTest.Bar/1:*.Baz/*-*.Baz/2";
+
+  GTEST_FLAG(lazy_parameterized_tests) = false;
+  EXPECT_TRUE(testing::internal::ShouldRegisterParameterizedTest("Prefix/FooTest", "Bar/0"));
+
+  GTEST_FLAG(lazy_parameterized_tests) = true;
+  EXPECT_TRUE(testing::internal::ShouldRegisterParameterizedTest("Prefix/FooTest", "Bar/1"));
+  EXPECT_FALSE(testing::internal::ShouldRegisterParameterizedTest("Prefix/FooTest", "Bar/0"));
+  EXPECT_TRUE(testing::internal::ShouldRegisterParameterizedTest("FooTest", "Baz/0"));
+  EXPECT_FALSE(testing::internal::ShouldRegisterParameterizedTest("FooTest", "Baz/2"));
+
+  // A changed filter is picked up.
+  GTEST_FLAG(filter) = "*";
+  EXPECT_TRUE(testing::internal::ShouldRegisterParameterizedTest("FooTest", "Baz/2"));
+}
+
+// Returns the elements ForEach() passes, in order.
+template <typename T>
+static std::vector<T> ElementsPassedByForEach(const testing::internal::ParamGenerator<T>& generator) {
+  std::vector<T> elements;
+  generator.ForEach([&elements](const T& value) { elements.push_back(value); });
+  return elements;
+}
+
+// Returns the elements the iterators of a generator walk through, in order.
+template <typename T>
+static std::vector<T> ElementsOfIterators(const testing::internal::ParamGenerator<T>& generator) {
+  std::vector<T> elements;
+  for (typename testing::internal::ParamGenerator<T>::iterator it = generator.begin();
+	   it != generator.end(); ++it) {
+	elements.push_back(*it);
+  }
+  return elements;
+}
+
+// Tests that ForEach() passes the same elements as the iterators, for every
+// generator that overrides it and for an empty one.
+TEST(ParamGeneratorForEachTest, PassesTheElementsOfTheIterators) {
+  const testing::internal::ParamGenerator<int> range = testing::Range(0, 10, 3);
+  EXPECT_EQ(ElementsOfIterators(range), ElementsPassedByForEach(range));
+
+  const testing::internal::ParamGenerator<int> empty_range = testing::Range(5, 5);
+  EXPECT_TRUE(ElementsPassedByForEach(empty_range).empty());
+
+  const int array[] = { 3, 5, 8 };
+  const testing::internal::ParamGenerator<int> values_in = testing::ValuesIn(array);
+  EXPECT_EQ(ElementsOfIterators(values_in), ElementsPassedByForEach(values_in));
+
+  const testing::internal::ParamGenerator<std::string> values = testing::Values("a", "b");
+  EXPECT_EQ(ElementsOfIterators(values), ElementsPassedByForEach(values));
+
+  const testing::internal::ParamGenerator<bool> bools = testing::Bool();
+  EXPECT_EQ(ElementsOfIterators(bools), ElementsPassedByForEach(bools));
+
+  const testing::internal::ParamGenerator<std::tuple<int, bool> > combined =
+	  testing::Combine(testing::Range(0, 3), testing::Bool());
+  EXPECT_EQ(ElementsOfIterators(combined), ElementsPassedByForEach(combined));
+}
+
+// Tests that ForEach() on a large Combine() visits every combination once,
+// the last parameter varying fastest.
+TEST(ParamGeneratorForEachTest, VisitsEveryCombinationInOrder) {
+  const testing::internal::ParamGenerator<std::tuple<int, int, char> > generator =
+	  testing::Combine(testing::Range(0, 100), testing::Range(0, 50), testing::Values('a', 'b', 'c'));
+
+  int count = 0;
+  generator.ForEach([&count](const std::tuple<int, int, char>& value) {
+	EXPECT_EQ(count / 150, std::get<0>(value));
+	EXPECT_EQ(count / 3 % 50, std::get<1>(value));
+	EXPECT_EQ('a' + count % 3, std::get<2>(value));
+	++count;
+  });
+  EXPECT_EQ(100 * 50 * 3, count);
+}
+
+// A parameter that can be neither default constructed nor assigned.
+class NonDefaultConstructAssignParam {
+ public:
+  NonDefaultConstructAssignParam(const std::string& s) : str_(s) {}  // NOLINT
+
+  const std::string& str() const { return str_; }
+
+ private:
+  std::string str_;
+
+  NonDefaultConstructAssignParam();
+  void operator=(const NonDefaultConstructAssignParam&);
+};
+
+// Tests that ForEach() on a Combine() builds its tuples without default
+// constructing or assigning the parameters.
+TEST(ParamGeneratorForEachTest, CombinesParametersThatCanNotBeAssigned) {
+  const testing::internal::ParamGenerator<std::tuple<int, NonDefaultConstructAssignParam> > generator =
+	  testing::Combine(testing::Values(0, 1),
+					   testing::Values(NonDefaultConstructAssignParam("A"),
+									   NonDefaultConstructAssignParam("B")));
+
+  std::string visited;
+  generator.ForEach([&visited](const std::tuple<int, NonDefaultConstructAssignParam>& value) {
+	visited += std::to_string(std::get<0>(value)) + std::get<1>(value).str();
+  });
+  EXPECT_EQ("0A0B1A1B", visited);
+}
+
+// Returns the content of the given report file.
+static std::string ReadReportFile(const std::string& path) {
+  FILE* const file = testing::internal::posix::FOpen(path.c_str(), "r");
+  if (file == nullptr) return "";
+
+  const std::string content = testing::internal::ReadEntireFile(file);
+  testing::internal::posix::FClose(file);
+  return content;
+}
+
+// Feeds the events of the current test to a report printer, checking that
+// each test is in the report once its suite ends and the report is complete
+// once the program ends.
+template <typename Printer>
+static void CheckStreamedReport(const std::string& path,
+								const std::string& test_entry,
+								const std::string& report_end) {
+  GTestFlagSaver saver;
+  GTEST_FLAG(stream_output) = true;
+
+  const ::jmsd::cutf::UnitTest& unit_test = *::jmsd::cutf::UnitTest::GetInstance();
+  const ::jmsd::cutf::TestSuite& test_suite = *unit_test.current_test_suite();
+  const ::jmsd::cutf::TestInfo& test_info = *unit_test.current_test_info();
+
+  Printer printer(path.c_str());
+  printer.OnTestIterationStart(unit_test, 0);
+  printer.OnTestSuiteStart(test_suite);
+  EXPECT_EQ(std::string::npos, ReadReportFile(path).find(test_entry));
+
+  printer.OnTestEnd(test_info);
+  EXPECT_EQ(std::string::npos, ReadReportFile(path).find(test_entry));
+
+  printer.OnTestSuiteEnd(test_suite);
+  const std::string streamed = ReadReportFile(path);
+  EXPECT_NE(std::string::npos, streamed.find(test_entry)) << streamed;
+
+  printer.OnTestIterationEnd(unit_test, 0);
+  EXPECT_FALSE(testing::internal::String::EndsWithCaseInsensitive(ReadReportFile(path), report_end));
+
+  printer.OnTestProgramEnd(unit_test);
+  EXPECT_TRUE(testing::internal::String::EndsWithCaseInsensitive(ReadReportFile(path), report_end));
+
+  remove(path.c_str());
+}
+
+// Tests that --cutf_stream_output writes the XML report as the tests run.
+TEST(StreamOutputTest, StreamsXmlReport) {
+  CheckStreamedReport<::jmsd::cutf::internal::XmlUnitTestResultPrinter>(
+	  testing::TempDir() + "cutf_stream_output_test.xml",
+	  "<testcase name=\"StreamsXmlReport\"", "</testsuites>\n");
+}
+
+// Tests that --cutf_stream_output writes the JSON report as the tests run.
+TEST(StreamOutputTest, StreamsJsonReport) {
+  CheckStreamedReport<::jmsd::cutf::internal::JsonUnitTestResultPrinter>(
+	  testing::TempDir() + "cutf_stream_output_test.json",
+	  "\"name\": \"StreamsJsonReport\"", "\n}\n");
+}
+
+// Tests that Report_file_buffer::FlushIfDue() writes the buffer out only
+// once the flush interval has passed.
+TEST(StreamOutputTest, FlushesReportBufferWhenDue) {
+  const std::string path = testing::TempDir() + "cutf_report_buffer_test.txt";
+
+  {
+	::jmsd::cutf::internal::Report_file_buffer buffer(
+		testing::internal::posix::FOpen(path.c_str(), "w"),
+		60 * 1000);
+	std::ostream stream(&buffer);
+	stream << "not due";
+	buffer.FlushIfDue();
+	EXPECT_EQ("", ReadReportFile(path));
+  }
+  EXPECT_EQ("not due", ReadReportFile(path));
+
+  {
+	::jmsd::cutf::internal::Report_file_buffer buffer(
+		testing::internal::posix::FOpen(path.c_str(), "w"),
+		0);
+	std::ostream stream(&buffer);
+	stream << "due";
+	buffer.FlushIfDue();
+	EXPECT_EQ("due", ReadReportFile(path));
+  }
+
+  remove(path.c_str());
+}
+
+// Returns the value of the given property of the current test, or "" if
+// it has none.
+static std::string GetCurrentTestProperty(const std::string& key) {
+  const ::jmsd::cutf::TestResult& result =
+	  *::jmsd::cutf::UnitTest::GetInstance()->current_test_info()->result();
+
+  for (int i = 0; i < result.test_property_count(); ++i) {
+	if (key == result.GetTestProperty(i).key()) {
+	  return result.GetTestProperty(i).value();
+	}
+  }
+
+  return "";
+}
+
+// Tests that Benchmark_state::Run() calibrates the iteration count and
+// records the timing as properties.
+TEST(BenchmarkStateTest, RecordsTimingProperties) {
+  int64_t last_iterations = 0;
+  volatile int sink = 0;
+
+  ::jmsd::cutf::Benchmark_state::Run([&](::jmsd::cutf::Benchmark_state& state) {
+	last_iterations = state.iterations();
+	while (state.KeepRunning()) {
+	  sink = sink + 1;
+	}
+  });
+
+  EXPECT_GT(last_iterations, 1);
+  EXPECT_EQ(::jmsd::cutf::internal::function_Streamable_to_string::StreamableToString(last_iterations),
+			GetCurrentTestProperty("iterations"));
+  EXPECT_NE("", GetCurrentTestProperty("ns_per_op"));
+  EXPECT_NE("", GetCurrentTestProperty("ns_per_op_stddev"));
+}
+
+// Enables allocation counting for the lifetime of the object, leaving it as
+// it was afterwards so the benchmarks of later tests are not affected.
+class ScopedAllocationCounting {
+ public:
+  ScopedAllocationCounting()
+	  : was_enabled_(
+			::jmsd::cutf::Benchmark_state::IsAllocationCountingEnabled()) {
+	::jmsd::cutf::Benchmark_state::EnableAllocationCounting();
+  }
+
+  ~ScopedAllocationCounting() {
+	if (!was_enabled_) {
+	  ::jmsd::cutf::Benchmark_state::DisableAllocationCounting();
+	}
+  }
+
+ private:
+  const bool was_enabled_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(ScopedAllocationCounting);
+};
+
+// Tests that allocs_per_op counts the allocations of one iteration.
+TEST(BenchmarkStateTest, CountsAllocationsPerOperation) {
+  ScopedAllocationCounting allocation_counting;
+
+  ::jmsd::cutf::Benchmark_state::Run([](::jmsd::cutf::Benchmark_state& state) {
+	while (state.KeepRunning()) {
+	  ::jmsd::cutf::Benchmark_state::CountAllocation();
+	  ::jmsd::cutf::Benchmark_state::CountAllocation();
+
+	  // Paused work is not measured.
+	  state.PauseTiming();
+	  ::jmsd::cutf::Benchmark_state::CountAllocation();
+	  state.ResumeTiming();
+	}
+  });
+
+  EXPECT_EQ("2.000", GetCurrentTestProperty("allocs_per_op"));
+}
+
+// Tests that allocs_per_op is left out once allocation counting is disabled.
+TEST(BenchmarkStateTest, LeavesOutAllocationsWhenDisabled) {
+  const bool was_enabled =
+	  ::jmsd::cutf::Benchmark_state::IsAllocationCountingEnabled();
+  { ScopedAllocationCounting allocation_counting; }
+  EXPECT_EQ(was_enabled,
+			::jmsd::cutf::Benchmark_state::IsAllocationCountingEnabled());
+
+  ::jmsd::cutf::Benchmark_state::DisableAllocationCounting();
+  ::jmsd::cutf::Benchmark_state::Run([](::jmsd::cutf::Benchmark_state& state) {
+	while (state.KeepRunning()) {
+	  ::jmsd::cutf::Benchmark_state::CountAllocation();
+	}
+  });
+  if (was_enabled) {
+	::jmsd::cutf::Benchmark_state::EnableAllocationCounting();
+  }
+
+  EXPECT_EQ("", GetCurrentTestProperty("allocs_per_op"));
+}
+
+// Tests that a benchmark body which never calls KeepRunning() fails.
+TEST(BenchmarkStateTest, FailsWithoutKeepRunning) {
+  EXPECT_NONFATAL_FAILURE(
+	  ::jmsd::cutf::Benchmark_state::Run([](::jmsd::cutf::Benchmark_state&) {}),
+	  "never calls state.KeepRunning()");
+}
+
+// Tests that TEST_BENCH() runs its body through Benchmark_state.
+TEST_BENCH(BenchmarkMacroTest, RunsTheBody) {
+  while (state.KeepRunning()) {
+  }
+
+  EXPECT_GT(state.iterations(), 0);
+}
+
+class BenchmarkFixtureTest : public ::jmsd::cutf::Test {
+ protected:
+  void SetUp() override { value_ = 42; }
+
+  int value_ = 0;
+};
+
+// Tests that BENCHMARK_F() gives its body access to the fixture.
+BENCHMARK_F(BenchmarkFixtureTest, SeesTheFixture) {
+  while (state.KeepRunning()) {
+	EXPECT_EQ(42, value_);
+  }
+}
+
 // For the same reason we are not explicitly testing everything in the
 // Test class, there are no separate tests for the following classes
 // (except for some trivial cases):
@@ -1965,6 +2875,23 @@ TEST(UnitTestTest, ReturnsPlausibleTimestamp) {
   EXPECT_LE(::jmsd::cutf::UnitTest::GetInstance()->start_timestamp(), GetTimeInMillis());
 }
 
+// Tests that the death test suites, registered in any order, run before
+// all the other test suites.
+TEST(UnitTestTest, RunsDeathTestSuitesFirst) {
+  const ::jmsd::cutf::UnitTest& unit_test = *::jmsd::cutf::UnitTest::GetInstance();
+  bool has_seen_non_death_test_suite = false;
+
+  for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
+	const char* const name = unit_test.GetTestSuite(i)->name();
+	const bool is_death_test_suite =
+		::jmsd::cutf::internal::UnitTestOptions::MatchesFilter(
+			name, ::jmsd::cutf::constants::kDeathTestSuiteFilter);
+
+	EXPECT_FALSE(is_death_test_suite && has_seen_non_death_test_suite) << name;
+	has_seen_non_death_test_suite = has_seen_non_death_test_suite || !is_death_test_suite;
+  }
+}
+
 // When a property using a reserved key is supplied to this function, it
 // tests that a non-fatal failure is added, a fatal failure is not added,
 // and that the property is not recorded.
@@ -2093,6 +3020,8 @@ TEST_F(UnitTestRecordPropertyTest,
 	  "status");
   ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTest(
 	  "time");
+  ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTest(
+	  "time_ns");
   ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTest(
 	  "classname");
 }
@@ -2101,8 +3030,8 @@ TEST_F(UnitTestRecordPropertyTest,
 	   AddRecordWithReservedKeysGeneratesCorrectPropertyList) {
   EXPECT_NONFATAL_FAILURE(
 	  Test::RecordProperty("name", "1"),
-	  "'classname', 'name', 'status', 'time', 'type_param', 'value_param',"
-	  " 'file', and 'line' are reserved");
+	  "'classname', 'name', 'status', 'time', 'time_ns', 'type_param',"
+	  " 'value_param', 'file', and 'line' are reserved");
 }
 
 class UnitTestRecordPropertyTestEnvironment : public Environment {
@@ -3504,9 +4433,9 @@ TEST(EditDistance, TestSuites) {
 	  {__LINE__, "ABCDEFGH", "ABXEGH1", "  -/ -  +",
 	   "@@ -1,8 +1,7 @@\n A\n B\n-C\n-D\n+X\n E\n-F\n G\n H\n+1\n"},
 	  {__LINE__, "AAAABCCCC", "ABABCDCDC", "- /   + / ",
-	   "@@ -1,9 +1,9 @@\n-A\n A\n-A\n+B\n A\n B\n C\n+D\n C\n-C\n+D\n C\n"},
+	   "@@ -1,9 +1,9 @@\n A\n-A\n-A\n+B\n A\n B\n C\n+D\n C\n-C\n+D\n C\n"},
 	  {__LINE__, "ABCDE", "BCDCD", "-   +/",
-	   "@@ -1,5 +1,5 @@\n-A\n B\n C\n D\n-E\n+C\n+D\n"},
+	   "@@ -1,5 +1,5 @@\n-A\n B\n+C\n+D\n C\n D\n-E\n"},
 	  {__LINE__, "ABCDEFGHIJKL", "BCDCDEFGJKLJK", "- ++     --   ++",
 	   "@@ -1,4 +1,5 @@\n-A\n B\n+C\n+D\n C\n D\n"
 	   "@@ -6,7 +7,7 @@\n F\n G\n-H\n-I\n J\n K\n L\n+J\n+K\n"},
@@ -3526,6 +4455,28 @@ TEST(EditDistance, TestSuites) {
   }
 }
 
+// Tests that the shortest edits keep every common line of long inputs.
+TEST(EditDistance, DiffsLongInputs) {
+  std::vector<std::string> left;
+  for (int i = 0; i < 20000; ++i) {
+	left.push_back("line " + ::jmsd::cutf::internal::function_Streamable_to_string::StreamableToString(i));
+  }
+
+  std::vector<std::string> right = left;
+  right[10000] = "changed";
+  right.erase(right.begin() + 15000);
+
+  const std::vector< ::jmsd::cutf::internal::Distance_editor::EditType > edits =
+	  ::jmsd::cutf::internal::Distance_editor::CalculateShortestEdits(left, right);
+  EXPECT_EQ(left.size() + 1, edits.size());
+
+  EXPECT_EQ("@@ -9999,5 +9999,5 @@\n line 9998\n line 9999\n-line 10000\n+changed\n"
+			" line 10001\n line 10002\n"
+			"@@ -14999,5 @@\n line 14998\n line 14999\n-line 15000\n"
+			" line 15001\n line 15002\n",
+			::jmsd::cutf::internal::Distance_editor::CreateUnifiedDiff(left, right));
+}
+
 // Tests EqFailure(), used for implementing *EQ* assertions.
 TEST(AssertionTest, EqFailure) {
   const std::string foo_val("5"), bar_val("6");
@@ -5470,15 +6421,23 @@ struct Flags {
   Flags() : also_run_disabled_tests(false),
 			break_on_failure(false),
 			catch_exceptions(false),
+			console_buffer(0),
+			death_test_jobs(1),
 			death_test_use_fork(false),
 			filter(""),
+			jobs(1),
+			lazy_parameterized_tests(false),
 			list_tests(false),
 			output(""),
 			print_time(true),
 			random_seed(0),
 			repeat(1),
+			shard_durations(""),
 			shuffle(false),
 			stack_trace_depth(::jmsd::cutf::constants::kMaxStackTraceDepth),
+			stream_output(false),
+			stream_result_buffer(0),
+			stream_result_overflow("block"),
 			stream_result_to(""),
 			throw_on_failure(false) {}
 
@@ -5508,6 +6467,22 @@ struct Flags {
 	return flags;
   }
 
+  // Creates a Flags struct where the cutf_console_buffer flag has the
+  // given value.
+  static Flags ConsoleBuffer(int32_t console_buffer) {
+	Flags flags;
+	flags.console_buffer = console_buffer;
+	return flags;
+  }
+
+  // Creates a Flags struct where the cutf_death_test_jobs flag has the
+  // given value.
+  static Flags DeathTestJobs(int32_t death_test_jobs) {
+	Flags flags;
+	flags.death_test_jobs = death_test_jobs;
+	return flags;
+  }
+
   // Creates a Flags struct where the gtest_death_test_use_fork flag has
   // the given value.
   static Flags DeathTestUseFork(bool death_test_use_fork) {
@@ -5524,6 +6499,22 @@ struct Flags {
 	return flags;
   }
 
+  // Creates a Flags struct where the cutf_jobs flag has the given
+  // value.
+  static Flags Jobs(int32_t jobs) {
+	Flags flags;
+	flags.jobs = jobs;
+	return flags;
+  }
+
+  // Creates a Flags struct where the cutf_lazy_parameterized_tests flag has
+  // the given value.
+  static Flags LazyParameterizedTests(bool lazy_parameterized_tests) {
+	Flags flags;
+	flags.lazy_parameterized_tests = lazy_parameterized_tests;
+	return flags;
+  }
+
   // Creates a Flags struct where the gtest_list_tests flag has the
   // given value.
   static Flags ListTests(bool list_tests) {
@@ -5564,6 +6555,14 @@ struct Flags {
 	return flags;
   }
 
+  // Creates a Flags struct where the cutf_shard_durations flag has the
+  // given value.
+  static Flags ShardDurations(const char* shard_durations) {
+	Flags flags;
+	flags.shard_durations = shard_durations;
+	return flags;
+  }
+
   // Creates a Flags struct where the gtest_shuffle flag has the given
   // value.
   static Flags Shuffle(bool shuffle) {
@@ -5580,6 +6579,30 @@ struct Flags {
 	return flags;
   }
 
+  // Creates a Flags struct where the cutf_stream_output flag has the given
+  // value.
+  static Flags StreamOutput(bool stream_output) {
+	Flags flags;
+	flags.stream_output = stream_output;
+	return flags;
+  }
+
+  // Creates a Flags struct where the cutf_stream_result_buffer flag has the
+  // given value.
+  static Flags StreamResultBuffer(int32_t stream_result_buffer) {
+	Flags flags;
+	flags.stream_result_buffer = stream_result_buffer;
+	return flags;
+  }
+
+  // Creates a Flags struct where the cutf_stream_result_overflow flag has
+  // the given value.
+  static Flags StreamResultOverflow(const char* stream_result_overflow) {
+	Flags flags;
+	flags.stream_result_overflow = stream_result_overflow;
+	return flags;
+  }
+
   // Creates a Flags struct where the GTEST_FLAG(stream_result_to) flag has
   // the given value.
   static Flags StreamResultTo(const char* stream_result_to) {
@@ -5600,15 +6623,23 @@ struct Flags {
   bool also_run_disabled_tests;
   bool break_on_failure;
   bool catch_exceptions;
+  int32_t console_buffer;
+  int32_t death_test_jobs;
   bool death_test_use_fork;
   const char* filter;
+  int32_t jobs;
+  bool lazy_parameterized_tests;
   bool list_tests;
   const char* output;
   bool print_time;
   int32_t random_seed;
   int32_t repeat;
+  const char* shard_durations;
   bool shuffle;
   int32_t stack_trace_depth;
+  bool stream_output;
+  int32_t stream_result_buffer;
+  const char* stream_result_overflow;
   const char* stream_result_to;
   bool throw_on_failure;
 };
@@ -5618,18 +6649,27 @@ class ParseFlagsTest : public Test {
  protected:
   // Clears the flags before each test.
   void SetUp() override {
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
 	GTEST_FLAG(also_run_disabled_tests) = false;
 	GTEST_FLAG(break_on_failure) = false;
 	GTEST_FLAG(catch_exceptions) = false;
+	GTEST_FLAG(console_buffer) = 0;
+	GTEST_FLAG(death_test_jobs) = 1;
 	GTEST_FLAG(death_test_use_fork) = false;
 	GTEST_FLAG(filter) = "";
+	GTEST_FLAG(jobs) = 1;
+	GTEST_FLAG(lazy_parameterized_tests) = false;
 	GTEST_FLAG(list_tests) = false;
 	GTEST_FLAG(output) = "";
 	GTEST_FLAG(print_time) = true;
 	GTEST_FLAG(random_seed) = 0;
 	GTEST_FLAG(repeat) = 1;
+	GTEST_FLAG(shard_durations) = "";
 	GTEST_FLAG(shuffle) = false;
 	GTEST_FLAG(stack_trace_depth) = ::jmsd::cutf::constants::kMaxStackTraceDepth;
+	GTEST_FLAG(stream_output) = false;
+	GTEST_FLAG(stream_result_buffer) = 0;
+	GTEST_FLAG(stream_result_overflow) = "block";
 	GTEST_FLAG(stream_result_to) = "";
 	GTEST_FLAG(throw_on_failure) = false;
   }
@@ -5651,15 +6691,24 @@ class ParseFlagsTest : public Test {
 			  GTEST_FLAG(also_run_disabled_tests));
 	EXPECT_EQ(expected.break_on_failure, GTEST_FLAG(break_on_failure));
 	EXPECT_EQ(expected.catch_exceptions, GTEST_FLAG(catch_exceptions));
+	EXPECT_EQ(expected.console_buffer, GTEST_FLAG(console_buffer));
+	EXPECT_EQ(expected.death_test_jobs, GTEST_FLAG(death_test_jobs));
 	EXPECT_EQ(expected.death_test_use_fork, GTEST_FLAG(death_test_use_fork));
 	EXPECT_STREQ(expected.filter, GTEST_FLAG(filter).c_str());
+	EXPECT_EQ(expected.jobs, GTEST_FLAG(jobs));
+	EXPECT_EQ(expected.lazy_parameterized_tests, GTEST_FLAG(lazy_parameterized_tests));
 	EXPECT_EQ(expected.list_tests, GTEST_FLAG(list_tests));
 	EXPECT_STREQ(expected.output, GTEST_FLAG(output).c_str());
 	EXPECT_EQ(expected.print_time, GTEST_FLAG(print_time));
 	EXPECT_EQ(expected.random_seed, GTEST_FLAG(random_seed));
 	EXPECT_EQ(expected.repeat, GTEST_FLAG(repeat));
+	EXPECT_STREQ(expected.shard_durations, GTEST_FLAG(shard_durations).c_str());
 	EXPECT_EQ(expected.shuffle, GTEST_FLAG(shuffle));
 	EXPECT_EQ(expected.stack_trace_depth, GTEST_FLAG(stack_trace_depth));
+	EXPECT_EQ(expected.stream_output, GTEST_FLAG(stream_output));
+	EXPECT_EQ(expected.stream_result_buffer, GTEST_FLAG(stream_result_buffer));
+	EXPECT_STREQ(expected.stream_result_overflow,
+				 GTEST_FLAG(stream_result_overflow).c_str());
 	EXPECT_STREQ(expected.stream_result_to,
 				 GTEST_FLAG(stream_result_to).c_str());
 	EXPECT_EQ(expected.throw_on_failure, GTEST_FLAG(throw_on_failure));
@@ -5853,6 +6902,54 @@ TEST_F(ParseFlagsTest, UnrecognizedFlag) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, flags, false);
 }
 
+// Tests having a --gtest_jobs flag
+TEST_F(ParseFlagsTest, JobsFlag) {
+  const char* argv[] = {"foo.exe", "--gtest_jobs=4", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Jobs(4), false);
+}
+
+// Tests that every flag is also accepted with the --cutf_ prefix.
+TEST_F(ParseFlagsTest, JobsFlagWithCutfPrefix) {
+  const char* argv[] = {"foo.exe", "--cutf_jobs=4", "--cutf_filter=b", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  Flags flags;
+  flags.jobs = 4;
+  flags.filter = "b";
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, flags, false);
+}
+
+// Tests having a --cutf_console_buffer flag
+TEST_F(ParseFlagsTest, ConsoleBufferFlag) {
+  const char* argv[] = {"foo.exe", "--cutf_console_buffer=65536", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::ConsoleBuffer(65536), false);
+}
+
+// Tests having a --cutf_death_test_jobs flag
+TEST_F(ParseFlagsTest, DeathTestJobsFlag) {
+  const char* argv[] = {"foo.exe", "--cutf_death_test_jobs=4", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestJobs(4), false);
+}
+
+// Tests parsing --cutf_lazy_parameterized_tests.
+TEST_F(ParseFlagsTest, LazyParameterizedTests) {
+  const char* argv[] = {"foo.exe", "--cutf_lazy_parameterized_tests", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::LazyParameterizedTests(true), false);
+}
+
 // Tests having a --gtest_list_tests flag
 TEST_F(ParseFlagsTest, ListTestsFlag) {
   const char* argv[] = {"foo.exe", "--gtest_list_tests", nullptr};
@@ -5999,6 +7096,15 @@ TEST_F(ParseFlagsTest, Repeat) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Repeat(1000), false);
 }
 
+// Tests parsing --cutf_shard_durations=reports
+TEST_F(ParseFlagsTest, ShardDurations) {
+  const char* argv[] = {"foo.exe", "--cutf_shard_durations=a.xml,b.json", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::ShardDurations("a.xml,b.json"), false);
+}
+
 // Tests having a --gtest_also_run_disabled_tests flag
 TEST_F(ParseFlagsTest, AlsoRunDisabledTestsFlag) {
   const char* argv[] = {"foo.exe", "--gtest_also_run_disabled_tests", nullptr};
@@ -6067,6 +7173,33 @@ TEST_F(ParseFlagsTest, StackTraceDepth) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::StackTraceDepth(5), false);
 }
 
+// Tests parsing --cutf_stream_output.
+TEST_F(ParseFlagsTest, StreamOutput) {
+  const char* argv[] = {"foo.exe", "--cutf_stream_output", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::StreamOutput(true), false);
+}
+
+// Tests parsing --cutf_stream_result_buffer=N.
+TEST_F(ParseFlagsTest, StreamResultBuffer) {
+  const char* argv[] = {"foo.exe", "--cutf_stream_result_buffer=1024", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::StreamResultBuffer(1024), false);
+}
+
+// Tests parsing --cutf_stream_result_overflow=drop.
+TEST_F(ParseFlagsTest, StreamResultOverflow) {
+  const char* argv[] = {"foo.exe", "--cutf_stream_result_overflow=drop", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::StreamResultOverflow("drop"), false);
+}
+
 TEST_F(ParseFlagsTest, StreamResultTo) {
   const char* argv[] = {"foo.exe", "--gtest_stream_result_to=localhost:1234",
 						nullptr};
@@ -6442,7 +7575,15 @@ TEST(StreamingAssertionsTest, AnyThrow) {
 
 // Tests that Google Test correctly decides whether to use colors in the output.
 
-TEST(ColoredOutputTest, UsesColorsWhenGTestColorFlagIsYes) {
+// The tests change the color flag and the environment.
+class ColoredOutputTest : public Test {
+ protected:
+  void SetUp() override {
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+  }
+};
+
+TEST_F(ColoredOutputTest, UsesColorsWhenGTestColorFlagIsYes) {
   GTEST_FLAG(color) = "yes";
 
   SetEnv("TERM", "xterm");  // TERM supports colors.
@@ -6454,7 +7595,7 @@ TEST(ColoredOutputTest, UsesColorsWhenGTestColorFlagIsYes) {
   EXPECT_TRUE(::jmsd::cutf::internal::Colored_print::ShouldUseColor(false));  // Stdout is not a TTY.
 }
 
-TEST(ColoredOutputTest, UsesColorsWhenGTestColorFlagIsAliasOfYes) {
+TEST_F(ColoredOutputTest, UsesColorsWhenGTestColorFlagIsAliasOfYes) {
   SetEnv("TERM", "dumb");  // TERM doesn't support colors.
 
   GTEST_FLAG(color) = "True";
@@ -6467,7 +7608,7 @@ TEST(ColoredOutputTest, UsesColorsWhenGTestColorFlagIsAliasOfYes) {
   EXPECT_TRUE(::jmsd::cutf::internal::Colored_print::ShouldUseColor(false));  // Stdout is not a TTY.
 }
 
-TEST(ColoredOutputTest, UsesNoColorWhenGTestColorFlagIsNo) {
+TEST_F(ColoredOutputTest, UsesNoColorWhenGTestColorFlagIsNo) {
   GTEST_FLAG(color) = "no";
 
   SetEnv("TERM", "xterm");  // TERM supports colors.
@@ -6479,7 +7620,7 @@ TEST(ColoredOutputTest, UsesNoColorWhenGTestColorFlagIsNo) {
   EXPECT_FALSE(::jmsd::cutf::internal::Colored_print::ShouldUseColor(false));  // Stdout is not a TTY.
 }
 
-TEST(ColoredOutputTest, UsesNoColorWhenGTestColorFlagIsInvalid) {
+TEST_F(ColoredOutputTest, UsesNoColorWhenGTestColorFlagIsInvalid) {
   SetEnv("TERM", "xterm");  // TERM supports colors.
 
   GTEST_FLAG(color) = "F";
@@ -6492,7 +7633,7 @@ TEST(ColoredOutputTest, UsesNoColorWhenGTestColorFlagIsInvalid) {
   EXPECT_FALSE(::jmsd::cutf::internal::Colored_print::ShouldUseColor(true));  // Stdout is a TTY.
 }
 
-TEST(ColoredOutputTest, UsesColorsWhenStdoutIsTty) {
+TEST_F(ColoredOutputTest, UsesColorsWhenStdoutIsTty) {
   GTEST_FLAG(color) = "auto";
 
   SetEnv("TERM", "xterm");  // TERM supports colors.
@@ -6500,7 +7641,7 @@ TEST(ColoredOutputTest, UsesColorsWhenStdoutIsTty) {
   EXPECT_TRUE(::jmsd::cutf::internal::Colored_print::ShouldUseColor(true));    // Stdout is a TTY.
 }
 
-TEST(ColoredOutputTest, UsesColorsWhenTermSupportsColors) {
+TEST_F(ColoredOutputTest, UsesColorsWhenTermSupportsColors) {
   GTEST_FLAG(color) = "auto";
 
 #if GTEST_OS_WINDOWS && !GTEST_OS_WINDOWS_MINGW
@@ -6565,6 +7706,139 @@ TEST(ColoredOutputTest, UsesColorsWhenTermSupportsColors) {
 #endif  // GTEST_OS_WINDOWS
 }
 
+#if GTEST_OS_LINUX && GTEST_HAS_STREAM_REDIRECTION
+
+// Buffers the console output for the lifetime of the object, then goes back
+// to the mode it was in, which is --cutf_console_buffer's.
+class ScopedConsoleBuffer {
+ public:
+  ScopedConsoleBuffer(size_t buffer_size, int flush_interval_millis)
+	  : saved_buffer_size_(
+			::jmsd::cutf::internal::Console_output::buffer_size()),
+		saved_flush_interval_millis_(
+			::jmsd::cutf::internal::Console_output::flush_interval_millis()) {
+	::jmsd::cutf::internal::Console_output::SetBuffered(buffer_size,
+														flush_interval_millis);
+  }
+
+  ~ScopedConsoleBuffer() {
+	::jmsd::cutf::internal::Console_output::SetBuffered(
+		saved_buffer_size_, saved_flush_interval_millis_);
+  }
+
+ private:
+  const size_t saved_buffer_size_;
+  const int saved_flush_interval_millis_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(ScopedConsoleBuffer);
+};
+
+// Tests that buffered console output stays in stdout's buffer until the
+// flush interval passes or it is flushed explicitly.
+TEST(ConsoleOutputTest, FlushesOnlyWhenDue) {
+  CaptureStdout();
+  size_t pending_before_flush = 0;
+  size_t pending_after_flush = 0;
+  {
+	ScopedConsoleBuffer buffer(1 << 16, 60 * 1000);
+	EXPECT_TRUE(::jmsd::cutf::internal::Console_output::is_buffered());
+	EXPECT_EQ(static_cast<size_t>(1 << 16),
+			  ::jmsd::cutf::internal::Console_output::buffer_size());
+
+	printf("buffered");
+	::jmsd::cutf::internal::Console_output::FlushIfDue();
+	pending_before_flush = __fpending(stdout);
+	::jmsd::cutf::internal::Console_output::Flush();
+	pending_after_flush = __fpending(stdout);
+  }
+
+  EXPECT_EQ("buffered", GetCapturedStdout());
+  EXPECT_EQ(8u, pending_before_flush);
+  EXPECT_EQ(0u, pending_after_flush);
+}
+
+// Tests that buffered console output is flushed when the flush interval
+// passes even if nothing is printed any more, as when a test hangs.
+TEST(ConsoleOutputTest, FlushesFromTimer) {
+  CaptureStdout();
+  size_t pending_after_interval = 1;
+  {
+	ScopedConsoleBuffer buffer(1 << 17, 10);
+
+	printf("hanging");
+	for (int i = 0; i < 500 && pending_after_interval != 0; ++i) {
+	  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	  pending_after_interval = __fpending(stdout);
+	}
+  }
+
+  EXPECT_EQ("hanging", GetCapturedStdout());
+  EXPECT_EQ(0u, pending_after_interval);
+}
+
+#endif  // GTEST_OS_LINUX && GTEST_HAS_STREAM_REDIRECTION
+
+#if JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
+// Tests that a failure keeps the raw frames of its stack and that they are
+// symbolized only when the result is printed.
+TEST(StackTraceTest, FailureKeepsRawFrames) {
+  TestPartResultArray results;
+  {
+	ScopedFakeTestPartResultReporter reporter(
+		ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD,
+		&results);
+	ADD_FAILURE() << "expected failure";
+	SUCCEED();
+  }
+
+  ASSERT_EQ(2, results.size());
+  const TestPartResult& failure = results.GetTestPartResult(0);
+  EXPECT_FALSE(failure.stack_trace().frames().empty());
+  EXPECT_STREQ("Failed\nexpected failure", failure.message());
+  EXPECT_STREQ("Failed\nexpected failure", failure.summary());
+  EXPECT_EQ(std::string("Failed\nexpected failure\nStack trace:\n") +
+				failure.stack_trace().ToString(),
+			failure.message_with_stack_trace());
+
+  // Passed assertions don't capture anything.
+  EXPECT_TRUE(results.GetTestPartResult(1).stack_trace().empty());
+  EXPECT_STREQ(results.GetTestPartResult(1).message(),
+			   results.GetTestPartResult(1).message_with_stack_trace().c_str());
+}
+
+// Tests that every address is symbolized once: the later traces through the
+// same frames are printed from the cache.
+TEST(StackTraceTest, SymbolizesEachAddressOnce) {
+  using ::jmsd::cutf::internal::Stack_trace;
+
+  // Capturing doesn't symbolize anything.
+  const size_t count_before_capturing = Stack_trace::cached_symbol_count();
+  std::vector<Stack_trace> traces;
+  for (int i = 0; i < 2; ++i) {
+	traces.push_back(Stack_trace::Capture(10, 0));
+  }
+  const size_t count_before_printing = Stack_trace::cached_symbol_count();
+  EXPECT_EQ(count_before_capturing, count_before_printing);
+
+  ASSERT_FALSE(traces[0].empty());
+  EXPECT_GE(10u, traces[0].frames().size());
+  ASSERT_EQ(traces[0].frames(), traces[1].frames());
+
+  const std::string text = traces[0].ToString();
+  const size_t count_after_printing = Stack_trace::cached_symbol_count();
+  EXPECT_LE(count_after_printing,
+			count_before_printing + traces[0].frames().size());
+
+  EXPECT_EQ(text, traces[1].ToString());
+  EXPECT_EQ(text, traces[0].ToString());
+  EXPECT_EQ(count_after_printing, Stack_trace::cached_symbol_count());
+
+  EXPECT_TRUE(Stack_trace::Capture(0, 0).empty());
+}
+
+#endif  // JMSD_CUTF_HAS_NATIVE_STACK_TRACE_
+
 // Verifies that StaticAssertTypeEq works in a namespace scope.
 
 static bool dummy1 GTEST_ATTRIBUTE_UNUSED_ = ::jmsd::cutf::Static_assert_type_sameness<bool, bool>();
@@ -6827,6 +8101,167 @@ TEST(EventListenerTest, AppendKeepsOrder) {
   EXPECT_STREQ("1st.OnTestIterationEnd", vec[2].c_str());
 }
 
+// A SequenceTestingListener that only asks for the start events.
+class StartInterestedListener : public SequenceTestingListener {
+ public:
+  StartInterestedListener(std::vector<std::string>* vector, const char* id)
+	  : SequenceTestingListener(vector, id) {}
+
+  unsigned event_interests() const override {
+	return kOnTestProgramStart | kOnTestIterationStart;
+  }
+};
+
+// Tests that the events a listener isn't interested in don't reach it, and
+// that the others keep their order.
+TEST(EventListenerTest, ForwardsOnlyEventsOfInterest) {
+  std::vector<std::string> vec;
+  TestEventListeners listeners;
+  listeners.Append(new SequenceTestingListener(&vec, "1st"));
+  listeners.Append(new StartInterestedListener(&vec, "2nd"));
+  listeners.Append(new SequenceTestingListener(&vec, "3rd"));
+
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestProgramStart(
+	  *::jmsd::cutf::UnitTest::GetInstance());
+  ASSERT_EQ(3U, vec.size());
+  EXPECT_STREQ("1st.OnTestProgramStart", vec[0].c_str());
+  EXPECT_STREQ("2nd.OnTestProgramStart", vec[1].c_str());
+  EXPECT_STREQ("3rd.OnTestProgramStart", vec[2].c_str());
+
+  vec.clear();
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestIterationEnd(
+	  *::jmsd::cutf::UnitTest::GetInstance(), 0);
+  ASSERT_EQ(2U, vec.size());
+  EXPECT_STREQ("3rd.OnTestIterationEnd", vec[0].c_str());
+  EXPECT_STREQ("1st.OnTestIterationEnd", vec[1].c_str());
+
+  vec.clear();
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestProgramEnd(
+	  *::jmsd::cutf::UnitTest::GetInstance());
+  ASSERT_EQ(2U, vec.size());
+  EXPECT_STREQ("3rd.OnTestProgramEnd", vec[0].c_str());
+  EXPECT_STREQ("1st.OnTestProgramEnd", vec[1].c_str());
+}
+
+// Tests that a released listener leaves the lists of all its events.
+TEST(EventListenerTest, ReleaseRemovesListenerFromEveryEvent) {
+  std::vector<std::string> vec;
+  TestEventListeners listeners;
+  StartInterestedListener* const listener =
+	  new StartInterestedListener(&vec, "released");
+  listeners.Append(listener);
+  listeners.Append(new SequenceTestingListener(&vec, "kept"));
+  EXPECT_EQ(listener, listeners.Release(listener));
+
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestProgramStart(
+	  *::jmsd::cutf::UnitTest::GetInstance());
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestIterationStart(
+	  *::jmsd::cutf::UnitTest::GetInstance(), 0);
+  ASSERT_EQ(2U, vec.size());
+  EXPECT_STREQ("kept.OnTestProgramStart", vec[0].c_str());
+  EXPECT_STREQ("kept.OnTestIterationStart", vec[1].c_str());
+  delete listener;
+}
+
+// The events the ctf listener forwards when no --ctf_show_* flag is given:
+// the start and end of the program and of the iterations, and failures.
+static const unsigned kDefaultCtfEventInterests =
+	::jmsd::cutf::TestEventListener::kOnTestProgramStart |
+	::jmsd::cutf::TestEventListener::kOnTestIterationStart |
+	::jmsd::cutf::TestEventListener::kOnTestPartResult | ::jmsd::cutf::TestEventListener::kOnTestEnd |
+	::jmsd::cutf::TestEventListener::kOnTestIterationEnd |
+	::jmsd::cutf::TestEventListener::kOnTestProgramEnd;
+
+// Returns the events the ctf listener forwards after parsing the given
+// flags.
+static unsigned CtfEventInterestsWith(const char* flag1,
+									  const char* flag2 = nullptr) {
+  std::vector<std::string> vec;
+  ::jmsd::ctf::modification::Configurable_event_listener listener(
+	  new SequenceTestingListener(&vec, "wrapped"));
+
+  char program[] = "ctf_test";
+  std::string argument1 = flag1;
+  std::string argument2 = flag2 == nullptr ? "" : flag2;
+  char* argv[] = {program, &argument1[0],
+				  flag2 == nullptr ? nullptr : &argument2[0], nullptr};
+  int argc = flag2 == nullptr ? 2 : 3;
+  listener.Parse_flags(&argc, argv);
+  return listener.event_interests();
+}
+
+// Tests that by default the ctf listener only forwards what it needs to
+// print failures.
+TEST(ConfigurableEventListenerTest, ForwardsFailuresByDefault) {
+  std::vector<std::string> vec;
+  const ::jmsd::ctf::modification::Configurable_event_listener listener(
+	  new SequenceTestingListener(&vec, "wrapped"));
+
+  EXPECT_EQ(kDefaultCtfEventInterests, listener.event_interests());
+}
+
+// Tests that every --ctf_show_* flag turns its events on or off.
+TEST(ConfigurableEventListenerTest, EachShowFlagSetsItsEvents) {
+  EXPECT_EQ(kDefaultCtfEventInterests | ::jmsd::cutf::TestEventListener::kOnTestSuiteStart |
+				::jmsd::cutf::TestEventListener::kOnTestSuiteEnd,
+			CtfEventInterestsWith("--ctf_show_test_cases"));
+  EXPECT_EQ(kDefaultCtfEventInterests | ::jmsd::cutf::TestEventListener::kOnTestStart,
+			CtfEventInterestsWith("--ctf_show_test_names=1"));
+  EXPECT_EQ(kDefaultCtfEventInterests &
+				~static_cast<unsigned>(::jmsd::cutf::TestEventListener::kOnTestPartResult),
+			CtfEventInterestsWith("--ctf_show_test_part_failures=0"));
+  EXPECT_EQ(kDefaultCtfEventInterests |
+				::jmsd::cutf::TestEventListener::kOnEnvironmentsSetUpStart |
+				::jmsd::cutf::TestEventListener::kOnEnvironmentsSetUpEnd |
+				::jmsd::cutf::TestEventListener::kOnEnvironmentsTearDownStart |
+				::jmsd::cutf::TestEventListener::kOnEnvironmentsTearDownEnd,
+			CtfEventInterestsWith("--ctf_show_environment=true"));
+
+  // The end of a test is forwarded to show either failures or successes.
+  EXPECT_EQ(kDefaultCtfEventInterests &
+				~static_cast<unsigned>(::jmsd::cutf::TestEventListener::kOnTestEnd),
+			CtfEventInterestsWith("--ctf_show_inline_failures=false"));
+  EXPECT_EQ(kDefaultCtfEventInterests,
+			CtfEventInterestsWith("--ctf_show_inline_failures=F",
+								  "--ctf_show_successes"));
+  EXPECT_EQ(kDefaultCtfEventInterests,
+			CtfEventInterestsWith("--ctf_show_successes=0"));
+
+  // Unknown and malformed flags change nothing.
+  EXPECT_EQ(kDefaultCtfEventInterests,
+			CtfEventInterestsWith("--ctf_show_test_names_too"));
+  EXPECT_EQ(kDefaultCtfEventInterests,
+			CtfEventInterestsWith("--gtest_show_test_names"));
+}
+
+// Tests that Parse_flags() takes its flags out of the command line and
+// leaves the other arguments, and the terminating NULL, in order.
+TEST(ConfigurableEventListenerTest, RemovesItsFlagsFromCommandLine) {
+  std::vector<std::string> vec;
+  ::jmsd::ctf::modification::Configurable_event_listener listener(
+	  new SequenceTestingListener(&vec, "wrapped"));
+
+  char program[] = "ctf_test";
+  char show_test_names[] = "--ctf_show_test_names";
+  char filter[] = "--gtest_filter=Foo.*";
+  char show_environment[] = "--ctf_show_environment=0";
+  char show_successes[] = "--ctf_show_successes=1";
+  char argument[] = "bar";
+  char* argv[] = {program,  show_test_names, filter, show_environment,
+				  argument, show_successes,  nullptr};
+  int argc = 6;
+
+  listener.Parse_flags(&argc, argv);
+
+  ASSERT_EQ(3, argc);
+  EXPECT_STREQ(program, argv[0]);
+  EXPECT_STREQ(filter, argv[1]);
+  EXPECT_STREQ(argument, argv[2]);
+  EXPECT_TRUE(argv[3] == nullptr);
+  EXPECT_EQ(kDefaultCtfEventInterests | ::jmsd::cutf::TestEventListener::kOnTestStart,
+			listener.event_interests());
+}
+
 // Tests that a listener removed from a TestEventListeners list stops receiving
 // events and is not deleted when the list is destroyed.
 TEST(TestEventListenersTest, Release) {
@@ -6873,6 +8308,177 @@ TEST(EventListenerDeathTest, EventsNotForwardedInDeathTestSubprecesses) {
 	  "expected failure");
 }
 
+#if GTEST_HAS_DEATH_TEST
+
+// Prints the message to stderr, then dies.
+static void DieWithMessage(const std::string& message) {
+  fprintf(stderr, "%s", message.c_str());
+  fflush(stderr);
+  if (::testing::internal::AlwaysTrue()) _exit(1);
+}
+
+#endif  // GTEST_HAS_DEATH_TEST
+
+#if JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+// Makes death tests collect their children's stderr through the
+// Death_test_reactor, as they do with --cutf_death_test_jobs.
+class ScopedActiveDeathTestReactor {
+ public:
+  ScopedActiveDeathTestReactor()
+	  : was_active_(::jmsd::cutf::internal::Death_test_reactor::is_active()) {
+	::jmsd::cutf::internal::Death_test_reactor::set_active(true);
+  }
+  ~ScopedActiveDeathTestReactor() {
+	::jmsd::cutf::internal::Death_test_reactor::set_active(was_active_);
+  }
+
+ private:
+  const bool was_active_;
+};
+
+// Writes more to stderr than a pipe holds, then dies.
+static void DieAfterLongOutput() {
+  DieWithMessage(std::string(1 << 20, 'x') +
+								  "end of the long output");
+}
+
+// Tests that the reactor collects the stderr of the death tests of every
+// style, also past what a pipe holds, and that their verdicts don't change.
+TEST(DeathTestReactorDeathTest, CollectsStderrOfEveryStyleThroughTheReactor) {
+  // Changes the death test style for the whole process.
+  ::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+
+  ScopedActiveDeathTestReactor active_reactor;
+  const char* const styles[] = { "threadsafe", "fast", "forkserver" };
+
+  for (const char* style : styles) {
+	SCOPED_TRACE(style);
+	::testing::GTEST_FLAG(death_test_style) = style;
+
+	EXPECT_DEATH(DieWithMessage("death inside the test"),
+				 "death inside");
+	EXPECT_EXIT(_exit(3), ::testing::ExitedWithCode(3), "");
+	EXPECT_DEATH(DieAfterLongOutput(), "end of the long output");
+	EXPECT_NONFATAL_FAILURE(
+		EXPECT_DEATH(DieWithMessage("the actual message"),
+					 "another one"),
+		"the actual message");
+	EXPECT_NONFATAL_FAILURE(
+		EXPECT_DEATH(::testing::internal::AlwaysTrue(), ""), "failed to die");
+  }
+}
+
+#endif  // JMSD_CUTF_HAS_DEATH_TEST_REACTOR_
+
+#if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+
+// Runs death tests in the "forkserver" style.  The style and the current
+// directory belong to the whole process, so the tests run alone.
+class ForkServerStyleDeathTest : public Test {
+ protected:
+  ForkServerStyleDeathTest()
+	  : original_dir_(::testing::internal::FilePath::GetCurrentDir()) {}
+
+  ~ForkServerStyleDeathTest() override {
+	::testing::internal::posix::ChDir(original_dir_.c_str());
+  }
+
+  void SetUp() override {
+	::jmsd::cutf::internal::Test_isolation::GetInstance()->Require();
+	::testing::GTEST_FLAG(death_test_style) = "forkserver";
+  }
+
+  // A static member function that's expected to die.
+  static void StaticMemberFunction() {
+	DieWithMessage("death inside StaticMemberFunction().");
+  }
+
+  static void ChangeToRootDir() {
+	::testing::internal::posix::ChDir(GTEST_PATH_SEP_);
+  }
+
+ private:
+  const ::testing::internal::FilePath original_dir_;
+};
+
+TEST_F(ForkServerStyleDeathTest, StaticMemberFunction) {
+  ASSERT_DEATH(StaticMemberFunction(), "death.*StaticMember");
+}
+
+TEST_F(ForkServerStyleDeathTest, InLoop) {
+  for (int i = 0; i < 3; ++i)
+	EXPECT_EXIT(_exit(i), ::testing::ExitedWithCode(i), "") << ": i = " << i;
+}
+
+TEST_F(ForkServerStyleDeathTest, InChangedDir) {
+  ChangeToRootDir();
+  EXPECT_EXIT(_exit(1), ::testing::ExitedWithCode(1), "");
+
+  ChangeToRootDir();
+  ASSERT_DEATH(_exit(1), "");
+}
+
+// The server waits for the child, so this checks that it passes on the exit
+// status as it is.
+TEST_F(ForkServerStyleDeathTest, KilledBySignal) {
+  EXPECT_EXIT(raise(SIGKILL), ::testing::KilledBySignal(SIGKILL), "");
+}
+
+// Tests that death tests of every style can follow one another in a test.
+TEST_F(ForkServerStyleDeathTest, MixedStyles) {
+  ::testing::GTEST_FLAG(death_test_style) = "threadsafe";
+  EXPECT_DEATH(_exit(1), "");
+  ::testing::GTEST_FLAG(death_test_style) = "fast";
+  EXPECT_DEATH(_exit(1), "");
+  ::testing::GTEST_FLAG(death_test_style) = "forkserver";
+  EXPECT_DEATH(_exit(1), "");
+}
+
+# if GTEST_OS_LINUX
+
+// Returns the number of the child processes of this process.
+static int CountChildProcesses() {
+  int count = 0;
+  DIR* const proc = opendir("/proc");
+  if (proc == nullptr) return -1;
+
+  while (const dirent* const entry = readdir(proc)) {
+	const std::string path = std::string("/proc/") + entry->d_name + "/stat";
+	FILE* const stat = ::testing::internal::posix::FOpen(path.c_str(), "r");
+	if (stat == nullptr) continue;
+
+	int pid = 0;
+	char name[256];
+	char state = 0;
+	int parent_pid = 0;
+	if (fscanf(stat, "%d %255s %c %d", &pid, name, &state, &parent_pid) == 4 &&
+		parent_pid == getpid()) {
+	  ++count;
+	}
+	::testing::internal::posix::FClose(stat);
+  }
+
+  closedir(proc);
+  return count;
+}
+
+// Tests that one death test after another reuses the same server.
+TEST_F(ForkServerStyleDeathTest, ReusesItsServer) {
+  EXPECT_DEATH(_exit(1), "");
+  const int count = CountChildProcesses();
+  ASSERT_NE(-1, count);
+
+  for (int i = 0; i < 3; ++i) {
+	EXPECT_DEATH(_exit(1), "");
+  }
+  EXPECT_EQ(count, CountChildProcesses());
+}
+
+# endif  // GTEST_OS_LINUX
+
+#endif  // GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+
 // Tests that a listener installed via SetDefaultResultPrinter() starts
 // receiving events and is returned via default_result_printer() and that
 // the previous default_result_printer is removed from the list and deleted.
@@ -154,9 +154,9 @@ class GTestXMLTestCase(gtest_test_utils.TestCase):
     Normalizes Google Test's XML output to eliminate references to transient
     information that may change from run to run.
 
-    *  The "time" attribute of <testsuites>, <testsuite> and <testcase>
-       elements is replaced with a single asterisk, if it contains
-       only digit characters.
+    *  The "time" and "time_ns" attributes of <testsuites>, <testsuite> and
+       <testcase> elements are replaced with a single asterisk, if they
+       contain only digit characters.
     *  The "timestamp" attribute of <testsuites> elements is replaced with a
        single asterisk, if it contains a valid ISO8601 datetime value.
     *  The "type_param" attribute of <testcase> elements is replaced with a
@@ -176,6 +176,9 @@ class GTestXMLTestCase(gtest_test_utils.TestCase):
     if element.tagName in ('testsuites', 'testsuite', 'testcase'):
       time = element.getAttributeNode('time')
       time.value = re.sub(r'^\d+(\.\d+)?$', '*', time.value)
+      time_ns = element.getAttributeNode('time_ns')
+      if time_ns:
+        time_ns.value = re.sub(r'^\d+$', '*', time_ns.value)
       type_param = element.getAttributeNode('type_param')
       if type_param and type_param.value:
         type_param.value = '*'